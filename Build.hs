@@ -28,8 +28,9 @@ main = shakeArgs shakeOptions{shakeFiles="_build/"} $ do
     let mockDir = ".." </> "mock"
     let mockInclude = " -I " ++ (mockDir </> "include")
     let gtestDir = ".." </> "gtest"
-    let checkedCxxflags = "--coverage -std=c++11 -stdlib=libc++ -O0 -I ./include -I " ++ (gtestDir </> "include") ++ " -I " ++ gtestDir ++ patternInclude ++ mockInclude
+    let checkedCxxflags = "--coverage -DVIX_TRACK_ALLOCATIONS -std=c++11 -stdlib=libc++ -O0 -I ./include -I " ++ (gtestDir </> "include") ++ " -I " ++ gtestDir ++ patternInclude ++ mockInclude
     let releaseCxxflags = "-std=c++11 -stdlib=libc++ -DNDEBUG -O3 -I ./include" ++ patternInclude ++ mockInclude
+    let trackedCxxflags = releaseCxxflags ++ " -DVIX_TRACK_ALLOCATIONS"
 
     phony "clean" $ do
         removeFilesAfter "_build" ["//*"]
@@ -40,16 +41,22 @@ main = shakeArgs shakeOptions{shakeFiles="_build/"} $ do
     --the checked library
     "_build/checked/libvix" <.> "a" *> (buildLibrary "checked" $ getDirectoryFiles "" ["src//*.cpp"])
 
+    --the release library, counting allocations, for the replay harness
+    "_build/tracked/libvix" <.> "a" *> (buildLibrary "tracked" $ getDirectoryFiles "" ["src//*.cpp"])
+
     --build an object file for release
     "_build/release//*.o" *> (buildCxxObject releaseCxxflags)
 
     --build an object file for checked
     "_build/checked//*.o" *> (buildCxxObject checkedCxxflags)
 
+    --build an object file for tracked
+    "_build/tracked//*.o" *> (buildCxxObject trackedCxxflags)
+
     --test targets
 
     let ldflags = ""
-    let testlink = "-lstdc++ -L _build/checked -lvix " ++ (gtestDir </> "src" </> "gtest-all.cc")
+    let testlink = "-lstdc++ -L _build/checked -lvix " ++ (gtestDir </> "src" </> "gtest-all.cc") ++ " -lpthread"
 
     "_build/test/coverage-report/index.html" *> \out -> do
         need ["_build/test/vixtest" <.> exe]
@@ -66,3 +73,34 @@ main = shakeArgs shakeOptions{shakeFiles="_build/"} $ do
         let os = ["_build" </> "checked" </> c -<.> "o" | c <- cs]
         need os
         cmd "clang++" checkedCxxflags ldflags "-o" [out] os testlink
+
+    --benchmark targets
+
+    let benchmarkDir = ".." </> "benchmark"
+    let benchCxxflags = releaseCxxflags ++ " -I " ++ (benchmarkDir </> "include")
+    let benchlink = "-lstdc++ -L _build/release -lvix -L " ++ (benchmarkDir </> "build" </> "src") ++ " -lbenchmark -lpthread"
+
+    --build an object file for the benchmarks
+    "_build/bench//*.o" *> (buildCxxObject benchCxxflags)
+
+    "_build/bench/vixbench" <.> exe *> \out -> do
+        need ["_build/release/libvix" <.> "a"]
+        cs <- getDirectoryFiles "" ["bench/*.cpp"]
+        let os = ["_build" </> "bench" </> c -<.> "o" | c <- cs]
+        need os
+        cmd "clang++" benchCxxflags ldflags "-o" [out] os benchlink
+
+    --run the benchmarks, keeping the results as JSON to compare runs
+    phony "bench" $ do
+        need ["_build/bench/vixbench" <.> exe]
+        cmd "_build/bench/vixbench --benchmark_out=_build/bench/vixbench.json --benchmark_out_format=json"
+
+    --the edit trace replay harness
+    let replaylink = "-lstdc++ -L _build/tracked -lvix -lpthread"
+
+    "_build/bench/vixreplay" <.> exe *> \out -> do
+        need ["_build/tracked/libvix" <.> "a"]
+        cs <- getDirectoryFiles "" ["bench/replay//*.cpp"]
+        let os = ["_build" </> "bench" </> c -<.> "o" | c <- cs]
+        need os
+        cmd "clang++" benchCxxflags ldflags "-o" [out] os replaylink
@@ -0,0 +1,67 @@
+#ifndef  BENCH_LINES_HEADER_GUARD
+# define BENCH_LINES_HEADER_GUARD
+
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vix/Buffer.h>
+
+namespace vix {
+
+    /**
+     * The buffer sizes, in lines, each buffer benchmark is run with.
+     */
+    const long BENCH_MIN_LINES = 1 << 10;
+    const long BENCH_MAX_LINES = 1 << 20;
+
+    /**
+     * Register the buffer sizes with a benchmark.
+     */
+    inline void benchSizes(benchmark::internal::Benchmark* b)
+    {
+        b->RangeMultiplier(8)->Range(BENCH_MIN_LINES, BENCH_MAX_LINES);
+        b->ArgName("lines");
+    }
+
+    /**
+     * Returns a line of source code like text, of a length typical of source
+     * code, which is the same for the same index.
+     */
+    inline std::wstring benchLine(std::size_t index)
+    {
+        static const wchar_t* WORDS[] = {
+            L"if", L"(value", L"==", L"nullptr)", L"return", L"buffer.lines();",
+            L"for", L"(auto&", L"line", L":", L"lines_)", L"{", L"}", L"café",
+        };
+        const std::size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+        std::minstd_rand rng(index + 1);
+        std::wstring line(rng() % 4 * 4, L' ');
+        std::size_t words = rng() % 10;
+
+        for (std::size_t i = 0; i < words; ++i)
+        {
+            line += WORDS[rng() % WORD_COUNT];
+            line += L' ';
+        }
+
+        return line;
+    }
+
+    /**
+     * Fill a buffer with the given number of lines.
+     */
+    inline void fillBenchBuffer(Buffer& buffer, std::size_t lines)
+    {
+        Buffer::LineList list;
+
+        for (std::size_t i = 0; i < lines; ++i)
+            list.emplace_back(benchLine(i));
+
+        buffer.assign(list);
+    }
+
+} /* namespace vix */
+
+#endif //BENCH_LINES_HEADER_GUARD
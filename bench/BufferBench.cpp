@@ -0,0 +1,309 @@
+#include <benchmark/benchmark.h>
+#include <vix/Buffer.h>
+#include <vix/TextFile.h>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BenchLines.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Where in a buffer an edit is made.
+     */
+    enum Position
+    {
+        HEAD,
+        MIDDLE,
+        TAIL
+    };
+
+    /**
+     * Returns the line at the given position in a buffer.
+     */
+    Buffer::iterator at(Buffer& buffer, long position)
+    {
+        switch (position)
+        {
+        case HEAD:
+            return buffer.begin();
+
+        case MIDDLE:
+            return next(buffer.begin(), buffer.lines() / 2);
+
+        default:
+            return prev(buffer.end());
+        }
+    }
+
+    /**
+     * Replace a line in a buffer, returning the line which replaced it.
+     */
+    Buffer::iterator replaceAt(Buffer& buffer, Buffer::iterator position, const Line& line)
+    {
+        //replace() erases the line it is given.
+        auto after = next(position);
+        buffer.replace(position, line);
+
+        return prev(after);
+    }
+
+    /**
+     * Register the buffer sizes and edit positions with a benchmark.
+     */
+    void positions(benchmark::internal::Benchmark* b)
+    {
+        for (long position : {HEAD, MIDDLE, TAIL})
+        {
+            for (long lines = BENCH_MIN_LINES; lines < BENCH_MAX_LINES * 8; lines *= 8)
+                b->Args({min(lines, BENCH_MAX_LINES), position});
+        }
+
+        b->ArgNames({"lines", "position"});
+    }
+
+    /**
+     * A synchronous observer which does nothing.
+     */
+    class NullObserver : public BufferChangeObserver
+    {
+    public:
+        virtual void onBufferChanged(const Buffer*)
+        {
+        }
+    };
+
+    /**
+     * An asynchronous observer which does nothing.
+     */
+    class NullAsyncObserver : public AsyncBufferChangeObserver
+    {
+    public:
+        virtual void onBufferChanged(const list<Line>&, const vector<BufferChange>&)
+        {
+        }
+    };
+}
+
+/**
+ * Load a text into a buffer.
+ */
+static void BM_BufferLoad(benchmark::State& state)
+{
+    Buffer source;
+    fillBenchBuffer(source, state.range(0));
+
+    ostringstream out;
+    writeText(out, source);
+    string text = out.str();
+
+    for (auto _ : state)
+    {
+        Buffer buffer;
+        TextFormat format;
+
+        readText(text.data(), text.size(), buffer, format);
+        benchmark::DoNotOptimize(buffer.lines());
+    }
+
+    state.SetBytesProcessed(state.iterations() * text.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferLoad)->Apply(benchSizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * Walk every line of a buffer.
+ */
+static void BM_BufferIterate(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    for (auto _ : state)
+    {
+        size_t characters = 0;
+
+        for (auto& line : buffer)
+            characters += line.str().size();
+
+        benchmark::DoNotOptimize(characters);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferIterate)->Apply(benchSizes);
+
+/**
+ * Look up lines by index, at random.
+ */
+static void BM_BufferRandomAccess(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    minstd_rand rng(42);
+    vector<size_t> indices(1024);
+    for (auto& index : indices)
+        index = rng() % buffer.lines();
+
+    size_t i = 0;
+
+    for (auto _ : state)
+    {
+        auto line = next(buffer.begin(), indices[i++ % indices.size()]);
+        benchmark::DoNotOptimize(line->str().size());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferRandomAccess)->Apply(benchSizes);
+
+/**
+ * Insert a line at the head, middle or tail of a buffer.
+ */
+static void BM_BufferInsert(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    Line line(benchLine(0));
+    auto position = at(buffer, state.range(1));
+
+    for (auto _ : state)
+    {
+        if (state.range(1) == TAIL)
+            buffer.append(line);
+        else
+            buffer.insert(position, line);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferInsert)->Apply(positions);
+
+/**
+ * Erase a line at the head, middle or tail of a buffer.
+ */
+static void BM_BufferErase(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    size_t refill = state.range(0) / 2;
+    auto position = at(buffer, state.range(1));
+
+    for (auto _ : state)
+    {
+        //top the buffer up, off the clock, before it gets too small to be
+        //the size being measured.
+        if (buffer.lines() <= refill)
+        {
+            state.PauseTiming();
+            fillBenchBuffer(buffer, state.range(0));
+            position = at(buffer, state.range(1));
+            state.ResumeTiming();
+        }
+
+        //the middle moves along a line at a time, as the lines after it go.
+        auto line = position;
+
+        if (state.range(1) == HEAD)
+            ++position;
+        else if (state.range(1) == TAIL)
+            --position;
+        else if (++position == buffer.end())
+            position = buffer.begin();
+
+        buffer.erase(line);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferErase)->Apply(positions);
+
+/**
+ * Replace a line at the head, middle or tail of a buffer.
+ */
+static void BM_BufferReplace(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    Line lines[2] = {Line(benchLine(1)), Line(benchLine(2))};
+    auto position = at(buffer, state.range(1));
+    size_t i = 0;
+
+    for (auto _ : state)
+        position = replaceAt(buffer, position, lines[i++ & 1]);
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferReplace)->Apply(positions);
+
+/**
+ * Replace a line in a buffer with the given number of synchronous observers.
+ */
+static void BM_BufferNotify(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, BENCH_MIN_LINES);
+
+    vector<shared_ptr<NullObserver>> observers;
+    for (long i = 0; i < state.range(0); ++i)
+    {
+        observers.push_back(make_shared<NullObserver>());
+        buffer.addObserver(observers.back());
+    }
+
+    Line lines[2] = {Line(benchLine(1)), Line(benchLine(2))};
+    auto position = at(buffer, MIDDLE);
+    size_t i = 0;
+
+    for (auto _ : state)
+        position = replaceAt(buffer, position, lines[i++ & 1]);
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferNotify)->Arg(0)->Arg(1)->Arg(4)->Arg(16)->ArgName("observers");
+
+/**
+ * Replace a line in a buffer with the given number of asynchronous
+ * observers, including delivery of the changes.
+ */
+static void BM_BufferNotifyAsync(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    vector<shared_ptr<NullAsyncObserver>> observers;
+    for (long i = 0; i < state.range(1); ++i)
+    {
+        observers.push_back(make_shared<NullAsyncObserver>());
+        buffer.addObserver(observers.back());
+    }
+
+    Line lines[2] = {Line(benchLine(1)), Line(benchLine(2))};
+    auto position = at(buffer, MIDDLE);
+    size_t i = 0;
+
+    for (auto _ : state)
+        position = replaceAt(buffer, position, lines[i++ & 1]);
+
+    buffer.waitForObservers();
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferNotifyAsync)
+    ->Args({BENCH_MIN_LINES, 1})
+    ->Args({BENCH_MIN_LINES, 4})
+    ->Args({BENCH_MAX_LINES, 1})
+    ->ArgNames({"lines", "observers"})
+    ->UseRealTime();
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+#include <vix/Buffer.h>
+#include <vix/FoldEngine.h>
+
+#include <iterator>
+#include <memory>
+
+#include "BenchLines.h"
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Insert and erase a line in the middle of a buffer with a fold every ten
+ * lines, including keeping the folds in place.
+ */
+static void BM_FoldEngineEdit(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    auto engine = make_shared<FoldEngine>(buffer);
+    buffer.addObserver(engine);
+
+    for (size_t first = 0; first + 5 < buffer.lines(); first += 10)
+        engine->add(first, first + 5);
+
+    auto middle = next(buffer.begin(), buffer.lines() / 2 + 3);
+    Line line(benchLine(1));
+
+    for (auto _ : state)
+    {
+        buffer.insert(middle, line);
+        buffer.erase(prev(middle));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FoldEngineEdit)->Apply(benchSizes);
@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+#include <vix/Buffer.h>
+#include <vix/JournalCheckpoint.h>
+#include <vix/JournalCheckpointer.h>
+#include <vix/SerialVarint.h>
+#include <vix/Serializable.h>
+#include <vix/Utf8.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#include "BenchLines.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * A record of a line of text, standing in for a Command.
+     */
+    class TextRecord : virtual public Serializable
+    {
+    public:
+        string text;
+
+        virtual void serialRead(istream& in) { serialReadCompact(in, text); }
+
+        virtual void serialWrite(ostream& out) const { serialWriteCompact(out, text); }
+    };
+
+    /**
+     * Returns the path of a new journal, which doesn't exist yet.
+     */
+    string journalPath()
+    {
+        char name[] = "/tmp/vixbench-journal-XXXXXX";
+        close(mkstemp(name));
+        unlink(name);
+
+        return name;
+    }
+}
+
+/**
+ * Checkpoint a buffer, including writing the snapshot and compacting the
+ * journal in the background within the given IO budget, in KB per second.
+ */
+static void BM_JournalCheckpoint(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    string path = journalPath();
+
+    uint64_t sequence = 0;
+
+    {
+        JournalCheckpointer journal(path, state.range(1) * 1024);
+
+        for (auto _ : state)
+        {
+            journal.checkpoint(buffer);
+            journal.wait();
+            ++sequence;
+        }
+    }
+
+    unlink(path.c_str());
+    unlink(checkpointSnapshotPath(path, sequence).c_str());
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_JournalCheckpoint)
+    ->Args({BENCH_MIN_LINES * 16, 0})
+    ->Args({BENCH_MIN_LINES * 16, 256})
+    ->ArgNames({"lines", "kbps"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Append a record to a journal while checkpoints of a buffer keep running in
+ * the background, within the given IO budget, in KB per second.  The number of
+ * appends is fixed, since the journal they leave is compacted within the
+ * budget before the next run.
+ */
+static void BM_JournalAppendDuringCheckpoint(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, BENCH_MIN_LINES * 16);
+
+    TextRecord record;
+    utf8Encode(benchLine(0), record.text);
+
+    string path = journalPath();
+    size_t appended = 0;
+
+    {
+        JournalCheckpointer journal(path, state.range(0) * 1024);
+
+        for (auto _ : state)
+        {
+            //a checkpoint waiting to start replaces the one before, so one is
+            //always in flight.
+            if (appended++ % 4096 == 0)
+                journal.checkpoint(buffer);
+
+            journal.append(record);
+        }
+
+        journal.wait();
+    }
+
+    unlink(path.c_str());
+    for (uint64_t sequence = 1; sequence <= appended / 4096 + 1; ++sequence)
+        unlink(checkpointSnapshotPath(path, sequence).c_str());
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_JournalAppendDuringCheckpoint)
+    ->Arg(0)
+    ->Arg(256)
+    ->ArgName("kbps")
+    ->Iterations(16384)
+    ->UseRealTime();
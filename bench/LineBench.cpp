@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+#include <vix/Line.h>
+
+#include <string>
+#include <vector>
+
+#include "BenchLines.h"
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Create a line from a string.
+ */
+static void BM_LineCreate(benchmark::State& state)
+{
+    wstring str = benchLine(3);
+
+    for (auto _ : state)
+    {
+        Line line(str);
+        benchmark::DoNotOptimize(line.str().data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LineCreate);
+
+/**
+ * Copy a line, which copies its contents.
+ */
+static void BM_LineCopy(benchmark::State& state)
+{
+    Line line(benchLine(3));
+
+    for (auto _ : state)
+    {
+        Line copy(line);
+        benchmark::DoNotOptimize(copy.str().data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LineCopy);
+
+/**
+ * Change the contents of a line.
+ */
+static void BM_LineSetString(benchmark::State& state)
+{
+    wstring strs[2] = {benchLine(1), benchLine(2)};
+    Line line;
+    size_t i = 0;
+
+    for (auto _ : state)
+    {
+        line.str(strs[i++ & 1]);
+        benchmark::DoNotOptimize(line.str().data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LineSetString);
@@ -0,0 +1,309 @@
+#include <benchmark/benchmark.h>
+#include <vix/BufferSnapshot.h>
+#include <vix/MemoryInputStream.h>
+#include <vix/SerialEndian.h>
+#include <vix/SerialUtilities.h>
+#include <vix/SerialVarint.h>
+#include <vix/Utf8.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BenchLines.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Returns the value with the given index, spread over the whole range of
+     * the type, so variable length encodings see every length.
+     */
+    template <typename T>
+    T benchValue(size_t index)
+    {
+        uint64_t value = (index + 1) * 0x9E3779B97F4A7C15ULL;
+
+        return (T)(value >> (index % (8 * sizeof(uint64_t))));
+    }
+
+    template <>
+    string benchValue<string>(size_t index)
+    {
+        string value;
+        utf8Encode(benchLine(index), value);
+
+        return value;
+    }
+
+    template <>
+    Line benchValue<Line>(size_t index)
+    {
+        return Line(benchLine(index));
+    }
+
+    /**
+     * Each encoding is a pair of functions which write and read a value.
+     */
+    template <typename T>
+    struct Plain
+    {
+        typedef T Value;
+
+        static void write(ostream& out, const T& value)
+        {
+            serialWrite(out, value);
+        }
+
+        static void read(istream& in, T& value)
+        {
+            serialRead(in, value);
+        }
+    };
+
+    template <typename T>
+    struct BigEndian
+    {
+        typedef T Value;
+
+        static void write(ostream& out, const T& value)
+        {
+            serialWriteBigEndian(out, value);
+        }
+
+        static void read(istream& in, T& value)
+        {
+            serialReadBigEndian(in, value);
+        }
+    };
+
+    struct Varint
+    {
+        typedef uint64_t Value;
+
+        static void write(ostream& out, const uint64_t& value)
+        {
+            serialWriteVarint(out, value);
+        }
+
+        static void read(istream& in, uint64_t& value)
+        {
+            serialReadVarint(in, value);
+        }
+    };
+
+    struct Zigzag
+    {
+        typedef int64_t Value;
+
+        static void write(ostream& out, const int64_t& value)
+        {
+            serialWriteZigzag(out, value);
+        }
+
+        static void read(istream& in, int64_t& value)
+        {
+            serialReadZigzag(in, value);
+        }
+    };
+
+    struct Compact
+    {
+        typedef string Value;
+
+        static void write(ostream& out, const string& value)
+        {
+            serialWriteCompact(out, value);
+        }
+
+        static void read(istream& in, string& value)
+        {
+            serialReadCompact(in, value);
+        }
+    };
+
+    struct FixedBuffer
+    {
+        typedef uint64_t Value;
+
+        static void write(ostream& out, const uint64_t& value)
+        {
+            serialWriteFixedBuffer(out, &value, sizeof(value));
+        }
+
+        static void read(istream& in, uint64_t& value)
+        {
+            serialReadFixedBuffer(in, &value, sizeof(value));
+        }
+    };
+
+    /**
+     * Returns the given number of values written one after another.
+     */
+    template <typename Encoding>
+    string encodeValues(size_t count)
+    {
+        ostringstream out;
+
+        for (size_t i = 0; i < count; ++i)
+            Encoding::write(out, benchValue<typename Encoding::Value>(i));
+
+        return out.str();
+    }
+
+    /**
+     * Register the numbers of values written or read per iteration.
+     */
+    void counts(benchmark::internal::Benchmark* b)
+    {
+        b->RangeMultiplier(16)->Range(16, 1 << 16);
+        b->ArgName("values");
+    }
+}
+
+/**
+ * Write a run of values to a string stream.
+ */
+template <typename Encoding>
+static void BM_SerialWrite(benchmark::State& state)
+{
+    typedef typename Encoding::Value Value;
+
+    vector<Value> values;
+    for (long i = 0; i < state.range(0); ++i)
+        values.push_back(benchValue<Value>(i));
+
+    size_t bytes = encodeValues<Encoding>(values.size()).size();
+
+    for (auto _ : state)
+    {
+        ostringstream out;
+
+        for (auto& value : values)
+            Encoding::write(out, value);
+
+        benchmark::DoNotOptimize(out.tellp());
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes);
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+/**
+ * Read a run of values from memory.
+ */
+template <typename Encoding>
+static void BM_SerialRead(benchmark::State& state)
+{
+    string bytes = encodeValues<Encoding>(state.range(0));
+    typename Encoding::Value value = typename Encoding::Value();
+
+    for (auto _ : state)
+    {
+        MemoryInputStream in(bytes.data(), bytes.size());
+
+        for (long i = 0; i < state.range(0); ++i)
+            Encoding::read(in, value);
+
+        benchmark::DoNotOptimize(value);
+    }
+
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+#define BENCH_SERIAL(encoding) \
+    BENCHMARK_TEMPLATE(BM_SerialWrite, encoding)->Apply(counts); \
+    BENCHMARK_TEMPLATE(BM_SerialRead, encoding)->Apply(counts)
+
+BENCH_SERIAL(Plain<uint8_t>);
+BENCH_SERIAL(Plain<uint16_t>);
+BENCH_SERIAL(Plain<uint32_t>);
+BENCH_SERIAL(Plain<uint64_t>);
+BENCH_SERIAL(Plain<int8_t>);
+BENCH_SERIAL(Plain<int16_t>);
+BENCH_SERIAL(Plain<int32_t>);
+BENCH_SERIAL(Plain<int64_t>);
+BENCH_SERIAL(Plain<string>);
+BENCH_SERIAL(Plain<Line>);
+BENCH_SERIAL(BigEndian<uint32_t>);
+BENCH_SERIAL(BigEndian<uint64_t>);
+BENCH_SERIAL(Varint);
+BENCH_SERIAL(Zigzag);
+BENCH_SERIAL(Compact);
+BENCH_SERIAL(FixedBuffer);
+
+/**
+ * Write a run of size prefixed buffers.  serialReadBuffer is declared, but
+ * has no definition to measure.
+ */
+static void BM_SerialWriteBuffer(benchmark::State& state)
+{
+    string value = benchValue<string>(0);
+
+    for (auto _ : state)
+    {
+        ostringstream out;
+
+        for (long i = 0; i < state.range(0); ++i)
+            serialWriteBuffer(out, value.data(), value.size());
+
+        benchmark::DoNotOptimize(out.tellp());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0) * (value.size() + 2));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SerialWriteBuffer)->Apply(counts);
+
+/**
+ * Write a whole buffer as a snapshot.
+ */
+static void BM_BufferSerialWrite(benchmark::State& state)
+{
+    Buffer buffer;
+    fillBenchBuffer(buffer, state.range(0));
+
+    for (auto _ : state)
+    {
+        ostringstream out;
+
+        buffer.serialWrite(out);
+        benchmark::DoNotOptimize(out.tellp());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferSerialWrite)
+    ->RangeMultiplier(8)->Range(BENCH_MIN_LINES, BENCH_MAX_LINES)
+    ->ArgName("lines")->Unit(benchmark::kMillisecond);
+
+/**
+ * Read a whole buffer from a snapshot.
+ */
+static void BM_BufferSerialRead(benchmark::State& state)
+{
+    Buffer source;
+    fillBenchBuffer(source, state.range(0));
+
+    ostringstream out;
+    source.serialWrite(out);
+    string snapshot = out.str();
+
+    for (auto _ : state)
+    {
+        Buffer buffer;
+        MemoryInputStream in(snapshot.data(), snapshot.size());
+
+        buffer.serialRead(in);
+        benchmark::DoNotOptimize(buffer.lines());
+    }
+
+    state.SetBytesProcessed(state.iterations() * snapshot.size());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BufferSerialRead)
+    ->RangeMultiplier(8)->Range(BENCH_MIN_LINES, BENCH_MAX_LINES)
+    ->ArgName("lines")->Unit(benchmark::kMillisecond);
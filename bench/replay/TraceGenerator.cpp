@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../BenchLines.h"
+#include "TraceGenerator.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //delays, in microseconds.
+    const uint64_t MILLISECOND = 1000;
+    const uint64_t SECOND = 1000 * MILLISECOND;
+
+    //words searched for, the last of which is in no line, so its search
+    //scans the whole file.
+    const wchar_t* SEARCHES[] = {
+        L"return", L"buffer.lines();", L"nullptr)", L"café", L"notInTheFile"
+    };
+    const size_t SEARCH_COUNT = sizeof(SEARCHES) / sizeof(SEARCHES[0]);
+
+    const wchar_t LETTERS[] = L"abcdefghijklmnopqrstuvwxyz_();";
+    const size_t LETTER_COUNT = sizeof(LETTERS) / sizeof(LETTERS[0]) - 1;
+
+    /**
+     * Tracks where the simulated user is, and how long each line is, so the
+     * events it generates make sense.  Undo isn't modelled, so positions may
+     * drift from the file as replayed; the replayer keeps them inside it.
+     */
+    class Generator
+    {
+    public:
+        Generator(size_t lines, size_t events, uint32_t seed)
+            : trace_(lines), events_(events), rng_(seed), line_(0), column_(0)
+        {
+            lengths_.reserve(lines);
+
+            for (size_t i = 0; i < lines; ++i)
+                lengths_.push_back(benchLine(i).size());
+
+            if (lengths_.empty())
+                lengths_.push_back(0);
+
+            line_ = lengths_.size() / 2;
+        }
+
+        EditTrace generate()
+        {
+            while (trace_.events().size() < events_)
+            {
+                unsigned choice = uniform(100);
+
+                if (choice < 60)
+                    typeWord();
+                else if (choice < 72)
+                    moveNear();
+                else if (choice < 76)
+                    moveFar();
+                else if (choice < 82)
+                    search();
+                else if (choice < 86)
+                    paste();
+                else if (choice < 90)
+                    undoRedo();
+                else
+                    eraseWord();
+            }
+
+            return trace_;
+        }
+
+    private:
+        EditTrace trace_;
+        size_t events_;
+        minstd_rand rng_;
+        vector<size_t> lengths_;
+        size_t line_;
+        size_t column_;
+
+        //returns a number in [0, n).
+        size_t uniform(size_t n)
+        {
+            return n ? rng_() % n : 0;
+        }
+
+        //returns a delay in [low, high) microseconds.
+        uint64_t delay(uint64_t low, uint64_t high)
+        {
+            return low + uniform(high - low);
+        }
+
+        void add(EditEventType type, uint64_t delay, size_t count = 0, const wstring& text = wstring())
+        {
+            EditEvent event;
+            event.type = type;
+            event.delay = delay;
+            event.line = line_;
+            event.column = column_;
+            event.count = count;
+            event.text = text;
+
+            trace_.append(event);
+        }
+
+        void type(wchar_t c)
+        {
+            add(EDIT_TYPE, delay(60 * MILLISECOND, 250 * MILLISECOND), 0, wstring(1, c));
+            ++column_;
+            ++lengths_[line_];
+        }
+
+        void backspace()
+        {
+            if (column_ == 0)
+                return;
+
+            --column_;
+            --lengths_[line_];
+            add(EDIT_ERASE, delay(100 * MILLISECOND, 300 * MILLISECOND), 1);
+        }
+
+        //type a word a key at a time, with the odd typo put right.
+        void typeWord()
+        {
+            size_t letters = 2 + uniform(7);
+
+            for (size_t i = 0; i < letters; ++i)
+            {
+                if (uniform(100) < 5)
+                {
+                    type(LETTERS[uniform(LETTER_COUNT)]);
+                    backspace();
+                }
+
+                type(LETTERS[uniform(LETTER_COUNT)]);
+            }
+
+            type(L' ');
+        }
+
+        void moveNear()
+        {
+            size_t low = line_ > 20 ? line_ - 20 : 0;
+            size_t high = min(line_ + 21, lengths_.size());
+
+            line_ = low + uniform(high - low);
+            column_ = uniform(lengths_[line_] + 1);
+            add(EDIT_MOVE, delay(300 * MILLISECOND, 1500 * MILLISECOND));
+        }
+
+        void moveFar()
+        {
+            line_ = uniform(lengths_.size());
+            column_ = uniform(lengths_[line_] + 1);
+            add(EDIT_MOVE, delay(1 * SECOND, 3 * SECOND));
+        }
+
+        void search()
+        {
+            add(EDIT_SEARCH, delay(1 * SECOND, 4 * SECOND), 0, SEARCHES[uniform(SEARCH_COUNT)]);
+        }
+
+        void paste()
+        {
+            wstring text;
+            size_t size = 20 + uniform(380);
+
+            while (text.size() < size)
+                text += benchLine(uniform(lengths_.size()));
+
+            text.resize(size);
+
+            add(EDIT_PASTE, delay(500 * MILLISECOND, 2 * SECOND), 0, text);
+            column_ += size;
+            lengths_[line_] += size;
+        }
+
+        void undoRedo()
+        {
+            size_t undos = 1 + uniform(5);
+
+            for (size_t i = 0; i < undos; ++i)
+                add(EDIT_UNDO, delay(200 * MILLISECOND, 600 * MILLISECOND));
+
+            if (uniform(2))
+            {
+                for (size_t i = 0; i < undos; ++i)
+                    add(EDIT_REDO, delay(200 * MILLISECOND, 600 * MILLISECOND));
+            }
+        }
+
+        //delete the word before the cursor at once.
+        void eraseWord()
+        {
+            size_t count = min<size_t>(column_, 1 + uniform(8));
+            if (count == 0)
+                return;
+
+            column_ -= count;
+            lengths_[line_] -= count;
+            add(EDIT_ERASE, delay(300 * MILLISECOND, 900 * MILLISECOND), count);
+        }
+    };
+}
+
+/**
+ * Generate a synthetic trace of a user editing a file filled by
+ * fillBenchBuffer.
+ */
+EditTrace
+vix::generateTrace(size_t lines, size_t events, uint32_t seed)
+{
+    Generator generator(lines, events, seed);
+
+    return generator.generate();
+}
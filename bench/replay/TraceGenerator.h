@@ -0,0 +1,25 @@
+#ifndef  BENCH_TRACE_GENERATOR_HEADER_GUARD
+# define BENCH_TRACE_GENERATOR_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <vix/EditTrace.h>
+
+namespace vix {
+
+    /**
+     * Generate a synthetic trace of a user editing a file filled by
+     * fillBenchBuffer.  The user mostly types and corrects words a keystroke
+     * at a time, moving around near where they were editing, and now and then
+     * jumps far away, searches, pastes, or undoes and redoes.  The same
+     * arguments always produce the same trace.
+     *
+     * \param lines         The number of lines in the file.
+     * \param events        The number of events to generate.
+     * \param seed          The seed for the random choices.
+     */
+    EditTrace generateTrace(std::size_t lines, std::size_t events, std::uint32_t seed);
+
+} /* namespace vix */
+
+#endif //BENCH_TRACE_GENERATOR_HEADER_GUARD
@@ -0,0 +1,177 @@
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <vix/AllocationTracker.h>
+#include <vix/EraseTextCommand.h>
+#include <vix/InsertTextCommand.h>
+
+#include "TraceReplayer.h"
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Replay traces against the given buffer, which mustn't be empty.
+ */
+TraceReplayer::TraceReplayer(shared_ptr<Buffer> buffer)
+    : buffer_(buffer), tree_(buffer), coalescer_(tree_),
+      now_(UndoTree::clock::now()), line_(0), column_(0), found_(0),
+      latency_(EDIT_EVENT_TYPES), allocations_(EDIT_EVENT_TYPES)
+{
+}
+
+/**
+ * Replay every event of a trace.
+ */
+void
+TraceReplayer::replay(const EditTrace& trace)
+{
+    for (const auto& recorded : trace.events())
+    {
+        now_ += chrono::duration_cast<UndoTree::clock::duration>(
+            chrono::microseconds(recorded.delay));
+
+        //keep the event inside the buffer, off the clock.
+        EditEvent event = recorded;
+        event.line = min(event.line, buffer_->lines() - 1);
+
+        size_t length = next(buffer_->begin(), event.line)->str().size();
+        event.column = min(event.column, length);
+        event.count = min(event.count, length - event.column);
+
+        AllocationTracker allocations;
+        auto start = chrono::steady_clock::now();
+
+        apply(event);
+
+        auto elapsed = chrono::steady_clock::now() - start;
+
+        allocations_[event.type] += allocations.allocations();
+        latency_[event.type].record(
+            chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    }
+
+    //anything still being typed is an undo step of its own.
+    coalescer_.boundary();
+}
+
+/**
+ * Returns the latencies of the events of the given kind.
+ */
+const LatencyStatistics&
+TraceReplayer::latency(EditEventType type) const
+{
+    return latency_[type];
+}
+
+/**
+ * Returns the number of heap allocations made by events of the given kind.
+ */
+uint64_t
+TraceReplayer::allocations(EditEventType type) const
+{
+    return allocations_[type];
+}
+
+/**
+ * Returns the number of searches which found their text.
+ */
+size_t
+TraceReplayer::found() const
+{
+    return found_;
+}
+
+/**
+ * Replay an event, moving the cursor to where it leaves it.
+ */
+void
+TraceReplayer::apply(const EditEvent& event)
+{
+    switch (event.type)
+    {
+    case EDIT_TYPE:
+        coalescer_.apply(make_shared<InsertTextCommand>(event.line, event.column, event.text), now_);
+        line_ = event.line;
+        column_ = event.column + event.text.size();
+        break;
+
+    case EDIT_ERASE:
+        if (event.count > 0)
+            coalescer_.apply(make_shared<EraseTextCommand>(event.line, event.column, event.count), now_);
+
+        line_ = event.line;
+        column_ = event.column;
+        break;
+
+    case EDIT_MOVE:
+        coalescer_.boundary();
+        line_ = event.line;
+        column_ = min(event.column, next(buffer_->begin(), line_)->str().size());
+        break;
+
+    case EDIT_SEARCH:
+        coalescer_.boundary();
+        line_ = event.line;
+        column_ = event.column;
+        search(event.text);
+        break;
+
+    case EDIT_PASTE:
+        coalescer_.boundary();
+        coalescer_.apply(make_shared<InsertTextCommand>(event.line, event.column, event.text), now_);
+        coalescer_.boundary();
+        line_ = event.line;
+        column_ = event.column + event.text.size();
+        break;
+
+    case EDIT_UNDO:
+        coalescer_.boundary();
+        tree_.undo();
+        break;
+
+    case EDIT_REDO:
+        coalescer_.boundary();
+        tree_.redo();
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Search forwards from the cursor for the given text, wrapping at the end of
+ * the buffer, and move the cursor to it.
+ */
+void
+TraceReplayer::search(const wstring& text)
+{
+    size_t lines = buffer_->lines();
+    size_t line = line_;
+    auto it = next(buffer_->begin(), line);
+
+    //the cursor's own line is searched last, whole.
+    for (size_t i = 0; i < lines; ++i)
+    {
+        if (++line == lines)
+        {
+            line = 0;
+            it = buffer_->begin();
+        }
+        else
+        {
+            ++it;
+        }
+
+        size_t column = it->str().find(text);
+        if (column != wstring::npos)
+        {
+            line_ = line;
+            column_ = column;
+            ++found_;
+
+            return;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef  BENCH_TRACE_REPLAYER_HEADER_GUARD
+# define BENCH_TRACE_REPLAYER_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vix/Buffer.h>
+#include <vix/CommandCoalescer.h>
+#include <vix/EditTrace.h>
+#include <vix/Instrumentation.h>
+#include <vix/UndoTree.h>
+
+namespace vix {
+
+    /**
+     * A TraceReplayer plays edit traces against a buffer the way the editor
+     * would: typing and erasing go through a CommandCoalescer into an
+     * UndoTree, moves, searches and pastes close the undo step, and undo and
+     * redo step through the tree.  Each event is timed, along with the heap
+     * allocations it makes, from the moment it is handed to the buffer until
+     * the buffer and its synchronous observers are done with it.
+     *
+     * The trace's delays drive the coalescer's clock, so typing coalesces as
+     * it did when it was recorded, without waiting for real.  Positions are
+     * kept inside the buffer, off the clock, so a trace can be replayed
+     * against any file.
+     */
+    class TraceReplayer
+    {
+    public:
+
+        /**
+         * Replay traces against the given buffer, which mustn't be empty.
+         */
+        explicit TraceReplayer(std::shared_ptr<Buffer> buffer);
+
+        /**
+         * Replay every event of a trace.
+         */
+        void replay(const EditTrace& trace);
+
+        /**
+         * Returns the latencies of the events of the given kind.
+         */
+        const LatencyStatistics& latency(EditEventType type) const;
+
+        /**
+         * Returns the number of heap allocations made by events of the given
+         * kind, which is zero unless AllocationTracker::enabled().
+         */
+        std::uint64_t allocations(EditEventType type) const;
+
+        /**
+         * Returns the number of searches which found their text.
+         */
+        std::size_t found() const;
+
+    private:
+        std::shared_ptr<Buffer> buffer_;
+        UndoTree tree_;
+        CommandCoalescer coalescer_;
+        UndoTree::clock::time_point now_;
+        std::size_t line_;
+        std::size_t column_;
+        std::size_t found_;
+        std::vector<LatencyStatistics> latency_;
+        std::vector<std::uint64_t> allocations_;
+
+        /**
+         * Replay an event, moving the cursor to where it leaves it.
+         */
+        void apply(const EditEvent& event);
+
+        /**
+         * Search forwards from the cursor for the given text, wrapping at
+         * the end of the buffer, and move the cursor to it.
+         */
+        void search(const std::wstring& text);
+    };
+
+} /* namespace vix */
+
+#endif //BENCH_TRACE_REPLAYER_HEADER_GUARD
@@ -0,0 +1,251 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vix/AllocationTracker.h>
+#include <vix/Buffer.h>
+#include <vix/EditTrace.h>
+#include <vix/Instrumentation.h>
+#include <vix/TextFile.h>
+
+#include "../BenchLines.h"
+#include "TraceGenerator.h"
+#include "TraceReplayer.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const char* USAGE =
+        "usage: vixreplay generate <lines> <events> <seed> <trace>\n"
+        "       vixreplay [--observers=N] [--async=N] [--file=PATH] [--instrument]\n"
+        "                 <trace>...\n"
+        "\n"
+        "generate writes a synthetic trace of editing a generated file with the\n"
+        "given number of lines.  Otherwise, each trace is replayed against the\n"
+        "given file, or a generated file of the trace's size, with N\n"
+        "synchronous and asynchronous observers attached, and the latency of\n"
+        "each kind of event is reported in microseconds.  --instrument adds the\n"
+        "buffer's own counters and timers for each trace.  Allocations are only\n"
+        "counted when libvix is built with VIX_TRACK_ALLOCATIONS.\n";
+
+    /**
+     * A synchronous observer which asks what changed, as a highlighter would.
+     */
+    class ChangeObserver : public BufferChangeObserver
+    {
+    public:
+        ChangeObserver() : lines_(0)
+        {
+        }
+
+        virtual void onBufferChanged(const Buffer* buffer)
+        {
+            lines_ += buffer->lastChange().inserted;
+        }
+
+    private:
+        size_t lines_;
+    };
+
+    /**
+     * An asynchronous observer which looks at every changed line.
+     */
+    class SnapshotObserver : public AsyncBufferChangeObserver
+    {
+    public:
+        SnapshotObserver() : characters_(0)
+        {
+        }
+
+        virtual void onBufferChanged(const list<Line>& snapshot, const vector<BufferChange>& changes)
+        {
+            for (const auto& change : changes)
+            {
+                auto line = next(snapshot.begin(), min(change.line, snapshot.size()));
+
+                for (size_t i = 0; i < change.inserted && line != snapshot.end(); ++i, ++line)
+                    characters_ += line->str().size();
+            }
+        }
+
+    private:
+        size_t characters_;
+    };
+
+    /**
+     * Returns the value of an option of the form --name=value, or null.
+     */
+    const char* option(const char* arg, const char* name)
+    {
+        size_t size = strlen(name);
+
+        if (strncmp(arg, name, size) != 0 || arg[size] != '=')
+            return nullptr;
+
+        return arg + size + 1;
+    }
+
+    int generate(int argc, char** argv)
+    {
+        if (argc != 6)
+        {
+            cerr << USAGE;
+            return 1;
+        }
+
+        EditTrace trace = generateTrace(
+            strtoul(argv[2], nullptr, 10),
+            strtoul(argv[3], nullptr, 10),
+            strtoul(argv[4], nullptr, 10));
+
+        ofstream out(argv[5], ios::binary);
+        trace.serialWrite(out);
+        out.close();
+
+        if (!out)
+        {
+            cerr << "vixreplay: can't write " << argv[5] << endl;
+            return 1;
+        }
+
+        return 0;
+    }
+
+    void report(const string& name, const TraceReplayer& replayer)
+    {
+        printf("%s\n", name.c_str());
+        printf("%-8s %10s %10s %10s %10s %10s %10s %10s\n",
+            "event", "count", "mean", "p50", "p99", "p99.9", "max", "allocs/op");
+
+        for (int type = 0; type < EDIT_EVENT_TYPES; ++type)
+        {
+            const LatencyStatistics& latency = replayer.latency((EditEventType)type);
+            if (latency.count == 0)
+                continue;
+
+            //allocations aren't seen unless the library replaces operator new.
+            char allocations[32] = "-";
+            if (AllocationTracker::enabled())
+                snprintf(allocations, sizeof(allocations), "%.1f",
+                    (double)replayer.allocations((EditEventType)type) / latency.count);
+
+            printf("%-8s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f %10s\n",
+                editEventName((EditEventType)type),
+                (unsigned long long)latency.count,
+                latency.mean() / 1000,
+                latency.percentile(0.5) / 1000.0,
+                latency.percentile(0.99) / 1000.0,
+                latency.percentile(0.999) / 1000.0,
+                latency.max / 1000.0,
+                allocations);
+        }
+
+        printf("\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "generate") == 0)
+        return generate(argc, argv);
+
+    size_t observers = 0;
+    size_t async = 0;
+    string file;
+    bool instrument = false;
+    vector<string> traces;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (const char* value = option(argv[i], "--observers"))
+            observers = strtoul(value, nullptr, 10);
+        else if (const char* value = option(argv[i], "--async"))
+            async = strtoul(value, nullptr, 10);
+        else if (const char* value = option(argv[i], "--file"))
+            file = value;
+        else if (strcmp(argv[i], "--instrument") == 0)
+            instrument = true;
+        else if (argv[i][0] != '-')
+            traces.push_back(argv[i]);
+        else
+        {
+            cerr << USAGE;
+            return 1;
+        }
+    }
+
+    if (traces.empty())
+    {
+        cerr << USAGE;
+        return 1;
+    }
+
+    try
+    {
+        for (const auto& path : traces)
+        {
+            EditTrace trace;
+            ifstream in(path, ios::binary);
+            trace.serialRead(in);
+
+            auto buffer = make_shared<Buffer>();
+
+            if (!file.empty())
+            {
+                TextFormat format;
+                readTextFile(file, *buffer, format);
+            }
+            else
+            {
+                fillBenchBuffer(*buffer, trace.lines());
+            }
+
+            if (buffer->lines() == 0)
+                buffer->append(Line());
+
+            vector<shared_ptr<ChangeObserver>> changeObservers;
+            for (size_t i = 0; i < observers; ++i)
+            {
+                changeObservers.push_back(make_shared<ChangeObserver>());
+                buffer->addObserver(changeObservers.back());
+            }
+
+            vector<shared_ptr<SnapshotObserver>> snapshotObservers;
+            for (size_t i = 0; i < async; ++i)
+            {
+                snapshotObservers.push_back(make_shared<SnapshotObserver>());
+                buffer->addObserver(snapshotObservers.back());
+            }
+
+            Instrumentation::reset();
+            Instrumentation::enable(instrument);
+
+            TraceReplayer replayer(buffer);
+            replayer.replay(trace);
+            buffer->waitForObservers();
+
+            Instrumentation::enable(false);
+
+            report(path + " (" + to_string(buffer->lines()) + " lines)", replayer);
+
+            if (instrument)
+            {
+                Instrumentation::snapshot().writeText(cout);
+                cout << endl;
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        cerr << "vixreplay: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef  VIX_ALLOCATION_TRACKER_HEADER_GUARD
+# define VIX_ALLOCATION_TRACKER_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vix
+{
+    /**
+     * An AllocationTracker counts the heap allocations made by the current
+     * thread for as long as it is in scope, so that a test can assert that an
+     * operation allocates no more than it should.  Trackers nest; each counts
+     * the allocations made since it was created.
+     *
+     * Allocations are only seen when libvix is built with
+     * VIX_TRACK_ALLOCATIONS defined, as the checked build is, which replaces
+     * the global operator new.  Otherwise enabled() is false and every
+     * tracker counts zero.
+     */
+    class AllocationTracker
+    {
+    public:
+
+        /**
+         * Start counting the allocations made by this thread.
+         */
+        AllocationTracker();
+
+        /**
+         * Stop counting, unless an enclosing tracker is still counting.
+         */
+        ~AllocationTracker();
+
+        /**
+         * Returns the number of allocations made since this tracker was
+         * created or reset.
+         */
+        std::uint64_t allocations() const;
+
+        /**
+         * Returns the number of bytes asked for since this tracker was
+         * created or reset.
+         */
+        std::uint64_t bytes() const;
+
+        /**
+         * Count from zero again.
+         */
+        void reset();
+
+        /**
+         * Returns true if allocations are seen, which they are when libvix
+         * is built with VIX_TRACK_ALLOCATIONS defined.
+         */
+        static bool enabled();
+
+        /**
+         * Count an allocation of the given size made by this thread.  This is
+         * called by the replacement operator new.
+         */
+        static void allocated(std::size_t size);
+
+    private:
+        std::uint64_t allocations_;
+        std::uint64_t bytes_;
+
+        AllocationTracker(const AllocationTracker&) = delete;
+        AllocationTracker& operator=(const AllocationTracker&) = delete;
+    };
+}
+
+#endif //VIX_ALLOCATION_TRACKER_HEADER_GUARD
@@ -0,0 +1,36 @@
+#ifndef  VIX_ASYNC_BUFFER_CHANGE_OBSERVER_HEADER_GUARD
+# define VIX_ASYNC_BUFFER_CHANGE_OBSERVER_HEADER_GUARD
+
+#include <list>
+#include <vector>
+#include <vix/BufferChange.h>
+#include <vix/Line.h>
+
+namespace vix
+{
+    /**
+     * This observer interface can be used to register for buffer change
+     * events delivered off the editing thread.  Changes made while an
+     * observer is busy are coalesced and delivered together, with a snapshot
+     * of the buffer as of the last of them.
+     */
+    class AsyncBufferChangeObserver
+    {
+    public:
+
+        /**
+         * Called on the dispatch thread with the changes made since the last
+         * call, in the order they were made.
+         *
+         * \param snapshot      The lines of the buffer after the changes.  The
+         *                      snapshot is only valid for the duration of the
+         *                      call.
+         * \param changes       The coalesced changes.
+         */
+        virtual void onBufferChanged(
+            const std::list<Line>& snapshot,
+            const std::vector<BufferChange>& changes) = 0;
+    };
+}
+
+#endif //VIX_ASYNC_BUFFER_CHANGE_OBSERVER_HEADER_GUARD
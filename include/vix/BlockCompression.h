@@ -0,0 +1,48 @@
+#ifndef  VIX_BLOCK_COMPRESSION_HEADER_GUARD
+# define VIX_BLOCK_COMPRESSION_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vix/CompressionException.h>
+
+/**
+ * The BlockCompression header file provides a fast, LZ4-style block codec.
+ * Compressed blocks use the LZ4 block format, and do not carry their
+ * uncompressed size; the caller is expected to store it alongside the block.
+ */
+namespace vix
+{
+    /**
+     * compressBlockBound returns the largest size a block of the given size
+     * can have once compressed.
+     *
+     * \param size          The uncompressed size of the block.
+     */
+    std::size_t compressBlockBound(std::size_t size);
+
+    /**
+     * compressBlock compresses a buffer, replacing the contents of the output
+     * vector with the compressed block.
+     *
+     * \param in            The buffer to compress.
+     * \param size          The size of the buffer to compress.
+     * \param out           The vector receiving the compressed block.
+     */
+    void compressBlock(const void* in, std::size_t size, std::vector<std::uint8_t>& out);
+
+    /**
+     * decompressBlock decompresses a block previously written by
+     * compressBlock.  The block must decompress to exactly outSize bytes.
+     *
+     * \param in            The compressed block.
+     * \param size          The size of the compressed block.
+     * \param out           The buffer receiving the decompressed data.
+     * \param outSize       The uncompressed size of the block.
+     *
+     * \throw vix::exception::Decompression if the block is malformed.
+     */
+    void decompressBlock(const void* in, std::size_t size, void* out, std::size_t outSize);
+}
+
+#endif //VIX_BLOCK_COMPRESSION_HEADER_GUARD
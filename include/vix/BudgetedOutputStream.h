@@ -0,0 +1,78 @@
+#ifndef  VIX_BUDGETED_OUTPUT_STREAM_HEADER_GUARD
+# define VIX_BUDGETED_OUTPUT_STREAM_HEADER_GUARD
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <vix/FileException.h>
+#include <vix/IoBudget.h>
+
+namespace vix
+{
+    /**
+     * A BudgetedOutputStream writes a new file in chunks, charging each chunk
+     * to an IoBudget before it is written.  The file is only durable once
+     * commit() has flushed it and synced it to disk.
+     */
+    class BudgetedOutputStream : public std::ostream
+    {
+    public:
+
+        /**
+         * Create or truncate the file at the given path.
+         *
+         * \throw vix::exception::FileOpen if the file cannot be created.
+         */
+        BudgetedOutputStream(const std::string& path, IoBudget& budget);
+
+        /**
+         * Destructor.  Flush and close the file, ignoring any errors.
+         */
+        ~BudgetedOutputStream();
+
+        /**
+         * Flush everything written and sync the file to disk.
+         *
+         * \throw vix::exception::FileWrite if the file cannot be written.
+         */
+        void commit();
+
+        /**
+         * Start or stop charging writes to the budget.  A file whose bulk
+         * was written within budget can have a short tail written at once.
+         */
+        void budgeted(bool enabled);
+
+    private:
+
+        /**
+         * The stream buffer collects writes into chunks.
+         */
+        class BudgetedBuffer : public std::streambuf
+        {
+        public:
+            BudgetedBuffer(int fd, IoBudget& budget);
+
+            bool charging;
+
+        protected:
+            virtual int_type overflow(int_type c);
+            virtual int sync();
+
+        private:
+            int fd_;
+            IoBudget& budget_;
+            std::vector<char> chunk_;
+        };
+
+        std::string path_;
+        int fd_;
+        BudgetedBuffer buffer_;
+
+        BudgetedOutputStream(const BudgetedOutputStream&) = delete;
+        BudgetedOutputStream& operator=(const BudgetedOutputStream&) = delete;
+    };
+}
+
+#endif //VIX_BUDGETED_OUTPUT_STREAM_HEADER_GUARD
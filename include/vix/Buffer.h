@@ -1,9 +1,22 @@
 #ifndef  VIX_BUFFER_HEADER_GUARD
 # define VIX_BUFFER_HEADER_GUARD
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <list>
+#include <memory>
+#include <string>
+#include <vector>
 #include <pattern/Observer.h>
+#include <vix/AsyncBufferChangeObserver.h>
+#include <vix/BufferChange.h>
+#include <vix/CancellationToken.h>
 #include <vix/Line.h>
+#include <vix/LineInternTable.h>
+#include <vix/ObserverBudget.h>
+#include <vix/Serializable.h>
 
 namespace vix
 {
@@ -12,27 +25,55 @@ namespace vix
      */
     class Buffer;
 
+    /**
+     * Forward declaration for BufferChangeDispatcher.
+     */
+    class BufferChangeDispatcher;
+
     /**
      * This observer interface can be used to register for buffer change
-     * events.
+     * events.  Observers are called synchronously, from within the change,
+     * and can ask the buffer what changed with lastChange.
      */
     class BufferChangeObserver
     {
     public:
         virtual void onBufferChanged(const Buffer* changedBuffer) = 0;
+
+        /**
+         * Returns the name Instrumentation reports this observer's time
+         * under, along with its address.  An empty name, the default, stands
+         * for the observer's class name.
+         */
+        virtual std::string instrumentationName() const
+        {
+            return std::string();
+        }
     };
 
     /**
-     * This class represents a physical buffer in memory.
+     * This class represents a physical buffer in memory.  A buffer is
+     * serialized in the binary snapshot format described in BufferSnapshot.
+     *
+     * Observers are registered with one of two policies.  A
+     * BufferChangeObserver is called synchronously from within each change.
+     * An AsyncBufferChangeObserver is called on the standard TaskScheduler,
+     * with coalesced changes and a snapshot of the lines, so a slow observer
+     * doesn't hold up editing.
      */
-    class Buffer : public pattern::Observable<BufferChangeObserver>
+    class Buffer
+        : public pattern::Observable<BufferChangeObserver>,
+          virtual public Serializable
     {
+    public:
+
+        /**
+         * The list type used to hold the lines of this buffer.
+         */
         typedef
         std::list<Line>
         LineList;
 
-    public:
-
         /**
          * The iterator type for this buffer.
          */
@@ -71,6 +112,79 @@ namespace vix
          */
         ~Buffer();
 
+        /**
+         * Register an observer to be called synchronously.  Anything the
+         * observer budget knew of an earlier observer at the same address
+         * is forgotten.
+         */
+        void addObserver(std::shared_ptr<BufferChangeObserver> observer);
+
+        /**
+         * Register an observer to be called asynchronously, with coalesced
+         * changes.  The first asynchronous observer or reader makes their
+         * copy of the lines on the calling thread, which takes time in
+         * proportion to the number of lines; see readLines.
+         */
+        void addObserver(std::shared_ptr<AsyncBufferChangeObserver> observer);
+
+        /**
+         * Wait until asynchronous observers have been told of every change
+         * made so far.
+         */
+        void waitForObservers();
+
+        /**
+         * A function given the lines of a buffer as they were at some
+         * version.
+         */
+        typedef
+        std::function<void(const LineList&)>
+        LinesReader;
+
+        /**
+         * Call the given function, as a task, with the lines of this buffer
+         * as they are now, so that work on the whole buffer never copies the
+         * lines' contents on the editing thread.  The function is called
+         * along with the asynchronous observers, once they have been told of
+         * every change made so far, and mustn't keep the lines after it
+         * returns.  If there are no asynchronous observers yet, the first
+         * call makes their copy of the lines on the calling thread: it moves
+         * the contents of each long line into storage shared with the copy,
+         * and copies the list, which takes time in proportion to the number
+         * of lines, though no line's contents are copied.
+         */
+        void readLines(LinesReader reader) const;
+
+        /**
+         * Give each call to a synchronous observer the given time budget, and
+         * keep statistics on how long each observer takes.  The handler is
+         * told when an observer's rolling average goes over budget.  If
+         * demote is true, such an observer is no longer called from within
+         * each change, but from dispatchDeferred.  A zero budget stops the
+         * timing, and calls every observer from within each change again.
+         *
+         * \param budget        The time each call should take at most.
+         * \param demote        True if slow observers should be deferred.
+         * \param handler       Told when an observer becomes slow.
+         */
+        void observerBudget(
+            ObserverBudget::clock::duration budget, bool demote = false,
+            ObserverBudget::SlowHandler handler = ObserverBudget::SlowHandler());
+
+        /**
+         * Returns the statistics kept on a synchronous observer since the
+         * budget was set.  Without a budget, nothing is kept.
+         */
+        ObserverBudget::Statistics observerStatistics(
+            const BufferChangeObserver& observer) const;
+
+        /**
+         * Call the deferred observers, once, with the changes made since they
+         * were last called merged into a single lastChange.  This is meant to
+         * be called when the editor is idle, such as between keystrokes.
+         */
+        void dispatchDeferred();
+
         /*** Iteration functions ***/
 
         iterator begin();
@@ -105,6 +219,13 @@ namespace vix
          */
         void append(const Line& newLine);
 
+        /**
+         * Append all of the given lines to the end of the buffer.  The lines
+         * are moved out of the given list, which is left empty.  Observers
+         * are notified once.
+         */
+        void append(LineList& newLines);
+
         /**
          * Erase a line.
          */
@@ -115,6 +236,20 @@ namespace vix
          */
         void replace(const iterator& line, const Line& newLine);
 
+        /**
+         * Replace the given number of characters at the given column of a line
+         * with the given text, changing the line in place.  Observers see the
+         * line replaced.
+         */
+        void replace(const iterator& line, size_t column, size_t length, const std::wstring& text);
+
+        /**
+         * Replace the contents of this buffer with the given lines.  The lines
+         * are moved out of the given list, which is left empty.  Observers
+         * are notified once.
+         */
+        void assign(LineList& newLines);
+
         /**
          * Clear the buffer.
          */
@@ -125,11 +260,225 @@ namespace vix
          */
         size_t lines() const;
 
+        /**
+         * Returns the index of a line.  This walks from the line towards both
+         * ends of the buffer at once, stopping early at the first line of the
+         * last change, so costs the distance to the nearest of the three.
+         */
+        size_t lineNumber(const_iterator line) const;
+
+        /**
+         * Returns the line at the given index, or end() if there isn't one.
+         * This walks from the nearest of the ends of the buffer and the first
+         * line of the last change.
+         */
+        iterator line(size_t index);
+        const_iterator line(size_t index) const;
+
+        /**
+         * Returns the version of this buffer, which starts at zero and goes
+         * up by one with every change.  Each line inserted or replaced by a
+         * change is stamped with the version the change produced, so a cache
+         * built at a given version is current while the version is unchanged,
+         * and otherwise only needs to revisit lines with later stamps.
+         * Reading the version is safe from any thread.
+         */
+        std::uint64_t version() const;
+
+        /**
+         * Returns a token which goes stale as soon as this buffer changes,
+         * for work derived from the buffer as it is now.  The token remains
+         * safe to check once the buffer is gone.
+         */
+        CancellationToken changeToken() const;
+
+        /**
+         * Returns the most recent change.  Before the first change, this is
+         * an empty change at the start of the buffer.  While dispatchDeferred
+         * is calling observers, this is the changes they haven't seen, merged.
+         * The index of a change made through an iterator is only worked out
+         * here, from the change before, the first time it is asked for.
+         */
+        BufferChange lastChange() const;
+
+        /**
+         * Returns true if this buffer interns the lines added to it.
+         */
+        bool interning() const;
+
+        /**
+         * Enable or disable line interning.  When enabled, lines with identical
+         * contents share a single copy of their storage.  Enabling interning
+         * interns the lines already in the buffer.
+         */
+        void interning(bool enabled);
+
+        /**
+         * The default number of lines compressed together by compressCold.
+         */
+        static const std::size_t COLD_BLOCK_LINES;
+
+        /**
+         * Compress the cold regions of this buffer.  Blocks which have not
+         * been read since the previous call are replaced by blocks holding
+         * only their compressed data, and every run of blockLines consecutive
+         * uncompressed lines is moved into a new block, which is compressed
+         * on the standard TaskScheduler.  Interned lines are left as they
+         * are; lines shared with the asynchronous observers' copy of them are
+         * compressed in both.  The first call looks at every line; later
+         * calls only at the blocks which have been decompressed, and the
+         * lines inserted since the call before.  Iterators remain valid, and
+         * references returned by Line::str() for lines in this buffer stay
+         * valid until the next call.
+         */
+        void compressCold(std::size_t blockLines = COLD_BLOCK_LINES);
+
+        /**
+         * Wait until every block started by compressCold has been compressed,
+         * and replace those which haven't been read since with their
+         * compressed data.
+         */
+        void waitForCompression();
+
+        /**
+         * Replace the contents of this buffer with a snapshot read from a
+         * binary input stream.
+         *
+         * \throw vix::exception::SerialRead if serialization fails.
+         */
+        virtual void serialRead(std::istream& in);
+
+        /**
+         * Write a snapshot of this buffer to a binary output stream.
+         *
+         * \throw vix::exception::SerialWrite if serialization fails.
+         */
+        virtual void serialWrite(std::ostream& out) const;
+
     private:
+        /**
+         * What compressCold knows of the buffer's blocks.
+         */
+        struct ColdCompression;
+
         LineList lines_;
+        bool interning_;
+        LineInternTable internTable_;
+        std::shared_ptr<ColdCompression> compression_;
+        std::shared_ptr<std::atomic<std::uint64_t>> version_;
+
+        //the most recent change.  A change made through an iterator has its
+        //index worked out only when something asks for it, by walking from
+        //its first line to the change before, so edits nobody is watching
+        //cost nothing to number, and edits close together stay cheap however
+        //large the buffer.
+        iterator changed_;
+        mutable std::size_t changedLine_;
+        mutable bool changedKnown_;
+        std::size_t changeRemoved_;
+        std::size_t changeInserted_;
+
+        //the first line of the change before the most recent one, and its
+        //index before the most recent change, if that was known.
+        iterator anchor_;
+        std::size_t anchorLine_;
+        bool anchored_;
+
+        //made for the first asynchronous observer or reader.
+        mutable std::unique_ptr<BufferChangeDispatcher> dispatcher_;
+
+        //each deferred observer's missed changes are kept by the budget,
+        //and lastChange reports them, merged, while it is being called.
+        std::unique_ptr<ObserverBudget> budget_;
+        bool deferredPending_;
+        bool dispatchingDeferred_;
+        BufferChange deferredChange_;
+
+        //the observers found registered during the last change, so the
+        //budget can forget those since gone.
+        std::vector<const BufferChangeObserver*> budgeted_;
+
+        /**
+         * Intern the given line if interning is enabled.
+         */
+        void internLine(Line& line);
+
+        /**
+         * Returns the dispatcher for asynchronous observers and readers,
+         * making it if there is none yet.
+         */
+        BufferChangeDispatcher& dispatcher() const;
+
+        /**
+         * Returns true if compressCold may move the given line's contents
+         * into a block.
+         */
+        bool compressible(const Line& line) const;
+
+        /**
+         * Tell the asynchronous observers where compressCold moved the
+         * contents of the lines.
+         */
+        void postMoves();
+
+        /**
+         * Sweep the given blocks, and those decompressed since the last
+         * sweep, replacing those which have not been read since with blocks
+         * holding only their compressed data.
+         */
+        void sweepBlocks(std::vector<const LineBlock*> blocks);
+
+        /**
+         * Compress the runs of uncompressed lines from the given line up to
+         * the next line which isn't, and forget the lines looked at as
+         * inserted.
+         *
+         * \returns the line which isn't uncompressed.
+         */
+        iterator compressRuns(iterator line, std::size_t blockLines);
+
+        /**
+         * Move the contents of the given lines into a new block, and compress
+         * it in the background.
+         */
+        void compressRun(const std::vector<iterator>& run);
+
+        /**
+         * List the compressed lines among the given lines under their blocks,
+         * and remember where the run of lines starts, once compressCold keeps
+         * track.
+         */
+        void trackInserted(iterator first, iterator last);
+
+        /**
+         * Called before a line is erased, so the first line of the last
+         * change, and what compressCold keeps track of, is never one that has
+         * gone.
+         */
+        void erasing(iterator line);
+
+        /**
+         * Work out the index of the most recent change, if it isn't known.
+         */
+        void findChange() const;
+
+        /**
+         * Record a change: the given number of lines were removed where the
+         * given line now is, and the given number inserted starting with it.
+         * The index of the line is worked out when it is asked for.
+         */
+        void recordChange(
+            iterator first, std::size_t removed, std::size_t inserted);
+
+        /**
+         * Record a change whose first line has the given index.
+         */
+        void recordChange(
+            iterator first, std::size_t line, std::size_t removed,
+            std::size_t inserted);
 
         /**
-         * Notify all observers that the buffer has been changed.
+         * Notify all observers of the change just recorded.
          */
         void notifyChanged();
     };
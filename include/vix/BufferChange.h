@@ -0,0 +1,61 @@
+#ifndef  VIX_BUFFER_CHANGE_HEADER_GUARD
+# define VIX_BUFFER_CHANGE_HEADER_GUARD
+
+#include <cstddef>
+#include <vector>
+
+namespace vix
+{
+    /**
+     * A BufferChange describes a change to a run of lines in a buffer: the
+     * given number of lines, starting at the given line, were removed, and
+     * the given number of lines inserted in their place.  A replaced line is
+     * one removed and one inserted.
+     */
+    struct BufferChange
+    {
+        /**
+         * The index of the first line changed.
+         */
+        std::size_t line;
+
+        /**
+         * The number of lines removed.
+         */
+        std::size_t removed;
+
+        /**
+         * The number of lines inserted.
+         */
+        std::size_t inserted;
+
+        /**
+         * Returns true if the given change, which followed this one, touches
+         * the lines this one inserted, or the lines on either side of them.
+         */
+        bool touches(const BufferChange& next) const;
+
+        /**
+         * Merge the given change, which followed this one, into this change,
+         * so that this change covers both.  Changes which don't touch merge
+         * into one which also covers the lines between them.
+         */
+        void merge(const BufferChange& next);
+    };
+
+    /**
+     * coalesceBufferChange adds a change to the end of a sequence of changes,
+     * each of which followed the one before.  The change is merged into the
+     * last change if they touch, and the whole sequence is merged into one
+     * change once it grows past the given size.
+     *
+     * \param changes       The sequence of changes.
+     * \param change        The change which followed the sequence.
+     * \param maxChanges    The most changes the sequence may hold.
+     */
+    void coalesceBufferChange(
+        std::vector<BufferChange>& changes, const BufferChange& change,
+        std::size_t maxChanges);
+}
+
+#endif //VIX_BUFFER_CHANGE_HEADER_GUARD
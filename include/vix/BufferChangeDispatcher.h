@@ -0,0 +1,164 @@
+#ifndef  VIX_BUFFER_CHANGE_DISPATCHER_HEADER_GUARD
+# define VIX_BUFFER_CHANGE_DISPATCHER_HEADER_GUARD
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vix/AsyncBufferChangeObserver.h>
+#include <vix/BufferChange.h>
+#include <vix/Line.h>
+#include <vix/LineBlock.h>
+#include <vix/TaskScheduler.h>
+
+namespace vix
+{
+    /**
+     * A BufferChangeDispatcher delivers a buffer's changes to asynchronous
+     * observers as interactive tasks on a TaskScheduler.  The editing thread
+     * posts each change with copies of the lines it inserted, so posting
+     * costs the same however many observers there are and however slow they
+     * are.  The buffer's lines share their contents with these copies, so
+     * neither posting nor the dispatcher's copy of the lines copies them.
+     * One delivery runs at a time.  It brings the dispatcher's own copy of
+     * the buffer's lines up to date from the posted changes, and hands it to
+     * each observer as the snapshot, along with every change posted since the
+     * observers were last called.
+     */
+    class BufferChangeDispatcher
+    {
+    public:
+
+        /**
+         * The most changes delivered in one call before they are merged into
+         * a single change covering them all.
+         */
+        static const std::size_t MAX_CHANGES;
+
+        /**
+         * A function given the dispatcher's copy of the lines.
+         */
+        typedef
+        std::function<void(const std::list<Line>&)>
+        Reader;
+
+        /**
+         * Where a buffer has moved the contents of its lines, without
+         * changing them.  Each line holding shared storage listed in lines is
+         * now held like the line listed for it, and each line in a block
+         * listed in blocks is now at the same index of the block listed for
+         * it.
+         */
+        struct Moves
+        {
+            std::unordered_map<std::shared_ptr<const std::wstring>, Line> lines;
+            std::unordered_map<std::shared_ptr<LineBlock>, std::shared_ptr<LineBlock>> blocks;
+        };
+
+        /**
+         * Start dispatching changes to a buffer with the given lines, which
+         * are copied.  Lines sharing their contents are copied without them.
+         */
+        explicit BufferChangeDispatcher(
+            const std::list<Line>& lines,
+            TaskScheduler& scheduler = TaskScheduler::standard());
+
+        /**
+         * Destructor.  Wait for any changes still pending to be delivered.
+         */
+        ~BufferChangeDispatcher();
+
+        /**
+         * Register an observer.  It is called for changes posted from now on.
+         */
+        void addObserver(std::shared_ptr<AsyncBufferChangeObserver> observer);
+
+        /**
+         * Post a change, with the lines it inserted, which are moved out of
+         * the given list.
+         */
+        void post(const BufferChange& change, std::list<Line>& lines);
+
+        /**
+         * Post where the buffer has moved the contents of its lines, which
+         * are moved out of the given moves, so that the dispatcher's copy of
+         * the lines holds them the same way, and keeps nothing the buffer has
+         * let go of.  The observers are not told.
+         */
+        void moved(Moves& moves);
+
+        /**
+         * Post a reader, which is called with the lines as they are once
+         * every change posted before it has been applied, as part of a
+         * delivery.  It mustn't keep the lines after it returns.
+         */
+        void read(Reader reader);
+
+        /**
+         * Wait until every change posted so far has been delivered.
+         */
+        void wait();
+
+    private:
+
+        /**
+         * A posted change, or a reader or moves posted in its place.
+         */
+        struct Edit
+        {
+            BufferChange change;
+            std::list<Line> lines;
+            Reader reader;
+            Moves moves;
+        };
+
+        TaskScheduler& scheduler_;
+
+        //guards everything below; held only briefly by deliveries.
+        std::mutex mutex_;
+        std::condition_variable idle_;
+        std::vector<Edit> edits_;
+        std::vector<std::weak_ptr<AsyncBufferChangeObserver>> observers_;
+        bool busy_;
+
+        //only used by the delivery in progress.
+        std::list<Line> lines_;
+        std::list<Line>::iterator cursor_;
+        std::size_t cursorLine_;
+
+        /**
+         * Deliver the changes posted so far, as a task.
+         */
+        void deliver();
+
+        /**
+         * Queue an edit, and start a delivery if none is running.
+         */
+        void post(Edit& edit);
+
+        /**
+         * Apply a posted change to the dispatcher's copy of the lines.
+         */
+        void apply(Edit& edit);
+
+        /**
+         * Move the contents of the dispatcher's copy of the lines where the
+         * buffer has moved them.
+         */
+        void relocate(const Moves& moves);
+
+        /**
+         * Returns the line at the given index in the dispatcher's copy of the
+         * lines, walking from whichever of the start, the end, or the last
+         * change is closest.
+         */
+        std::list<Line>::iterator seek(std::size_t line);
+    };
+}
+
+#endif //VIX_BUFFER_CHANGE_DISPATCHER_HEADER_GUARD
@@ -0,0 +1,93 @@
+#ifndef  VIX_BUFFER_SNAPSHOT_HEADER_GUARD
+# define VIX_BUFFER_SNAPSHOT_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vix/Buffer.h>
+#include <vix/Line.h>
+#include <vix/SerialException.h>
+
+/**
+ * The BufferSnapshot header file provides a compact binary snapshot format for
+ * the contents of a Buffer.  A snapshot is laid out so that it can be written
+ * with a handful of large writes and loaded with a single read or mapping.
+ * All integers are Big Endian.
+ *
+ *   header         magic "VIXS", u16 version, u16 flags, u64 line count,
+ *                  u64 text size
+ *   line table     u32 UTF-8 length of each line
+ *   text           the UTF-8 text of every line, end to end
+ *
+ * When the SNAPSHOT_CHECKSUMS flag is set, each of the three sections is
+ * followed by its u32 CRC-32C.
+ */
+namespace vix
+{
+    /**
+     * The flag set in snapshots which carry checksums.
+     */
+    const std::uint16_t SNAPSHOT_CHECKSUMS = 0x0001;
+
+    /**
+     * writeBufferSnapshot writes a snapshot of a buffer to a binary stream.
+     *
+     * \param out           The stream to which the snapshot is written.
+     * \param buffer        The buffer to write.
+     * \param flags         The snapshot flags.
+     *
+     * \throw vix::exception::SerialWrite if the serial write fails.
+     */
+    void writeBufferSnapshot(std::ostream& out, const Buffer& buffer, std::uint16_t flags = SNAPSHOT_CHECKSUMS);
+
+    /**
+     * readBufferSnapshot replaces the contents of a buffer with a snapshot
+     * read from a binary stream.
+     *
+     * \param in            The stream from which the snapshot is read.
+     * \param buffer        The buffer to fill.
+     * \param threads       The number of threads used to decode lines.
+     *
+     * \throw vix::exception::SerialRead if the snapshot is truncated,
+     *        malformed, or fails its checksums.
+     */
+    void readBufferSnapshot(std::istream& in, Buffer& buffer, unsigned threads = 1);
+
+    /**
+     * readBufferSnapshot replaces the contents of a buffer with a snapshot
+     * held in memory, such as a memory mapped file.
+     *
+     * \param data          The snapshot.
+     * \param size          The size of the snapshot.
+     * \param buffer        The buffer to fill.
+     * \param threads       The number of threads used to decode lines.
+     *
+     * \throw vix::exception::SerialRead if the snapshot is truncated,
+     *        malformed, or fails its checksums.
+     */
+    void readBufferSnapshot(const void* data, std::size_t size, Buffer& buffer, unsigned threads = 1);
+
+    /**
+     * serialWrite(const Line&) is an overloaded function that writes a line to
+     * the output stream as a UTF-8 string with a varint length.
+     *
+     * \param out           The output stream to which this value is written.
+     * \param value         The line to write.
+     *
+     * \throw vix::exception::SerialWrite if the serial write fails.
+     */
+    void serialWrite(std::ostream& out, const Line& value);
+
+    /**
+     * serialRead(Line&) is an overloaded function that reads a line written by
+     * serialWrite(const Line&) from the input stream.
+     *
+     * \param in            The input stream from which this value is read.
+     * \param value         The line to read.
+     *
+     * \throw vix::exception::SerialRead if the serial read fails.
+     */
+    void serialRead(std::istream& in, Line& value);
+}
+
+#endif //VIX_BUFFER_SNAPSHOT_HEADER_GUARD
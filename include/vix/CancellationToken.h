@@ -0,0 +1,58 @@
+#ifndef  VIX_CANCELLATION_TOKEN_HEADER_GUARD
+# define VIX_CANCELLATION_TOKEN_HEADER_GUARD
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace vix
+{
+    /**
+     * A CancellationToken tells a background task whether its result is
+     * still wanted.  A token is cancelled explicitly, or becomes stale by
+     * itself, typically when the buffer the task was computing something for
+     * has changed since.  Copies of a token share its state, so the task can
+     * hold one while its owner cancels another.
+     */
+    class CancellationToken
+    {
+    public:
+
+        /**
+         * Create a token which is only cancelled by cancel.
+         */
+        CancellationToken();
+
+        /**
+         * Create a token which is also cancelled once the given function
+         * returns true.  The function is called from whichever thread checks
+         * the token, and must be safe to call from any.
+         */
+        explicit CancellationToken(std::function<bool()> stale);
+
+        /**
+         * Cancel the token, and every copy of it.
+         */
+        void cancel();
+
+        /**
+         * Returns true if the token has been cancelled or has gone stale.
+         */
+        bool cancelled() const;
+
+    private:
+
+        /**
+         * The state shared by copies of a token.
+         */
+        struct State
+        {
+            std::atomic<bool> cancelled;
+            std::function<bool()> stale;
+        };
+
+        std::shared_ptr<State> state_;
+    };
+}
+
+#endif //VIX_CANCELLATION_TOKEN_HEADER_GUARD
@@ -28,6 +28,32 @@ namespace vix
          * Revert the previously applied command.
          */
         virtual void revert(std::weak_ptr<Buffer> buffer) = 0;
+
+        /**
+         * Returns true if the given command, applied straight after this one,
+         * could be merged into it.  This is decided from where the commands
+         * apply, before the given command is applied, so that a command which
+         * won't merge never has to be applied and taken back.  By default,
+         * commands don't merge.
+         */
+        virtual bool canMerge(const Command&) const
+        {
+            return false;
+        }
+
+        /**
+         * Merge a command which has just been applied, straight after this
+         * one, into this command, so that this command covers both.  This is
+         * how runs of small edits, such as typing, are coalesced into a single
+         * undo step.  By default, commands don't merge.
+         *
+         * \returns true if the command was merged, which it is whenever
+         *          canMerge says it could be.
+         */
+        virtual bool merge(const Command&)
+        {
+            return false;
+        }
     };
 }
 
@@ -0,0 +1,80 @@
+#ifndef  VIX_COMMAND_COALESCER_HEADER_GUARD
+# define VIX_COMMAND_COALESCER_HEADER_GUARD
+
+#include <functional>
+#include <memory>
+#include <vix/Command.h>
+#include <vix/UndoTree.h>
+
+namespace vix
+{
+    /**
+     * A CommandCoalescer sits in front of an UndoTree and merges runs of small
+     * commands, such as the characters typed in insert mode, into a single
+     * command and a single undo step.  Each command is merged into the open
+     * command until a boundary: the editor calls boundary() when the cursor
+     * jumps or the mode changes, and a pause longer than the timeout is a
+     * boundary too.  A command which won't merge starts a new open command.
+     *
+     * Each command is passed to the sink, such as a journal, once, when it is
+     * closed, so the journal sees one record per undo step instead of one per
+     * keystroke.  Undo, redo and jumps in the tree must come after a
+     * boundary.
+     */
+    class CommandCoalescer
+    {
+    public:
+
+        /**
+         * The function called with each command once it is closed.
+         */
+        typedef
+        std::function<void(const Command&)>
+        Sink;
+
+        /**
+         * The default pause after which typing starts a new undo step.
+         */
+        static const UndoTree::clock::duration DEFAULT_TIMEOUT;
+
+        /**
+         * Create a coalescer for an undo tree.
+         */
+        explicit CommandCoalescer(
+            UndoTree& tree, Sink sink = Sink(),
+            UndoTree::clock::duration timeout = DEFAULT_TIMEOUT);
+
+        /**
+         * Destructor.  Close the open command.
+         */
+        ~CommandCoalescer();
+
+        /**
+         * Apply a command, merging it into the open command if it can be.
+         */
+        void apply(std::shared_ptr<Command> command, UndoTree::clock::time_point when = UndoTree::clock::now());
+
+        /**
+         * Close the open command, so the next command starts a new undo step.
+         */
+        void boundary();
+
+        /**
+         * Returns the open command, or null if there is none.
+         */
+        std::shared_ptr<Command> open() const;
+
+    private:
+        UndoTree& tree_;
+        Sink sink_;
+        UndoTree::clock::duration timeout_;
+        std::shared_ptr<Command> open_;
+        UndoTree::NodeId node_;
+        UndoTree::clock::time_point last_;
+
+        CommandCoalescer(const CommandCoalescer&) = delete;
+        CommandCoalescer& operator=(const CommandCoalescer&) = delete;
+    };
+}
+
+#endif //VIX_COMMAND_COALESCER_HEADER_GUARD
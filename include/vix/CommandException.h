@@ -0,0 +1,26 @@
+#ifndef  VIX_COMMAND_EXCEPTION_HEADER_GUARD
+# define VIX_COMMAND_EXCEPTION_HEADER_GUARD
+
+#include <stdexcept>
+#include <string>
+#include <vix/ExceptionSpecification.h>
+
+namespace vix
+{
+    namespace exception
+    {
+        /**
+         * The Command exception occurs when a command can't be applied or
+         * reverted.
+         */
+        EXCEPTION_SPECIFICATION(Command, std::runtime_error);
+
+        /**
+         * The CommandRange exception occurs when a command refers to a line
+         * or column outside of the buffer.
+         */
+        EXCEPTION_SPECIFICATION(CommandRange, Command);
+    }
+}
+
+#endif //VIX_COMMAND_EXCEPTION_HEADER_GUARD
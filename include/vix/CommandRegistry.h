@@ -0,0 +1,77 @@
+#ifndef  VIX_COMMAND_REGISTRY_HEADER_GUARD
+# define VIX_COMMAND_REGISTRY_HEADER_GUARD
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include <vix/Command.h>
+#include <vix/SerialException.h>
+
+namespace vix
+{
+    /**
+     * A CommandRegistry maps each concrete Command type to a one byte tag, so
+     * that serialized commands can be reconstructed: the tag is written ahead
+     * of the command, and read back to pick the factory which creates an
+     * empty command to deserialize into.
+     */
+    class CommandRegistry
+    {
+    public:
+
+        /**
+         * Creates an empty command of a registered type.
+         */
+        typedef
+        std::function<std::shared_ptr<Command>()>
+        Factory;
+
+        /**
+         * Create an empty registry.
+         */
+        CommandRegistry();
+
+        /**
+         * Register a default constructible command type under a tag.
+         */
+        template <typename T>
+        void add(std::uint8_t tag)
+        {
+            add(tag, typeid(T), [] { return std::make_shared<T>(); });
+        }
+
+        /**
+         * Register a command type under a tag, with a factory for it.
+         */
+        void add(std::uint8_t tag, const std::type_info& type, Factory factory);
+
+        /**
+         * Create an empty command for a tag.
+         *
+         * \throw vix::exception::SerialRead if the tag isn't registered.
+         */
+        std::shared_ptr<Command> create(std::uint8_t tag) const;
+
+        /**
+         * Returns the tag of a command's type.
+         *
+         * \throw vix::exception::SerialWrite if the type isn't registered.
+         */
+        std::uint8_t tag(const Command& command) const;
+
+        /**
+         * Returns the registry of the commands vix provides.
+         */
+        static const CommandRegistry& standard();
+
+    private:
+        std::vector<Factory> factories_;
+        std::unordered_map<std::type_index, std::uint8_t> tags_;
+    };
+}
+
+#endif //VIX_COMMAND_REGISTRY_HEADER_GUARD
@@ -0,0 +1,26 @@
+#ifndef  VIX_COMPRESSION_EXCEPTION_HEADER_GUARD
+# define VIX_COMPRESSION_EXCEPTION_HEADER_GUARD
+
+#include <stdexcept>
+#include <string>
+#include <vix/ExceptionSpecification.h>
+
+namespace vix
+{
+    namespace exception
+    {
+        /**
+         * The Compression exception occurs when any compression failure
+         * occurs.
+         */
+        EXCEPTION_SPECIFICATION(Compression, std::runtime_error);
+
+        /**
+         * The Decompression exception occurs when a compressed block is
+         * malformed or does not decompress to the expected size.
+         */
+        EXCEPTION_SPECIFICATION(Decompression, Compression);
+    }
+}
+
+#endif //VIX_COMPRESSION_EXCEPTION_HEADER_GUARD
@@ -0,0 +1,28 @@
+#ifndef  VIX_CRC32C_HEADER_GUARD
+# define VIX_CRC32C_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vix
+{
+    /**
+     * crc32c computes the CRC-32C (Castagnoli) checksum of a buffer.  A
+     * checksum can be computed incrementally by passing the result of the
+     * previous call as the initial value of the next.  The CPU's CRC
+     * instructions are used where they are available.
+     *
+     * \param data          The buffer to checksum.
+     * \param size          The size of the buffer.
+     * \param crc           The checksum of the preceding data, if any.
+     */
+    std::uint32_t crc32c(const void* data, std::size_t size, std::uint32_t crc = 0);
+
+    /**
+     * crc32cAccelerated returns true if crc32c uses the CPU's CRC instructions
+     * rather than lookup tables.
+     */
+    bool crc32cAccelerated();
+}
+
+#endif //VIX_CRC32C_HEADER_GUARD
@@ -0,0 +1,162 @@
+#ifndef  VIX_EDIT_TRACE_HEADER_GUARD
+# define VIX_EDIT_TRACE_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vix/Serializable.h>
+
+namespace vix
+{
+    /**
+     * The kinds of event in an EditTrace.
+     */
+    enum EditEventType
+    {
+        /**
+         * Text typed at the event's position.
+         */
+        EDIT_TYPE,
+
+        /**
+         * Count characters erased, starting at the event's position.
+         */
+        EDIT_ERASE,
+
+        /**
+         * The cursor moved to the event's position.
+         */
+        EDIT_MOVE,
+
+        /**
+         * A search for the event's text, forwards from its position.
+         */
+        EDIT_SEARCH,
+
+        /**
+         * Text pasted at the event's position.
+         */
+        EDIT_PASTE,
+
+        /**
+         * Undo the most recent change.
+         */
+        EDIT_UNDO,
+
+        /**
+         * Redo the most recently undone change.
+         */
+        EDIT_REDO,
+
+        /**
+         * The number of kinds of event.
+         */
+        EDIT_EVENT_TYPES
+    };
+
+    /**
+     * An EditEvent is one thing the user did, with the time since the event
+     * before it.
+     */
+    struct EditEvent
+    {
+        /**
+         * What the user did.
+         */
+        EditEventType type;
+
+        /**
+         * The time since the previous event, in microseconds.
+         */
+        std::uint64_t delay;
+
+        /**
+         * The line at which the event happened.
+         */
+        std::size_t line;
+
+        /**
+         * The column at which the event happened.
+         */
+        std::size_t column;
+
+        /**
+         * The number of characters erased.
+         */
+        std::size_t count;
+
+        /**
+         * The text typed, pasted or searched for.
+         */
+        std::wstring text;
+
+        /**
+         * Two events are equal if every field is.
+         */
+        bool operator==(const EditEvent& other) const;
+        bool operator!=(const EditEvent& other) const;
+    };
+
+    /**
+     * Returns the name of a kind of event, for reports.
+     */
+    const char* editEventName(EditEventType type);
+
+    /**
+     * An EditTrace is a recording of a user editing a file, which can be
+     * replayed against a buffer holding the file to see how editing feels,
+     * rather than how fast each operation is alone.  A trace is serialized
+     * with a four byte magic number and a 16-bit version, followed by the
+     * number of lines in the file it was recorded against and the events.
+     * Every number but the version is a varint, and text is UTF-8, so a long
+     * trace of typing costs a few bytes a keystroke.
+     */
+    class EditTrace : virtual public Serializable
+    {
+    public:
+
+        /**
+         * Create an empty trace of edits to a file with the given number of
+         * lines.
+         */
+        explicit EditTrace(std::size_t lines = 0);
+
+        /**
+         * Returns the number of lines in the file the trace was recorded
+         * against.
+         */
+        std::size_t lines() const;
+
+        /**
+         * Returns the events, in the order they happened.
+         */
+        const std::vector<EditEvent>& events() const;
+
+        /**
+         * Add an event to the end of the trace.
+         */
+        void append(const EditEvent& event);
+
+        /**
+         * Read a trace.
+         *
+         * \throw vix::exception::SerialRead if serialization fails, or the
+         *        stream doesn't hold a trace.
+         */
+        virtual void serialRead(std::istream& in);
+
+        /**
+         * Write the trace.
+         *
+         * \throw vix::exception::SerialWrite if serialization fails.
+         */
+        virtual void serialWrite(std::ostream& out) const;
+
+    private:
+        std::size_t lines_;
+        std::vector<EditEvent> events_;
+    };
+}
+
+#endif //VIX_EDIT_TRACE_HEADER_GUARD
@@ -0,0 +1,97 @@
+#ifndef  VIX_ERASE_TEXT_COMMAND_HEADER_GUARD
+# define VIX_ERASE_TEXT_COMMAND_HEADER_GUARD
+
+#include <cstddef>
+#include <string>
+#include <vix/Command.h>
+#include <vix/CommandException.h>
+
+namespace vix
+{
+    /**
+     * An EraseTextCommand erases a run of characters from a line.  Applying
+     * the command remembers the erased text, so that it can be reverted.  A
+     * command erasing the characters just before this command's, as
+     * backspace does, or just after, as delete does, merges into it.  Text is
+     * serialized as UTF-8, and positions as varints.
+     */
+    class EraseTextCommand : public Command
+    {
+    public:
+
+        /**
+         * Create a command erasing the given number of characters at the
+         * given line and column.
+         */
+        EraseTextCommand(std::size_t line = 0, std::size_t column = 0, std::size_t length = 0);
+
+        /**
+         * Returns the line from which text is erased.
+         */
+        std::size_t line() const;
+
+        /**
+         * Returns the column of the first erased character.
+         */
+        std::size_t column() const;
+
+        /**
+         * Returns the number of characters erased.
+         */
+        std::size_t length() const;
+
+        /**
+         * Returns the erased text, once the command has been applied.
+         */
+        const std::wstring& text() const;
+
+        /**
+         * Erase the text.
+         *
+         * \throw vix::exception::CommandRange if the range is outside the
+         *        buffer.
+         */
+        virtual void apply(std::weak_ptr<Buffer> buffer);
+
+        /**
+         * Put the erased text back.
+         *
+         * \throw vix::exception::CommandRange if the position is outside the
+         *        buffer.
+         */
+        virtual void revert(std::weak_ptr<Buffer> buffer);
+
+        /**
+         * Returns true if the given command erases the characters either side
+         * of this command's.
+         */
+        virtual bool canMerge(const Command& next) const;
+
+        /**
+         * Merge an erasure of the characters either side of this command's.
+         */
+        virtual bool merge(const Command& next);
+
+        /**
+         * Replace this command with one read from a binary input stream.
+         *
+         * \throw vix::exception::SerialRead if serialization fails.
+         */
+        virtual void serialRead(std::istream& in);
+
+        /**
+         * Write this command to a binary output stream.
+         *
+         * \throw vix::exception::SerialWrite if serialization fails.
+         */
+        virtual void serialWrite(std::ostream& out) const;
+
+    private:
+        std::size_t line_;
+        std::size_t column_;
+        std::size_t length_;
+        std::wstring text_;
+    };
+}
+
+#endif //VIX_ERASE_TEXT_COMMAND_HEADER_GUARD
@@ -0,0 +1,34 @@
+#ifndef  VIX_FILE_EXCEPTION_HEADER_GUARD
+# define VIX_FILE_EXCEPTION_HEADER_GUARD
+
+#include <stdexcept>
+#include <string>
+#include <vix/ExceptionSpecification.h>
+
+namespace vix
+{
+    namespace exception
+    {
+        /**
+         * The File exception occurs when any file operation fails.
+         */
+        EXCEPTION_SPECIFICATION(File, std::runtime_error);
+
+        /**
+         * The FileOpen exception occurs when a file cannot be opened.
+         */
+        EXCEPTION_SPECIFICATION(FileOpen, File);
+
+        /**
+         * The FileRead exception occurs when reading or mapping a file fails.
+         */
+        EXCEPTION_SPECIFICATION(FileRead, File);
+
+        /**
+         * The FileWrite exception occurs when writing a file fails.
+         */
+        EXCEPTION_SPECIFICATION(FileWrite, File);
+    }
+}
+
+#endif //VIX_FILE_EXCEPTION_HEADER_GUARD
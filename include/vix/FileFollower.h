@@ -0,0 +1,165 @@
+#ifndef  VIX_FILE_FOLLOWER_HEADER_GUARD
+# define VIX_FILE_FOLLOWER_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vix/Buffer.h>
+#include <vix/FileException.h>
+#include <vix/IoBackend.h>
+#include <vix/LineIndex.h>
+#include <vix/Utf8Decoder.h>
+
+namespace vix
+{
+    /**
+     * A FileFollower follows a file which is being written to, such as a log,
+     * the way tail -F does, and appends each line written to the end of a
+     * buffer.  Only the bytes written since the last poll are read, through
+     * an IoBackend which reads the next block while the last is split into
+     * lines, and the lines they complete are appended in one change, so
+     * observers hear of a batch of lines at once.  A line is appended only
+     * once it has ended.
+     *
+     * The file is watched with inotify, and the follower's descriptor becomes
+     * readable when the file may have changed, so it can be polled from an
+     * event loop.  A file truncated in place is read again from the start,
+     * replacing the contents of the buffer.  When another file takes the
+     * place of the one followed, as when a log is rotated, what is left of
+     * the old file is read and the new one is followed from its start.
+     *
+     * Lines end at line feeds.  If the first line ends in a carriage return
+     * line feed, the carriage return is dropped from every line which has
+     * one.
+     */
+    class FileFollower
+    {
+    public:
+
+        /**
+         * The default number of bytes read by a poll.
+         */
+        static const std::size_t MAX_BATCH_SIZE;
+
+        /**
+         * Follow the file at the given path from its start, appending its
+         * lines to the given buffer, which must outlive the follower.
+         *
+         * \throw vix::exception::FileOpen if the file cannot be opened or
+         *        watched.
+         */
+        FileFollower(const std::string& path, Buffer& buffer);
+
+        /**
+         * Destructor.  Stop following the file.
+         */
+        ~FileFollower();
+
+        /**
+         * Returns a descriptor which becomes readable when the file may have
+         * changed.  It is drained by poll.
+         */
+        int descriptor() const;
+
+        /**
+         * Wait for the file to change, or for the given number of
+         * milliseconds, or forever if negative.
+         *
+         * \returns false if the wait timed out.
+         */
+        bool wait(int milliseconds);
+
+        /**
+         * Read what has been written to the file since the last poll, up to
+         * the given number of bytes, and append the lines it completes to the
+         * buffer.  This never waits for the file to change.
+         *
+         * \returns the number of lines appended, or if the file was truncated,
+         *          the number of lines in the buffer.
+         *
+         * \throw vix::exception::FileRead if the file cannot be read.
+         */
+        std::size_t poll(std::size_t maxBytes = MAX_BATCH_SIZE);
+
+        /**
+         * Returns true if the last poll stopped at its limit with more of the
+         * file left to read.
+         */
+        bool behind() const;
+
+        /**
+         * Returns the number of bytes read from the file being followed.
+         */
+        std::uint64_t offset() const;
+
+        /**
+         * Returns the line ending of the first line read, or LINE_ENDING_LF
+         * if no line has ended yet.
+         */
+        LineEnding ending() const;
+
+        /**
+         * Returns true if all the lines read were well formed UTF-8.
+         */
+        bool utf8() const;
+
+    private:
+        std::string path_;
+        Buffer& buffer_;
+        int fd_;
+        int inotify_;
+        int fileWatch_;
+        dev_t device_;
+        ino_t inode_;
+        std::uint64_t offset_;
+        bool behind_;
+        bool ended_;
+        LineEnding ending_;
+        bool utf8_;
+        std::unique_ptr<IoBackend> backend_;
+
+        //the unfinished last line.
+        std::wstring partial_;
+        Utf8Decoder decoder_;
+
+        /**
+         * Open the file at the path and watch it, in place of any file
+         * followed before.
+         */
+        void openFile();
+
+        /**
+         * Close the file being followed.
+         */
+        void closeFile();
+
+        /**
+         * Read the pending inotify events, which only wake pollers.
+         */
+        void drainEvents();
+
+        /**
+         * Returns true if the path now names a file other than the one being
+         * followed.
+         */
+        bool replaced() const;
+
+        /**
+         * Split the bytes read into lines, appending the complete ones to the
+         * given list.
+         */
+        void split(const char* data, std::size_t size, Buffer::LineList& lines);
+
+        /**
+         * Append the unfinished last line to the given list as it stands.
+         */
+        void endLine(Buffer::LineList& lines);
+
+        FileFollower(const FileFollower&) = delete;
+        FileFollower& operator=(const FileFollower&) = delete;
+    };
+}
+
+#endif //VIX_FILE_FOLLOWER_HEADER_GUARD
@@ -0,0 +1,40 @@
+#ifndef  VIX_FOLD_HEADER_GUARD
+# define VIX_FOLD_HEADER_GUARD
+
+#include <cstddef>
+
+namespace vix
+{
+    /**
+     * A Fold covers a range of at least two lines.  When closed, the fold is
+     * displayed as its first line alone, and the rest of its lines are
+     * hidden.  Folds nest: two folds are either disjoint, or one lies within
+     * the other.
+     */
+    struct Fold
+    {
+        /**
+         * The index of the first line in the fold.
+         */
+        std::size_t first;
+
+        /**
+         * The index of the last line in the fold.
+         */
+        std::size_t last;
+
+        /**
+         * True if the fold is closed.
+         */
+        bool closed;
+
+        /**
+         * Two folds are equal if they cover the same lines and are in the
+         * same state.
+         */
+        bool operator==(const Fold& other) const;
+        bool operator!=(const Fold& other) const;
+    };
+}
+
+#endif //VIX_FOLD_HEADER_GUARD
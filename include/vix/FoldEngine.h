@@ -0,0 +1,281 @@
+#ifndef  VIX_FOLD_ENGINE_HEADER_GUARD
+# define VIX_FOLD_ENGINE_HEADER_GUARD
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vix/Buffer.h>
+#include <vix/CancellationToken.h>
+#include <vix/Fold.h>
+#include <vix/FoldException.h>
+#include <vix/LineRowMap.h>
+#include <vix/TaskScheduler.h>
+
+namespace vix
+{
+    /**
+     * A FoldEngine holds the folds of a buffer, and maps between the buffer's
+     * lines and the rows they are displayed on.  It must be registered with
+     * the buffer as a synchronous observer, and moves its folds with every
+     * change to the buffer: lines inserted within a fold grow it, and a fold
+     * whose first line is erased goes with it.
+     *
+     * Folds are held in a treap ordered by first line, outermost first, with
+     * each subtree keeping the furthest last line of its open and of its
+     * closed folds, so the folds containing a line are found without visiting
+     * the others.  Moving every fold after a change is a single lazy shift.
+     * Together with a LineRowMap of the lines hidden by closed folds, every
+     * operation is O(log n), apart from the folds directly affected.
+     *
+     * Indent folds are computed from a copy of the buffer's lines in the
+     * background, and installed by poll once ready, unless the buffer has
+     * changed in the meantime.
+     */
+    class FoldEngine : public BufferChangeObserver
+    {
+    public:
+
+        /**
+         * Create an engine with no folds for the given buffer, which must
+         * outlive it.
+         *
+         * \param buffer        The buffer the folds belong to.
+         * \param scheduler     The scheduler which computes indent folds.
+         */
+        explicit FoldEngine(
+            const Buffer& buffer,
+            TaskScheduler& scheduler = TaskScheduler::standard());
+
+        /**
+         * Destructor.  Wait for any indent folds being computed.
+         */
+        ~FoldEngine();
+
+        /**
+         * Move the folds to follow the buffer's last change.
+         */
+        virtual void onBufferChanged(const Buffer* changedBuffer);
+
+        /**
+         * Add a fold.
+         *
+         * \throw vix::exception::FoldRange if the fold covers fewer than two
+         *        lines, or lines past the end of the buffer.
+         * \throw vix::exception::FoldOverlap if the fold already exists, or
+         *        partly overlaps another.
+         */
+        void add(std::size_t first, std::size_t last, bool closed = true);
+
+        /**
+         * Remove the innermost fold containing a line.
+         *
+         * \returns false if no fold contains the line.
+         */
+        bool remove(std::size_t line);
+
+        /**
+         * Open the outermost closed fold containing a line, as vi's zo does.
+         *
+         * \returns false if no closed fold contains the line.
+         */
+        bool open(std::size_t line);
+
+        /**
+         * Close the innermost open fold containing a line, as vi's zc does.
+         *
+         * \returns false if no open fold contains the line.
+         */
+        bool close(std::size_t line);
+
+        /**
+         * Remove every fold.
+         */
+        void clear();
+
+        /**
+         * Replace every fold with the given folds.  A fold which already
+         * exists keeps its state; the others are added as given.
+         *
+         * \throw vix::exception::Fold if a fold can't be added, in which case
+         *        the folds before it have been.
+         */
+        void assign(const std::vector<Fold>& folds);
+
+        /**
+         * Find the innermost fold containing a line.
+         *
+         * \returns false if no fold contains the line.
+         */
+        bool find(std::size_t line, Fold& fold) const;
+
+        /**
+         * Returns every fold, in order of first line, outermost first.
+         */
+        std::vector<Fold> folds() const;
+
+        /**
+         * Returns the number of folds.
+         */
+        std::size_t size() const;
+
+        /**
+         * Returns true if a line is hidden by a closed fold.
+         */
+        bool hidden(std::size_t line) const;
+
+        /**
+         * Returns the row a line is displayed on.  A hidden line is displayed
+         * on the row of the fold hiding it.
+         */
+        std::size_t row(std::size_t line) const;
+
+        /**
+         * Returns the line displayed on a row, or the number of lines if the
+         * row is past the last.
+         */
+        std::size_t line(std::size_t row) const;
+
+        /**
+         * Returns the number of rows the buffer is displayed on.
+         */
+        std::size_t rows() const;
+
+        /**
+         * Returns the number of lines in the buffer.
+         */
+        std::size_t lines() const;
+
+        /**
+         * Start computing indent folds for the buffer as it is now, in the
+         * background.  The lines are copied by a task rather than on the
+         * editing thread, and not at all if the buffer changes again first;
+         * the copies share their contents with the buffer's lines.  If the
+         * buffer has no asynchronous observers yet, the first computation
+         * makes their copy of the lines on the calling thread, in time
+         * proportional to the number of lines; see Buffer::readLines.  A
+         * computation still running for an earlier version of the buffer
+         * gives up.
+         *
+         * \param shiftWidth    The indent of each fold level; zero uses the
+         *                      tab stop.
+         * \param tabStop       The width of a tab.
+         */
+        void computeIndentFolds(std::size_t shiftWidth, std::size_t tabStop = 8);
+
+        /**
+         * Install the indent folds computed in the background, if they are
+         * ready and the buffer hasn't changed since they were started.
+         *
+         * \returns true if folds were installed.
+         */
+        bool poll();
+
+        /**
+         * Wait until no indent folds are being computed.
+         */
+        void wait();
+
+    private:
+
+        /**
+         * A fold, and the subtree it heads.
+         */
+        struct Node
+        {
+            std::size_t first;
+            std::size_t last;
+            bool closed;
+            std::uint32_t priority;
+            std::unique_ptr<Node> left;
+            std::unique_ptr<Node> right;
+
+            //one past the furthest last line of the subtree's open and
+            //closed folds, or zero if there are none.
+            std::size_t reach[2];
+
+            //added to the lines of both children, but not yet passed down.
+            std::size_t shift;
+        };
+
+        /**
+         * Indent folds computed in the background.
+         */
+        struct Computed
+        {
+            std::uint64_t version;
+            std::vector<Fold> folds;
+        };
+
+        const Buffer& buffer_;
+        TaskScheduler& scheduler_;
+        LineRowMap rows_;
+        std::unique_ptr<Node> root_;
+        std::size_t size_;
+        std::uint32_t seed_;
+
+        //guards everything below, which background computations share.
+        std::mutex mutex_;
+        std::condition_variable idle_;
+        std::size_t computing_;
+        std::unique_ptr<Computed> computed_;
+
+        FoldEngine(const FoldEngine&) = delete;
+        FoldEngine& operator=(const FoldEngine&) = delete;
+
+        void insertLines(std::size_t line, std::size_t count);
+        void eraseLines(std::size_t line, std::size_t count);
+
+        void insertFold(const Fold& fold);
+        void extract(std::unique_ptr<Node>& tree, std::size_t first, std::size_t last);
+        void coverFold(const Fold& fold, int delta);
+        std::size_t discard(const Node* node, std::size_t shift);
+
+        std::unique_ptr<Node> merge(std::unique_ptr<Node> left, std::unique_ptr<Node> right);
+        static void split(
+            std::unique_ptr<Node> node, std::size_t first, std::size_t last,
+            std::unique_ptr<Node>& left, std::unique_ptr<Node>& right);
+
+        static void update(Node* node);
+        static void apply(Node* node, std::size_t delta);
+        static void push(Node* node);
+        static std::size_t reach(const Node* node, int states);
+
+        static bool innermost(
+            const Node* node, std::size_t shift, std::size_t line,
+            std::size_t bound, int states, Fold& fold);
+        static bool outermost(
+            const Node* node, std::size_t shift, std::size_t line, int states,
+            Fold& fold);
+        static bool contains(
+            const Node* node, std::size_t shift, std::size_t first,
+            std::size_t last, Fold& fold);
+        static void collect(
+            const Node* node, std::size_t shift, std::size_t line,
+            std::vector<Fold>& folds);
+        static void stretch(Node* node, std::size_t line, std::size_t count);
+    };
+
+    /**
+     * indentFolds computes folds from the indent of each line, as vi's indent
+     * fold method does.  A line's fold level is its indent divided by the
+     * shift width, and a blank line takes the lower level of the lines either
+     * side of it.  Each run of two or more lines at or above a level is a
+     * fold, closed.
+     *
+     * \param lines         The lines to fold.
+     * \param shiftWidth    The indent of each fold level; zero uses the tab
+     *                      stop.
+     * \param tabStop       The width of a tab.
+     * \param token         Checked now and then; once cancelled, the folds
+     *                      found so far are returned.
+     */
+    std::vector<Fold> indentFolds(
+        const std::list<Line>& lines, std::size_t shiftWidth,
+        std::size_t tabStop = 8, CancellationToken token = CancellationToken());
+}
+
+#endif //VIX_FOLD_ENGINE_HEADER_GUARD
@@ -0,0 +1,31 @@
+#ifndef  VIX_FOLD_EXCEPTION_HEADER_GUARD
+# define VIX_FOLD_EXCEPTION_HEADER_GUARD
+
+#include <stdexcept>
+#include <string>
+#include <vix/ExceptionSpecification.h>
+
+namespace vix
+{
+    namespace exception
+    {
+        /**
+         * The Fold exception occurs when a fold can't be created.
+         */
+        EXCEPTION_SPECIFICATION(Fold, std::runtime_error);
+
+        /**
+         * The FoldRange exception occurs when a fold doesn't cover at least
+         * two lines of the buffer.
+         */
+        EXCEPTION_SPECIFICATION(FoldRange, Fold);
+
+        /**
+         * The FoldOverlap exception occurs when a fold would partly overlap
+         * another, rather than containing it or lying within it.
+         */
+        EXCEPTION_SPECIFICATION(FoldOverlap, Fold);
+    }
+}
+
+#endif //VIX_FOLD_EXCEPTION_HEADER_GUARD
@@ -0,0 +1,91 @@
+#ifndef  VIX_INSERT_TEXT_COMMAND_HEADER_GUARD
+# define VIX_INSERT_TEXT_COMMAND_HEADER_GUARD
+
+#include <cstddef>
+#include <string>
+#include <vix/Command.h>
+#include <vix/CommandException.h>
+
+namespace vix
+{
+    /**
+     * An InsertTextCommand inserts text into a line at a given column.  A
+     * command inserting text straight after this command's text merges into
+     * it, as does a command erasing the end of this command's text, so that
+     * typing, with corrections, becomes a single command.  Text is serialized
+     * as UTF-8, and positions as varints.
+     */
+    class InsertTextCommand : public Command
+    {
+    public:
+
+        /**
+         * Create a command inserting text at the given line and column.
+         */
+        InsertTextCommand(std::size_t line = 0, std::size_t column = 0, const std::wstring& text = std::wstring());
+
+        /**
+         * Returns the line into which text is inserted.
+         */
+        std::size_t line() const;
+
+        /**
+         * Returns the column at which text is inserted.
+         */
+        std::size_t column() const;
+
+        /**
+         * Returns the inserted text.
+         */
+        const std::wstring& text() const;
+
+        /**
+         * Insert the text.
+         *
+         * \throw vix::exception::CommandRange if the position is outside the
+         *        buffer.
+         */
+        virtual void apply(std::weak_ptr<Buffer> buffer);
+
+        /**
+         * Remove the inserted text.
+         *
+         * \throw vix::exception::CommandRange if the position is outside the
+         *        buffer.
+         */
+        virtual void revert(std::weak_ptr<Buffer> buffer);
+
+        /**
+         * Returns true if the given command inserts text straight after this
+         * command's text, or erases the end of this command's text.
+         */
+        virtual bool canMerge(const Command& next) const;
+
+        /**
+         * Merge an insertion straight after this command's text, or an
+         * erasure of the end of this command's text.
+         */
+        virtual bool merge(const Command& next);
+
+        /**
+         * Replace this command with one read from a binary input stream.
+         *
+         * \throw vix::exception::SerialRead if serialization fails.
+         */
+        virtual void serialRead(std::istream& in);
+
+        /**
+         * Write this command to a binary output stream.
+         *
+         * \throw vix::exception::SerialWrite if serialization fails.
+         */
+        virtual void serialWrite(std::ostream& out) const;
+
+    private:
+        std::size_t line_;
+        std::size_t column_;
+        std::wstring text_;
+    };
+}
+
+#endif //VIX_INSERT_TEXT_COMMAND_HEADER_GUARD
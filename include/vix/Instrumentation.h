@@ -0,0 +1,310 @@
+#ifndef  VIX_INSTRUMENTATION_HEADER_GUARD
+# define VIX_INSTRUMENTATION_HEADER_GUARD
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vix
+{
+    /**
+     * Forward declaration for BufferChangeObserver.
+     */
+    class BufferChangeObserver;
+
+    /**
+     * The counters kept by Instrumentation.
+     */
+    enum InstrumentedCounter
+    {
+        /**
+         * Journal records, and the bytes of their frames, written and read.
+         */
+        COUNTER_JOURNAL_RECORDS_WRITTEN,
+        COUNTER_JOURNAL_BYTES_WRITTEN,
+        COUNTER_JOURNAL_RECORDS_READ,
+        COUNTER_JOURNAL_BYTES_READ,
+
+        /**
+         * Buffer snapshots, and their bytes, written and read.
+         */
+        COUNTER_SNAPSHOTS_WRITTEN,
+        COUNTER_SNAPSHOT_BYTES_WRITTEN,
+        COUNTER_SNAPSHOTS_READ,
+        COUNTER_SNAPSHOT_BYTES_READ,
+
+        /**
+         * Heap allocations, and the bytes asked for.  These are only counted
+         * when libvix is built with VIX_TRACK_ALLOCATIONS defined, which
+         * replaces the global operator new for any program using
+         * AllocationTracker.
+         */
+        COUNTER_ALLOCATIONS,
+        COUNTER_ALLOCATED_BYTES,
+
+        /**
+         * Lines stepped over to find a line's index, or the line at an index,
+         * by a Buffer or the dispatcher of its asynchronous observers.
+         */
+        COUNTER_LINES_WALKED,
+
+        /**
+         * The number of counters.
+         */
+        INSTRUMENTED_COUNTERS
+    };
+
+    /**
+     * The operations timed by Instrumentation.  Each Buffer mutator is timed
+     * including the observers it notifies, and TIMER_BUFFER_NOTIFY times
+     * the synchronous observers alone.
+     */
+    enum InstrumentedTimer
+    {
+        TIMER_BUFFER_INSERT,
+        TIMER_BUFFER_APPEND,
+        TIMER_BUFFER_ERASE,
+        TIMER_BUFFER_REPLACE,
+        TIMER_BUFFER_ASSIGN,
+        TIMER_BUFFER_CLEAR,
+        TIMER_BUFFER_NOTIFY,
+
+        /**
+         * The number of timers.
+         */
+        INSTRUMENTED_TIMERS
+    };
+
+    /**
+     * The latencies recorded by a timer, or by anything else which wants
+     * their percentiles, such as the trace replay harness, in nanoseconds.
+     * Latencies are counted in buckets a quarter of a power of two wide, and
+     * percentiles are rounded up to the top of a bucket, so they never
+     * understate the true value, and overstate it by less than a quarter.
+     * Counting one costs a few instructions.
+     */
+    struct LatencyStatistics
+    {
+        /**
+         * The number of buckets latencies are counted in.
+         */
+        static const std::size_t BUCKETS;
+
+        /**
+         * Returns the bucket the given latency is counted in.
+         */
+        static std::size_t bucketOf(std::uint64_t nanoseconds);
+
+        /**
+         * Returns the largest latency counted in the given bucket.
+         */
+        static std::uint64_t bucketTop(std::size_t bucket);
+
+        /**
+         * Create empty statistics.
+         */
+        LatencyStatistics();
+
+        /**
+         * The number of latencies recorded.
+         */
+        std::uint64_t count;
+
+        /**
+         * The sum of the latencies recorded.
+         */
+        std::uint64_t total;
+
+        /**
+         * The largest latency recorded.
+         */
+        std::uint64_t max;
+
+        /**
+         * The number of latencies in each bucket.
+         */
+        std::vector<std::uint64_t> buckets;
+
+        /**
+         * Count a latency.
+         */
+        void record(std::uint64_t nanoseconds);
+
+        /**
+         * Returns the mean latency.
+         */
+        double mean() const;
+
+        /**
+         * Returns the latency which the given fraction of latencies are at or
+         * below, rounded up to the top of its bucket.
+         */
+        std::uint64_t percentile(double fraction) const;
+
+        /**
+         * Add the latencies of other statistics to these.
+         */
+        void merge(const LatencyStatistics& other);
+    };
+
+    /**
+     * The counters and latencies recorded by every thread, at one moment.
+     */
+    struct InstrumentationSnapshot
+    {
+        /**
+         * Each counter, indexed by InstrumentedCounter.
+         */
+        std::vector<std::uint64_t> counters;
+
+        /**
+         * Each timer, indexed by InstrumentedTimer.
+         */
+        std::vector<LatencyStatistics> timers;
+
+        /**
+         * The time taken by each synchronous buffer observer, by its name
+         * and address, so two observers of one class are told apart.
+         * Observers beyond the number each thread can tell apart between
+         * resets are counted together as "(other)".
+         */
+        std::map<std::string, LatencyStatistics> observers;
+
+        /**
+         * Write the snapshot as a JSON object.
+         */
+        void writeJson(std::ostream& out) const;
+
+        /**
+         * Write the snapshot as text tables, for people.
+         */
+        void writeText(std::ostream& out) const;
+    };
+
+    /**
+     * Instrumentation counts and times what libvix does on its hot paths, so
+     * a hitch in the editor can be explained after the fact.  It is off until
+     * enabled, and then each thread records into its own counters without
+     * locking or sharing cache lines with other threads, and a snapshot
+     * gathers them up.  Threads which finish have their counts kept.
+     *
+     * While it is off, each instrumented operation costs one relaxed load
+     * and a well predicted branch.  Defining VIX_NO_INSTRUMENTATION when
+     * building compiles the checks, and everything they guard, away.
+     */
+    class Instrumentation
+    {
+    public:
+
+        /**
+         * Returns true if instrumentation is recording.
+         */
+        static bool enabled()
+        {
+#ifdef VIX_NO_INSTRUMENTATION
+            return false;
+#else
+            return enabled_.load(std::memory_order_relaxed);
+#endif
+        }
+
+        /**
+         * Start or stop recording.
+         */
+        static void enable(bool enabled);
+
+        /**
+         * Add to a counter, if enabled.
+         */
+        static void count(InstrumentedCounter counter, std::uint64_t amount = 1)
+        {
+            if (enabled())
+                add(counter, amount);
+        }
+
+        /**
+         * Record the latency of an operation, in nanoseconds.
+         */
+        static void record(InstrumentedTimer timer, std::uint64_t nanoseconds);
+
+        /**
+         * Record the time taken by a call to an observer, in nanoseconds.
+         */
+        static void record(const BufferChangeObserver& observer, std::uint64_t nanoseconds);
+
+        /**
+         * Returns what every thread has recorded since the last reset.
+         */
+        static InstrumentationSnapshot snapshot();
+
+        /**
+         * Zero every counter and timer, and forget the observers seen so
+         * far, so that as many new observers can be told apart as before.
+         * Anything recorded while the reset is under way may be partly kept.
+         */
+        static void reset();
+
+    private:
+        static std::atomic<bool> enabled_;
+
+        static void add(InstrumentedCounter counter, std::uint64_t amount);
+    };
+
+    /**
+     * An InstrumentationTimer times its own lifetime, as the latency of an
+     * operation or of an observer, if instrumentation is enabled when it is
+     * created.
+     */
+    class InstrumentationTimer
+    {
+    public:
+
+        /**
+         * Time an operation.
+         */
+        explicit InstrumentationTimer(InstrumentedTimer timer)
+            : timer_(timer), observer_(nullptr), running_(Instrumentation::enabled())
+        {
+            if (running_)
+                start_ = std::chrono::steady_clock::now();
+        }
+
+        /**
+         * Time an observer.
+         */
+        explicit InstrumentationTimer(const BufferChangeObserver& observer)
+            : timer_(INSTRUMENTED_TIMERS), observer_(&observer),
+              running_(Instrumentation::enabled())
+        {
+            if (running_)
+                start_ = std::chrono::steady_clock::now();
+        }
+
+        /**
+         * Destructor.  Record the time since construction.
+         */
+        ~InstrumentationTimer()
+        {
+            if (running_)
+                stop();
+        }
+
+    private:
+        InstrumentedTimer timer_;
+        const BufferChangeObserver* observer_;
+        bool running_;
+        std::chrono::steady_clock::time_point start_;
+
+        void stop();
+
+        InstrumentationTimer(const InstrumentationTimer&) = delete;
+        InstrumentationTimer& operator=(const InstrumentationTimer&) = delete;
+    };
+}
+
+#endif //VIX_INSTRUMENTATION_HEADER_GUARD
@@ -0,0 +1,145 @@
+#ifndef  VIX_IO_BACKEND_HEADER_GUARD
+# define VIX_IO_BACKEND_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <vix/FileException.h>
+
+namespace vix
+{
+    /**
+     * An IoBackend reads and writes files through a fixed set of staging
+     * buffers, each with at most one read or write in flight.  Reads and
+     * writes are queued, handed to the operating system together by submit,
+     * and run while the caller gets on with something else, until it waits
+     * for the buffer.
+     *
+     * On Linux, the backend uses io_uring, with the staging buffers
+     * registered with the kernel, so a batch of reads and writes costs a
+     * single system call and no copies into the kernel's own buffers.  Where
+     * io_uring isn't available, a backend which reads and writes each buffer
+     * as it is queued, with pread and pwrite, stands in for it.
+     *
+     * A backend is used by one thread at a time.
+     */
+    class IoBackend
+    {
+    public:
+
+        /**
+         * The default number of staging buffers.
+         */
+        static const std::size_t DEFAULT_BUFFERS;
+
+        /**
+         * The default size of each staging buffer.
+         */
+        static const std::size_t DEFAULT_BUFFER_SIZE;
+
+        /**
+         * Returns the fastest backend available, with the given number of
+         * staging buffers of the given size.
+         */
+        static std::unique_ptr<IoBackend> create(
+            std::size_t buffers = DEFAULT_BUFFERS,
+            std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+        /**
+         * Returns a backend which reads and writes each buffer as it is
+         * queued, with the given number of staging buffers of the given size.
+         */
+        static std::unique_ptr<IoBackend> blocking(
+            std::size_t buffers = DEFAULT_BUFFERS,
+            std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+        /**
+         * Destructor.
+         */
+        virtual ~IoBackend();
+
+        /**
+         * Returns the number of staging buffers.
+         */
+        std::size_t buffers() const;
+
+        /**
+         * Returns the size of each staging buffer.
+         */
+        std::size_t bufferSize() const;
+
+        /**
+         * Returns the staging buffer with the given index, which mustn't be
+         * touched while a read or write is in flight on it.
+         */
+        char* buffer(std::size_t index);
+
+        /**
+         * Queue a read from a file into a staging buffer with nothing in
+         * flight.
+         *
+         * \param fd            The file, which must stay open until the read
+         *                      is waited for.
+         * \param index         The index of the buffer.
+         * \param size          The number of bytes to read, at most the size
+         *                      of the buffer.
+         * \param offset        Where in the file to read from.
+         */
+        virtual void read(int fd, std::size_t index, std::size_t size, std::uint64_t offset) = 0;
+
+        /**
+         * Queue a write to a file from a staging buffer with nothing in
+         * flight.  The whole of the given size is written.
+         *
+         * \param fd            The file, which must stay open until the write
+         *                      is waited for.
+         * \param index         The index of the buffer.
+         * \param size          The number of bytes to write, at most the size
+         *                      of the buffer.
+         * \param offset        Where in the file to write to.
+         */
+        virtual void write(int fd, std::size_t index, std::size_t size, std::uint64_t offset) = 0;
+
+        /**
+         * Hand everything queued to the operating system, without waiting for
+         * any of it.
+         */
+        virtual void submit() = 0;
+
+        /**
+         * Wait for the read or write in flight on a staging buffer, submitting
+         * anything still queued first.
+         *
+         * \returns the number of bytes transferred, which for a read is less
+         *          than asked for at the end of the file.
+         *
+         * \throw vix::exception::FileRead if the read failed.
+         * \throw vix::exception::FileWrite if the write failed.
+         */
+        virtual std::size_t wait(std::size_t index) = 0;
+
+        /**
+         * Returns true if reads and writes run while the caller does
+         * something else.
+         */
+        virtual bool asynchronous() const = 0;
+
+    protected:
+
+        /**
+         * Allocate the given number of staging buffers of the given size.
+         */
+        IoBackend(std::size_t buffers, std::size_t bufferSize);
+
+    private:
+        std::size_t buffers_;
+        std::size_t bufferSize_;
+        std::vector<char> storage_;
+
+        IoBackend(const IoBackend&) = delete;
+        IoBackend& operator=(const IoBackend&) = delete;
+    };
+}
+
+#endif //VIX_IO_BACKEND_HEADER_GUARD
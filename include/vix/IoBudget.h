@@ -0,0 +1,52 @@
+#ifndef  VIX_IO_BUDGET_HEADER_GUARD
+# define VIX_IO_BUDGET_HEADER_GUARD
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace vix
+{
+    /**
+     * An IoBudget limits the rate at which background work writes to disk, so
+     * that checkpointing and compaction don't starve the editor of IO.  It is
+     * a token bucket: up to burst bytes can be written at once, after which
+     * writers are held back to the configured rate.  A rate of zero means the
+     * budget is unlimited.
+     */
+    class IoBudget
+    {
+    public:
+
+        /**
+         * Create a budget allowing the given number of bytes per second.  The
+         * burst defaults to one second's worth of writes.
+         */
+        explicit IoBudget(std::uint64_t bytesPerSecond = 0, std::uint64_t burst = 0);
+
+        /**
+         * Returns the number of bytes per second allowed, or zero if the
+         * budget is unlimited.
+         */
+        std::uint64_t rate() const;
+
+        /**
+         * Spend the given number of bytes, blocking the calling thread until
+         * the budget allows them.
+         */
+        void consume(std::uint64_t bytes);
+
+    private:
+        typedef
+        std::chrono::steady_clock
+        clock;
+
+        std::mutex mutex_;
+        double rate_;
+        double burst_;
+        double tokens_;
+        clock::time_point refilled_;
+    };
+}
+
+#endif //VIX_IO_BUDGET_HEADER_GUARD
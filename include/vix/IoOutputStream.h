@@ -0,0 +1,85 @@
+#ifndef  VIX_IO_OUTPUT_STREAM_HEADER_GUARD
+# define VIX_IO_OUTPUT_STREAM_HEADER_GUARD
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <vix/IoBackend.h>
+
+namespace vix
+{
+    /**
+     * An IoOutputStream writes to a file through an IoBackend, so anything
+     * which writes to a stream can write a file without a system call per
+     * write.  Writes go straight into the backend's staging buffers, and a
+     * full buffer is written while the next one fills.  Buffers are written
+     * in order, one at a time, so a crash leaves the file cut short rather
+     * than with holes in it.
+     */
+    class IoOutputStream : public std::ostream
+    {
+    public:
+
+        /**
+         * Write to an open file, starting at the given offset.  The file must
+         * outlive the stream.
+         */
+        IoOutputStream(
+            int fd, std::uint64_t offset,
+            std::unique_ptr<IoBackend> backend = IoBackend::create());
+
+        /**
+         * Destructor.  Write out everything written, ignoring any errors.
+         */
+        ~IoOutputStream();
+
+        /**
+         * Returns the offset in the file of the next byte written.
+         */
+        std::uint64_t offset() const;
+
+    private:
+
+        /**
+         * The stream buffer's put area is a staging buffer.
+         */
+        class IoBuffer : public std::streambuf
+        {
+        public:
+            IoBuffer(int fd, std::uint64_t offset, std::unique_ptr<IoBackend> backend);
+
+            std::uint64_t offset() const;
+
+        protected:
+            virtual int_type overflow(int_type c);
+            virtual int sync();
+
+        private:
+            int fd_;
+            std::unique_ptr<IoBackend> backend_;
+            std::uint64_t offset_;
+            std::size_t current_;
+            std::size_t writing_;
+            std::size_t writingSize_;
+            bool inFlight_;
+
+            /**
+             * Start writing the current buffer, and move on to the next.
+             */
+            void writeCurrent();
+
+            /**
+             * Wait for the buffer being written.
+             */
+            void waitForWrite();
+        };
+
+        IoBuffer buffer_;
+
+        IoOutputStream(const IoOutputStream&) = delete;
+        IoOutputStream& operator=(const IoOutputStream&) = delete;
+    };
+}
+
+#endif //VIX_IO_OUTPUT_STREAM_HEADER_GUARD
@@ -0,0 +1,193 @@
+#ifndef  VIX_JOURNAL_HEADER_GUARD
+# define VIX_JOURNAL_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vix/FileException.h>
+#include <vix/SerialException.h>
+#include <vix/Serializable.h>
+#include <vix/StringRef.h>
+
+/**
+ * The Journal header file describes the framed, append-only journal format
+ * used to record Commands.  All integers are Big Endian.
+ *
+ *   header         magic "VIXJ", u16 version, u16 flags
+ *   frame          u32 CRC-32C, u32 payload length, u8 record type, payload
+ *   ...
+ *
+ * A frame's checksum covers everything in the frame after the checksum
+ * itself, so a torn or corrupted length is caught along with a corrupted
+ * payload.  Each frame can be validated on its own, which lets recovery scan
+ * a mapped journal front to back, keep every record up to the first bad
+ * frame, and cut the journal off there.
+ */
+namespace vix
+{
+    /**
+     * The magic number at the start of every journal.
+     */
+    const char JOURNAL_MAGIC[4] = {'V', 'I', 'X', 'J'};
+
+    /**
+     * The journal format version.
+     */
+    const std::uint16_t JOURNAL_VERSION = 1;
+
+    /**
+     * The size of the journal header.
+     */
+    const std::size_t JOURNAL_HEADER_SIZE = 8;
+
+    /**
+     * The size of the frame header preceding each record's payload.
+     */
+    const std::size_t JOURNAL_FRAME_HEADER_SIZE = 9;
+
+    /**
+     * The largest payload a single record can carry.  Anything claiming to be
+     * larger is treated as corruption.
+     */
+    const std::uint32_t JOURNAL_MAX_RECORD_SIZE = 1U << 30;
+
+    /**
+     * The type of records holding a serialized Command.  Type zero is never
+     * written, so a zero filled tail never looks like a record.
+     */
+    const std::uint8_t JOURNAL_COMMAND = 1;
+
+    /**
+     * The type of records marking a checkpoint, as described in
+     * JournalCheckpoint.
+     */
+    const std::uint8_t JOURNAL_CHECKPOINT = 2;
+
+    /**
+     * The type of records holding a node of a saved undo tree, as described
+     * in UndoHistory.
+     */
+    const std::uint8_t JOURNAL_UNDO_NODE = 3;
+
+    /**
+     * The type of records marking the state of a saved undo tree and the
+     * contents of the file it belongs to, as described in UndoHistory.
+     */
+    const std::uint8_t JOURNAL_UNDO_STATE = 4;
+
+    /**
+     * A JournalRecord refers to a validated record within a journal held in
+     * memory.  The payload refers into the journal, which must outlive it.
+     */
+    struct JournalRecord
+    {
+        /**
+         * The offset of the record's frame within the journal.
+         */
+        std::size_t offset;
+
+        /**
+         * The record type.
+         */
+        std::uint8_t type;
+
+        /**
+         * The record payload.
+         */
+        StringRef payload;
+    };
+
+    /**
+     * The result of recovering a journal.
+     */
+    struct JournalRecovery
+    {
+        /**
+         * The number of valid records replayed.
+         */
+        std::size_t records;
+
+        /**
+         * The size of the journal after recovery.
+         */
+        std::size_t size;
+
+        /**
+         * The number of bytes cut off the end of the journal.
+         */
+        std::size_t discarded;
+    };
+
+    /**
+     * writeJournalHeader writes the header which starts a journal.
+     *
+     * \param out           The stream to which the header is written.
+     *
+     * \throw vix::exception::SerialWrite if the serial write fails.
+     */
+    void writeJournalHeader(std::ostream& out);
+
+    /**
+     * writeJournalRecord frames a raw payload as a record of the given type
+     * and writes the frame in a single write.
+     *
+     * \param out           The stream to which the record is written.
+     * \param type          The record type.
+     * \param payload       The payload.
+     * \param size          The size of the payload.
+     *
+     * \returns the size of the frame.
+     *
+     * \throw vix::exception::SerialWrite if the record is too large or the
+     *        serial write fails.
+     */
+    std::size_t writeJournalRecord(std::ostream& out, std::uint8_t type, const void* payload, std::size_t size);
+
+    /**
+     * writeJournalRecord frames a serialized object as a record of the given
+     * type and writes the frame in a single write.
+     *
+     * \param out           The stream to which the record is written.
+     * \param type          The record type.
+     * \param value         The object to write.
+     *
+     * \returns the size of the frame.
+     *
+     * \throw vix::exception::SerialWrite if the record is too large or the
+     *        serial write fails.
+     */
+    std::size_t writeJournalRecord(std::ostream& out, std::uint8_t type, const Serializable& value);
+
+    /**
+     * readJournalRecord reads a serializable object from the payload of a
+     * journal record, without copying the payload.
+     *
+     * \param record        The record to read.
+     * \param value         The object to read.
+     *
+     * \throw vix::exception::SerialRead if the serial read fails.
+     */
+    void readJournalRecord(const JournalRecord& record, Serializable& value);
+
+    /**
+     * recoverJournal scans the journal at the given path, passes each valid
+     * record to the replay function in order, and truncates the journal just
+     * past the last valid record if anything follows it.  Nothing before the
+     * first bad frame is discarded.
+     *
+     * \param path          The path of the journal.
+     * \param replay        The function called with each valid record.
+     *
+     * \throw vix::exception::FileOpen if the journal cannot be opened.
+     * \throw vix::exception::FileRead if the journal cannot be mapped.
+     * \throw vix::exception::FileWrite if the journal cannot be truncated.
+     * \throw vix::exception::SerialRead if the file is not a journal.
+     */
+    JournalRecovery recoverJournal(
+        const std::string& path,
+        const std::function<void(const JournalRecord&)>& replay);
+}
+
+#endif //VIX_JOURNAL_HEADER_GUARD
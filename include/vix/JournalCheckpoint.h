@@ -0,0 +1,83 @@
+#ifndef  VIX_JOURNAL_CHECKPOINT_HEADER_GUARD
+# define VIX_JOURNAL_CHECKPOINT_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vix/Buffer.h>
+#include <vix/Journal.h>
+#include <vix/Serializable.h>
+
+namespace vix
+{
+    /**
+     * A JournalCheckpoint record says that the buffer snapshot with the given
+     * sequence number holds the state of the buffer as of the given offset in
+     * the journal, so that only the records from that offset on need to be
+     * replayed on top of it.  The snapshot lives beside the journal, at the
+     * path given by checkpointSnapshotPath.
+     */
+    class JournalCheckpoint : virtual public Serializable
+    {
+    public:
+
+        /**
+         * The size of a serialized checkpoint.
+         */
+        static const std::size_t SERIAL_SIZE;
+
+        /**
+         * Create a checkpoint.
+         */
+        JournalCheckpoint(std::uint64_t sequence = 0, std::uint64_t offset = 0);
+
+        /**
+         * Returns the sequence number of the checkpoint's snapshot.
+         */
+        std::uint64_t sequence() const;
+
+        /**
+         * Returns the journal offset from which records are replayed.
+         */
+        std::uint64_t offset() const;
+
+        virtual void serialRead(std::istream& in);
+
+        virtual void serialWrite(std::ostream& out) const;
+
+    private:
+        std::uint64_t sequence_;
+        std::uint64_t offset_;
+    };
+
+    /**
+     * checkpointSnapshotPath returns the path of the snapshot with the given
+     * sequence number taken for the journal at the given path.
+     */
+    std::string checkpointSnapshotPath(const std::string& journalPath, std::uint64_t sequence);
+
+    /**
+     * loadJournal recovers the journal at the given path, loads the buffer
+     * from its latest checkpoint, if it has one, and replays the records
+     * written after that checkpoint.  Without a checkpoint, every record is
+     * replayed on top of the buffer as it is.
+     *
+     * \param path          The path of the journal.
+     * \param buffer        The buffer to load.
+     * \param replay        The function called with each record to replay.
+     * \param threads       The number of threads used to decode the snapshot.
+     *
+     * \returns the recovery of the journal, counting only replayed records.
+     *
+     * \throw vix::exception::File if the journal or snapshot can't be read, or
+     *        the journal can't be truncated.
+     * \throw vix::exception::SerialRead if the journal or snapshot is invalid.
+     */
+    JournalRecovery loadJournal(
+        const std::string& path, Buffer& buffer,
+        const std::function<void(const JournalRecord&)>& replay,
+        unsigned threads = 1);
+}
+
+#endif //VIX_JOURNAL_CHECKPOINT_HEADER_GUARD
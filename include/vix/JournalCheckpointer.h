@@ -0,0 +1,168 @@
+#ifndef  VIX_JOURNAL_CHECKPOINTER_HEADER_GUARD
+# define VIX_JOURNAL_CHECKPOINTER_HEADER_GUARD
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vix/Buffer.h>
+#include <vix/IoBudget.h>
+#include <vix/Journal.h>
+#include <vix/JournalWriter.h>
+#include <vix/Serializable.h>
+#include <vix/TaskScheduler.h>
+
+namespace vix
+{
+    /**
+     * A JournalCheckpointer owns the journal of an editing session.  Records
+     * are appended from the editing thread as usual.  A checkpoint has a task
+     * copy the buffer's lines, as they were when it was requested, so the
+     * editing thread never copies their contents, and hands the copy to a
+     * background task.  The copy shares its contents with the buffer's
+     * lines.  That task writes a snapshot, records the checkpoint in the
+     * journal, and then compacts the journal so it starts at the new
+     * checkpoint, optionally archiving the old journal first.  All background
+     * writes are charged to an IoBudget, and only one checkpoint runs at a
+     * time.  The editing thread only waits for the journal while the few
+     * records appended during compaction are copied across and the new
+     * journal is swapped in.
+     *
+     * If the buffer has no asynchronous observers yet, the first checkpoint
+     * makes their copy of the lines on the calling thread, in time
+     * proportional to the number of lines; see Buffer::readLines.
+     *
+     * The journal should be loaded with loadJournal, which also recovers it,
+     * before a checkpointer is created for it.
+     */
+    class JournalCheckpointer
+    {
+    public:
+
+        /**
+         * Open the journal at the given path, creating it if necessary.
+         *
+         * \param path          The path of the journal.
+         * \param bytesPerSecond The background IO budget; zero is unlimited.
+         * \param archive       Keep each journal replaced by compaction, and
+         *                      the snapshot it refers to, rather than deleting
+         *                      them.
+         * \param scheduler     The scheduler which runs checkpoints.
+         *
+         * \throw vix::exception::File if the journal can't be opened.
+         * \throw vix::exception::SerialRead if the file is not a journal.
+         */
+        JournalCheckpointer(
+            const std::string& path, std::uint64_t bytesPerSecond = 0,
+            bool archive = false,
+            TaskScheduler& scheduler = TaskScheduler::standard());
+
+        /**
+         * Destructor.  Finish any pending checkpoint.
+         */
+        ~JournalCheckpointer();
+
+        /**
+         * Append a record to the journal.
+         *
+         * \throw vix::exception::SerialWrite if the write fails.
+         */
+        void append(const Serializable& record, std::uint8_t type = JOURNAL_COMMAND);
+
+        /**
+         * Flush appended records to the operating system.
+         *
+         * \throw vix::exception::FileWrite if the flush fails.
+         */
+        void flush();
+
+        /**
+         * Checkpoint the buffer, which must reflect every record appended so
+         * far.  The snapshot and compaction run in the background; if another
+         * checkpoint is still waiting to start, it is replaced by this one.
+         *
+         * \throw any exception raised by a previous background checkpoint.
+         */
+        void checkpoint(const Buffer& buffer);
+
+        /**
+         * Wait until no checkpoint is pending or running.
+         *
+         * \throw any exception raised by a background checkpoint.
+         */
+        void wait();
+
+        /**
+         * Returns the archive path of the journal replaced by the checkpoint
+         * with the given sequence number.
+         */
+        std::string archivePath(std::uint64_t sequence) const;
+
+    private:
+        std::string path_;
+        IoBudget budget_;
+        bool archive_;
+        TaskScheduler& scheduler_;
+
+        //guards everything below; held only briefly by checkpoints.
+        std::mutex mutex_;
+        std::condition_variable idle_;
+        std::unique_ptr<JournalWriter> writer_;
+        std::shared_ptr<Buffer::LineList> pendingLines_;
+        std::uint64_t pendingOffset_;
+
+        //the latest checkpoint requested, and the offset its lines reflect,
+        //while its lines are still to be copied.
+        std::uint64_t requested_;
+        std::uint64_t requestedOffset_;
+        bool awaiting_;
+
+        bool busy_;
+        std::exception_ptr error_;
+
+        //only used by the checkpoint in progress.
+        std::uint64_t sequence_;
+
+        /**
+         * Run the pending checkpoint, as a task.
+         */
+        void run();
+
+        /**
+         * Snapshot the given lines, which reflect the journal up to the given
+         * offset, then compact the journal.
+         */
+        void runCheckpoint(Buffer::LineList& lines, std::uint64_t offset);
+
+        /**
+         * Replace the journal with one starting at the given checkpoint.
+         */
+        void compact(std::uint64_t sequence, std::uint64_t offset);
+
+        /**
+         * Copy the records from the given journal offset on, leaving out
+         * checkpoints, and return the offset of the end of the last record
+         * copied.  The offset and size of each checkpoint left out is added
+         * to skipped.
+         */
+        std::uint64_t copyRecords(
+            std::ostream& out, std::uint64_t offset,
+            std::vector<std::pair<std::uint64_t, std::uint64_t>>& skipped);
+
+        /**
+         * Rethrow a background error, if there has been one.  The mutex must
+         * be held.
+         */
+        void rethrowError();
+
+        JournalCheckpointer(const JournalCheckpointer&) = delete;
+        JournalCheckpointer& operator=(const JournalCheckpointer&) = delete;
+    };
+}
+
+#endif //VIX_JOURNAL_CHECKPOINTER_HEADER_GUARD
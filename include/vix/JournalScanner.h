@@ -0,0 +1,66 @@
+#ifndef  VIX_JOURNAL_SCANNER_HEADER_GUARD
+# define VIX_JOURNAL_SCANNER_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <vix/Journal.h>
+#include <vix/SerialException.h>
+
+namespace vix
+{
+    /**
+     * A JournalScanner walks the records of a journal held in memory, such as
+     * a MappedFile, validating each frame's checksum as it goes.  Scanning
+     * stops at the end of the journal or at the first frame which is torn or
+     * fails its checksum; corrupt() tells the two apart, and position() gives
+     * the offset just past the last valid record either way.
+     */
+    class JournalScanner
+    {
+    public:
+
+        /**
+         * Create a scanner over a journal.  An empty range is an empty
+         * journal, and a range too short to hold the header is a journal
+         * whose header was torn.
+         *
+         * \throw vix::exception::SerialRead if the range holds something other
+         *        than a journal.
+         */
+        JournalScanner(const void* data, std::size_t size);
+
+        /**
+         * Read the next valid record.
+         *
+         * \returns false at the end of the journal or at a bad frame.
+         */
+        bool next(JournalRecord& record);
+
+        /**
+         * Returns the offset just past the last valid record scanned.
+         */
+        std::size_t position() const;
+
+        /**
+         * Continue scanning from the given offset, which must be the start of
+         * a frame or the end of the journal, such as the offset recorded by a
+         * checkpoint.
+         *
+         * \throw vix::exception::SerialRead if the offset is out of range.
+         */
+        void position(std::size_t offset);
+
+        /**
+         * Returns true if scanning stopped at a torn or corrupt frame.
+         */
+        bool corrupt() const;
+
+    private:
+        const std::uint8_t* data_;
+        std::size_t size_;
+        std::size_t position_;
+        bool corrupt_;
+    };
+}
+
+#endif //VIX_JOURNAL_SCANNER_HEADER_GUARD
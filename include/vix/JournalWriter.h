@@ -0,0 +1,79 @@
+#ifndef  VIX_JOURNAL_WRITER_HEADER_GUARD
+# define VIX_JOURNAL_WRITER_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vix/FileException.h>
+#include <vix/IoOutputStream.h>
+#include <vix/Journal.h>
+#include <vix/Serializable.h>
+
+namespace vix
+{
+    /**
+     * A JournalWriter appends framed records to a journal file.  Records are
+     * framed in memory and collected in the staging buffers of an IoBackend,
+     * which hands them to the file in order, a buffer at a time, while more
+     * are appended.  A crash leaves at most one torn frame at the tail, which
+     * recoverJournal cuts off.  A journal should be recovered before it is
+     * opened for writing, so that new records don't land behind a torn one.
+     */
+    class JournalWriter
+    {
+    public:
+
+        /**
+         * Open a journal for appending, creating it if necessary.
+         *
+         * \throw vix::exception::FileOpen if the journal cannot be opened.
+         * \throw vix::exception::FileWrite if the header cannot be written.
+         */
+        explicit JournalWriter(const std::string& path);
+
+        /**
+         * Destructor.  Flush appended records, ignoring any errors, and close
+         * the journal.
+         */
+        ~JournalWriter();
+
+        /**
+         * Append a serialized object as a record of the given type.
+         *
+         * \throw vix::exception::SerialWrite if the record is too large or
+         *        the write fails.
+         */
+        void append(std::uint8_t type, const Serializable& record);
+
+        /**
+         * Append a raw payload as a record of the given type.
+         *
+         * \throw vix::exception::SerialWrite if the record is too large or
+         *        the write fails.
+         */
+        void append(std::uint8_t type, const void* payload, std::size_t size);
+
+        /**
+         * Flush appended records to the operating system.
+         *
+         * \throw vix::exception::FileWrite if the flush fails.
+         */
+        void flush();
+
+        /**
+         * Returns the size of the journal, including records not yet flushed.
+         */
+        std::uint64_t size() const;
+
+    private:
+        int fd_;
+        std::uint64_t size_;
+        std::unique_ptr<IoOutputStream> out_;
+
+        JournalWriter(const JournalWriter&) = delete;
+        JournalWriter& operator=(const JournalWriter&) = delete;
+    };
+}
+
+#endif //VIX_JOURNAL_WRITER_HEADER_GUARD
@@ -1,13 +1,36 @@
 #ifndef  VIX_LINE_HEADER_GUARD
 # define VIX_LINE_HEADER_GUARD
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vix/LineBlock.h>
 
 namespace vix
 {
     /**
-     * This represents a line in a buffer.  It is currently a simple wrapper
-     * around wstring.
+     * Forward declarations for Buffer, BufferChangeDispatcher,
+     * LineInternTable and UndoTree.
+     */
+    class Buffer;
+    class BufferChangeDispatcher;
+    class LineInternTable;
+    class UndoTree;
+
+    /**
+     * This represents a line in a buffer.  A line holds its string value
+     * itself, so copying a line copies its contents, unless the line has been
+     * interned, in which case it shares immutable, reference counted storage
+     * with the other lines holding the same contents, or is in a buffer with
+     * asynchronous observers, in which case it shares such storage with their
+     * copy of it, or compressed, in which case it refers to its contents in
+     * a LineBlock, and is decompressed, with the rest of the block, the first
+     * time it is read.  Either way, shared contents are never changed; a line
+     * holding them is given its own copy first.
+     *
+     * A line in a buffer is stamped with the buffer's version as of the
+     * change which put it there, so anything derived from a line can tell
+     * whether the line has changed since by comparing stamps.
      */
     class Line
     {
@@ -23,28 +46,146 @@ namespace vix
          */
         Line(const std::wstring&);
 
+        /**
+         * Construct a line, taking ownership of the given string value.
+         */
+        Line(std::wstring&&);
+
         /**
          * Copy constructor.
          */
         Line(const Line&);
 
+        /**
+         * Move constructor.  Moving never throws, so containers of lines
+         * move them rather than copying them when they grow.
+         */
+        Line(Line&&) noexcept;
+
         /**
          * Assignment operator.
          */
         const Line& operator=(const Line&);
 
         /**
-         * Get the wstring representation of this line.
+         * Move assignment operator.
+         */
+        const Line& operator=(Line&&) noexcept;
+
+        /**
+         * Destructor.
+         */
+        ~Line();
+
+        /**
+         * Get the wstring representation of this line.  Reading a compressed
+         * line decompresses it without changing the line, so lines can be
+         * read from any number of threads at once.  The reference stays valid
+         * until the line is given a new value or destroyed.
          */
         const std::wstring& str() const;
 
         /**
-         * Replace the contents of this line with the given wstring.
+         * Replace the contents of this line with the given wstring.  Any other
+         * line sharing storage with this line is unaffected.  The line loses
+         * its stamp.
          */
         void str(const std::wstring& str);
 
+        /**
+         * Returns true if the contents of this line are currently held only
+         * in compressed form.
+         */
+        bool compressed() const;
+
+        /**
+         * Returns true if this line shares its storage with the given line,
+         * which interned, compressed and observed lines can.
+         */
+        bool shares(const Line& other) const;
+
+        /**
+         * Returns the version of the buffer in which this line was last
+         * inserted or replaced, or zero if it has never been in a buffer, or
+         * has been given a new value since.  Copies of a line keep its stamp.
+         */
+        std::uint64_t stamp() const;
+
+        /**
+         * Two lines are equal if their string values are equal.  Lines which
+         * share storage compare equal without examining their contents.
+         */
+        bool operator==(const Line& other) const;
+        bool operator!=(const Line& other) const;
+
     private:
-        std::wstring str_;
+        /**
+         * How the contents of a line are held.
+         */
+        enum Storage
+        {
+            OWNED,
+            SHARED,
+            COMPRESSED
+        };
+
+        /**
+         * The place of a compressed line's contents in its block.
+         */
+        struct BlockLine
+        {
+            std::shared_ptr<LineBlock> block;
+            std::uint32_t index;
+        };
+
+        //only the member named by storage_ is alive, so a line takes no more
+        //room than a string and its stamp.
+        union
+        {
+            std::wstring str_;
+            std::shared_ptr<const std::wstring> shared_;
+            BlockLine block_;
+        };
+
+        std::uint64_t stamp_ : 62;
+        std::uint64_t storage_ : 2;
+
+        /**
+         * Take the contents of the given line, leaving it empty.
+         */
+        void take(Line& other) noexcept;
+
+        /**
+         * Destroy the contents of this line, leaving it with none.
+         */
+        void release() noexcept;
+
+        /**
+         * Hold the contents of this line itself, if it doesn't already, and
+         * return them for changing in place.
+         */
+        std::wstring& own();
+
+        /**
+         * Hold the contents of this line in the given shared storage.
+         */
+        void share(const std::shared_ptr<const std::wstring>& storage);
+
+        /**
+         * Hold the contents of this line at the given index of a block.
+         */
+        void compress(const std::shared_ptr<LineBlock>& block, std::uint32_t index);
+
+        /**
+         * Move the contents of this line into shared storage, if it holds its
+         * own and they are too long to copy cheaply, so its copies share them.
+         */
+        void publish();
+
+        friend class Buffer;
+        friend class BufferChangeDispatcher;
+        friend class LineInternTable;
+        friend class UndoTree;
     };
 }
 
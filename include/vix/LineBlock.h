@@ -0,0 +1,124 @@
+#ifndef  VIX_LINE_BLOCK_HEADER_GUARD
+# define VIX_LINE_BLOCK_HEADER_GUARD
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vix
+{
+    /**
+     * A LineBlock holds the contents of a run of lines, in compressed form
+     * once compress has been called, and decompressed for as long as any of
+     * them is being read.  A block never drops contents it has handed out, so
+     * references to them last as long as the block.  A block's owner instead
+     * replaces a block which has gone cold with the one returned by cold,
+     * which shares its compressed data, and is decompressed again the first
+     * time one of its lines is read.
+     */
+    class LineBlock
+    {
+    public:
+
+        /**
+         * Called when a block made by cold is decompressed, from whichever
+         * thread read it.
+         */
+        typedef
+        std::function<void(const LineBlock*)>
+        DecompressHandler;
+
+        /**
+         * Create a block holding the given line contents, which are moved out
+         * of the given vector.  The block is not compressed until compress is
+         * called.
+         */
+        LineBlock(std::vector<std::wstring>& lines);
+
+        /**
+         * Returns the number of lines in this block.
+         */
+        std::size_t lines() const;
+
+        /**
+         * Compress the contents of this block.  This is safe to call while
+         * the block is being read.
+         */
+        void compress();
+
+        /**
+         * Returns true once compress has finished.
+         */
+        bool compressed() const;
+
+        /**
+         * Returns the size of this block's compressed data in bytes, or zero
+         * if it has not been compressed.
+         */
+        std::size_t compressedSize() const;
+
+        /**
+         * Returns the contents of the line at the given index, decompressing
+         * the block if needed.  The reference stays valid for as long as this
+         * block exists.
+         *
+         * \throw vix::exception::Decompression if the block is corrupt.
+         */
+        const std::wstring& line(std::size_t index) const;
+
+        /**
+         * Returns true if this block's contents are decompressed.
+         */
+        bool decompressed() const;
+
+        /**
+         * Sweep this block.  A block which has not been read since the last
+         * sweep is cold.
+         *
+         * \returns true if the block is cold.
+         */
+        bool sweep();
+
+        /**
+         * Returns a new block sharing this one's compressed data, whose
+         * contents are only decompressed when one of its lines is read, at
+         * which point the given handler, if any, is called.  This block must
+         * have been compressed.
+         */
+        std::shared_ptr<LineBlock> cold(DecompressHandler handler = DecompressHandler()) const;
+
+    private:
+        /**
+         * The compressed contents of a block, which the blocks made from it
+         * by cold share.
+         */
+        struct Compressed
+        {
+            std::vector<std::uint8_t> data;
+            std::vector<std::uint32_t> ends;
+        };
+
+        /**
+         * Create a block from compressed contents.
+         */
+        LineBlock(std::shared_ptr<const Compressed> compressed, DecompressHandler handler);
+
+        std::size_t lines_;
+        mutable std::mutex mutex_;
+        std::shared_ptr<const Compressed> compressed_;
+        DecompressHandler handler_;
+
+        //the contents are only ever filled in once, so they can be read
+        //without the lock once they are.
+        mutable std::vector<std::wstring> contents_;
+        mutable std::atomic<bool> decompressed_;
+        mutable std::atomic<bool> accessed_;
+    };
+}
+
+#endif //VIX_LINE_BLOCK_HEADER_GUARD
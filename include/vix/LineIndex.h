@@ -0,0 +1,108 @@
+#ifndef  VIX_LINE_INDEX_HEADER_GUARD
+# define VIX_LINE_INDEX_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <vix/StringRef.h>
+
+namespace vix
+{
+    /**
+     * The ways a line may end.
+     */
+    enum LineEnding
+    {
+        LINE_ENDING_LF,
+        LINE_ENDING_CRLF,
+        LINE_ENDING_CR
+    };
+
+    /**
+     * A LineIndex finds the lines of a text held in memory, such as a mapped
+     * file, in a single pass which compares a vector of bytes at a time
+     * against the line ending characters.  Large texts are scanned in
+     * parallel, a part per thread, on the standard TaskScheduler.
+     *
+     * Lines end at each line feed, and a carriage return just before it is
+     * dropped from the line if carriage return line feeds are the most common
+     * ending.  A text with no line feeds at all ends its lines at carriage
+     * returns.  Text after the last line ending is a line of its own, and the
+     * text has no final line ending.
+     *
+     * The index refers to the text, which must outlive it.
+     */
+    class LineIndex
+    {
+    public:
+
+        /**
+         * The fewest bytes of text given to each thread which works on it,
+         * below which more threads don't pay for themselves.
+         */
+        static const std::size_t MIN_BYTES_PER_THREAD;
+
+        /**
+         * Index a text.
+         *
+         * \param data          The text.
+         * \param size          The size of the text in bytes.
+         * \param threads       The number of threads used to scan it.
+         */
+        LineIndex(const char* data, std::size_t size, unsigned threads = 1);
+
+        /**
+         * Returns the number of lines.
+         */
+        std::size_t lines() const;
+
+        /**
+         * Returns a line, without its ending.
+         */
+        StringRef line(std::size_t index) const;
+
+        /**
+         * Returns the index of the line holding the given byte of the text,
+         * or the number of lines if the byte is past the last line.
+         */
+        std::size_t lineAt(std::uint64_t offset) const;
+
+        /**
+         * Returns the most common line ending, or LINE_ENDING_LF if there
+         * are none.  LINE_ENDING_CR is only returned for a text whose lines
+         * end at carriage returns.
+         */
+        LineEnding ending() const;
+
+        /**
+         * Returns true if lines end in more than one way.  Lone carriage
+         * returns within lines which end at line feeds don't count.
+         */
+        bool mixed() const;
+
+        /**
+         * Returns the number of line endings of the given kind in the text.
+         * Lone carriage returns are counted even in a text whose lines end
+         * at line feeds.
+         */
+        std::uint64_t endings(LineEnding ending) const;
+
+        /**
+         * Returns true if the last line has an ending.
+         */
+        bool finalNewline() const;
+
+    private:
+        const char* data_;
+        std::size_t size_;
+
+        //the offset of the character ending each line.
+        std::vector<std::uint64_t> ends_;
+
+        std::uint64_t endings_[3];
+        LineEnding ending_;
+        char separator_;
+    };
+}
+
+#endif //VIX_LINE_INDEX_HEADER_GUARD
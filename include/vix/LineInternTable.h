@@ -0,0 +1,62 @@
+#ifndef  VIX_LINE_INTERN_TABLE_HEADER_GUARD
+# define VIX_LINE_INTERN_TABLE_HEADER_GUARD
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vix/Line.h>
+
+namespace vix
+{
+    /**
+     * The LineInternTable deduplicates the storage of lines with identical
+     * contents.  Interning a line makes it share the storage of any live line
+     * previously interned with the same contents.  The table only holds weak
+     * references, so storage is released once the last line using it is
+     * gone.
+     */
+    class LineInternTable
+    {
+    public:
+
+        /**
+         * Default constructor.  Create an empty intern table.
+         */
+        LineInternTable();
+
+        /**
+         * Intern the given line.  On return, the line shares storage with
+         * every other line in this table holding the same contents.
+         */
+        void intern(Line& line);
+
+        /**
+         * Returns the number of entries in this table, including entries whose
+         * storage has since been released but which have not yet been purged.
+         */
+        std::size_t size() const;
+
+        /**
+         * Remove all entries whose storage has been released.
+         */
+        void purge();
+
+        /**
+         * Remove all entries from this table.  Lines which were interned
+         * continue to share their storage.
+         */
+        void clear();
+
+    private:
+        typedef
+        std::unordered_multimap<
+            std::size_t, std::weak_ptr<const std::wstring>>
+        EntryMap;
+
+        EntryMap entries_;
+        std::size_t purgeThreshold_;
+    };
+}
+
+#endif //VIX_LINE_INTERN_TABLE_HEADER_GUARD
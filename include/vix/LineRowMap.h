@@ -0,0 +1,125 @@
+#ifndef  VIX_LINE_ROW_MAP_HEADER_GUARD
+# define VIX_LINE_ROW_MAP_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace vix
+{
+    /**
+     * A LineRowMap maps between the lines of a buffer and the rows they are
+     * displayed on when some lines are hidden by closed folds.  Each line has
+     * a cover count, which is the number of closed folds hiding it; a line is
+     * visible if its count is zero.  A hidden line is displayed on the row of
+     * the nearest visible line above it, which is the head of the fold
+     * hiding it.
+     *
+     * Lines are held as runs of consecutive lines with the same count, in a
+     * treap ordered by position, so inserting and erasing lines moves
+     * everything after them without touching it.  Each subtree keeps its
+     * number of lines, its lowest count and the number of lines with that
+     * count, from which the number of visible lines follows, and counts are
+     * changed over a range lazily.  Every operation is O(log n) in the number
+     * of runs.
+     */
+    class LineRowMap
+    {
+    public:
+
+        /**
+         * Create a map of the given number of visible lines.
+         */
+        explicit LineRowMap(std::size_t lines = 0);
+
+        /**
+         * Destructor.
+         */
+        ~LineRowMap();
+
+        /**
+         * Insert lines before the given line.  They are hidden by the folds
+         * hiding the line they are inserted before, so lines inserted inside
+         * a closed fold are hidden, and lines appended at the end are not.
+         */
+        void insert(std::size_t line, std::size_t count);
+
+        /**
+         * Erase lines starting at the given line.
+         */
+        void erase(std::size_t line, std::size_t count);
+
+        /**
+         * Add to the cover count of each line in a range, which is one for
+         * each fold closed over the range, and minus one for each opened.
+         */
+        void cover(std::size_t first, std::size_t last, int delta);
+
+        /**
+         * Returns the number of lines.
+         */
+        std::size_t lines() const;
+
+        /**
+         * Returns the number of rows, which is the number of visible lines.
+         */
+        std::size_t rows() const;
+
+        /**
+         * Returns true if a line is hidden.
+         */
+        bool hidden(std::size_t line) const;
+
+        /**
+         * Returns the row a line is displayed on.
+         */
+        std::size_t row(std::size_t line) const;
+
+        /**
+         * Returns the visible line displayed on a row, or the number of lines
+         * if the row is past the last.
+         */
+        std::size_t line(std::size_t row) const;
+
+    private:
+
+        /**
+         * A run of lines with the same cover count, and the subtree it heads.
+         */
+        struct Run
+        {
+            std::size_t length;
+            int count;
+            std::uint32_t priority;
+            std::unique_ptr<Run> left;
+            std::unique_ptr<Run> right;
+
+            //the subtree's lines, lowest count and lines with it.
+            std::size_t lines;
+            int lowest;
+            std::size_t lowestLines;
+
+            //added to the counts of both children, but not yet passed down.
+            int pending;
+        };
+
+        std::unique_ptr<Run> root_;
+        std::uint32_t seed_;
+
+        LineRowMap(const LineRowMap&) = delete;
+        LineRowMap& operator=(const LineRowMap&) = delete;
+
+        std::unique_ptr<Run> makeRun(std::size_t length, int count);
+
+        static void update(Run* run);
+        static void add(Run* run, int delta);
+        static void push(Run* run);
+        static std::size_t visible(const Run* run, int pending);
+
+        std::unique_ptr<Run> merge(std::unique_ptr<Run> left, std::unique_ptr<Run> right);
+        void split(std::unique_ptr<Run> run, std::size_t lines, std::unique_ptr<Run>& left, std::unique_ptr<Run>& right);
+        static bool grow(Run* run, std::size_t line, std::size_t count, bool onlyVisible);
+    };
+}
+
+#endif //VIX_LINE_ROW_MAP_HEADER_GUARD
@@ -0,0 +1,55 @@
+#ifndef  VIX_MAPPED_FILE_HEADER_GUARD
+# define VIX_MAPPED_FILE_HEADER_GUARD
+
+#include <cstddef>
+#include <string>
+#include <vix/FileException.h>
+
+namespace vix
+{
+    /**
+     * A MappedFile maps the contents of a file read-only into memory for the
+     * lifetime of the object.
+     */
+    class MappedFile
+    {
+    public:
+
+        /**
+         * Map the file at the given path.
+         *
+         * \throw vix::exception::FileOpen if the file cannot be opened.
+         * \throw vix::exception::FileRead if the file cannot be mapped.
+         */
+        explicit MappedFile(const std::string& path);
+
+        /**
+         * Move constructor.
+         */
+        MappedFile(MappedFile&& other);
+
+        /**
+         * Destructor.  Unmap the file.
+         */
+        ~MappedFile();
+
+        /**
+         * Returns the start of the mapping, or null if the file is empty.
+         */
+        const void* data() const;
+
+        /**
+         * Returns the size of the file in bytes.
+         */
+        std::size_t size() const;
+
+    private:
+        void* data_;
+        std::size_t size_;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+    };
+}
+
+#endif //VIX_MAPPED_FILE_HEADER_GUARD
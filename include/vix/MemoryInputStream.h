@@ -0,0 +1,40 @@
+#ifndef  VIX_MEMORY_INPUT_STREAM_HEADER_GUARD
+# define VIX_MEMORY_INPUT_STREAM_HEADER_GUARD
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+
+namespace vix
+{
+    /**
+     * A MemoryInputStream is a binary input stream over a range of memory,
+     * such as a record in a memory mapped journal.  It lets the stream based
+     * Serializable interface read directly from the mapping without copying
+     * it into a string first.  The memory must outlive the stream.
+     */
+    class MemoryInputStream : public std::istream
+    {
+    public:
+
+        /**
+         * Create a stream over the given range of memory.
+         */
+        MemoryInputStream(const void* data, std::size_t size);
+
+    private:
+
+        /**
+         * The stream buffer reads straight out of the range.
+         */
+        class MemoryBuffer : public std::streambuf
+        {
+        public:
+            MemoryBuffer(const void* data, std::size_t size);
+        };
+
+        MemoryBuffer buffer_;
+    };
+}
+
+#endif //VIX_MEMORY_INPUT_STREAM_HEADER_GUARD
@@ -0,0 +1,180 @@
+#ifndef  VIX_OBSERVER_BUDGET_HEADER_GUARD
+# define VIX_OBSERVER_BUDGET_HEADER_GUARD
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <vix/BufferChange.h>
+
+namespace vix
+{
+    /**
+     * Forward declaration for BufferChangeObserver.
+     */
+    class BufferChangeObserver;
+
+    /**
+     * An ObserverBudget gives each synchronous buffer observer a time budget
+     * for each call, and keeps a rolling average of how long each observer
+     * takes.  An observer whose rolling average goes over budget becomes
+     * slow, and the handler is told, so the culprit behind sluggish typing
+     * can be named.  A single slow call doesn't make an observer slow.
+     *
+     * If the budget demotes, a slow observer is deferred: the buffer stops
+     * calling it from within each change, and calls it from dispatchDeferred
+     * instead, once for all the changes since.  A deferred observer whose
+     * rolling average falls under half the budget is promoted back to being
+     * called from within each change.
+     */
+    class ObserverBudget
+    {
+    public:
+
+        /**
+         * The clock used to time observers.
+         */
+        typedef
+        std::chrono::steady_clock
+        clock;
+
+        /**
+         * What is known about one observer.
+         */
+        struct Statistics
+        {
+            /**
+             * The number of calls timed.
+             */
+            std::uint64_t calls;
+
+            /**
+             * The number of calls which took longer than the budget.
+             */
+            std::uint64_t overBudget;
+
+            /**
+             * The total time taken by the calls.
+             */
+            clock::duration total;
+
+            /**
+             * The longest call.
+             */
+            clock::duration max;
+
+            /**
+             * The rolling average of the time taken by recent calls.
+             */
+            clock::duration recent;
+
+            /**
+             * True if the rolling average is over budget.
+             */
+            bool slow;
+
+            /**
+             * True if the observer has been demoted to deferred dispatch.
+             */
+            bool deferred;
+        };
+
+        /**
+         * The function told when an observer becomes slow.
+         */
+        typedef
+        std::function<void(BufferChangeObserver&, const Statistics&)>
+        SlowHandler;
+
+        /**
+         * Create a budget for each call to an observer.
+         *
+         * \param budget        The time each call should take at most.
+         * \param demote        True if slow observers should be deferred.
+         * \param handler       Told when an observer becomes slow.
+         */
+        explicit ObserverBudget(
+            clock::duration budget, bool demote = false,
+            SlowHandler handler = SlowHandler());
+
+        /**
+         * Returns the time each call should take at most.
+         */
+        clock::duration budget() const;
+
+        /**
+         * Returns true if slow observers are deferred.
+         */
+        bool demotes() const;
+
+        /**
+         * Returns true if the given observer is deferred.
+         */
+        bool deferred(const BufferChangeObserver& observer) const;
+
+        /**
+         * Record the time a call to an observer took, and tell the handler
+         * if that made the observer slow.
+         */
+        void record(BufferChangeObserver& observer, clock::duration elapsed);
+
+        /**
+         * Returns what is known about an observer.  An observer which hasn't
+         * been timed has zero calls.
+         */
+        Statistics statistics(const BufferChangeObserver& observer) const;
+
+        /**
+         * Note a change a deferred observer wasn't called for, merging it
+         * into those it has already missed.
+         */
+        void skipped(const BufferChangeObserver& observer, const BufferChange& change);
+
+        /**
+         * Take the changes an observer has missed since it was last called,
+         * merged into one.
+         *
+         * \param observer      The observer.
+         * \param change        Set to the merged change, if there is one.
+         * \return              False if the observer hasn't missed any.
+         */
+        bool takeSkipped(const BufferChangeObserver& observer, BufferChange& change);
+
+        /**
+         * Forget what is known about an observer, so another observer at the
+         * same address starts afresh.
+         */
+        void forget(const BufferChangeObserver& observer);
+
+        /**
+         * Forget what is known about every observer but the given ones.
+         *
+         * \param live          The observers still registered.
+         */
+        void retain(const std::vector<const BufferChangeObserver*>& live);
+
+        /**
+         * Returns the number of observers something is known about.
+         */
+        std::size_t size() const;
+
+    private:
+        clock::duration budget_;
+        bool demote_;
+        SlowHandler handler_;
+
+        //what is known about an observer, and the changes it has missed.
+        struct Entry
+        {
+            Statistics statistics;
+            bool skipped;
+            BufferChange change;
+        };
+
+        std::unordered_map<const BufferChangeObserver*, Entry> observers_;
+    };
+}
+
+#endif //VIX_OBSERVER_BUDGET_HEADER_GUARD
@@ -0,0 +1,158 @@
+#ifndef  VIX_SERIAL_ENDIAN_HEADER_GUARD
+# define VIX_SERIAL_ENDIAN_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vix/SerialUtilities.h>
+
+/**
+ * The SerialEndian header file provides header-only templates for encoding
+ * integral values in Big Endian format, either into memory or onto a binary
+ * stream.  The byte order conversion is resolved at compile time for each
+ * integral type, and compiles down to a single byte swap instruction where the
+ * host supports one.
+ */
+namespace vix
+{
+    /**
+     * ByteSwap reverses the byte order of an unsigned value of the given size.
+     */
+    template <std::size_t Size>
+    struct ByteSwap;
+
+    template <>
+    struct ByteSwap<1>
+    {
+        static constexpr std::uint8_t swap(std::uint8_t value)
+        {
+            return value;
+        }
+    };
+
+    template <>
+    struct ByteSwap<2>
+    {
+        static constexpr std::uint16_t swap(std::uint16_t value)
+        {
+            return __builtin_bswap16(value);
+        }
+    };
+
+    template <>
+    struct ByteSwap<4>
+    {
+        static constexpr std::uint32_t swap(std::uint32_t value)
+        {
+            return __builtin_bswap32(value);
+        }
+    };
+
+    template <>
+    struct ByteSwap<8>
+    {
+        static constexpr std::uint64_t swap(std::uint64_t value)
+        {
+            return __builtin_bswap64(value);
+        }
+    };
+
+    /**
+     * byteSwap reverses the byte order of an integral value.
+     */
+    template <typename T>
+    constexpr T byteSwap(T value)
+    {
+        static_assert(std::is_integral<T>::value, "byteSwap requires an integral type.");
+
+        return (T)ByteSwap<sizeof(T)>::swap(
+            (typename std::make_unsigned<T>::type)value);
+    }
+
+    /**
+     * hostToBigEndian converts an integral value from host byte order to Big
+     * Endian byte order.  The conversion is its own inverse.
+     */
+    template <typename T>
+    constexpr T hostToBigEndian(T value)
+    {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return value;
+#else
+        return byteSwap(value);
+#endif
+    }
+
+    /**
+     * encodeBigEndian writes an integral value to memory in Big Endian format.
+     *
+     * \param out           The memory to which the value is written.  It must
+     *                      have room for sizeof(T) bytes.
+     * \param value         The value to write.
+     */
+    template <typename T>
+    inline void encodeBigEndian(void* out, T value)
+    {
+        value = hostToBigEndian(value);
+
+        std::memcpy(out, &value, sizeof(value));
+    }
+
+    /**
+     * decodeBigEndian reads an integral value in Big Endian format from
+     * memory.
+     *
+     * \param in            The memory from which the value is read.  It must
+     *                      hold at least sizeof(T) bytes.
+     */
+    template <typename T>
+    inline T decodeBigEndian(const void* in)
+    {
+        T value;
+
+        std::memcpy(&value, in, sizeof(value));
+
+        return hostToBigEndian(value);
+    }
+
+    /**
+     * serialWriteBigEndian writes an integral value to the output stream in
+     * Big Endian format.
+     *
+     * \param out           The output stream to which this value is written.
+     * \param value         The value to write.
+     *
+     * \throw vix::exception::SerialWrite if the serial write fails.
+     */
+    template <typename T>
+    inline void serialWriteBigEndian(std::ostream& out, T value)
+    {
+        std::uint8_t buffer[sizeof(T)];
+
+        encodeBigEndian(buffer, value);
+
+        serialWriteFixedBuffer(out, buffer, sizeof(buffer));
+    }
+
+    /**
+     * serialReadBigEndian reads an integral value in Big Endian format from
+     * the input stream.
+     *
+     * \param in            The input stream from which this value is read.
+     * \param value         The value to be read.
+     *
+     * \throw vix::exception::SerialRead if the serial read fails.
+     */
+    template <typename T>
+    inline void serialReadBigEndian(std::istream& in, T& value)
+    {
+        std::uint8_t buffer[sizeof(T)];
+
+        serialReadFixedBuffer(in, buffer, sizeof(buffer));
+
+        value = decodeBigEndian<T>(buffer);
+    }
+}
+
+#endif //VIX_SERIAL_ENDIAN_HEADER_GUARD
@@ -1,7 +1,7 @@
 #ifndef  VIX_SERIAL_EXCEPTION_HEADER_GUARD
 # define VIX_SERIAL_EXCEPTION_HEADER_GUARD
 
-#include <exception>
+#include <stdexcept>
 #include <string>
 #include <vix/ExceptionSpecification.h>
 
@@ -0,0 +1,133 @@
+#ifndef  VIX_SERIAL_MEMORY_READER_HEADER_GUARD
+# define VIX_SERIAL_MEMORY_READER_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <vix/SerialEndian.h>
+#include <vix/SerialException.h>
+#include <vix/StringRef.h>
+
+namespace vix
+{
+    /**
+     * A SerialMemoryReader reads serialized values from a contiguous range of
+     * memory, such as a memory mapped journal.  It reads the same formats as
+     * the stream functions in SerialUtilities and SerialVarint, but strings
+     * are returned as references into the underlying memory instead of being
+     * copied.  Every read is bounds checked; a read past the end of the range
+     * throws vix::exception::SerialRead, as a truncated stream would.
+     */
+    class SerialMemoryReader
+    {
+    public:
+
+        /**
+         * Create a reader over the given range of memory.
+         */
+        SerialMemoryReader(const void* data, std::size_t size);
+
+        /**
+         * Returns the current read offset.
+         */
+        std::size_t position() const;
+
+        /**
+         * Move the read offset.
+         *
+         * \throw vix::exception::SerialRead if the offset is out of range.
+         */
+        void position(std::size_t offset);
+
+        /**
+         * Returns the number of bytes left to read.
+         */
+        std::size_t remaining() const;
+
+        /**
+         * Returns the size of the range.
+         */
+        std::size_t size() const;
+
+        /**
+         * Read a fixed size buffer, as written by serialWriteFixedBuffer.
+         *
+         * \throw vix::exception::SerialRead if the read is out of range.
+         */
+        void readFixedBuffer(void* buffer, std::size_t size);
+
+        /**
+         * Return a reference to the next size bytes, and skip past them.
+         *
+         * \throw vix::exception::SerialRead if the read is out of range.
+         */
+        StringRef readFixedRef(std::size_t size);
+
+        /**
+         * Read an integral value, as written by serialWrite.
+         *
+         * \throw vix::exception::SerialRead if the read is out of range.
+         */
+        template <typename T>
+        void read(T& value)
+        {
+            value = decodeBigEndian<T>(advance(sizeof(T)));
+        }
+
+        /**
+         * Read a reference to a string, as written by serialWrite.
+         *
+         * \throw vix::exception::SerialRead if the read is out of range.
+         */
+        void read(StringRef& value);
+
+        /**
+         * Read an unsigned varint, as written by serialWriteVarint.
+         *
+         * \throw vix::exception::SerialRead if the read is out of range or the
+         *        encoding is malformed.
+         */
+        void readVarint(std::uint64_t& value);
+
+        /**
+         * Read a signed varint, as written by serialWriteZigzag.
+         *
+         * \throw vix::exception::SerialRead if the read is out of range or the
+         *        encoding is malformed.
+         */
+        void readZigzag(std::int64_t& value);
+
+        /**
+         * Read a reference to a string, as written by serialWriteCompact.
+         *
+         * \throw vix::exception::SerialRead if the read is out of range or the
+         *        encoding is malformed.
+         */
+        void readCompact(StringRef& value);
+
+    private:
+        const std::uint8_t* data_;
+        std::size_t size_;
+        std::size_t position_;
+
+        /**
+         * Return a pointer to the next size bytes, and skip past them.
+         */
+        const std::uint8_t* advance(std::size_t size)
+        {
+            if (size > size_ - position_)
+                throwTruncated();
+
+            const std::uint8_t* p = data_ + position_;
+            position_ += size;
+
+            return p;
+        }
+
+        /**
+         * Throw a SerialRead exception for a read past the end of the range.
+         */
+        [[noreturn]] static void throwTruncated();
+    };
+}
+
+#endif //VIX_SERIAL_MEMORY_READER_HEADER_GUARD
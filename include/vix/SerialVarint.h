@@ -0,0 +1,149 @@
+#ifndef  VIX_SERIAL_VARINT_HEADER_GUARD
+# define VIX_SERIAL_VARINT_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vix/SerialException.h>
+
+/**
+ * The SerialVarint header file provides a compact, variable length encoding
+ * for integers, as an alternative to the fixed width encoding provided by
+ * SerialUtilities.  Unsigned values are written in LEB128 form: seven bits per
+ * byte, least significant group first, with the high bit of each byte set if
+ * another byte follows.  Signed values are zigzag encoded first, so that
+ * values close to zero are short whatever their sign.
+ */
+namespace vix
+{
+    /**
+     * The largest number of bytes a 64-bit varint can occupy.
+     */
+    const std::size_t VARINT_MAX_SIZE = 10;
+
+    /**
+     * The number of bytes the output of encodeVarint must have room for,
+     * regardless of the size of the encoded value.
+     */
+    const std::size_t VARINT_ENCODE_SPACE = 16;
+
+    /**
+     * zigzagEncode maps a signed value onto an unsigned value, so that values
+     * with a small magnitude have a small encoding.
+     */
+    inline std::uint64_t zigzagEncode(std::int64_t value)
+    {
+        return (((std::uint64_t)value) << 1) ^ (std::uint64_t)(value >> 63);
+    }
+
+    /**
+     * zigzagDecode reverses zigzagEncode.
+     */
+    inline std::int64_t zigzagDecode(std::uint64_t value)
+    {
+        return (std::int64_t)((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    /**
+     * varintSize returns the number of bytes needed to encode the given value.
+     *
+     * \param value         The value to be encoded.
+     */
+    std::size_t varintSize(std::uint64_t value);
+
+    /**
+     * encodeVarint encodes a value into memory.  The encoder writes whole
+     * words at a time, so the output must have room for VARINT_ENCODE_SPACE
+     * bytes, even though only the returned number of bytes are meaningful.
+     *
+     * \param out           The memory to which the value is encoded.
+     * \param value         The value to encode.
+     *
+     * \returns the number of bytes in the encoding.
+     */
+    std::size_t encodeVarint(void* out, std::uint64_t value);
+
+    /**
+     * decodeVarint decodes a value from memory.
+     *
+     * \param in            The memory from which the value is decoded.
+     * \param size          The number of bytes available to decode.
+     * \param value         The decoded value.
+     *
+     * \returns the number of bytes consumed.
+     *
+     * \throw vix::exception::SerialRead if the encoding is truncated or is
+     *        longer than VARINT_MAX_SIZE bytes.
+     */
+    std::size_t decodeVarint(const void* in, std::size_t size, std::uint64_t& value);
+
+    /**
+     * serialWriteVarint writes an unsigned value to the output stream as a
+     * varint.
+     *
+     * \param out           The output stream to which this value is written.
+     * \param value         The value to write.
+     *
+     * \throw vix::exception::SerialWrite if the serial write fails.
+     */
+    void serialWriteVarint(std::ostream& out, std::uint64_t value);
+
+    /**
+     * serialReadVarint reads an unsigned varint from the input stream.
+     *
+     * \param in            The input stream from which this value is read.
+     * \param value         The value to be read.
+     *
+     * \throw vix::exception::SerialRead if the serial read fails, or if the
+     *        encoding is malformed.
+     */
+    void serialReadVarint(std::istream& in, std::uint64_t& value);
+
+    /**
+     * serialWriteZigzag writes a signed value to the output stream as a
+     * zigzag encoded varint.
+     *
+     * \param out           The output stream to which this value is written.
+     * \param value         The value to write.
+     *
+     * \throw vix::exception::SerialWrite if the serial write fails.
+     */
+    void serialWriteZigzag(std::ostream& out, std::int64_t value);
+
+    /**
+     * serialReadZigzag reads a signed, zigzag encoded varint from the input
+     * stream.
+     *
+     * \param in            The input stream from which this value is read.
+     * \param value         The value to be read.
+     *
+     * \throw vix::exception::SerialRead if the serial read fails, or if the
+     *        encoding is malformed.
+     */
+    void serialReadZigzag(std::istream& in, std::int64_t& value);
+
+    /**
+     * serialWriteCompact writes a string to the output stream, preceded by
+     * its length as a varint.
+     *
+     * \param out           The output stream to which this value is written.
+     * \param value         The string value to write.
+     *
+     * \throw vix::exception::SerialWrite if the serial write fails.
+     */
+    void serialWriteCompact(std::ostream& out, const std::string& value);
+
+    /**
+     * serialReadCompact reads a string written by serialWriteCompact from the
+     * input stream.
+     *
+     * \param in            The input stream from which this value is read.
+     * \param value         The string value to read.
+     *
+     * \throw vix::exception::SerialRead if the serial read fails.
+     */
+    void serialReadCompact(std::istream& in, std::string& value);
+}
+
+#endif //VIX_SERIAL_VARINT_HEADER_GUARD
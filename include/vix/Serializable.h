@@ -12,7 +12,7 @@ namespace vix
      * istream.  The serialWrite method reads object state from a binary
      * ostream.  How this data is serialized is up to the implementing class.
      */
-    class Serializable : virtual public Serializable
+    class Serializable
     {
     public:
 
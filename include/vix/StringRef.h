@@ -0,0 +1,102 @@
+#ifndef  VIX_STRING_REF_HEADER_GUARD
+# define VIX_STRING_REF_HEADER_GUARD
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace vix
+{
+    /**
+     * A StringRef is a non-owning reference to a contiguous range of
+     * characters, such as a string stored in a memory mapped journal.  The
+     * referenced memory must outlive the StringRef.
+     */
+    class StringRef
+    {
+    public:
+
+        typedef
+        const char*
+        const_iterator;
+
+        /**
+         * Construct an empty reference.
+         */
+        StringRef()
+            : data_(nullptr), size_(0)
+        {
+        }
+
+        /**
+         * Construct a reference to the given range of characters.
+         */
+        StringRef(const char* data, std::size_t size)
+            : data_(data), size_(size)
+        {
+        }
+
+        /**
+         * Construct a reference to the contents of the given string.
+         */
+        StringRef(const std::string& str)
+            : data_(str.data()), size_(str.size())
+        {
+        }
+
+        const char* data() const
+        {
+            return data_;
+        }
+
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        bool empty() const
+        {
+            return size_ == 0;
+        }
+
+        const_iterator begin() const
+        {
+            return data_;
+        }
+
+        const_iterator end() const
+        {
+            return data_ + size_;
+        }
+
+        char operator[](std::size_t index) const
+        {
+            return data_[index];
+        }
+
+        /**
+         * Copy the referenced characters into a new string.
+         */
+        std::string str() const
+        {
+            return std::string(data_, size_);
+        }
+
+        bool operator==(const StringRef& other) const
+        {
+            return size_ == other.size_
+                && (size_ == 0 || !std::memcmp(data_, other.data_, size_));
+        }
+
+        bool operator!=(const StringRef& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        const char* data_;
+        std::size_t size_;
+    };
+}
+
+#endif //VIX_STRING_REF_HEADER_GUARD
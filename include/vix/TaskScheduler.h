@@ -0,0 +1,229 @@
+#ifndef  VIX_TASK_SCHEDULER_HEADER_GUARD
+# define VIX_TASK_SCHEDULER_HEADER_GUARD
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <vix/CancellationToken.h>
+
+namespace vix
+{
+    /**
+     * A TaskScheduler runs tasks on a fixed pool of threads, by default one
+     * per core, which every background service in the editor shares rather
+     * than starting threads of its own.  Each thread has a deque of tasks for
+     * each priority.  A task submitted from a pool thread goes on that
+     * thread's own deque, where it is likely to find its data still in cache;
+     * others are dealt out in turn.  A thread takes the newest task from its
+     * own deque, and when that is empty, steals the oldest from another's.
+     * Interactive tasks are always taken before background ones.
+     *
+     * A task may carry a CancellationToken.  A task whose token has been
+     * cancelled by the time a thread takes it is dropped without running.
+     * Tasks are not otherwise ordered, and should report their own errors;
+     * an exception escaping a task is counted and dropped.
+     */
+    class TaskScheduler
+    {
+    public:
+
+        /**
+         * A task.
+         */
+        typedef
+        std::function<void()>
+        Task;
+
+        /**
+         * The clock used to measure task latency.
+         */
+        typedef
+        std::chrono::steady_clock
+        clock;
+
+        /**
+         * The priority of a task.
+         */
+        enum Priority
+        {
+            /**
+             * Work the user is waiting to see, such as highlighting.
+             */
+            INTERACTIVE,
+
+            /**
+             * Work nobody is waiting for, such as compaction or indexing.
+             */
+            BACKGROUND
+        };
+
+        /**
+         * Counters describing the scheduler's work so far.
+         */
+        struct Statistics
+        {
+            /**
+             * The number of tasks waiting to run.
+             */
+            std::size_t queued;
+
+            /**
+             * The number of tasks run.
+             */
+            std::uint64_t executed;
+
+            /**
+             * The number of tasks taken from another thread's deque.
+             */
+            std::uint64_t stolen;
+
+            /**
+             * The number of tasks dropped because they were cancelled.
+             */
+            std::uint64_t cancelled;
+
+            /**
+             * The number of tasks which threw.
+             */
+            std::uint64_t failed;
+
+            /**
+             * The total time tasks waited between submission and starting.
+             */
+            clock::duration totalLatency;
+
+            /**
+             * The longest time a task waited between submission and starting.
+             */
+            clock::duration maxLatency;
+        };
+
+        /**
+         * Start a scheduler with the given number of threads, or one per core
+         * if zero.
+         */
+        explicit TaskScheduler(std::size_t threads = 0);
+
+        /**
+         * Destructor.  Run every task already submitted, then stop the
+         * threads.
+         */
+        ~TaskScheduler();
+
+        /**
+         * Submit a task.
+         */
+        void submit(
+            Task task, Priority priority = BACKGROUND,
+            CancellationToken token = CancellationToken());
+
+        /**
+         * Wait until every task submitted so far, and every task they submit,
+         * has run or been dropped.
+         */
+        void wait();
+
+        /**
+         * Call the given function with each index from zero up to count,
+         * spread across the pool, and wait for every call to return.  The
+         * calling thread takes indices too, and only waits for calls other
+         * threads have already started, so this is safe to call from a task.
+         *
+         * \param count         The number of indices.
+         * \param body          The function called with each index.
+         * \param priority      The priority of the tasks helping out.
+         *
+         * \throw the exception thrown by the call with the lowest index, if
+         *        any threw.
+         */
+        void parallelFor(
+            std::size_t count, const std::function<void(std::size_t)>& body,
+            Priority priority = INTERACTIVE);
+
+        /**
+         * Returns the number of threads in the pool.
+         */
+        std::size_t threads() const;
+
+        /**
+         * Returns the scheduler's counters.
+         */
+        Statistics statistics() const;
+
+        /**
+         * Returns the scheduler shared by the editor's services.
+         */
+        static TaskScheduler& standard();
+
+    private:
+
+        /**
+         * A submitted task.
+         */
+        struct QueuedTask
+        {
+            Task task;
+            CancellationToken token;
+            clock::time_point submitted;
+        };
+
+        /**
+         * The deques of a thread in the pool, one per priority.
+         */
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<QueuedTask> tasks[2];
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+        std::atomic<std::size_t> next_;
+
+        //tasks on the deques, which only change under a deque's mutex, and
+        //tasks not yet finished.
+        std::atomic<std::size_t> queued_;
+        std::atomic<std::size_t> outstanding_;
+
+        //the counters, kept apart from the deques so that running a task
+        //takes no lock but its deque's.
+        std::atomic<std::uint64_t> executed_;
+        std::atomic<std::uint64_t> stolen_;
+        std::atomic<std::uint64_t> cancelled_;
+        std::atomic<std::uint64_t> failed_;
+        std::atomic<clock::rep> totalLatency_;
+        std::atomic<clock::rep> maxLatency_;
+
+        //only taken to park an idle thread, to wake one, or to wait.
+        std::mutex mutex_;
+        std::condition_variable work_;
+        std::condition_variable idle_;
+        std::atomic<std::size_t> sleepers_;
+        bool stop_;
+
+        /**
+         * The body of the pool thread with the given index.
+         */
+        void run(std::size_t index);
+
+        /**
+         * Take the next task for the pool thread with the given index.
+         *
+         * \returns false if there are no tasks.
+         */
+        bool take(std::size_t index, QueuedTask& task);
+
+        TaskScheduler(const TaskScheduler&) = delete;
+        TaskScheduler& operator=(const TaskScheduler&) = delete;
+    };
+}
+
+#endif //VIX_TASK_SCHEDULER_HEADER_GUARD
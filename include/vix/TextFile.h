@@ -0,0 +1,113 @@
+#ifndef  VIX_TEXT_FILE_HEADER_GUARD
+# define VIX_TEXT_FILE_HEADER_GUARD
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vix/Buffer.h>
+#include <vix/FileException.h>
+#include <vix/LineIndex.h>
+#include <vix/SerialException.h>
+
+/**
+ * The TextFile header file provides loading and saving of a Buffer as plain
+ * UTF-8 text, one line per line of the file.
+ */
+namespace vix
+{
+    /**
+     * The format of a text file, as found when it is read, and as it is
+     * written back.
+     */
+    struct TextFormat
+    {
+        /**
+         * The line ending; when read, the most common one.
+         */
+        LineEnding ending;
+
+        /**
+         * True if the lines read ended in more than one way.  Written lines
+         * all end the same way.
+         */
+        bool mixed;
+
+        /**
+         * True if the last line ends with a line ending.
+         */
+        bool finalNewline;
+
+        /**
+         * True if the text read was well formed UTF-8.
+         */
+        bool utf8;
+
+        /**
+         * The format of a new file: lines ending in line feeds, including
+         * the last.
+         */
+        TextFormat();
+    };
+
+    /**
+     * readText replaces the contents of a buffer with a text held in memory,
+     * such as a memory mapped file.  The buffer is given all of the lines at
+     * once, so observers are notified once.
+     *
+     * \param data          The text.
+     * \param size          The size of the text in bytes.
+     * \param buffer        The buffer to fill.
+     * \param format        Set to the format of the text.
+     * \param threads       The number of threads used to read the text.
+     */
+    void readText(
+        const void* data, std::size_t size, Buffer& buffer, TextFormat& format,
+        unsigned threads = 1);
+
+    /**
+     * readTextFile replaces the contents of a buffer with a text file.
+     *
+     * \param path          The path of the file.
+     * \param buffer        The buffer to fill.
+     * \param format        Set to the format of the file.
+     * \param threads       The number of threads used to read the file.
+     *
+     * \throw vix::exception::File if the file can't be read.
+     */
+    void readTextFile(
+        const std::string& path, Buffer& buffer, TextFormat& format,
+        unsigned threads = 1);
+
+    /**
+     * writeText writes the lines of a buffer to a stream as text.
+     *
+     * \param out           The stream to which the text is written.
+     * \param buffer        The buffer to write.
+     * \param format        The format to write it in.
+     *
+     * \throw vix::exception::SerialWrite if the write fails.
+     */
+    void writeText(
+        std::ostream& out, const Buffer& buffer,
+        const TextFormat& format = TextFormat());
+
+    /**
+     * writeTextFile creates or replaces a text file with the lines of a
+     * buffer.  The text is written through an IoBackend, so lines are encoded
+     * while the text before them is written.  It goes to a temporary file
+     * beside the file, which is flushed to disk and then renamed over it, so
+     * a save which fails leaves the file as it was.
+     *
+     * \param path          The path of the file.
+     * \param buffer        The buffer to write.
+     * \param format        The format to write it in.
+     *
+     * \throw vix::exception::FileOpen if the file can't be created.
+     * \throw vix::exception::FileWrite if the file can't be written.
+     */
+    void writeTextFile(
+        const std::string& path, const Buffer& buffer,
+        const TextFormat& format = TextFormat());
+}
+
+#endif //VIX_TEXT_FILE_HEADER_GUARD
@@ -0,0 +1,31 @@
+#ifndef  VIX_TREAP_PRIORITY_HEADER_GUARD
+# define VIX_TREAP_PRIORITY_HEADER_GUARD
+
+#include <cstdint>
+
+/**
+ * The TreapPriority header file provides the random priorities given to the
+ * nodes of the treaps which FoldEngine and LineRowMap keep.
+ */
+namespace vix
+{
+    /**
+     * The seed a treap starts its priorities from.
+     */
+    const std::uint32_t TREAP_PRIORITY_SEED = 0x9E3779B9;
+
+    /**
+     * Advance a treap's seed, and return it as the priority of a new node.
+     * xorshift is plenty random enough to balance a treap.
+     */
+    inline std::uint32_t treapPriority(std::uint32_t& seed)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+
+        return seed;
+    }
+}
+
+#endif //VIX_TREAP_PRIORITY_HEADER_GUARD
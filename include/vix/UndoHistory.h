@@ -0,0 +1,98 @@
+#ifndef  VIX_UNDO_HISTORY_HEADER_GUARD
+# define VIX_UNDO_HISTORY_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vix/CommandRegistry.h>
+#include <vix/FileException.h>
+#include <vix/Journal.h>
+#include <vix/MappedFile.h>
+#include <vix/SerialException.h>
+#include <vix/UndoTree.h>
+
+namespace vix
+{
+    /**
+     * An UndoHistory keeps the UndoTree of a file in a journal beside it, so
+     * undo survives the editor being closed.  Each node is a JOURNAL_UNDO_NODE
+     * record holding its command's tag in a CommandRegistry, its parent, its
+     * timestamp in milliseconds, and the serialized command.  Each save ends
+     * with a JOURNAL_UNDO_STATE record holding the number of nodes, the
+     * current node, and the size and CRC-32C of the file as saved, which must
+     * match the file when it is next opened for the history to be used.
+     *
+     * Loading only reads the fixed part of each node.  The journal stays
+     * mapped, and each command is deserialized the first time it is applied
+     * or reverted, so a long history costs one pass over the journal and
+     * nothing more until the user steps back into it.  Loading never writes
+     * to the journal.  Later saves append only the nodes created since,
+     * first cutting off anything torn after the last valid record.
+     */
+    class UndoHistory
+    {
+    public:
+
+        /**
+         * Use the history journal at the given path.  Nothing is read or
+         * written until load or save.
+         *
+         * \param path          The path of the history journal.
+         * \param registry      The registry of the commands in the history,
+         *                      which must outlive every tree loaded.
+         */
+        explicit UndoHistory(
+            const std::string& path,
+            const CommandRegistry& registry = CommandRegistry::standard());
+
+        /**
+         * Returns the path of the history journal for a file: a hidden file
+         * in the same directory.
+         */
+        static std::string historyPath(const std::string& filePath);
+
+        /**
+         * Load the saved history into a new tree, whose buffer holds the
+         * file's contents, and make the saved current node the tree's
+         * current state.
+         *
+         * \param tree          A tree with no nodes beyond its root.
+         * \param filePath      The file the history belongs to.
+         *
+         * \returns false, leaving the tree alone, if there is no history, or
+         *          if the file has changed since the history was saved.
+         *
+         * \throw vix::exception::File if a file can't be read.
+         * \throw vix::exception::SerialRead if the history is malformed.
+         */
+        bool load(UndoTree& tree, const std::string& filePath);
+
+        /**
+         * Save the tree's history, as it stands just after the file has been
+         * written.  Only nodes created since the last load or save are
+         * written.  Any command being coalesced must be closed first, since
+         * nodes are never written twice.
+         *
+         * \param tree          The tree loaded from, or first saved to, this
+         *                      history.
+         * \param filePath      The file the history belongs to.
+         *
+         * \throw vix::exception::File if a file can't be read or written.
+         * \throw vix::exception::SerialWrite if a command can't be written.
+         */
+        void save(const UndoTree& tree, const std::string& filePath);
+
+    private:
+        std::string path_;
+        const CommandRegistry& registry_;
+        std::size_t saved_;
+
+        //where the valid records of the journal end, as of the last load or
+        //save, which is where the next save appends.
+        std::uint64_t end_;
+        bool attached_;
+    };
+}
+
+#endif //VIX_UNDO_HISTORY_HEADER_GUARD
@@ -0,0 +1,301 @@
+#ifndef  VIX_UNDO_TREE_HEADER_GUARD
+# define VIX_UNDO_TREE_HEADER_GUARD
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <vix/Buffer.h>
+#include <vix/Command.h>
+
+namespace vix
+{
+    /**
+     * An UndoTree records every Command applied to a buffer as a node in a
+     * tree of states.  Undoing and then making a new edit starts a new branch
+     * instead of throwing the undone commands away.  Each node has a sequence
+     * number, which is its position in creation order, and a timestamp.
+     *
+     * Any state can be reached from any other.  A jump reverts commands up to
+     * the nearest common ancestor of the two states and applies commands down
+     * to the target.  Ancestors are found in O(log n) using one jump pointer
+     * per node.  The buffer's contents are also checkpointed every
+     * checkpointInterval levels of the tree, so a long jump restores the
+     * checkpoint nearest the target instead of replaying thousands of
+     * commands.
+     *
+     * A checkpoint is a list of runs of lines, which share the storage of
+     * each line.  A run whose lines are unchanged since the previous
+     * checkpoint is shared with it rather than copied, so a checkpoint costs
+     * memory in proportion to what has changed.  The root's checkpoint and
+     * that of the state the tree was last rebased to are always kept.  The
+     * oldest of the others are dropped once they hold more than
+     * maxCheckpointBytes between them, though the most recent is always kept.
+     */
+    class UndoTree
+    {
+    public:
+
+        /**
+         * The clock used for node timestamps.
+         */
+        typedef
+        std::chrono::system_clock
+        clock;
+
+        /**
+         * Identifies a node.  The root, which is the state of the buffer when
+         * the tree was created, is node zero.  Nodes are numbered in the order
+         * they are created, so a node's id is also its sequence number.
+         */
+        typedef
+        std::size_t
+        NodeId;
+
+        /**
+         * The default number of tree levels between checkpoints.
+         */
+        static const std::size_t DEFAULT_CHECKPOINT_INTERVAL;
+
+        /**
+         * The default number of bytes checkpoints may hold, besides the
+         * root's and the rebased state's, not counting storage their lines
+         * share with other lines.
+         */
+        static const std::size_t DEFAULT_MAX_CHECKPOINT_BYTES;
+
+        /**
+         * Create an undo tree for a buffer, with its current contents as the
+         * root state.
+         */
+        explicit UndoTree(
+            std::weak_ptr<Buffer> buffer,
+            std::size_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL,
+            std::size_t maxCheckpointBytes = DEFAULT_MAX_CHECKPOINT_BYTES);
+
+        /**
+         * Apply a command to the buffer and record it as a new child of the
+         * current state, which it then becomes.
+         */
+        void apply(std::shared_ptr<Command> command, clock::time_point when = clock::now());
+
+        /**
+         * Add a node for a command as a child of the given node, without
+         * touching the buffer or the current state.  This rebuilds a tree
+         * from saved history; the node's id is the tree's size beforehand.
+         */
+        NodeId graft(NodeId parent, std::shared_ptr<Command> command, clock::time_point when);
+
+        /**
+         * Declare that the buffer now holds the given node's state, without
+         * applying or reverting anything.  Checkpoints taken so far are
+         * dropped, since they may not match the history grafted since, and
+         * the buffer's contents are kept as the given node's checkpoint.
+         */
+        void rebase(NodeId current);
+
+        /**
+         * Revert the current state's command, moving to its parent.
+         *
+         * \returns false if the current state is the root.
+         */
+        bool undo();
+
+        /**
+         * Apply the command of the child most recently left by undo, or most
+         * recently created.
+         *
+         * \returns false if the current state has no children.
+         */
+        bool redo();
+
+        /**
+         * Move the buffer to the given state by the cheapest route.
+         */
+        void jump(NodeId target);
+
+        /**
+         * Move the buffer to the latest state created at or before the given
+         * time, or to the root if there is none.
+         */
+        void jump(clock::time_point when);
+
+        /**
+         * Move the buffer to the state it had the given time before the
+         * current state was created, as vi's :earlier does.
+         */
+        void earlier(clock::duration duration);
+
+        /**
+         * Move the buffer to the state created the given time after the
+         * current state, as vi's :later does.
+         */
+        void later(clock::duration duration);
+
+        /**
+         * Returns the buffer this tree applies commands to.
+         */
+        std::weak_ptr<Buffer> buffer() const;
+
+        /**
+         * Returns the current state.
+         */
+        NodeId current() const;
+
+        /**
+         * Returns the number of nodes, including the root.
+         */
+        std::size_t size() const;
+
+        /**
+         * Returns the latest node created at or before the given time, or the
+         * root if there is none.
+         */
+        NodeId at(clock::time_point when) const;
+
+        /**
+         * Returns the parent of a node.  The root is its own parent.
+         */
+        NodeId parent(NodeId node) const;
+
+        /**
+         * Returns the depth of a node, which is the number of commands
+         * applied between the root and the node.
+         */
+        std::size_t depth(NodeId node) const;
+
+        /**
+         * Returns the nearest common ancestor of two nodes.
+         */
+        NodeId ancestor(NodeId a, NodeId b) const;
+
+        /**
+         * Returns the time a node was created.
+         */
+        clock::time_point timestamp(NodeId node) const;
+
+        /**
+         * Returns the command which leads to a node from its parent, or null
+         * for the root.
+         */
+        std::shared_ptr<Command> command(NodeId node) const;
+
+        /**
+         * Returns the number of bytes checkpoints hold, not counting storage
+         * their lines share with other lines.
+         */
+        std::size_t checkpointBytes() const;
+
+    private:
+
+        /**
+         * What tells a line of the buffer apart from a different one without
+         * reading it: where the buffer keeps it, and its stamp, which no line
+         * kept there later can share.
+         */
+        typedef
+        std::pair<const Line*, std::uint64_t>
+        LineKey;
+
+        /**
+         * A run of consecutive lines in a checkpoint, which checkpoints share
+         * for as long as the lines are unchanged.  Its size is counted in the
+         * tree's total for as long as it exists.
+         */
+        struct Run
+        {
+            std::vector<Line> lines;
+            //the keys of the buffer's lines they were copied from.
+            std::vector<LineKey> keys;
+            std::size_t bytes;
+            std::shared_ptr<std::size_t> total;
+
+            ~Run();
+        };
+
+        /**
+         * The contents of the buffer in some state.
+         */
+        typedef
+        std::vector<std::shared_ptr<const Run>>
+        Checkpoint;
+
+        /**
+         * A state in the tree.
+         */
+        struct Node
+        {
+            std::shared_ptr<Command> command;
+            NodeId parent;
+            NodeId jump;
+            NodeId redo;
+            std::size_t depth;
+            clock::time_point time;
+            std::unique_ptr<Checkpoint> checkpoint;
+        };
+
+        std::weak_ptr<Buffer> buffer_;
+        std::vector<Node> nodes_;
+        NodeId current_;
+        NodeId base_;
+        std::size_t checkpointInterval_;
+        std::size_t maxCheckpointBytes_;
+        std::shared_ptr<std::size_t> checkpointBytes_;
+        //the bytes of the root's or rebased state's checkpoint, which stay.
+        std::size_t pinnedBytes_;
+        std::vector<NodeId> checkpoints_;
+
+        /**
+         * Add a node for a command as a child of the given node.
+         */
+        NodeId addNode(NodeId parent, std::shared_ptr<Command> command, clock::time_point when);
+
+        /**
+         * Returns the number of commands between two nodes.
+         */
+        std::size_t distance(NodeId a, NodeId b) const;
+
+        /**
+         * Returns the ancestor of a node at the given depth.
+         */
+        NodeId ancestorAtDepth(NodeId node, std::size_t depth) const;
+
+        /**
+         * Checkpoint the current state if it is due one.  This happens as the
+         * state is left rather than when it is created, so a command can
+         * still be amended while its state is current.
+         */
+        void seal();
+
+        /**
+         * Returns a checkpoint of the buffer's contents, sharing the runs of
+         * the given checkpoint, if any, whose lines are unchanged.
+         */
+        std::unique_ptr<Checkpoint> checkpoint(
+            const Buffer& buffer, const Checkpoint* previous) const;
+
+        /**
+         * Returns what tells a line of the buffer apart from a different one.
+         */
+        static LineKey key(const Line& line);
+
+        /**
+         * Revert commands from the current state up to an ancestor.
+         */
+        void revertTo(NodeId ancestor);
+
+        /**
+         * Apply commands from the current state down to a descendant.
+         */
+        void applyTo(NodeId descendant);
+
+        /**
+         * Replace the buffer's contents with a node's checkpoint.
+         */
+        void restore(NodeId node);
+    };
+}
+
+#endif //VIX_UNDO_TREE_HEADER_GUARD
@@ -0,0 +1,75 @@
+#ifndef  VIX_UTF8_HEADER_GUARD
+# define VIX_UTF8_HEADER_GUARD
+
+#include <cstddef>
+#include <string>
+
+/**
+ * The Utf8 header file provides conversion between the UTF-8 encoding used on
+ * disk and the wide strings held by Line.  Runs of ASCII are converted a
+ * vector at a time, with the widest instructions the CPU supports, and
+ * everything else a character at a time.
+ */
+namespace vix
+{
+    /**
+     * The character substituted for malformed input.
+     */
+    const wchar_t UTF8_REPLACEMENT_CHARACTER = 0xFFFD;
+
+    /**
+     * utf8EncodedSize returns the number of bytes needed to encode the given
+     * wide string as UTF-8.
+     *
+     * \param in            The wide string to measure.
+     * \param size          The number of characters in the wide string.
+     */
+    std::size_t utf8EncodedSize(const wchar_t* in, std::size_t size);
+
+    /**
+     * utf8Encode appends the UTF-8 encoding of a wide string to the output.
+     * Characters which are not Unicode scalar values are encoded as the
+     * replacement character.
+     *
+     * \param in            The wide string to encode.
+     * \param size          The number of characters in the wide string.
+     * \param out           The string to which the encoding is appended.
+     */
+    void utf8Encode(const wchar_t* in, std::size_t size, std::string& out);
+
+    /**
+     * utf8Encode appends the UTF-8 encoding of a wide string to the output.
+     */
+    void utf8Encode(const std::wstring& in, std::string& out);
+
+    /**
+     * utf8Decode appends the characters of a UTF-8 encoded buffer to the
+     * output.  Each malformed sequence is decoded as a single replacement
+     * character.
+     *
+     * \param in            The UTF-8 encoded buffer.
+     * \param size          The number of bytes in the buffer.
+     * \param out           The wide string to which the characters are
+     *                      appended.
+     *
+     * \returns true if the buffer was well formed.
+     */
+    bool utf8Decode(const char* in, std::size_t size, std::wstring& out);
+
+    /**
+     * utf8Validate returns true if a buffer is well formed UTF-8, which is
+     * exactly when utf8Decode would return true for it.
+     *
+     * \param in            The UTF-8 encoded buffer.
+     * \param size          The number of bytes in the buffer.
+     */
+    bool utf8Validate(const char* in, std::size_t size);
+
+    /**
+     * utf8Accelerated returns true if the UTF-8 functions use the CPU's
+     * vector instructions.
+     */
+    bool utf8Accelerated();
+}
+
+#endif //VIX_UTF8_HEADER_GUARD
@@ -0,0 +1,65 @@
+#ifndef  VIX_UTF8_DECODER_HEADER_GUARD
+# define VIX_UTF8_DECODER_HEADER_GUARD
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vix
+{
+    /**
+     * A Utf8Decoder decodes UTF-8 which arrives in chunks, such as a file read
+     * a block at a time.  A sequence split between two chunks is held back
+     * until the rest of it arrives, so the characters decoded are exactly
+     * those utf8Decode would decode from all the chunks at once.
+     */
+    class Utf8Decoder
+    {
+    public:
+
+        /**
+         * Create a decoder at the start of its input.
+         */
+        Utf8Decoder();
+
+        /**
+         * Append the characters of the next chunk of input to the output.
+         * A sequence at the end of the chunk which may continue in the next
+         * is held back.
+         *
+         * \param in            The chunk.
+         * \param size          The number of bytes in the chunk.
+         * \param out           The wide string to which the characters are
+         *                      appended.
+         */
+        void decode(const char* in, std::size_t size, std::wstring& out);
+
+        /**
+         * Append anything held back to the output, as the input has ended,
+         * and start again.
+         *
+         * \param out           The wide string to which the characters are
+         *                      appended.
+         *
+         * \returns true if the input was well formed.
+         */
+        bool finish(std::wstring& out);
+
+        /**
+         * Returns true if the input decoded so far was well formed.
+         */
+        bool valid() const;
+
+        /**
+         * Returns the number of bytes held back.
+         */
+        std::size_t pending() const;
+
+    private:
+        char pending_[4];
+        std::size_t pendingSize_;
+        bool valid_;
+    };
+}
+
+#endif //VIX_UTF8_DECODER_HEADER_GUARD
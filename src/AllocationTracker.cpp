@@ -0,0 +1,185 @@
+#include <cstdlib>
+#include <new>
+#include <vix/AllocationTracker.h>
+#include <vix/Instrumentation.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //these are plain integers, so reaching them from operator new needs no
+    //thread local initialization, and so no allocation.
+    thread_local unsigned trackers = 0;
+    thread_local uint64_t threadAllocations = 0;
+    thread_local uint64_t threadBytes = 0;
+}
+
+/**
+ * Start counting the allocations made by this thread.
+ */
+AllocationTracker::AllocationTracker()
+    : allocations_(threadAllocations), bytes_(threadBytes)
+{
+    ++trackers;
+}
+
+/**
+ * Stop counting, unless an enclosing tracker is still counting.
+ */
+AllocationTracker::~AllocationTracker()
+{
+    --trackers;
+}
+
+/**
+ * Returns the number of allocations made since this tracker was created or
+ * reset.
+ */
+uint64_t
+AllocationTracker::allocations() const
+{
+    return threadAllocations - allocations_;
+}
+
+/**
+ * Returns the number of bytes asked for since this tracker was created or
+ * reset.
+ */
+uint64_t
+AllocationTracker::bytes() const
+{
+    return threadBytes - bytes_;
+}
+
+/**
+ * Count from zero again.
+ */
+void
+AllocationTracker::reset()
+{
+    allocations_ = threadAllocations;
+    bytes_ = threadBytes;
+}
+
+/**
+ * Returns true if allocations are seen.
+ */
+bool
+AllocationTracker::enabled()
+{
+#ifdef VIX_TRACK_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Count an allocation of the given size made by this thread.
+ */
+void
+AllocationTracker::allocated(size_t size)
+{
+    if (trackers)
+    {
+        ++threadAllocations;
+        threadBytes += size;
+    }
+}
+
+#ifdef VIX_TRACK_ALLOCATIONS
+
+/*
+ * Building with VIX_TRACK_ALLOCATIONS replaces the global operator new and
+ * delete for the whole program, so that Instrumentation and AllocationTracker
+ * can count heap allocations.  While neither is counting, each allocation
+ * costs one more relaxed load and a thread local test.
+ *
+ * The replacements live here rather than in a file of their own so that they
+ * are linked from the static library whenever AllocationTracker is: nothing
+ * refers to an object holding only operator new, and the linker would leave
+ * it out in favour of the C++ runtime's.
+ */
+
+namespace {
+    /**
+     * Count an allocation of the given size.
+     */
+    void count(size_t size)
+    {
+        Instrumentation::count(COUNTER_ALLOCATIONS);
+        Instrumentation::count(COUNTER_ALLOCATED_BYTES, size);
+        AllocationTracker::allocated(size);
+    }
+}
+
+void* operator new(size_t size)
+{
+    count(size);
+
+    //as the standard operator new does, give the new handler a chance to
+    //free some memory each time the allocation fails.
+    for (;;)
+    {
+        void* p = malloc(size ? size : 1);
+        if (p)
+            return p;
+
+        new_handler handler = get_new_handler();
+        if (!handler)
+            throw bad_alloc();
+
+        handler();
+    }
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new[](size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept
+{
+    free(p);
+}
+
+#endif //VIX_TRACK_ALLOCATIONS
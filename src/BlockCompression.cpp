@@ -0,0 +1,280 @@
+#include <cstring>
+#include <vix/BlockCompression.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string CORRUPT_BLOCK{"Compressed block is corrupt."};
+
+    //the shortest match the format can encode.
+    const size_t MIN_MATCH = 4;
+
+    //the format requires the last match to start at least this far from the
+    //end of the block.
+    const size_t MATCH_FIND_LIMIT = 12;
+
+    //the format requires the last bytes of a block to be literals.
+    const size_t LAST_LITERALS = 5;
+
+    //the farthest back a match can reference.
+    const size_t MAX_OFFSET = 65535;
+
+    //the size of the match finder's hash table.
+    const unsigned HASH_LOG = 12;
+
+    //the number of failed match attempts after which the match finder starts
+    //skipping ahead faster through incompressible data.
+    const unsigned SKIP_TRIGGER = 6;
+
+    inline uint32_t read32(const uint8_t* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+
+        return value;
+    }
+
+    inline uint32_t hash32(uint32_t sequence)
+    {
+        return (sequence * 2654435761U) >> (32 - HASH_LOG);
+    }
+
+    /**
+     * Write a length as a run of 255 bytes followed by the remainder.
+     */
+    inline uint8_t* writeLength(uint8_t* op, size_t length)
+    {
+        while (length >= 255)
+        {
+            *op++ = 255;
+            length -= 255;
+        }
+
+        *op++ = (uint8_t)length;
+
+        return op;
+    }
+
+    /**
+     * Write a sequence of literals optionally followed by a match.  A match
+     * length of zero writes a final, literal-only sequence.
+     */
+    uint8_t* writeSequence(
+        uint8_t* op, const uint8_t* literals, size_t literalLength,
+        size_t offset, size_t matchLength)
+    {
+        uint8_t* token = op++;
+
+        if (literalLength >= 15)
+        {
+            *token = 15 << 4;
+            op = writeLength(op, literalLength - 15);
+        }
+        else
+        {
+            *token = (uint8_t)(literalLength << 4);
+        }
+
+        if (literalLength > 0)
+            memcpy(op, literals, literalLength);
+        op += literalLength;
+
+        if (matchLength == 0)
+            return op;
+
+        *op++ = offset & 0xFF;
+        *op++ = (offset >> 8) & 0xFF;
+
+        matchLength -= MIN_MATCH;
+        if (matchLength >= 15)
+        {
+            *token |= 15;
+            op = writeLength(op, matchLength - 15);
+        }
+        else
+        {
+            *token |= (uint8_t)matchLength;
+        }
+
+        return op;
+    }
+
+    /**
+     * Read an extended length.
+     */
+    inline size_t readLength(const uint8_t*& ip, const uint8_t* end)
+    {
+        size_t length = 0;
+        uint8_t b;
+
+        do
+        {
+            if (ip >= end)
+                throw exception::Decompression(CORRUPT_BLOCK);
+
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+
+        return length;
+    }
+}
+
+/**
+ * compressBlockBound returns the largest size a block of the given size can
+ * have once compressed.
+ *
+ * \param size          The uncompressed size of the block.
+ */
+size_t
+vix::compressBlockBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+/**
+ * compressBlock compresses a buffer, replacing the contents of the output
+ * vector with the compressed block.
+ *
+ * \param in            The buffer to compress.
+ * \param size          The size of the buffer to compress.
+ * \param out           The vector receiving the compressed block.
+ */
+void
+vix::compressBlock(const void* in, size_t size, vector<uint8_t>& out)
+{
+    const uint8_t* base = (const uint8_t*)in;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    const uint8_t* end = base + size;
+
+    out.resize(compressBlockBound(size));
+    uint8_t* op = &out[0];
+
+    //blocks too small to hold a match are stored as literals.
+    if (size > MATCH_FIND_LIMIT)
+    {
+        const uint8_t* findLimit = end - MATCH_FIND_LIMIT;
+        const uint8_t* matchLimit = end - LAST_LITERALS;
+        vector<uint32_t> table(1U << HASH_LOG, 0);
+        unsigned misses = 0;
+
+        //the first position has nothing behind it to match.
+        ++ip;
+
+        while (ip < findLimit)
+        {
+            uint32_t sequence = read32(ip);
+            uint32_t h = hash32(sequence);
+            const uint8_t* ref = base + table[h];
+            table[h] = (uint32_t)(ip - base);
+
+            if (ip - ref > (ptrdiff_t)MAX_OFFSET || read32(ref) != sequence)
+            {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+
+            misses = 0;
+
+            //extend the match backwards over any pending literals.
+            while (ip > anchor && ref > base && ip[-1] == ref[-1])
+            {
+                --ip;
+                --ref;
+            }
+
+            //then forwards, as far as the format allows.
+            size_t length = MIN_MATCH;
+            while (ip + length < matchLimit && ip[length] == ref[length])
+                ++length;
+
+            op = writeSequence(op, anchor, ip - anchor, ip - ref, length);
+
+            ip += length;
+            anchor = ip;
+        }
+    }
+
+    op = writeSequence(op, anchor, end - anchor, 0, 0);
+
+    out.resize(op - &out[0]);
+}
+
+/**
+ * decompressBlock decompresses a block previously written by compressBlock.
+ * The block must decompress to exactly outSize bytes.
+ *
+ * \param in            The compressed block.
+ * \param size          The size of the compressed block.
+ * \param out           The buffer receiving the decompressed data.
+ * \param outSize       The uncompressed size of the block.
+ *
+ * \throw vix::exception::Decompression if the block is malformed.
+ */
+void
+vix::decompressBlock(const void* in, size_t size, void* out, size_t outSize)
+{
+    const uint8_t* ip = (const uint8_t*)in;
+    const uint8_t* end = ip + size;
+    uint8_t* const base = (uint8_t*)out;
+    uint8_t* op = base;
+    uint8_t* const outEnd = base + outSize;
+
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+
+        //copy the literals.
+        size_t literalLength = token >> 4;
+        if (literalLength == 15)
+            literalLength += readLength(ip, end);
+
+        if ((size_t)(end - ip) < literalLength
+         || (size_t)(outEnd - op) < literalLength)
+            throw exception::Decompression(CORRUPT_BLOCK);
+
+        if (literalLength > 0)
+            memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        //the last sequence has no match.
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            throw exception::Decompression(CORRUPT_BLOCK);
+
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if (offset == 0 || offset > (size_t)(op - base))
+            throw exception::Decompression(CORRUPT_BLOCK);
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15)
+            matchLength += readLength(ip, end);
+        matchLength += MIN_MATCH;
+
+        if ((size_t)(outEnd - op) < matchLength)
+            throw exception::Decompression(CORRUPT_BLOCK);
+
+        //matches may overlap their own output, so copy forwards.
+        const uint8_t* ref = op - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(op, ref, matchLength);
+            op += matchLength;
+        }
+        else
+        {
+            for (size_t i = 0; i < matchLength; ++i)
+                *op++ = *ref++;
+        }
+    }
+
+    if (op != outEnd)
+        throw exception::Decompression(CORRUPT_BLOCK);
+}
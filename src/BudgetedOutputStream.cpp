@@ -0,0 +1,124 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vix/BudgetedOutputStream.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //the size of each write charged to the budget.
+    const size_t CHUNK_SIZE = 64 * 1024;
+
+    /**
+     * Open a file for writing, throwing if it can't be.
+     */
+    int openForWriting(const string& path)
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            throw exception::FileOpen("Could not create " + path + ".");
+
+        return fd;
+    }
+}
+
+/**
+ * Create or truncate the file at the given path.
+ *
+ * \throw vix::exception::FileOpen if the file cannot be created.
+ */
+BudgetedOutputStream::BudgetedOutputStream(const string& path, IoBudget& budget)
+    : std::ostream(nullptr), path_(path), fd_(openForWriting(path)),
+      buffer_(fd_, budget)
+{
+    //the buffer is only constructed after the ostream base.
+    rdbuf(&buffer_);
+}
+
+/**
+ * Destructor.  Flush and close the file, ignoring any errors.
+ */
+BudgetedOutputStream::~BudgetedOutputStream()
+{
+    buffer_.pubsync();
+    close(fd_);
+}
+
+/**
+ * Flush everything written and sync the file to disk.
+ *
+ * \throw vix::exception::FileWrite if the file cannot be written.
+ */
+void
+BudgetedOutputStream::commit()
+{
+    if (bad() || buffer_.pubsync() < 0 || fsync(fd_) < 0)
+        throw exception::FileWrite("Could not write " + path_ + ".");
+}
+
+/**
+ * Start or stop charging writes to the budget.
+ */
+void
+BudgetedOutputStream::budgeted(bool enabled)
+{
+    buffer_.charging = enabled;
+}
+
+BudgetedOutputStream::BudgetedBuffer::BudgetedBuffer(int fd, IoBudget& budget)
+    : charging(true), fd_(fd), budget_(budget), chunk_(CHUNK_SIZE)
+{
+    setp(chunk_.data(), chunk_.data() + chunk_.size());
+}
+
+/**
+ * Write out the full chunk, then buffer the character which didn't fit.
+ */
+BudgetedOutputStream::BudgetedBuffer::int_type
+BudgetedOutputStream::BudgetedBuffer::overflow(int_type c)
+{
+    if (sync() < 0)
+        return traits_type::eof();
+
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+/**
+ * Charge the buffered chunk to the budget and write it out.
+ */
+int
+BudgetedOutputStream::BudgetedBuffer::sync()
+{
+    const char* p = pbase();
+    size_t size = pptr() - pbase();
+
+    if (charging)
+        budget_.consume(size);
+
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd_, p, size);
+
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return -1;
+        }
+
+        p += written;
+        size -= written;
+    }
+
+    setp(chunk_.data(), chunk_.data() + chunk_.size());
+
+    return 0;
+}
@@ -1,11 +1,93 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include <vix/Buffer.h>
+#include <vix/BufferChangeDispatcher.h>
+#include <vix/BufferSnapshot.h>
+#include <vix/Instrumentation.h>
+#include <vix/LineBlock.h>
+#include <vix/TaskScheduler.h>
 
+using namespace std;
 using namespace vix;
 
+const size_t Buffer::COLD_BLOCK_LINES = 256;
+
+/**
+ * What compressCold knows of the buffer's blocks, so that it never has to walk
+ * the whole buffer after the first time.  The compression tasks, and the
+ * blocks being read, share this with the buffer, so the buffer can go before
+ * they are done with it.
+ */
+struct Buffer::ColdCompression
+{
+    std::mutex mutex;
+    condition_variable idle;
+    size_t compressing;
+
+    //the cold blocks decompressed since the last sweep, reported from
+    //whichever thread read them.
+    vector<const LineBlock*> decompressed;
+
+    //the rest is only touched by the editing thread.  Each block's lines in
+    //the buffer are listed, so a block can be swept without finding them;
+    //lines which have been given a new value in place are skipped.
+    unordered_map<const LineBlock*, vector<iterator>> blocks;
+
+    //the blocks with decompressed contents, which are all a sweep visits,
+    //and those made since the last sweep.
+    unordered_set<const LineBlock*> warm;
+    vector<const LineBlock*> made;
+
+    //the blocks replaced by the last sweep, kept so that references to their
+    //contents stay good until the next.
+    vector<shared_ptr<LineBlock>> retired;
+
+    //where the lines' contents have been moved, while compressCold or
+    //waitForCompression runs, for the asynchronous observers' copy of them.
+    BufferChangeDispatcher::Moves moves;
+
+    //once compressCold has looked at the whole buffer, the first line of each
+    //run of lines inserted since is remembered, which is where new runs of
+    //uncompressed lines are looked for.
+    bool tracking;
+    unordered_map<const Line*, iterator> fresh;
+
+    ColdCompression()
+        : compressing(0), tracking(false)
+    {
+    }
+
+    /**
+     * Forget the lines of a buffer which is being emptied.
+     */
+    void clear()
+    {
+        blocks.clear();
+        warm.clear();
+        made.clear();
+        fresh.clear();
+    }
+};
+
 /**
  * Default constructor.  Create an empty buffer.
  */
 Buffer::Buffer()
+    : interning_(false), compression_(make_shared<ColdCompression>()),
+      version_(make_shared<atomic<uint64_t>>(0)),
+      changed_(lines_.begin()), changedLine_(0), changedKnown_(true),
+      changeRemoved_(0), changeInserted_(0),
+      anchor_(lines_.begin()), anchorLine_(0), anchored_(false),
+      deferredPending_(false), dispatchingDeferred_(false),
+      deferredChange_(BufferChange{0, 0, 0})
 {
 }
 
@@ -16,6 +98,117 @@ Buffer::~Buffer()
 {
 }
 
+/**
+ * Register an observer to be called synchronously.
+ */
+void
+Buffer::addObserver(shared_ptr<BufferChangeObserver> observer)
+{
+    if (budget_)
+        budget_->forget(*observer);
+
+    pattern::Observable<BufferChangeObserver>::addObserver(observer);
+}
+
+/**
+ * Register an observer to be called asynchronously, with coalesced changes.
+ * The first asynchronous observer or reader makes their copy of the lines on
+ * the calling thread, which takes time in proportion to the number of lines.
+ */
+void
+Buffer::addObserver(shared_ptr<AsyncBufferChangeObserver> observer)
+{
+    dispatcher().addObserver(observer);
+}
+
+/**
+ * Wait until asynchronous observers have been told of every change made so
+ * far.
+ */
+void
+Buffer::waitForObservers()
+{
+    if (dispatcher_)
+        dispatcher_->wait();
+}
+
+/**
+ * Call the given function, as a task, with the lines of this buffer as they
+ * are now, so that work on the whole buffer never copies the lines' contents on
+ * the editing thread.  The function is called along with the asynchronous
+ * observers, once they have been told of every change made so far, and mustn't
+ * keep the lines after it returns.  If there are no asynchronous observers yet,
+ * the first call makes their copy of the lines on the calling thread: it moves
+ * the contents of each long line into storage shared with the copy, and copies
+ * the list, which takes time in proportion to the number of lines, though no
+ * line's contents are copied.
+ */
+void
+Buffer::readLines(LinesReader reader) const
+{
+    //the dispatcher's copy of the lines is only ever touched by its tasks,
+    //once it has been made.
+    dispatcher().read(reader);
+}
+
+/**
+ * Give each call to a synchronous observer the given time budget, and keep
+ * statistics on how long each observer takes.  A zero budget stops the timing.
+ */
+void
+Buffer::observerBudget(
+    ObserverBudget::clock::duration budget, bool demote,
+    ObserverBudget::SlowHandler handler)
+{
+    //observers still waiting on changes get them before the budget goes.
+    dispatchDeferred();
+
+    if (budget == ObserverBudget::clock::duration::zero())
+        budget_.reset();
+    else
+        budget_.reset(new ObserverBudget(budget, demote, handler));
+}
+
+/**
+ * Returns the statistics kept on a synchronous observer since the budget was
+ * set.
+ */
+ObserverBudget::Statistics
+Buffer::observerStatistics(const BufferChangeObserver& observer) const
+{
+    if (!budget_)
+        return ObserverBudget::Statistics();
+
+    return budget_->statistics(observer);
+}
+
+/**
+ * Call the deferred observers, once, with the changes made since they were
+ * last called merged into a single lastChange.
+ */
+void
+Buffer::dispatchDeferred()
+{
+    if (!deferredPending_ || !budget_)
+        return;
+
+    deferredPending_ = false;
+    dispatchingDeferred_ = true;
+
+    notify(
+        [=](BufferChangeObserver& o) {
+            if (!budget_->takeSkipped(o, deferredChange_))
+                return;
+
+            InstrumentationTimer observerTimer(o);
+            auto start = ObserverBudget::clock::now();
+            o.onBufferChanged(this);
+            budget_->record(o, ObserverBudget::clock::now() - start);
+        });
+
+    dispatchingDeferred_ = false;
+}
+
 /**
  * Return the begin iterator of the buffer.
  */
@@ -94,9 +287,13 @@ Buffer::rend() const
 void
 Buffer::insert(const Line& newLine)
 {
+    InstrumentationTimer timer(TIMER_BUFFER_INSERT);
+
     lines_.push_front(newLine);
+    internLine(lines_.front());
 
     //let the observers know that the buffer has changed.
+    recordChange(lines_.begin(), 0, 0, 1);
     notifyChanged();
 }
 
@@ -106,9 +303,43 @@ Buffer::insert(const Line& newLine)
 void
 Buffer::append(const Line& newLine)
 {
+    InstrumentationTimer timer(TIMER_BUFFER_APPEND);
+
     lines_.push_back(newLine);
+    internLine(lines_.back());
+
+    //let the observers know that the buffer has changed.
+    recordChange(prev(lines_.end()), lines_.size() - 1, 0, 1);
+    notifyChanged();
+}
+
+/**
+ * Append all of the given lines to the end of the buffer.  The lines are moved
+ * out of the given list, which is left empty.  Observers are notified once.
+ */
+void
+Buffer::append(LineList& newLines)
+{
+    InstrumentationTimer timer(TIMER_BUFFER_APPEND);
+
+    if (newLines.empty())
+        return;
+
+    auto first = newLines.begin();
+    size_t line = lines_.size();
+    size_t count = newLines.size();
+
+    //splicing the whole list is constant time.
+    lines_.splice(lines_.end(), newLines);
+
+    if (interning_)
+    {
+        for (auto i = first; i != lines_.end(); ++i)
+            internTable_.intern(*i);
+    }
 
     //let the observers know that the buffer has changed.
+    recordChange(first, line, 0, count);
     notifyChanged();
 }
 
@@ -118,9 +349,13 @@ Buffer::append(const Line& newLine)
 void
 Buffer::insert(const Buffer::iterator& before, const Line& newLine)
 {
-    lines_.insert(before, newLine);
+    InstrumentationTimer timer(TIMER_BUFFER_INSERT);
+
+    auto inserted = lines_.insert(before, newLine);
+    internLine(*inserted);
 
     //let the observers know that the buffer has changed.
+    recordChange(inserted, 0, 1);
     notifyChanged();
 }
 
@@ -130,20 +365,27 @@ Buffer::insert(const Buffer::iterator& before, const Line& newLine)
 void
 Buffer::append(const Buffer::iterator& after, const Line& newLine)
 {
+    InstrumentationTimer timer(TIMER_BUFFER_APPEND);
+
     Buffer::iterator position = after;
 
     if (after == lines_.end() || (++position) == lines_.end())
     {
         lines_.push_back(newLine);
+        internLine(lines_.back());
+
+        recordChange(prev(lines_.end()), lines_.size() - 1, 0, 1);
     }
     else
     {
         //note that this insert ONLY occurs if position above is incremented.
         //this hackery with the OR is needed to prevent us from incrementing
         //past the end of the list.
-        lines_.insert(position, newLine);
-    }
+        auto inserted = lines_.insert(position, newLine);
+        internLine(*inserted);
 
+        recordChange(inserted, 0, 1);
+    }
 
     //let the observers know that the buffer has changed.
     notifyChanged();
@@ -155,9 +397,13 @@ Buffer::append(const Buffer::iterator& after, const Line& newLine)
 void
 Buffer::erase(const Buffer::iterator& line)
 {
-    lines_.erase(line);
+    InstrumentationTimer timer(TIMER_BUFFER_ERASE);
+
+    erasing(line);
+    auto following = lines_.erase(line);
 
     //let the observers know that the buffer has changed.
+    recordChange(following, 1, 0);
     notifyChanged();
 }
 
@@ -167,33 +413,97 @@ Buffer::erase(const Buffer::iterator& line)
 void
 Buffer::replace(const iterator& line, const Line& newLine)
 {
+    InstrumentationTimer timer(TIMER_BUFFER_REPLACE);
+
     //this only works if the iterator is a valid line
     if (line != lines_.end())
     {
         //insert the new line before this line.
         auto nl = lines_.insert(line, newLine);
+        internLine(*nl);
 
         //the iterator points to the new line before the line to be erased.
         //increment to the line to be erased.
         ++nl;
 
         //now, erase the old line.
-        lines_.erase(nl);
+        erasing(nl);
+        nl = lines_.erase(nl);
 
         //notify observers that the buffer has changed
+        recordChange(--nl, 1, 1);
         notifyChanged();
     }
 }
 
+/**
+ * Replace the given number of characters at the given column of a line with
+ * the given text, changing the line in place.  Observers see the line
+ * replaced.
+ */
+void
+Buffer::replace(const iterator& line, size_t column, size_t length, const wstring& text)
+{
+    InstrumentationTimer timer(TIMER_BUFFER_REPLACE);
+
+    assert(line != lines_.end());
+
+    auto& contents = line->own();
+
+    assert(column <= contents.size() && length <= contents.size() - column);
+
+    contents.replace(column, length, text);
+    internLine(*line);
+
+    //notify observers that the buffer has changed
+    recordChange(line, 1, 1);
+    notifyChanged();
+}
+
+/**
+ * Replace the contents of this buffer with the given lines.  The lines are
+ * moved out of the given list, which is left empty.  Observers are notified
+ * once.
+ */
+void
+Buffer::assign(LineList& newLines)
+{
+    InstrumentationTimer timer(TIMER_BUFFER_ASSIGN);
+
+    size_t removed = lines_.size();
+
+    lines_.clear();
+    internTable_.clear();
+    compression_->clear();
+    lines_.swap(newLines);
+
+    if (interning_)
+    {
+        for (auto& line : lines_)
+            internTable_.intern(line);
+    }
+
+    //let the observers know that the buffer has changed.
+    recordChange(lines_.begin(), 0, removed, lines_.size());
+    notifyChanged();
+}
+
 /**
  * Clear the buffer.
  */
 void
 Buffer::clear()
 {
+    InstrumentationTimer timer(TIMER_BUFFER_CLEAR);
+
+    size_t removed = lines_.size();
+
     lines_.clear();
+    internTable_.clear();
+    compression_->clear();
 
     //let the observers know that the buffer has changed.
+    recordChange(lines_.begin(), 0, removed, 0);
     notifyChanged();
 }
 
@@ -207,11 +517,771 @@ Buffer::lines() const
 }
 
 /**
- * Notify all observers that the buffer has been changed.
+ * Returns the index of a line.  This walks from the line towards both ends of
+ * the buffer at once, stopping early at the first line of the last change, so
+ * costs the distance to the nearest of the three.
+ */
+size_t
+Buffer::lineNumber(const_iterator line) const
+{
+    findChange();
+
+    const_iterator back = line;
+    const_iterator forward = line;
+    const_iterator changed = changed_;
+    size_t distance = 0;
+    size_t index;
+
+    for (;;)
+    {
+        if (back == lines_.begin())
+        {
+            index = distance;
+            break;
+        }
+
+        if (forward == lines_.end())
+        {
+            index = lines_.size() - distance;
+            break;
+        }
+
+        if (back == changed)
+        {
+            index = changedLine_ + distance;
+            break;
+        }
+
+        if (forward == changed)
+        {
+            index = changedLine_ - distance;
+            break;
+        }
+
+        --back;
+        ++forward;
+        ++distance;
+    }
+
+    Instrumentation::count(COUNTER_LINES_WALKED, distance);
+
+    return index;
+}
+
+/**
+ * Returns the line at the given index, or end() if there isn't one.  This
+ * walks from the nearest of the ends of the buffer and the first line of the
+ * last change.
+ */
+Buffer::iterator
+Buffer::line(size_t index)
+{
+    if (index >= lines_.size())
+        return lines_.end();
+
+    findChange();
+
+    size_t fromEnd = lines_.size() - index;
+    size_t fromChange = index > changedLine_ ? index - changedLine_ : changedLine_ - index;
+
+    if (fromChange < index && fromChange < fromEnd)
+    {
+        Instrumentation::count(COUNTER_LINES_WALKED, fromChange);
+
+        auto line = changed_;
+        if (index > changedLine_)
+            advance(line, fromChange);
+        else
+            advance(line, -static_cast<ptrdiff_t>(fromChange));
+
+        return line;
+    }
+
+    Instrumentation::count(COUNTER_LINES_WALKED, min(index, fromEnd));
+
+    if (index <= fromEnd)
+        return next(lines_.begin(), index);
+
+    return prev(lines_.end(), fromEnd);
+}
+
+Buffer::const_iterator
+Buffer::line(size_t index) const
+{
+    return const_cast<Buffer*>(this)->line(index);
+}
+
+/**
+ * Returns the version of this buffer, which starts at zero and goes up by one
+ * with every change.  Reading the version is safe from any thread.
+ */
+uint64_t
+Buffer::version() const
+{
+    return *version_;
+}
+
+/**
+ * Returns a token which goes stale as soon as this buffer changes, for work
+ * derived from the buffer as it is now.  The token remains safe to check once
+ * the buffer is gone.
+ */
+CancellationToken
+Buffer::changeToken() const
+{
+    auto version = version_;
+    uint64_t current = *version;
+
+    return CancellationToken([version, current] { return *version != current; });
+}
+
+/**
+ * Returns the most recent change.  Before the first change, this is an empty
+ * change at the start of the buffer.
+ */
+BufferChange
+Buffer::lastChange() const
+{
+    if (dispatchingDeferred_)
+        return deferredChange_;
+
+    findChange();
+
+    return BufferChange{changedLine_, changeRemoved_, changeInserted_};
+}
+
+/**
+ * Returns true if this buffer interns the lines added to it.
+ */
+bool
+Buffer::interning() const
+{
+    return interning_;
+}
+
+/**
+ * Enable or disable line interning.  When enabled, lines with identical
+ * contents share a single copy of their storage.  Enabling interning interns
+ * the lines already in the buffer.
+ */
+void
+Buffer::interning(bool enabled)
+{
+    if (enabled == interning_)
+        return;
+
+    interning_ = enabled;
+
+    if (interning_)
+    {
+        for (auto& line : lines_)
+            internTable_.intern(line);
+    }
+    else
+    {
+        //interned lines keep sharing their storage; only the table goes.
+        internTable_.clear();
+    }
+}
+
+/**
+ * Compress the cold regions of this buffer.  Blocks which have not been read
+ * since the previous call are replaced by blocks holding only their compressed
+ * data, and every run of blockLines consecutive uncompressed lines is moved
+ * into a new block, which is compressed on the standard TaskScheduler.  Lines
+ * shared with the asynchronous observers' copy of them are compressed in both.
+ * The first call looks at every line; later calls only at the blocks which
+ * have been decompressed, and the lines inserted since the call before.
+ * Iterators remain valid, and references returned by Line::str() for lines in
+ * this buffer stay valid until the next call.
+ */
+void
+Buffer::compressCold(size_t blockLines)
+{
+    assert(blockLines > 0);
+
+    auto& cold = *compression_;
+
+    cold.retired.clear();
+    cold.made.clear();
+
+    sweepBlocks(vector<const LineBlock*>(cold.warm.begin(), cold.warm.end()));
+
+    if (!cold.tracking)
+    {
+        cold.tracking = true;
+
+        trackInserted(lines_.begin(), lines_.end());
+        cold.fresh.clear();
+
+        for (auto line = lines_.begin(); line != lines_.end(); )
+        {
+            if (compressible(*line))
+                line = compressRuns(line, blockLines);
+            else
+                ++line;
+        }
+
+        postMoves();
+
+        return;
+    }
+
+    //a run may start before the lines inserted, among uncompressed lines left
+    //over from before.
+    while (!cold.fresh.empty())
+    {
+        auto line = cold.fresh.begin()->second;
+        cold.fresh.erase(cold.fresh.begin());
+
+        if (!compressible(*line))
+            continue;
+
+        while (line != lines_.begin() && compressible(*prev(line)))
+            --line;
+
+        compressRuns(line, blockLines);
+    }
+
+    postMoves();
+}
+
+/**
+ * Wait until every block started by compressCold has been compressed, and
+ * replace those which haven't been read since with their compressed data.
+ */
+void
+Buffer::waitForCompression()
+{
+    {
+        unique_lock<std::mutex> lock(compression_->mutex);
+        compression_->idle.wait(lock, [this] {
+            return compression_->compressing == 0;
+        });
+    }
+
+    vector<const LineBlock*> made;
+    made.swap(compression_->made);
+
+    sweepBlocks(made);
+    postMoves();
+}
+
+/**
+ * Replace the contents of this buffer with a snapshot read from a binary input
+ * stream.
+ *
+ * \throw vix::exception::SerialRead if serialization fails.
+ */
+void
+Buffer::serialRead(std::istream& in)
+{
+    readBufferSnapshot(in, *this);
+}
+
+/**
+ * Write a snapshot of this buffer to a binary output stream.
+ *
+ * \throw vix::exception::SerialWrite if serialization fails.
+ */
+void
+Buffer::serialWrite(std::ostream& out) const
+{
+    writeBufferSnapshot(out, *this);
+}
+
+/**
+ * Intern the given line if interning is enabled.
+ */
+void
+Buffer::internLine(Line& line)
+{
+    if (interning_)
+        internTable_.intern(line);
+}
+
+/**
+ * Returns the dispatcher for asynchronous observers and readers, making it if
+ * there is none yet.  The lines share their contents with its copy of them, so
+ * the buffer's contents are never held twice.
+ */
+BufferChangeDispatcher&
+Buffer::dispatcher() const
+{
+    if (!dispatcher_)
+    {
+        //sharing changes how the lines hold their contents, not what they
+        //are.
+        for (auto& line : const_cast<LineList&>(lines_))
+            line.publish();
+
+        dispatcher_.reset(new BufferChangeDispatcher(lines_));
+    }
+
+    return *dispatcher_;
+}
+
+/**
+ * Returns true if compressCold may move the given line's contents into a
+ * block: it holds them itself, or shares them with the asynchronous observers'
+ * copy of it.  While interning, shared lines are interned ones, which are left
+ * as they are.
+ */
+bool
+Buffer::compressible(const Line& line) const
+{
+    if (line.storage_ == Line::SHARED)
+        return dispatcher_ && !interning_;
+
+    return line.storage_ == Line::OWNED;
+}
+
+/**
+ * Tell the asynchronous observers where compressCold moved the contents of the
+ * lines.
+ */
+void
+Buffer::postMoves()
+{
+    auto& moves = compression_->moves;
+
+    if (moves.lines.empty() && moves.blocks.empty())
+        return;
+
+    if (dispatcher_)
+        dispatcher_->moved(moves);
+
+    moves.lines.clear();
+    moves.blocks.clear();
+}
+
+/**
+ * Sweep the given blocks, and those decompressed since the last sweep,
+ * replacing those which have not been read since with blocks holding only
+ * their compressed data, so their decompressed contents go once nothing else
+ * refers to them.
+ */
+void
+Buffer::sweepBlocks(vector<const LineBlock*> blocks)
+{
+    auto& cold = *compression_;
+
+    {
+        lock_guard<std::mutex> lock(cold.mutex);
+
+        //the blocks decompressed since are swept along with the given ones.
+        for (auto block : cold.decompressed)
+        {
+            if (cold.warm.insert(block).second)
+                blocks.push_back(block);
+        }
+
+        cold.decompressed.clear();
+    }
+
+    //blocks made by a sweep tell the buffer when they are decompressed, as
+    //long as it is still around.
+    weak_ptr<ColdCompression> weak = compression_;
+    auto decompressed = [weak](const LineBlock* block) {
+        auto compression = weak.lock();
+        if (!compression)
+            return;
+
+        lock_guard<std::mutex> lock(compression->mutex);
+        compression->decompressed.push_back(block);
+    };
+
+    for (auto key : blocks)
+    {
+        auto entry = cold.blocks.find(key);
+
+        //the lines of a block are only listed while the buffer has some.
+        shared_ptr<LineBlock> block;
+        if (entry != cold.blocks.end())
+        {
+            for (auto line : entry->second)
+            {
+                if (line->storage_ == Line::COMPRESSED && line->block_.block.get() == key)
+                {
+                    block = line->block_.block;
+                    break;
+                }
+            }
+        }
+
+        if (!block)
+        {
+            if (entry != cold.blocks.end())
+                cold.blocks.erase(entry);
+
+            cold.warm.erase(key);
+            continue;
+        }
+
+        //a block still being compressed has nothing to go back to.
+        if (!block->compressed() || !block->sweep())
+            continue;
+
+        auto replacement = block->cold(decompressed);
+
+        vector<iterator> lines;
+        lines.swap(entry->second);
+        cold.blocks.erase(entry);
+        cold.warm.erase(key);
+
+        auto& replaced = cold.blocks[replacement.get()];
+        for (auto line : lines)
+        {
+            if (line->storage_ == Line::COMPRESSED && line->block_.block == block)
+            {
+                line->compress(replacement, line->block_.index);
+                replaced.push_back(line);
+            }
+        }
+
+        //the asynchronous observers' copy of the lines lets go of the block
+        //as well.
+        if (dispatcher_)
+            cold.moves.blocks.emplace(block, replacement);
+
+        cold.retired.push_back(block);
+    }
+}
+
+/**
+ * Compress the runs of uncompressed lines from the given line up to the next
+ * line which isn't, and forget the lines looked at as inserted.
+ *
+ * \returns the line which isn't uncompressed.
+ */
+Buffer::iterator
+Buffer::compressRuns(iterator line, size_t blockLines)
+{
+    auto& cold = *compression_;
+    vector<iterator> run;
+
+    run.reserve(blockLines);
+
+    //empty lines have nothing to compress, but don't break up a run.
+    for (; line != lines_.end() && compressible(*line); ++line)
+    {
+        cold.fresh.erase(&*line);
+
+        if (line->str().empty())
+            continue;
+
+        run.push_back(line);
+
+        if (run.size() == blockLines)
+        {
+            compressRun(run);
+            run.clear();
+        }
+    }
+
+    return line;
+}
+
+/**
+ * Move the contents of the given lines into a new block, and compress it in
+ * the background.
+ */
+void
+Buffer::compressRun(const vector<iterator>& run)
+{
+    auto& cold = *compression_;
+    vector<wstring> contents;
+
+    contents.reserve(run.size());
+
+    //contents shared with the asynchronous observers' copy of the lines are
+    //copied, and that copy is moved to the block once it's told.
+    for (auto line : run)
+    {
+        if (line->storage_ == Line::OWNED)
+            contents.push_back(move(line->str_));
+        else
+            contents.push_back(*line->shared_);
+    }
+
+    auto block = make_shared<LineBlock>(contents);
+
+    for (size_t i = 0; i < run.size(); ++i)
+    {
+        auto shared = run[i]->storage_ == Line::SHARED ? run[i]->shared_ : nullptr;
+
+        run[i]->compress(block, i);
+
+        if (shared && dispatcher_)
+            cold.moves.lines.emplace(shared, *run[i]);
+    }
+
+    cold.blocks[block.get()] = run;
+    cold.warm.insert(block.get());
+    cold.made.push_back(block.get());
+
+    auto compression = compression_;
+
+    {
+        lock_guard<std::mutex> lock(compression->mutex);
+        ++compression->compressing;
+    }
+
+    TaskScheduler::standard().submit([=] {
+        //there's no one to report a failure to; the block just keeps its
+        //contents uncompressed.
+        try
+        {
+            block->compress();
+        }
+        catch (...)
+        {
+        }
+
+        lock_guard<std::mutex> lock(compression->mutex);
+
+        if (--compression->compressing == 0)
+            compression->idle.notify_all();
+    }, TaskScheduler::BACKGROUND);
+}
+
+/**
+ * List the compressed lines among the given lines under their blocks, and
+ * remember where the run of lines starts, once compressCold keeps track.
+ */
+void
+Buffer::trackInserted(iterator first, iterator last)
+{
+    auto& cold = *compression_;
+
+    if (first == last)
+        return;
+
+    cold.fresh.emplace(&*first, first);
+
+    for (auto line = first; line != last; ++line)
+    {
+        if (line->storage_ != Line::COMPRESSED)
+            continue;
+
+        auto block = line->block_.block.get();
+
+        cold.blocks[block].push_back(line);
+
+        if (block->decompressed())
+            cold.warm.insert(block);
+    }
+}
+
+/**
+ * Called before a line is erased, so the first line of the last change, and
+ * what compressCold keeps track of, is never one that has gone.
+ */
+void
+Buffer::erasing(iterator line)
+{
+    //the line after has the next index, as of before the coming change.
+    if (line == changed_ && changedKnown_)
+    {
+        ++changed_;
+        ++changedLine_;
+    }
+
+    auto& cold = *compression_;
+    if (!cold.tracking)
+        return;
+
+    //the lines inserted after this one are still looked at.
+    auto fresh = cold.fresh.find(&*line);
+    if (fresh != cold.fresh.end())
+    {
+        cold.fresh.erase(fresh);
+
+        auto following = next(line);
+        if (following != lines_.end())
+            cold.fresh.emplace(&*following, following);
+    }
+
+    if (line->storage_ != Line::COMPRESSED)
+        return;
+
+    auto entry = cold.blocks.find(line->block_.block.get());
+    if (entry == cold.blocks.end())
+        return;
+
+    auto& lines = entry->second;
+    auto listed = find(lines.begin(), lines.end(), line);
+    if (listed != lines.end())
+    {
+        *listed = lines.back();
+        lines.pop_back();
+    }
+
+    if (lines.empty())
+        cold.blocks.erase(entry);
+}
+
+/**
+ * Work out the index of the most recent change, if it isn't known.  This walks
+ * from the change's first line towards both ends of the buffer and the first
+ * line of the change before, whichever comes first.
+ */
+void
+Buffer::findChange() const
+{
+    if (changedKnown_)
+        return;
+
+    const_iterator back = changed_;
+    const_iterator forward = changed_;
+    const_iterator anchor = anchor_;
+    size_t distance = 0;
+
+    for (;;)
+    {
+        //lines after the change moved up or down with it; those before it
+        //kept their indexes.
+        if (anchored_ && forward == anchor)
+        {
+            changedLine_ = anchorLine_ + changeInserted_ - changeRemoved_ - distance;
+            break;
+        }
+
+        if (anchored_ && back == anchor)
+        {
+            changedLine_ = anchorLine_ + distance;
+            break;
+        }
+
+        if (back == lines_.begin())
+        {
+            changedLine_ = distance;
+            break;
+        }
+
+        if (forward == lines_.end())
+        {
+            changedLine_ = lines_.size() - distance;
+            break;
+        }
+
+        --back;
+        ++forward;
+        ++distance;
+    }
+
+    Instrumentation::count(COUNTER_LINES_WALKED, distance);
+
+    changedKnown_ = true;
+}
+
+/**
+ * Record a change: the given number of lines were removed where the given line
+ * now is, and the given number inserted starting with it.
+ */
+void
+Buffer::recordChange(iterator first, size_t removed, size_t inserted)
+{
+    //an unknown index can't be found from a change before it which wasn't
+    //worked out either.
+    anchor_ = changed_;
+    anchorLine_ = changedLine_;
+    anchored_ = changedKnown_;
+
+    changed_ = first;
+    changedKnown_ = false;
+    changeRemoved_ = removed;
+    changeInserted_ = inserted;
+}
+
+/**
+ * Record a change whose first line has the given index.
+ */
+void
+Buffer::recordChange(iterator first, size_t line, size_t removed, size_t inserted)
+{
+    recordChange(first, removed, inserted);
+
+    changedLine_ = line;
+    changedKnown_ = true;
+}
+
+/**
+ * Notify all observers of the change just recorded.
  */
 void
 Buffer::notifyChanged()
 {
+    uint64_t version = ++*version_;
+
+    //while deferred observers are being called, lastChange reports what they
+    //missed rather than this.
+    auto change = [this] {
+        findChange();
+
+        return BufferChange{changedLine_, changeRemoved_, changeInserted_};
+    };
+
+    auto last = changed_;
+    for (size_t i = 0; i < changeInserted_; ++i)
+    {
+        //asynchronous observers share the contents of the inserted lines.
+        if (dispatcher_)
+            last->publish();
+
+        (last++)->stamp_ = version;
+    }
+
+    if (compression_->tracking)
+        trackInserted(changed_, last);
+
+    //asynchronous observers get their own copies of the inserted lines, which
+    //share their contents, and need to know where they go.
+    if (dispatcher_)
+    {
+        LineList lines(changed_, last);
+
+        dispatcher_->post(change(), lines);
+    }
+
+    InstrumentationTimer timer(TIMER_BUFFER_NOTIFY);
+
+    if (!budget_)
+    {
+        notify(
+            [=](BufferChangeObserver& o) {
+                InstrumentationTimer observerTimer(o);
+                o.onBufferChanged(this);
+            });
+
+        return;
+    }
+
+    bool deferred = false;
+    budgeted_.clear();
+
     notify(
-        [=](BufferChangeObserver& o) { o.onBufferChanged(this); });
+        [&](BufferChangeObserver& o) {
+            budgeted_.push_back(&o);
+
+            if (budget_->deferred(o))
+            {
+                budget_->skipped(o, change());
+                deferred = true;
+                return;
+            }
+
+            InstrumentationTimer observerTimer(o);
+            auto start = ObserverBudget::clock::now();
+            o.onBufferChanged(this);
+            budget_->record(o, ObserverBudget::clock::now() - start);
+        });
+
+    //observers which have gone since the last change leave nothing behind
+    //for another observer at the same address to inherit.
+    if (budget_->size() > budgeted_.size())
+        budget_->retain(budgeted_);
+
+    if (deferred)
+        deferredPending_ = true;
 }
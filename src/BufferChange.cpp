@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <vix/BufferChange.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Returns true if the given change, which followed this one, touches the lines
+ * this one inserted, or the lines on either side of them.
+ */
+bool
+BufferChange::touches(const BufferChange& next) const
+{
+    return next.line <= line + inserted && next.line + next.removed >= line;
+}
+
+/**
+ * Merge the given change, which followed this one, into this change, so that
+ * this change covers both.  Changes which don't touch merge into one which
+ * also covers the lines between them.
+ */
+void
+BufferChange::merge(const BufferChange& next)
+{
+    //the end of the range covered by both changes, in the lines left by this
+    //one, and so after the next's removals but before its insertions.
+    size_t start = min(line, next.line);
+    size_t end = max(line + inserted, next.line + next.removed);
+
+    removed = end - inserted + removed - start;
+    inserted = end - next.removed + next.inserted - start;
+    line = start;
+}
+
+/**
+ * coalesceBufferChange adds a change to the end of a sequence of changes, each
+ * of which followed the one before.  The change is merged into the last change
+ * if they touch, and the whole sequence is merged into one change once it
+ * grows past the given size.
+ *
+ * \param changes       The sequence of changes.
+ * \param change        The change which followed the sequence.
+ * \param maxChanges    The most changes the sequence may hold.
+ */
+void
+vix::coalesceBufferChange(
+    vector<BufferChange>& changes, const BufferChange& change,
+    size_t maxChanges)
+{
+    if (!changes.empty() && changes.back().touches(change))
+    {
+        changes.back().merge(change);
+        return;
+    }
+
+    changes.push_back(change);
+
+    if (changes.size() > maxChanges)
+    {
+        for (size_t i = 1; i < changes.size(); ++i)
+            changes.front().merge(changes[i]);
+
+        changes.resize(1);
+    }
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vix/BufferChangeDispatcher.h>
+#include <vix/Instrumentation.h>
+
+using namespace std;
+using namespace vix;
+
+const size_t BufferChangeDispatcher::MAX_CHANGES = 64;
+
+/**
+ * Start dispatching changes to a buffer with the given lines, which are
+ * copied.  Lines sharing their contents are copied without them.
+ */
+BufferChangeDispatcher::BufferChangeDispatcher(const list<Line>& lines, TaskScheduler& scheduler)
+    : scheduler_(scheduler), busy_(false), lines_(lines), cursorLine_(0)
+{
+    cursor_ = lines_.begin();
+}
+
+/**
+ * Destructor.  Wait for any changes still pending to be delivered.
+ */
+BufferChangeDispatcher::~BufferChangeDispatcher()
+{
+    wait();
+}
+
+/**
+ * Register an observer.  It is called for changes posted from now on.
+ */
+void
+BufferChangeDispatcher::addObserver(shared_ptr<AsyncBufferChangeObserver> observer)
+{
+    lock_guard<mutex> lock(mutex_);
+
+    observers_.push_back(observer);
+}
+
+/**
+ * Post a change, with the lines it inserted, which are moved out of the given
+ * list.
+ */
+void
+BufferChangeDispatcher::post(const BufferChange& change, list<Line>& lines)
+{
+    Edit edit{change, list<Line>(), Reader(), Moves()};
+    edit.lines.swap(lines);
+
+    post(edit);
+}
+
+/**
+ * Post where the buffer has moved the contents of its lines, which are moved
+ * out of the given moves, so that the dispatcher's copy of the lines holds
+ * them the same way, and keeps nothing the buffer has let go of.  The
+ * observers are not told.
+ */
+void
+BufferChangeDispatcher::moved(Moves& moves)
+{
+    Edit edit{BufferChange{0, 0, 0}, list<Line>(), Reader(), Moves()};
+    edit.moves.lines.swap(moves.lines);
+    edit.moves.blocks.swap(moves.blocks);
+
+    post(edit);
+}
+
+/**
+ * Post a reader, which is called with the lines as they are once every change
+ * posted before it has been applied, as part of a delivery.  It mustn't keep
+ * the lines after it returns.
+ */
+void
+BufferChangeDispatcher::read(Reader reader)
+{
+    Edit edit{BufferChange{0, 0, 0}, list<Line>(), reader, Moves()};
+
+    post(edit);
+}
+
+/**
+ * Queue an edit, and start a delivery if none is running.
+ */
+void
+BufferChangeDispatcher::post(Edit& edit)
+{
+    bool start = false;
+
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        edits_.push_back(move(edit));
+
+        //changes posted while a delivery is running wait for the next.
+        start = !busy_;
+        busy_ = true;
+    }
+
+    if (start)
+        scheduler_.submit([this] { deliver(); }, TaskScheduler::INTERACTIVE);
+}
+
+/**
+ * Wait until every change posted so far has been delivered.
+ */
+void
+BufferChangeDispatcher::wait()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    idle_.wait(lock, [this] { return !busy_; });
+}
+
+/**
+ * Deliver the changes posted so far, as a task.
+ */
+void
+BufferChangeDispatcher::deliver()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    //everything posted while the observers were busy is delivered at once.
+    vector<Edit> edits;
+    edits.swap(edits_);
+    auto observers = observers_;
+
+    lock.unlock();
+
+    vector<BufferChange> changes;
+    for (auto& edit : edits)
+    {
+        //moving the lines' contents doesn't change them.
+        if (!edit.moves.lines.empty() || !edit.moves.blocks.empty())
+        {
+            relocate(edit.moves);
+            continue;
+        }
+
+        if (!edit.reader)
+        {
+            apply(edit);
+            coalesceBufferChange(changes, edit.change, MAX_CHANGES);
+            continue;
+        }
+
+        //a reader's failure is its own to report.
+        try
+        {
+            edit.reader(lines_);
+        }
+        catch (...)
+        {
+        }
+    }
+
+    edits.clear();
+
+    //a delivery of nothing but readers and moves has nothing to tell the
+    //observers.
+    if (changes.empty())
+        observers.clear();
+
+    for (auto& weak : observers)
+    {
+        auto observer = weak.lock();
+        if (!observer)
+            continue;
+
+        //there's no one to report an observer's failure to, and it mustn't
+        //keep the others from hearing about the change.
+        try
+        {
+            observer->onBufferChanged(lines_, changes);
+        }
+        catch (...)
+        {
+        }
+    }
+
+    lock.lock();
+
+    //changes posted in the meantime get a delivery of their own, so other
+    //tasks get a look in between.
+    if (!edits_.empty())
+    {
+        lock.unlock();
+        scheduler_.submit([this] { deliver(); }, TaskScheduler::INTERACTIVE);
+
+        return;
+    }
+
+    busy_ = false;
+    idle_.notify_all();
+}
+
+/**
+ * Apply a posted change to the dispatcher's copy of the lines.
+ */
+void
+BufferChangeDispatcher::apply(Edit& edit)
+{
+    auto position = seek(edit.change.line);
+
+    for (size_t i = 0; i < edit.change.removed; ++i)
+        position = lines_.erase(position);
+
+    auto first = edit.lines.begin();
+    bool inserted = !edit.lines.empty();
+
+    lines_.splice(position, edit.lines);
+
+    //the next change is most likely near this one.
+    cursor_ = inserted ? first : position;
+    cursorLine_ = edit.change.line;
+}
+
+/**
+ * Move the contents of the dispatcher's copy of the lines where the buffer has
+ * moved them.
+ */
+void
+BufferChangeDispatcher::relocate(const Moves& moves)
+{
+    for (auto& line : lines_)
+    {
+        if (line.storage_ == Line::SHARED)
+        {
+            auto moved = moves.lines.find(line.shared_);
+            if (moved != moves.lines.end())
+                line = moved->second;
+        }
+        else if (line.storage_ == Line::COMPRESSED)
+        {
+            auto moved = moves.blocks.find(line.block_.block);
+            if (moved != moves.blocks.end())
+                line.compress(moved->second, line.block_.index);
+        }
+    }
+}
+
+/**
+ * Returns the line at the given index in the dispatcher's copy of the lines,
+ * walking from whichever of the start, the end, or the last change is closest.
+ */
+list<Line>::iterator
+BufferChangeDispatcher::seek(size_t line)
+{
+    size_t size = lines_.size();
+    size_t fromCursor = line > cursorLine_ ? line - cursorLine_ : cursorLine_ - line;
+
+    Instrumentation::count(COUNTER_LINES_WALKED, min(fromCursor, min(line, size - line)));
+
+    if (line <= fromCursor && line <= size - line)
+        return next(lines_.begin(), line);
+
+    if (size - line <= fromCursor)
+        return prev(lines_.end(), size - line);
+
+    return next(cursor_, (ptrdiff_t)line - (ptrdiff_t)cursorLine_);
+}
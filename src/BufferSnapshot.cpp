@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include <vix/BufferSnapshot.h>
+#include <vix/Crc32c.h>
+#include <vix/Instrumentation.h>
+#include <vix/SerialEndian.h>
+#include <vix/SerialMemoryReader.h>
+#include <vix/SerialVarint.h>
+#include <vix/TaskScheduler.h>
+#include <vix/Utf8.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string NOT_A_SNAPSHOT{"Not a buffer snapshot."};
+    const string UNSUPPORTED_VERSION{"Unsupported buffer snapshot version."};
+    const string CHECKSUM_MISMATCH{"Buffer snapshot checksum mismatch."};
+    const string MALFORMED_SNAPSHOT{"Buffer snapshot is malformed."};
+    const string LINE_TOO_LONG{"Line is too long for a buffer snapshot."};
+
+    const char MAGIC[4] = {'V', 'I', 'X', 'S'};
+    const uint16_t VERSION = 1;
+
+    //magic, version, flags, line count, text size.
+    const size_t HEADER_SIZE = 4 + 2 + 2 + 8 + 8;
+
+    //the size of each entry in the line table.
+    const size_t LINE_ENTRY_SIZE = sizeof(uint32_t);
+
+    //below this many lines per thread, more threads don't pay for themselves.
+    const size_t MIN_LINES_PER_THREAD = 16384;
+
+    //sections read from a stream grow by this much at a time, so a corrupt
+    //header can't ask for more memory than the stream holds.
+    const size_t SECTION_READ_CHUNK = 64 * 1024;
+
+    /**
+     * The parsed header of a snapshot.
+     */
+    struct SnapshotHeader
+    {
+        uint16_t flags;
+        uint64_t lines;
+        uint64_t textSize;
+    };
+
+    /**
+     * Read a section of the given size from a stream into a container of
+     * bytes, growing it only as the bytes arrive.
+     */
+    template <typename Container>
+    void readSection(istream& in, Container& section, size_t size)
+    {
+        section.clear();
+
+        while (section.size() < size)
+        {
+            size_t offset = section.size();
+            size_t chunk = min(size - offset, SECTION_READ_CHUNK);
+
+            section.resize(offset + chunk);
+            serialReadFixedBuffer(in, &section[offset], chunk);
+        }
+    }
+
+    /**
+     * Parse and validate a snapshot header.
+     */
+    SnapshotHeader parseHeader(const uint8_t* header)
+    {
+        SnapshotHeader parsed;
+
+        if (!equal(MAGIC, MAGIC + sizeof(MAGIC), header))
+            throw exception::SerialRead(NOT_A_SNAPSHOT);
+
+        if (decodeBigEndian<uint16_t>(header + 4) != VERSION)
+            throw exception::SerialRead(UNSUPPORTED_VERSION);
+
+        parsed.flags = decodeBigEndian<uint16_t>(header + 6);
+        parsed.lines = decodeBigEndian<uint64_t>(header + 8);
+        parsed.textSize = decodeBigEndian<uint64_t>(header + 16);
+
+        return parsed;
+    }
+
+    /**
+     * Verify a section checksum.
+     */
+    void verifyChecksum(const void* data, size_t size, uint32_t expected)
+    {
+        if (crc32c(data, size) != expected)
+            throw exception::SerialRead(CHECKSUM_MISMATCH);
+    }
+
+    /**
+     * Decode the lines described by a line table and text blob into a line
+     * list, optionally splitting the work across several threads of the
+     * standard scheduler.
+     */
+    void decodeLines(
+        const uint8_t* table, const char* text, uint64_t lines,
+        uint64_t textSize, unsigned threads, Buffer::LineList& out)
+    {
+        //limit the number of threads to something worthwhile.
+        size_t parts = min<uint64_t>(
+            max(1U, threads), max<uint64_t>(1, lines / MIN_LINES_PER_THREAD));
+
+        uint64_t linesPerPart = (lines + parts - 1) / parts;
+
+        //find where each part starts in the text, checking the table adds up.
+        vector<uint64_t> partStart(parts, 0);
+        uint64_t offset = 0;
+
+        for (uint64_t i = 0; i < lines; ++i)
+        {
+            if (i % linesPerPart == 0)
+                partStart[i / linesPerPart] = offset;
+
+            offset += decodeBigEndian<uint32_t>(table + i * LINE_ENTRY_SIZE);
+        }
+
+        if (offset != textSize)
+            throw exception::SerialRead(MALFORMED_SNAPSHOT);
+
+        vector<Buffer::LineList> decoded(parts);
+
+        TaskScheduler::standard().parallelFor(parts, [&](size_t part) {
+            uint64_t first = part * linesPerPart;
+            uint64_t last = min(lines, first + linesPerPart);
+            uint64_t start = partStart[part];
+
+            for (uint64_t i = first; i < last; ++i)
+            {
+                uint32_t length =
+                    decodeBigEndian<uint32_t>(table + i * LINE_ENTRY_SIZE);
+                wstring str;
+
+                utf8Decode(text + start, length, str);
+                decoded[part].emplace_back(move(str));
+
+                start += length;
+            }
+        });
+
+        for (auto& part : decoded)
+            out.splice(out.end(), part);
+    }
+}
+
+/**
+ * writeBufferSnapshot writes a snapshot of a buffer to a binary stream.
+ *
+ * \param out           The stream to which the snapshot is written.
+ * \param buffer        The buffer to write.
+ * \param flags         The snapshot flags.
+ *
+ * \throw vix::exception::SerialWrite if the serial write fails.
+ */
+void
+vix::writeBufferSnapshot(std::ostream& out, const Buffer& buffer, uint16_t flags)
+{
+    vector<uint8_t> table(buffer.lines() * LINE_ENTRY_SIZE);
+    string text;
+    size_t entry = 0;
+
+    //build the line table and text blob in memory.
+    for (auto& line : buffer)
+    {
+        size_t start = text.size();
+
+        utf8Encode(line.str(), text);
+
+        size_t length = text.size() - start;
+        if (length > numeric_limits<uint32_t>::max())
+            throw exception::SerialWrite(LINE_TOO_LONG);
+
+        encodeBigEndian<uint32_t>(&table[entry], length);
+        entry += LINE_ENTRY_SIZE;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    copy(MAGIC, MAGIC + sizeof(MAGIC), header);
+    encodeBigEndian<uint16_t>(header + 4, VERSION);
+    encodeBigEndian<uint16_t>(header + 6, flags);
+    encodeBigEndian<uint64_t>(header + 8, buffer.lines());
+    encodeBigEndian<uint64_t>(header + 16, text.size());
+
+    //then write each section in one go.
+    bool checksums = flags & SNAPSHOT_CHECKSUMS;
+
+    serialWriteFixedBuffer(out, header, sizeof(header));
+    if (checksums)
+        serialWriteBigEndian(out, crc32c(header, sizeof(header)));
+
+    serialWriteFixedBuffer(out, table.data(), table.size());
+    if (checksums)
+        serialWriteBigEndian(out, crc32c(table.data(), table.size()));
+
+    serialWriteFixedBuffer(out, text.data(), text.size());
+    if (checksums)
+        serialWriteBigEndian(out, crc32c(text.data(), text.size()));
+
+    Instrumentation::count(COUNTER_SNAPSHOTS_WRITTEN);
+    Instrumentation::count(
+        COUNTER_SNAPSHOT_BYTES_WRITTEN,
+        sizeof(header) + table.size() + text.size() + (checksums ? 3 * sizeof(uint32_t) : 0));
+}
+
+/**
+ * readBufferSnapshot replaces the contents of a buffer with a snapshot read
+ * from a binary stream.
+ *
+ * \param in            The stream from which the snapshot is read.
+ * \param buffer        The buffer to fill.
+ * \param threads       The number of threads used to decode lines.
+ *
+ * \throw vix::exception::SerialRead if the snapshot is truncated, malformed,
+ *        or fails its checksums.
+ */
+void
+vix::readBufferSnapshot(std::istream& in, Buffer& buffer, unsigned threads)
+{
+    uint8_t header[HEADER_SIZE];
+    uint32_t crc = 0;
+
+    serialReadFixedBuffer(in, header, sizeof(header));
+    SnapshotHeader parsed = parseHeader(header);
+    bool checksums = parsed.flags & SNAPSHOT_CHECKSUMS;
+
+    if (checksums)
+    {
+        serialReadBigEndian(in, crc);
+        verifyChecksum(header, sizeof(header), crc);
+    }
+
+    //refuse sizes which can't be allocated.  Without checksums nothing
+    //vouches for the rest, so the sections grow only as the stream delivers.
+    if (parsed.lines > numeric_limits<size_t>::max() / LINE_ENTRY_SIZE
+     || parsed.textSize > numeric_limits<size_t>::max())
+        throw exception::SerialRead(MALFORMED_SNAPSHOT);
+
+    vector<uint8_t> table;
+    readSection(in, table, parsed.lines * LINE_ENTRY_SIZE);
+    if (checksums)
+    {
+        serialReadBigEndian(in, crc);
+        verifyChecksum(table.data(), table.size(), crc);
+    }
+
+    string text;
+    readSection(in, text, parsed.textSize);
+    if (checksums)
+    {
+        serialReadBigEndian(in, crc);
+        verifyChecksum(text.data(), text.size(), crc);
+    }
+
+    Instrumentation::count(COUNTER_SNAPSHOTS_READ);
+    Instrumentation::count(
+        COUNTER_SNAPSHOT_BYTES_READ,
+        sizeof(header) + table.size() + text.size() + (checksums ? 3 * sizeof(uint32_t) : 0));
+
+    Buffer::LineList lines;
+    decodeLines(
+        table.data(), text.data(), parsed.lines, parsed.textSize, threads,
+        lines);
+
+    buffer.assign(lines);
+}
+
+/**
+ * readBufferSnapshot replaces the contents of a buffer with a snapshot held in
+ * memory, such as a memory mapped file.
+ *
+ * \param data          The snapshot.
+ * \param size          The size of the snapshot.
+ * \param buffer        The buffer to fill.
+ * \param threads       The number of threads used to decode lines.
+ *
+ * \throw vix::exception::SerialRead if the snapshot is truncated, malformed,
+ *        or fails its checksums.
+ */
+void
+vix::readBufferSnapshot(const void* data, size_t size, Buffer& buffer, unsigned threads)
+{
+    SerialMemoryReader reader(data, size);
+    uint32_t crc = 0;
+
+    StringRef header = reader.readFixedRef(HEADER_SIZE);
+    SnapshotHeader parsed = parseHeader((const uint8_t*)header.data());
+    bool checksums = parsed.flags & SNAPSHOT_CHECKSUMS;
+
+    if (checksums)
+    {
+        reader.read(crc);
+        verifyChecksum(header.data(), header.size(), crc);
+    }
+
+    //the sections must fit in what is left of the snapshot.
+    if (parsed.lines > reader.remaining() / LINE_ENTRY_SIZE)
+        throw exception::SerialRead(MALFORMED_SNAPSHOT);
+
+    StringRef table = reader.readFixedRef(parsed.lines * LINE_ENTRY_SIZE);
+    if (checksums)
+    {
+        reader.read(crc);
+        verifyChecksum(table.data(), table.size(), crc);
+    }
+
+    if (parsed.textSize > reader.remaining())
+        throw exception::SerialRead(MALFORMED_SNAPSHOT);
+
+    StringRef text = reader.readFixedRef(parsed.textSize);
+    if (checksums)
+    {
+        reader.read(crc);
+        verifyChecksum(text.data(), text.size(), crc);
+    }
+
+    Instrumentation::count(COUNTER_SNAPSHOTS_READ);
+    Instrumentation::count(COUNTER_SNAPSHOT_BYTES_READ, reader.position());
+
+    Buffer::LineList lines;
+    decodeLines(
+        (const uint8_t*)table.data(), text.data(), parsed.lines,
+        parsed.textSize, threads, lines);
+
+    buffer.assign(lines);
+}
+
+/**
+ * serialWrite(const Line&) is an overloaded function that writes a line to the
+ * output stream as a UTF-8 string with a varint length.
+ *
+ * \param out           The output stream to which this value is written.
+ * \param value         The line to write.
+ *
+ * \throw vix::exception::SerialWrite if the serial write fails.
+ */
+void
+vix::serialWrite(std::ostream& out, const Line& value)
+{
+    string text;
+
+    utf8Encode(value.str(), text);
+
+    serialWriteCompact(out, text);
+}
+
+/**
+ * serialRead(Line&) is an overloaded function that reads a line written by
+ * serialWrite(const Line&) from the input stream.
+ *
+ * \param in            The input stream from which this value is read.
+ * \param value         The line to read.
+ *
+ * \throw vix::exception::SerialRead if the serial read fails.
+ */
+void
+vix::serialRead(std::istream& in, Line& value)
+{
+    string text;
+    wstring str;
+
+    serialReadCompact(in, text);
+    utf8Decode(text.data(), text.size(), str);
+
+    value = Line(move(str));
+}
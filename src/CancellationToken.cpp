@@ -0,0 +1,50 @@
+#include <vix/CancellationToken.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Create a token which is only cancelled by cancel.
+ */
+CancellationToken::CancellationToken()
+    : state_(make_shared<State>())
+{
+    state_->cancelled = false;
+}
+
+/**
+ * Create a token which is also cancelled once the given function returns true.
+ * The function is called from whichever thread checks the token, and must be
+ * safe to call from any.
+ */
+CancellationToken::CancellationToken(function<bool()> stale)
+    : state_(make_shared<State>())
+{
+    state_->cancelled = false;
+    state_->stale = stale;
+}
+
+/**
+ * Cancel the token, and every copy of it.
+ */
+void
+CancellationToken::cancel()
+{
+    state_->cancelled = true;
+}
+
+/**
+ * Returns true if the token has been cancelled or has gone stale.
+ */
+bool
+CancellationToken::cancelled() const
+{
+    if (state_->cancelled)
+        return true;
+
+    //once stale, always stale, so the function needn't be asked again.
+    if (state_->stale && state_->stale())
+        state_->cancelled = true;
+
+    return state_->cancelled;
+}
@@ -0,0 +1,84 @@
+#include <vix/CommandCoalescer.h>
+
+using namespace std;
+using namespace vix;
+
+const UndoTree::clock::duration CommandCoalescer::DEFAULT_TIMEOUT =
+    chrono::seconds(5);
+
+/**
+ * Create a coalescer for an undo tree.
+ */
+CommandCoalescer::CommandCoalescer(UndoTree& tree, Sink sink, UndoTree::clock::duration timeout)
+    : tree_(tree), sink_(sink), timeout_(timeout), node_(0)
+{
+}
+
+/**
+ * Destructor.  Close the open command.
+ */
+CommandCoalescer::~CommandCoalescer()
+{
+    //a destructor can't report a failing sink.
+    try
+    {
+        boundary();
+    }
+    catch (...)
+    {
+    }
+}
+
+/**
+ * Apply a command, merging it into the open command if it can be.
+ */
+void
+CommandCoalescer::apply(shared_ptr<Command> command, UndoTree::clock::time_point when)
+{
+    //a pause, or the tree having moved on without a boundary, closes the
+    //open command.
+    if (open_ && (when - last_ > timeout_ || tree_.current() != node_))
+        boundary();
+
+    //a command which merges is applied straight to the buffer; one which
+    //doesn't goes through the tree, which checkpoints first.
+    if (open_ && open_->canMerge(*command))
+    {
+        command->apply(tree_.buffer());
+        open_->merge(*command);
+
+        last_ = when;
+        return;
+    }
+
+    boundary();
+    tree_.apply(command, when);
+
+    open_ = command;
+    node_ = tree_.current();
+    last_ = when;
+}
+
+/**
+ * Close the open command, so the next command starts a new undo step.
+ */
+void
+CommandCoalescer::boundary()
+{
+    if (!open_)
+        return;
+
+    if (sink_)
+        sink_(*open_);
+
+    open_.reset();
+}
+
+/**
+ * Returns the open command, or null if there is none.
+ */
+shared_ptr<Command>
+CommandCoalescer::open() const
+{
+    return open_;
+}
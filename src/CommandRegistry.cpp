@@ -0,0 +1,82 @@
+#include <vix/CommandRegistry.h>
+#include <vix/EraseTextCommand.h>
+#include <vix/InsertTextCommand.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string UNKNOWN_TAG{"Unknown command tag."};
+    const string UNKNOWN_TYPE{"Command type is not registered."};
+
+    /**
+     * The tags of the commands vix provides.  These are stored in undo
+     * history files, so they must never change.
+     */
+    const uint8_t INSERT_TEXT_TAG = 1;
+    const uint8_t ERASE_TEXT_TAG = 2;
+}
+
+/**
+ * Create an empty registry.
+ */
+CommandRegistry::CommandRegistry()
+    : factories_(256)
+{
+}
+
+/**
+ * Register a command type under a tag, with a factory for it.
+ */
+void
+CommandRegistry::add(uint8_t tag, const type_info& type, Factory factory)
+{
+    factories_[tag] = factory;
+    tags_[type_index(type)] = tag;
+}
+
+/**
+ * Create an empty command for a tag.
+ *
+ * \throw vix::exception::SerialRead if the tag isn't registered.
+ */
+shared_ptr<Command>
+CommandRegistry::create(uint8_t tag) const
+{
+    if (!factories_[tag])
+        throw exception::SerialRead(UNKNOWN_TAG);
+
+    return factories_[tag]();
+}
+
+/**
+ * Returns the tag of a command's type.
+ *
+ * \throw vix::exception::SerialWrite if the type isn't registered.
+ */
+uint8_t
+CommandRegistry::tag(const Command& command) const
+{
+    auto found = tags_.find(type_index(typeid(command)));
+    if (found == tags_.end())
+        throw exception::SerialWrite(UNKNOWN_TYPE);
+
+    return found->second;
+}
+
+/**
+ * Returns the registry of the commands vix provides.
+ */
+const CommandRegistry&
+CommandRegistry::standard()
+{
+    static const CommandRegistry STANDARD = [] {
+        CommandRegistry registry;
+        registry.add<InsertTextCommand>(INSERT_TEXT_TAG);
+        registry.add<EraseTextCommand>(ERASE_TEXT_TAG);
+
+        return registry;
+    }();
+
+    return STANDARD;
+}
@@ -0,0 +1,192 @@
+#include <cstring>
+#include <vix/Crc32c.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VIX_CRC32C_SSE42
+#include <nmmintrin.h>
+#endif
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //the reflected CRC-32C polynomial.
+    const uint32_t POLYNOMIAL = 0x82F63B78;
+
+    /**
+     * Lookup tables for processing eight bytes per step.  Table zero is the
+     * classic byte at a time table; table n advances a byte through n further
+     * zero bytes.
+     */
+    struct Crc32cTables
+    {
+        uint32_t table[8][256];
+
+        Crc32cTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    crc = (crc >> 1) ^ (POLYNOMIAL & (~(crc & 1) + 1));
+
+                table[0][i] = crc;
+            }
+
+            for (int n = 1; n < 8; ++n)
+            {
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    uint32_t crc = table[n - 1][i];
+                    table[n][i] = (crc >> 8) ^ table[0][crc & 0xFF];
+                }
+            }
+        }
+    };
+
+    const Crc32cTables& tables()
+    {
+        static const Crc32cTables TABLES;
+
+        return TABLES;
+    }
+
+    /**
+     * Compute a checksum a byte, or eight bytes, at a time with lookup tables.
+     */
+    uint32_t crc32cPortable(const uint8_t* p, size_t size, uint32_t crc)
+    {
+        const uint32_t (&t)[8][256] = tables().table;
+
+        //slicing by eight: fold in eight bytes per step.
+        while (size >= 8)
+        {
+            uint32_t low;
+            uint32_t high;
+            memcpy(&low, p, sizeof(low));
+            memcpy(&high, p + 4, sizeof(high));
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            low = __builtin_bswap32(low);
+            high = __builtin_bswap32(high);
+#endif
+
+            low ^= crc;
+
+            crc = t[7][low & 0xFF]
+                ^ t[6][(low >> 8) & 0xFF]
+                ^ t[5][(low >> 16) & 0xFF]
+                ^ t[4][low >> 24]
+                ^ t[3][high & 0xFF]
+                ^ t[2][(high >> 8) & 0xFF]
+                ^ t[1][(high >> 16) & 0xFF]
+                ^ t[0][high >> 24];
+
+            p += 8;
+            size -= 8;
+        }
+
+        while (size--)
+            crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+
+        return crc;
+    }
+
+#ifdef VIX_CRC32C_SSE42
+    /**
+     * Compute a checksum with the SSE 4.2 crc32 instruction, which implements
+     * exactly this polynomial.  Only called once the CPU is known to have it.
+     */
+    __attribute__((target("sse4.2")))
+    uint32_t crc32cSse42(const uint8_t* p, size_t size, uint32_t crc)
+    {
+        //bring the pointer to a word boundary, so the main loop's loads don't
+        //straddle cache lines.
+        while (size > 0 && ((uintptr_t)p & 7))
+        {
+            crc = _mm_crc32_u8(crc, *p++);
+            --size;
+        }
+
+#ifdef __x86_64__
+        uint64_t crc64 = crc;
+
+        while (size >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, p, sizeof(word));
+
+            crc64 = _mm_crc32_u64(crc64, word);
+
+            p += 8;
+            size -= 8;
+        }
+
+        crc = (uint32_t)crc64;
+#endif
+
+        while (size >= 4)
+        {
+            uint32_t word;
+            memcpy(&word, p, sizeof(word));
+
+            crc = _mm_crc32_u32(crc, word);
+
+            p += 4;
+            size -= 4;
+        }
+
+        while (size--)
+            crc = _mm_crc32_u8(crc, *p++);
+
+        return crc;
+    }
+#endif
+
+    typedef uint32_t (*Crc32cImplementation)(const uint8_t*, size_t, uint32_t);
+
+    /**
+     * Pick the fastest implementation the CPU supports.
+     */
+    Crc32cImplementation selectImplementation()
+    {
+#ifdef VIX_CRC32C_SSE42
+        if (__builtin_cpu_supports("sse4.2"))
+            return &crc32cSse42;
+#endif
+
+        return &crc32cPortable;
+    }
+
+    Crc32cImplementation implementation()
+    {
+        static const Crc32cImplementation IMPLEMENTATION =
+            selectImplementation();
+
+        return IMPLEMENTATION;
+    }
+}
+
+/**
+ * crc32c computes the CRC-32C (Castagnoli) checksum of a buffer.  A checksum
+ * can be computed incrementally by passing the result of the previous call as
+ * the initial value of the next.
+ *
+ * \param data          The buffer to checksum.
+ * \param size          The size of the buffer.
+ * \param crc           The checksum of the preceding data, if any.
+ */
+uint32_t
+vix::crc32c(const void* data, size_t size, uint32_t crc)
+{
+    return ~implementation()((const uint8_t*)data, size, ~crc);
+}
+
+/**
+ * crc32cAccelerated returns true if crc32c uses the CPU's CRC instructions.
+ */
+bool
+vix::crc32cAccelerated()
+{
+    return implementation() != &crc32cPortable;
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <istream>
+#include <ostream>
+#include <vix/EditTrace.h>
+#include <vix/SerialUtilities.h>
+#include <vix/SerialVarint.h>
+#include <vix/Utf8.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string NOT_A_TRACE{"Not an edit trace."};
+    const string UNSUPPORTED_VERSION{"Unsupported edit trace version."};
+    const string MALFORMED_TRACE{"Malformed edit trace."};
+
+    const char MAGIC[4] = {'V', 'I', 'X', 'T'};
+    const uint16_t VERSION = 1;
+
+    const char* EVENT_NAMES[EDIT_EVENT_TYPES] = {
+        "type", "erase", "move", "search", "paste", "undo", "redo"
+    };
+
+    //a count read from a damaged trace mustn't reserve the world.
+    const size_t MAX_RESERVE = 1 << 16;
+}
+
+/**
+ * Two events are equal if every field is.
+ */
+bool
+EditEvent::operator==(const EditEvent& other) const
+{
+    return type == other.type
+        && delay == other.delay
+        && line == other.line
+        && column == other.column
+        && count == other.count
+        && text == other.text;
+}
+
+bool
+EditEvent::operator!=(const EditEvent& other) const
+{
+    return !(*this == other);
+}
+
+/**
+ * Returns the name of a kind of event, for reports.
+ */
+const char*
+vix::editEventName(EditEventType type)
+{
+    return type < EDIT_EVENT_TYPES ? EVENT_NAMES[type] : "unknown";
+}
+
+/**
+ * Create an empty trace of edits to a file with the given number of lines.
+ */
+EditTrace::EditTrace(size_t lines)
+    : lines_(lines)
+{
+}
+
+/**
+ * Returns the number of lines in the file the trace was recorded against.
+ */
+size_t
+EditTrace::lines() const
+{
+    return lines_;
+}
+
+/**
+ * Returns the events, in the order they happened.
+ */
+const vector<EditEvent>&
+EditTrace::events() const
+{
+    return events_;
+}
+
+/**
+ * Add an event to the end of the trace.
+ */
+void
+EditTrace::append(const EditEvent& event)
+{
+    events_.push_back(event);
+}
+
+/**
+ * Read a trace.
+ *
+ * \throw vix::exception::SerialRead if serialization fails, or the stream
+ *        doesn't hold a trace.
+ */
+void
+EditTrace::serialRead(istream& in)
+{
+    char magic[sizeof(MAGIC)];
+    uint16_t version = 0;
+
+    serialReadFixedBuffer(in, magic, sizeof(magic));
+    if (!equal(MAGIC, MAGIC + sizeof(MAGIC), magic))
+        throw exception::SerialRead(NOT_A_TRACE);
+
+    vix::serialRead(in, version);
+    if (version != VERSION)
+        throw exception::SerialRead(UNSUPPORTED_VERSION);
+
+    uint64_t lines = 0;
+    uint64_t size = 0;
+
+    serialReadVarint(in, lines);
+    serialReadVarint(in, size);
+
+    vector<EditEvent> events;
+    events.reserve(min<uint64_t>(size, MAX_RESERVE));
+
+    string text;
+
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        uint8_t type = 0;
+        uint64_t line = 0;
+        uint64_t column = 0;
+        uint64_t count = 0;
+        EditEvent event;
+
+        vix::serialRead(in, type);
+        if (type >= EDIT_EVENT_TYPES)
+            throw exception::SerialRead(MALFORMED_TRACE);
+
+        event.type = (EditEventType)type;
+
+        serialReadVarint(in, event.delay);
+        serialReadVarint(in, line);
+        serialReadVarint(in, column);
+        serialReadVarint(in, count);
+        serialReadCompact(in, text);
+
+        event.line = line;
+        event.column = column;
+        event.count = count;
+
+        if (!utf8Decode(text.data(), text.size(), event.text))
+            throw exception::SerialRead(MALFORMED_TRACE);
+
+        events.push_back(move(event));
+    }
+
+    lines_ = lines;
+    events_.swap(events);
+}
+
+/**
+ * Write the trace.
+ *
+ * \throw vix::exception::SerialWrite if serialization fails.
+ */
+void
+EditTrace::serialWrite(ostream& out) const
+{
+    serialWriteFixedBuffer(out, MAGIC, sizeof(MAGIC));
+    vix::serialWrite(out, VERSION);
+    serialWriteVarint(out, lines_);
+    serialWriteVarint(out, events_.size());
+
+    string text;
+
+    for (const auto& event : events_)
+    {
+        text.clear();
+        utf8Encode(event.text, text);
+
+        vix::serialWrite(out, (uint8_t)event.type);
+        serialWriteVarint(out, event.delay);
+        serialWriteVarint(out, event.line);
+        serialWriteVarint(out, event.column);
+        serialWriteVarint(out, event.count);
+        serialWriteCompact(out, text);
+    }
+}
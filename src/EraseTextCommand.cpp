@@ -0,0 +1,181 @@
+#include <vix/EraseTextCommand.h>
+#include <vix/SerialVarint.h>
+#include <vix/Utf8.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string OUT_OF_RANGE{"Erased text is outside the buffer."};
+}
+
+/**
+ * Create a command erasing the given number of characters at the given line
+ * and column.
+ */
+EraseTextCommand::EraseTextCommand(size_t line, size_t column, size_t length)
+    : line_(line), column_(column), length_(length)
+{
+}
+
+/**
+ * Returns the line from which text is erased.
+ */
+size_t
+EraseTextCommand::line() const
+{
+    return line_;
+}
+
+/**
+ * Returns the column of the first erased character.
+ */
+size_t
+EraseTextCommand::column() const
+{
+    return column_;
+}
+
+/**
+ * Returns the number of characters erased.
+ */
+size_t
+EraseTextCommand::length() const
+{
+    return length_;
+}
+
+/**
+ * Returns the erased text, once the command has been applied.
+ */
+const wstring&
+EraseTextCommand::text() const
+{
+    return text_;
+}
+
+/**
+ * Erase the text.
+ *
+ * \throw vix::exception::CommandRange if the range is outside the buffer.
+ */
+void
+EraseTextCommand::apply(weak_ptr<Buffer> buffer)
+{
+    auto b = buffer.lock();
+    if (!b || line_ >= b->lines())
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    auto line = b->line(line_);
+    auto& str = line->str();
+
+    if (column_ > str.size() || length_ > str.size() - column_)
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    text_ = str.substr(column_, length_);
+    b->replace(line, column_, length_, wstring());
+}
+
+/**
+ * Put the erased text back.
+ *
+ * \throw vix::exception::CommandRange if the position is outside the buffer.
+ */
+void
+EraseTextCommand::revert(weak_ptr<Buffer> buffer)
+{
+    auto b = buffer.lock();
+    if (!b || line_ >= b->lines())
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    auto line = b->line(line_);
+    auto& str = line->str();
+
+    if (column_ > str.size())
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    b->replace(line, column_, 0, text_);
+}
+
+/**
+ * Returns true if the given command erases the characters either side of this
+ * command's.
+ */
+bool
+EraseTextCommand::canMerge(const Command& next) const
+{
+    auto erase = dynamic_cast<const EraseTextCommand*>(&next);
+
+    return erase && erase->line_ == line_
+        && (erase->column_ + erase->length_ == column_ || erase->column_ == column_);
+}
+
+/**
+ * Merge an erasure of the characters either side of this command's.
+ */
+bool
+EraseTextCommand::merge(const Command& next)
+{
+    if (!canMerge(next))
+        return false;
+
+    auto& erase = dynamic_cast<const EraseTextCommand&>(next);
+
+    if (erase.column_ + erase.length_ == column_)
+    {
+        //backspace: the new text comes before.
+        text_.insert(0, erase.text_);
+        column_ = erase.column_;
+    }
+    else
+    {
+        //delete: the following text closed up, so the new text comes after.
+        text_ += erase.text_;
+    }
+
+    length_ += erase.length_;
+
+    return true;
+}
+
+/**
+ * Replace this command with one read from a binary input stream.
+ *
+ * \throw vix::exception::SerialRead if serialization fails.
+ */
+void
+EraseTextCommand::serialRead(std::istream& in)
+{
+    uint64_t line = 0;
+    uint64_t column = 0;
+    uint64_t length = 0;
+    string text;
+
+    serialReadVarint(in, line);
+    serialReadVarint(in, column);
+    serialReadVarint(in, length);
+    serialReadCompact(in, text);
+
+    line_ = line;
+    column_ = column;
+    length_ = length;
+    text_.clear();
+    utf8Decode(text.data(), text.size(), text_);
+}
+
+/**
+ * Write this command to a binary output stream.
+ *
+ * \throw vix::exception::SerialWrite if serialization fails.
+ */
+void
+EraseTextCommand::serialWrite(std::ostream& out) const
+{
+    string text;
+    utf8Encode(text_, text);
+
+    serialWriteVarint(out, line_);
+    serialWriteVarint(out, column_);
+    serialWriteVarint(out, length_);
+    serialWriteCompact(out, text);
+}
@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vix/FileFollower.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //the file is read in pieces of this size.
+    const size_t READ_BLOCK_SIZE = 1 << 20;
+
+    //what happens to the file followed.
+    const uint32_t FILE_EVENTS =
+        IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF;
+
+    //a file taking its place in the directory.
+    const uint32_t DIRECTORY_EVENTS = IN_CREATE | IN_MOVED_TO;
+
+    /**
+     * Returns the directory holding the file at the given path.
+     */
+    string directoryOf(const string& path)
+    {
+        size_t slash = path.rfind('/');
+
+        if (slash == string::npos)
+            return ".";
+
+        return slash == 0 ? "/" : path.substr(0, slash);
+    }
+}
+
+const size_t FileFollower::MAX_BATCH_SIZE = 1 << 20;
+
+/**
+ * Follow the file at the given path from its start.
+ *
+ * \throw vix::exception::FileOpen if the file cannot be opened or watched.
+ */
+FileFollower::FileFollower(const string& path, Buffer& buffer)
+    : path_(path), buffer_(buffer), fd_(-1), inotify_(-1), fileWatch_(-1),
+      device_(0), inode_(0), offset_(0), behind_(false), ended_(false),
+      ending_(LINE_ENDING_LF), utf8_(true),
+      backend_(IoBackend::create(2, READ_BLOCK_SIZE))
+{
+    inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_ < 0)
+        throw exception::FileOpen("Could not watch " + path_ + ".");
+
+    try
+    {
+        if (inotify_add_watch(inotify_, directoryOf(path_).c_str(), DIRECTORY_EVENTS) < 0)
+            throw exception::FileOpen("Could not watch " + path_ + ".");
+
+        openFile();
+    }
+    catch (...)
+    {
+        close(inotify_);
+        throw;
+    }
+}
+
+/**
+ * Destructor.  Stop following the file.
+ */
+FileFollower::~FileFollower()
+{
+    closeFile();
+    close(inotify_);
+}
+
+/**
+ * Returns a descriptor which becomes readable when the file may have changed.
+ */
+int
+FileFollower::descriptor() const
+{
+    return inotify_;
+}
+
+/**
+ * Wait for the file to change, or for the given number of milliseconds.
+ *
+ * \returns false if the wait timed out.
+ */
+bool
+FileFollower::wait(int milliseconds)
+{
+    struct pollfd ready = {inotify_, POLLIN, 0};
+    int result;
+
+    do
+    {
+        result = ::poll(&ready, 1, milliseconds);
+    }
+    while (result < 0 && errno == EINTR);
+
+    return result > 0;
+}
+
+/**
+ * Read what has been written to the file since the last poll, up to the given
+ * number of bytes, and append the lines it completes to the buffer.
+ *
+ * \returns the number of lines appended, or if the file was truncated, the
+ *          number of lines in the buffer.
+ *
+ * \throw vix::exception::FileRead if the file cannot be read.
+ */
+size_t
+FileFollower::poll(size_t maxBytes)
+{
+    //events only say that something happened; what happened is found below.
+    drainEvents();
+
+    Buffer::LineList lines;
+    bool truncated = false;
+    size_t remaining = maxBytes;
+
+    behind_ = false;
+
+    for (;;)
+    {
+        struct stat st;
+        if (fstat(fd_, &st) < 0)
+            throw exception::FileRead("Could not stat " + path_ + ".");
+
+        //a file truncated in place is read again from the start.
+        if ((uint64_t)st.st_size < offset_)
+        {
+            truncated = true;
+            lines.clear();
+            partial_.clear();
+            decoder_ = Utf8Decoder();
+            offset_ = 0;
+            ended_ = false;
+            ending_ = LINE_ENDING_LF;
+            utf8_ = true;
+        }
+
+        size_t current = 0;
+        bool reading = false;
+
+        while (remaining > 0)
+        {
+            if (!reading)
+                backend_->read(fd_, current, min(READ_BLOCK_SIZE, remaining), offset_);
+
+            size_t count = backend_->wait(current);
+            reading = false;
+
+            if (count == 0)
+                break;
+
+            offset_ += count;
+            remaining -= count;
+
+            //read the next block while this one is split.
+            size_t next = (current + 1) % backend_->buffers();
+
+            if (remaining > 0)
+            {
+                backend_->read(fd_, next, min(READ_BLOCK_SIZE, remaining), offset_);
+                backend_->submit();
+                reading = true;
+            }
+
+            split(backend_->buffer(current), count, lines);
+            current = next;
+        }
+
+        if (remaining == 0)
+        {
+            behind_ = fstat(fd_, &st) == 0 && (uint64_t)st.st_size > offset_;
+            break;
+        }
+
+        if (!replaced())
+            break;
+
+        //a file which goes again before it can be opened is looked for again
+        //next time.
+        try
+        {
+            openFile();
+        }
+        catch (const exception::FileOpen&)
+        {
+            break;
+        }
+
+        //the old file is finished with, so its last line has ended, and
+        //whatever replaced it is followed from its start.
+        if (!partial_.empty() || decoder_.pending() > 0)
+            endLine(lines);
+    }
+
+    size_t appended = lines.size();
+
+    if (truncated)
+    {
+        buffer_.assign(lines);
+        return buffer_.lines();
+    }
+
+    buffer_.append(lines);
+
+    return appended;
+}
+
+/**
+ * Returns true if the last poll stopped at its limit with more of the file
+ * left to read.
+ */
+bool
+FileFollower::behind() const
+{
+    return behind_;
+}
+
+/**
+ * Returns the number of bytes read from the file being followed.
+ */
+uint64_t
+FileFollower::offset() const
+{
+    return offset_;
+}
+
+/**
+ * Returns the line ending of the first line read.
+ */
+LineEnding
+FileFollower::ending() const
+{
+    return ending_;
+}
+
+/**
+ * Returns true if all the lines read were well formed UTF-8.
+ */
+bool
+FileFollower::utf8() const
+{
+    return utf8_ && decoder_.valid();
+}
+
+/**
+ * Open the file at the path and watch it, in place of any file followed
+ * before.
+ */
+void
+FileFollower::openFile()
+{
+    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw exception::FileOpen("Could not open " + path_ + ".");
+
+    struct stat st;
+    int watch = inotify_add_watch(inotify_, path_.c_str(), FILE_EVENTS);
+
+    if (watch < 0 || fstat(fd, &st) < 0)
+    {
+        close(fd);
+        throw exception::FileOpen("Could not watch " + path_ + ".");
+    }
+
+    closeFile();
+
+    fd_ = fd;
+    fileWatch_ = watch;
+    device_ = st.st_dev;
+    inode_ = st.st_ino;
+    offset_ = 0;
+}
+
+/**
+ * Close the file being followed.
+ */
+void
+FileFollower::closeFile()
+{
+    if (fd_ < 0)
+        return;
+
+    //the watch is gone already if the file was deleted.
+    inotify_rm_watch(inotify_, fileWatch_);
+    close(fd_);
+
+    fd_ = -1;
+    fileWatch_ = -1;
+}
+
+/**
+ * Read the pending inotify events.
+ */
+void
+FileFollower::drainEvents()
+{
+    char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    while (read(inotify_, events, sizeof(events)) > 0)
+        ;
+}
+
+/**
+ * Returns true if the path now names a file other than the one being
+ * followed.
+ */
+bool
+FileFollower::replaced() const
+{
+    struct stat st;
+
+    //until something takes the place of a file moved away, the old one is
+    //still followed.
+    if (stat(path_.c_str(), &st) < 0)
+        return false;
+
+    return st.st_dev != device_ || st.st_ino != inode_;
+}
+
+/**
+ * Split the bytes read into lines, appending the complete ones to the given
+ * list.
+ */
+void
+FileFollower::split(const char* data, size_t size, Buffer::LineList& lines)
+{
+    const char* end = data + size;
+
+    while (data < end)
+    {
+        const char* feed = (const char*)memchr(data, '\n', end - data);
+
+        //the rest of the line is still to come.
+        if (!feed)
+        {
+            decoder_.decode(data, end - data, partial_);
+            return;
+        }
+
+        decoder_.decode(data, feed - data, partial_);
+        utf8_ &= decoder_.finish(partial_);
+
+        bool carriageReturn = !partial_.empty() && partial_.back() == L'\r';
+
+        if (!ended_)
+        {
+            ending_ = carriageReturn ? LINE_ENDING_CRLF : LINE_ENDING_LF;
+            ended_ = true;
+        }
+
+        if (carriageReturn && ending_ == LINE_ENDING_CRLF)
+            partial_.pop_back();
+
+        endLine(lines);
+
+        data = feed + 1;
+    }
+}
+
+/**
+ * Append the unfinished last line to the given list as it stands.
+ */
+void
+FileFollower::endLine(Buffer::LineList& lines)
+{
+    utf8_ &= decoder_.finish(partial_);
+
+    lines.emplace_back(move(partial_));
+    partial_.clear();
+}
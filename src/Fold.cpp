@@ -0,0 +1,18 @@
+#include <vix/Fold.h>
+
+using namespace vix;
+
+/**
+ * Two folds are equal if they cover the same lines and are in the same state.
+ */
+bool
+Fold::operator==(const Fold& other) const
+{
+    return first == other.first && last == other.last && closed == other.closed;
+}
+
+bool
+Fold::operator!=(const Fold& other) const
+{
+    return !(*this == other);
+}
@@ -0,0 +1,899 @@
+#include <algorithm>
+#include <limits>
+#include <vix/FoldEngine.h>
+#include <vix/TreapPriority.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string FOLD_TOO_SHORT{"A fold must cover at least two lines."};
+    const string FOLD_PAST_END{"Fold extends past the end of the buffer."};
+    const string FOLD_EXISTS{"Fold already exists."};
+    const string FOLD_OVERLAPS{"Fold partly overlaps another fold."};
+
+    //the states searched for, as a mask.
+    const int OPEN = 1;
+    const int CLOSED = 2;
+    const int ANY = OPEN | CLOSED;
+
+    //sorts after every fold with the same first line.
+    const size_t BEFORE_ALL = numeric_limits<size_t>::max();
+
+    //how many lines indentFolds looks at between checks of its token.
+    const size_t CHECK_INTERVAL = 4096;
+
+    /**
+     * Returns the width of a line's indent, or npos if the line is blank.
+     */
+    size_t indentWidth(const wstring& str, size_t tabStop)
+    {
+        size_t width = 0;
+
+        for (auto ch : str)
+        {
+            if (ch == L' ')
+                ++width;
+            else if (ch == L'\t')
+                width += tabStop - width % tabStop;
+            else
+                return width;
+        }
+
+        return wstring::npos;
+    }
+}
+
+/**
+ * Create an engine with no folds for the given buffer.
+ */
+FoldEngine::FoldEngine(const Buffer& buffer, TaskScheduler& scheduler)
+    : buffer_(buffer), scheduler_(scheduler), rows_(buffer.lines()), size_(0),
+      seed_(TREAP_PRIORITY_SEED), computing_(0)
+{
+}
+
+/**
+ * Destructor.  Wait for any indent folds being computed.
+ */
+FoldEngine::~FoldEngine()
+{
+    wait();
+}
+
+/**
+ * Move the folds to follow the buffer's last change.  A replaced line is left
+ * in whatever folds it was in.
+ */
+void
+FoldEngine::onBufferChanged(const Buffer* changedBuffer)
+{
+    BufferChange change = changedBuffer->lastChange();
+    size_t replaced = min(change.removed, change.inserted);
+
+    if (change.removed > replaced)
+        eraseLines(change.line + replaced, change.removed - replaced);
+    else if (change.inserted > replaced)
+        insertLines(change.line + replaced, change.inserted - replaced);
+}
+
+/**
+ * Add a fold.
+ */
+void
+FoldEngine::add(size_t first, size_t last, bool closed)
+{
+    if (first >= last)
+        throw exception::FoldRange(FOLD_TOO_SHORT);
+
+    if (last >= lines())
+        throw exception::FoldRange(FOLD_PAST_END);
+
+    Fold fold;
+    if (contains(root_.get(), 0, first, last, fold))
+        throw exception::FoldOverlap(FOLD_EXISTS);
+
+    //the innermost fold starting before this one must not end inside it.
+    if (first > 0
+     && innermost(root_.get(), 0, first, first - 1, ANY, fold)
+     && fold.last < last)
+        throw exception::FoldOverlap(FOLD_OVERLAPS);
+
+    //and no fold starting inside it may end after it.
+    unique_ptr<Node> before;
+    unique_ptr<Node> inside;
+    unique_ptr<Node> after;
+
+    split(move(root_), first + 1, BEFORE_ALL, before, inside);
+    split(move(inside), last + 1, BEFORE_ALL, inside, after);
+
+    bool overlaps = reach(inside.get(), ANY) > last + 1;
+
+    root_ = merge(merge(move(before), move(inside)), move(after));
+
+    if (overlaps)
+        throw exception::FoldOverlap(FOLD_OVERLAPS);
+
+    fold = Fold{first, last, closed};
+    insertFold(fold);
+    coverFold(fold, 1);
+}
+
+/**
+ * Remove the innermost fold containing a line.
+ */
+bool
+FoldEngine::remove(size_t line)
+{
+    Fold fold;
+    if (!innermost(root_.get(), 0, line, line, ANY, fold))
+        return false;
+
+    extract(root_, fold.first, fold.last);
+    coverFold(fold, -1);
+
+    return true;
+}
+
+/**
+ * Open the outermost closed fold containing a line.
+ */
+bool
+FoldEngine::open(size_t line)
+{
+    Fold fold;
+    if (!outermost(root_.get(), 0, line, CLOSED, fold))
+        return false;
+
+    extract(root_, fold.first, fold.last);
+    coverFold(fold, -1);
+
+    fold.closed = false;
+    insertFold(fold);
+
+    return true;
+}
+
+/**
+ * Close the innermost open fold containing a line.
+ */
+bool
+FoldEngine::close(size_t line)
+{
+    Fold fold;
+    if (!innermost(root_.get(), 0, line, line, OPEN, fold))
+        return false;
+
+    extract(root_, fold.first, fold.last);
+
+    fold.closed = true;
+    insertFold(fold);
+    coverFold(fold, 1);
+
+    return true;
+}
+
+/**
+ * Remove every fold.
+ */
+void
+FoldEngine::clear()
+{
+    discard(root_.get(), 0);
+
+    root_.reset();
+    size_ = 0;
+}
+
+/**
+ * Replace every fold with the given folds.
+ */
+void
+FoldEngine::assign(const vector<Fold>& folds)
+{
+    vector<Fold> added(folds);
+
+    for (auto& fold : added)
+    {
+        Fold existing;
+        if (contains(root_.get(), 0, fold.first, fold.last, existing))
+            fold.closed = existing.closed;
+    }
+
+    clear();
+
+    for (auto& fold : added)
+        add(fold.first, fold.last, fold.closed);
+}
+
+/**
+ * Find the innermost fold containing a line.
+ */
+bool
+FoldEngine::find(size_t line, Fold& fold) const
+{
+    return innermost(root_.get(), 0, line, line, ANY, fold);
+}
+
+/**
+ * Returns every fold, in order of first line, outermost first.
+ */
+vector<Fold>
+FoldEngine::folds() const
+{
+    vector<Fold> folds;
+    folds.reserve(size_);
+
+    collect(root_.get(), 0, 0, folds);
+
+    return folds;
+}
+
+/**
+ * Returns the number of folds.
+ */
+size_t
+FoldEngine::size() const
+{
+    return size_;
+}
+
+/**
+ * Returns true if a line is hidden by a closed fold.
+ */
+bool
+FoldEngine::hidden(size_t line) const
+{
+    return rows_.hidden(line);
+}
+
+/**
+ * Returns the row a line is displayed on.
+ */
+size_t
+FoldEngine::row(size_t line) const
+{
+    return rows_.row(line);
+}
+
+/**
+ * Returns the line displayed on a row.
+ */
+size_t
+FoldEngine::line(size_t row) const
+{
+    return rows_.line(row);
+}
+
+/**
+ * Returns the number of rows the buffer is displayed on.
+ */
+size_t
+FoldEngine::rows() const
+{
+    return rows_.rows();
+}
+
+/**
+ * Returns the number of lines in the buffer.
+ */
+size_t
+FoldEngine::lines() const
+{
+    return rows_.lines();
+}
+
+/**
+ * Start computing indent folds for the buffer as it is now, in the
+ * background.
+ */
+void
+FoldEngine::computeIndentFolds(size_t shiftWidth, size_t tabStop)
+{
+    uint64_t version = buffer_.version();
+
+    //the token, rather than the scheduler, drops a stale computation, so the
+    //count of those running is always brought back down.
+    CancellationToken token = buffer_.changeToken();
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        ++computing_;
+    }
+
+    auto done = [this] {
+        lock_guard<mutex> lock(mutex_);
+
+        if (--computing_ == 0)
+            idle_.notify_all();
+    };
+
+    //the lines are copied off the editing thread, from the buffer as it was
+    //at this version, unless it has changed again by then.  The copies share
+    //their contents with the buffer's lines.  Only the asynchronous
+    //observers' copy, if this makes it, is made here.
+    buffer_.readLines([=](const Buffer::LineList& current) {
+        shared_ptr<Buffer::LineList> lines;
+
+        try
+        {
+            if (!token.cancelled())
+                lines = make_shared<Buffer::LineList>(current);
+        }
+        catch (...)
+        {
+        }
+
+        if (!lines)
+        {
+            done();
+            return;
+        }
+
+        scheduler_.submit([=] {
+            unique_ptr<Computed> computed;
+
+            //there's no one to report a failure to; the folds just don't
+            //change.
+            try
+            {
+                computed.reset(new Computed{
+                    version, indentFolds(*lines, shiftWidth, tabStop, token)});
+            }
+            catch (...)
+            {
+            }
+
+            {
+                lock_guard<mutex> lock(mutex_);
+
+                if (computed && !token.cancelled())
+                    computed_ = move(computed);
+            }
+
+            done();
+        }, TaskScheduler::BACKGROUND);
+    });
+}
+
+/**
+ * Install the indent folds computed in the background, if they are ready and
+ * the buffer hasn't changed since they were started.
+ */
+bool
+FoldEngine::poll()
+{
+    unique_ptr<Computed> computed;
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        computed = move(computed_);
+    }
+
+    if (!computed || computed->version != buffer_.version())
+        return false;
+
+    assign(computed->folds);
+
+    return true;
+}
+
+/**
+ * Wait until no indent folds are being computed.
+ */
+void
+FoldEngine::wait()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    idle_.wait(lock, [this] { return computing_ == 0; });
+}
+
+/**
+ * Move the folds after lines inserted before the given line, and grow the
+ * folds the lines were inserted within.
+ */
+void
+FoldEngine::insertLines(size_t line, size_t count)
+{
+    rows_.insert(line, count);
+
+    unique_ptr<Node> before;
+    unique_ptr<Node> after;
+
+    split(move(root_), line, BEFORE_ALL, before, after);
+
+    apply(after.get(), count);
+    stretch(before.get(), line, count);
+
+    root_ = merge(move(before), move(after));
+}
+
+/**
+ * Move the folds after erased lines, shrink the folds they were erased from,
+ * and remove the folds whose first line was erased, or which are left with a
+ * single line.
+ */
+void
+FoldEngine::eraseLines(size_t line, size_t count)
+{
+    unique_ptr<Node> before;
+    unique_ptr<Node> erased;
+    unique_ptr<Node> after;
+
+    split(move(root_), line, BEFORE_ALL, before, erased);
+    split(move(erased), line + count, BEFORE_ALL, erased, after);
+
+    size_ -= discard(erased.get(), 0);
+    erased.reset();
+
+    //folds ending among the erased lines are cut short, and put back once
+    //the lines are gone, unless there's nothing left of them or they would
+    //duplicate another.  They come out before the others are moved, while
+    //the order is still intact.
+    vector<Fold> cut;
+    collect(before.get(), 0, line, cut);
+
+    cut.erase(
+        remove_if(cut.begin(), cut.end(), [&](const Fold& fold) {
+            return fold.last >= line + count;
+        }),
+        cut.end());
+
+    for (auto& fold : cut)
+    {
+        extract(before, fold.first, fold.last);
+        coverFold(fold, -1);
+    }
+
+    stretch(before.get(), line, -count);
+    rows_.erase(line, count);
+
+    apply(after.get(), -count);
+    root_ = merge(move(before), move(after));
+
+    for (auto& fold : cut)
+    {
+        Fold existing;
+        fold.last = line - 1;
+
+        if (fold.first < fold.last
+         && !contains(root_.get(), 0, fold.first, fold.last, existing))
+        {
+            insertFold(fold);
+            coverFold(fold, 1);
+        }
+    }
+}
+
+/**
+ * Insert a fold into the treap, without covering its lines.
+ */
+void
+FoldEngine::insertFold(const Fold& fold)
+{
+    unique_ptr<Node> node(new Node);
+    node->first = fold.first;
+    node->last = fold.last;
+    node->closed = fold.closed;
+    node->priority = treapPriority(seed_);
+    node->shift = 0;
+    update(node.get());
+
+    unique_ptr<Node> before;
+    unique_ptr<Node> after;
+
+    split(move(root_), fold.first, fold.last, before, after);
+    root_ = merge(merge(move(before), move(node)), move(after));
+
+    ++size_;
+}
+
+/**
+ * Take a fold out of a treap, without uncovering its lines.
+ */
+void
+FoldEngine::extract(unique_ptr<Node>& tree, size_t first, size_t last)
+{
+    unique_ptr<Node> before;
+    unique_ptr<Node> node;
+    unique_ptr<Node> after;
+
+    split(move(tree), first, last, before, node);
+    split(move(node), first, last - 1, node, after);
+
+    tree = merge(move(before), move(after));
+
+    if (node)
+        --size_;
+}
+
+/**
+ * Add to the cover count of the lines a fold hides, if it is closed.
+ */
+void
+FoldEngine::coverFold(const Fold& fold, int delta)
+{
+    if (fold.closed)
+        rows_.cover(fold.first + 1, fold.last, delta);
+}
+
+/**
+ * Uncover the lines hidden by every closed fold in a subtree, given the shift
+ * pending above it.
+ *
+ * \returns the number of folds in the subtree.
+ */
+size_t
+FoldEngine::discard(const Node* node, size_t shift)
+{
+    if (!node)
+        return 0;
+
+    coverFold(Fold{node->first + shift, node->last + shift, node->closed}, -1);
+
+    shift += node->shift;
+
+    return 1 + discard(node->left.get(), shift) + discard(node->right.get(), shift);
+}
+
+/**
+ * Join two treaps, every fold of the first coming before the second.
+ */
+unique_ptr<FoldEngine::Node>
+FoldEngine::merge(unique_ptr<Node> left, unique_ptr<Node> right)
+{
+    if (!left)
+        return right;
+
+    if (!right)
+        return left;
+
+    if (left->priority > right->priority)
+    {
+        push(left.get());
+        left->right = merge(move(left->right), move(right));
+        update(left.get());
+
+        return left;
+    }
+
+    push(right.get());
+    right->left = merge(move(left), move(right->left));
+    update(right.get());
+
+    return right;
+}
+
+/**
+ * Split a treap into the folds ordered before the given fold, and the rest.
+ * Folds are ordered by first line, then outermost first.
+ */
+void
+FoldEngine::split(
+    unique_ptr<Node> node, size_t first, size_t last, unique_ptr<Node>& left,
+    unique_ptr<Node>& right)
+{
+    if (!node)
+    {
+        left.reset();
+        right.reset();
+
+        return;
+    }
+
+    push(node.get());
+
+    if (node->first < first || (node->first == first && node->last > last))
+    {
+        split(move(node->right), first, last, node->right, right);
+        update(node.get());
+        left = move(node);
+    }
+    else
+    {
+        split(move(node->left), first, last, left, node->left);
+        update(node.get());
+        right = move(node);
+    }
+}
+
+/**
+ * Recompute a fold's subtree reach from its children.
+ */
+void
+FoldEngine::update(Node* node)
+{
+    node->reach[0] = 0;
+    node->reach[1] = 0;
+    node->reach[node->closed] = node->last + 1;
+
+    for (Node* child : {node->left.get(), node->right.get()})
+    {
+        if (!child)
+            continue;
+
+        node->reach[0] = max(node->reach[0], child->reach[0]);
+        node->reach[1] = max(node->reach[1], child->reach[1]);
+    }
+}
+
+/**
+ * Move every fold in a subtree by the given number of lines, which wraps
+ * around to move them back.
+ */
+void
+FoldEngine::apply(Node* node, size_t delta)
+{
+    if (!node)
+        return;
+
+    node->first += delta;
+    node->last += delta;
+    node->shift += delta;
+
+    for (auto& reach : node->reach)
+    {
+        if (reach)
+            reach += delta;
+    }
+}
+
+/**
+ * Pass a fold's pending shift down to its children.
+ */
+void
+FoldEngine::push(Node* node)
+{
+    if (node->shift == 0)
+        return;
+
+    apply(node->left.get(), node->shift);
+    apply(node->right.get(), node->shift);
+    node->shift = 0;
+}
+
+/**
+ * Returns one past the furthest last line of the folds in a subtree in the
+ * given states, or zero if there are none, not counting the shift pending
+ * above it.
+ */
+size_t
+FoldEngine::reach(const Node* node, int states)
+{
+    if (!node)
+        return 0;
+
+    return max(
+        states & OPEN ? node->reach[0] : 0,
+        states & CLOSED ? node->reach[1] : 0);
+}
+
+/**
+ * Find the innermost fold in the given states which contains a line and
+ * starts at or before the given bound, which is the last such fold in order.
+ */
+bool
+FoldEngine::innermost(
+    const Node* node, size_t shift, size_t line, size_t bound, int states,
+    Fold& fold)
+{
+    size_t furthest = reach(node, states);
+    if (furthest == 0 || furthest + shift <= line)
+        return false;
+
+    size_t first = node->first + shift;
+    size_t last = node->last + shift;
+    size_t below = shift + node->shift;
+
+    if (first > bound)
+        return innermost(node->left.get(), below, line, bound, states, fold);
+
+    if (innermost(node->right.get(), below, line, bound, states, fold))
+        return true;
+
+    if (last >= line && (states & (node->closed ? CLOSED : OPEN)))
+    {
+        fold = Fold{first, last, node->closed};
+
+        return true;
+    }
+
+    return innermost(node->left.get(), below, line, bound, states, fold);
+}
+
+/**
+ * Find the outermost fold in the given states which contains a line, which is
+ * the first such fold in order.
+ */
+bool
+FoldEngine::outermost(
+    const Node* node, size_t shift, size_t line, int states, Fold& fold)
+{
+    size_t furthest = reach(node, states);
+    if (furthest == 0 || furthest + shift <= line)
+        return false;
+
+    size_t first = node->first + shift;
+    size_t last = node->last + shift;
+    size_t below = shift + node->shift;
+
+    if (outermost(node->left.get(), below, line, states, fold))
+        return true;
+
+    if (first > line)
+        return false;
+
+    if (last >= line && (states & (node->closed ? CLOSED : OPEN)))
+    {
+        fold = Fold{first, last, node->closed};
+
+        return true;
+    }
+
+    return outermost(node->right.get(), below, line, states, fold);
+}
+
+/**
+ * Find the fold covering exactly the given lines.
+ */
+bool
+FoldEngine::contains(
+    const Node* node, size_t shift, size_t first, size_t last, Fold& fold)
+{
+    while (node)
+    {
+        size_t nodeFirst = node->first + shift;
+        size_t nodeLast = node->last + shift;
+
+        if (nodeFirst == first && nodeLast == last)
+        {
+            fold = Fold{first, last, node->closed};
+
+            return true;
+        }
+
+        shift += node->shift;
+
+        if (nodeFirst < first || (nodeFirst == first && nodeLast > last))
+            node = node->right.get();
+        else
+            node = node->left.get();
+    }
+
+    return false;
+}
+
+/**
+ * Append the folds in a subtree which end at or after the given line, in
+ * order.
+ */
+void
+FoldEngine::collect(
+    const Node* node, size_t shift, size_t line, vector<Fold>& folds)
+{
+    size_t furthest = reach(node, ANY);
+    if (furthest == 0 || furthest + shift <= line)
+        return;
+
+    size_t last = node->last + shift;
+    size_t below = shift + node->shift;
+
+    collect(node->left.get(), below, line, folds);
+
+    if (last >= line)
+        folds.push_back(Fold{node->first + shift, last, node->closed});
+
+    collect(node->right.get(), below, line, folds);
+}
+
+/**
+ * Move the last line of every fold in a subtree which ends at or after the
+ * given line by the given number of lines, which wraps around to move them
+ * back.  The subtree must have no shift pending above it.
+ */
+void
+FoldEngine::stretch(Node* node, size_t line, size_t count)
+{
+    if (reach(node, ANY) <= line)
+        return;
+
+    push(node);
+
+    stretch(node->left.get(), line, count);
+    stretch(node->right.get(), line, count);
+
+    if (node->last >= line)
+        node->last += count;
+
+    update(node);
+}
+
+/**
+ * indentFolds computes folds from the indent of each line, as vi's indent
+ * fold method does.
+ *
+ * \param lines         The lines to fold.
+ * \param shiftWidth    The indent of each fold level; zero uses the tab stop.
+ * \param tabStop       The width of a tab.
+ * \param token         Checked now and then; once cancelled, the folds found
+ *                      so far are returned.
+ */
+vector<Fold>
+vix::indentFolds(
+    const list<Line>& lines, size_t shiftWidth, size_t tabStop,
+    CancellationToken token)
+{
+    tabStop = max<size_t>(1, tabStop);
+    shiftWidth = shiftWidth ? shiftWidth : tabStop;
+
+    vector<Fold> folds;
+    vector<size_t> levels;
+    levels.reserve(lines.size());
+
+    //a run of blank lines takes the lower level of the lines either side.
+    size_t previous = 0;
+    size_t blanks = 0;
+
+    for (auto& line : lines)
+    {
+        if (levels.size() % CHECK_INTERVAL == 0 && token.cancelled())
+            return folds;
+
+        size_t width = indentWidth(line.str(), tabStop);
+
+        if (width == wstring::npos)
+        {
+            levels.push_back(0);
+            ++blanks;
+
+            continue;
+        }
+
+        size_t level = width / shiftWidth;
+
+        fill(levels.end() - blanks, levels.end(), min(previous, level));
+        levels.push_back(level);
+
+        previous = level;
+        blanks = 0;
+    }
+
+    //each level open at a line is a fold starting at the line which opened
+    //it; a jump of several levels opens several folds with the same start,
+    //which close together, and only the outermost is kept.
+    vector<size_t> starts;
+
+    auto closeTo = [&](size_t level, size_t end) {
+        while (starts.size() > level)
+        {
+            size_t start = starts.back();
+            starts.pop_back();
+
+            bool duplicate = !folds.empty()
+                && folds.back().first == start && folds.back().last == end;
+
+            if (end > start && !duplicate)
+                folds.push_back(Fold{start, end, true});
+        }
+    };
+
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        if (i % CHECK_INTERVAL == 0 && token.cancelled())
+            return folds;
+
+        closeTo(levels[i], i - 1);
+
+        while (starts.size() < levels[i])
+            starts.push_back(i);
+    }
+
+    closeTo(0, levels.size() - 1);
+
+    sort(folds.begin(), folds.end(), [](const Fold& a, const Fold& b) {
+        return a.first < b.first || (a.first == b.first && a.last > b.last);
+    });
+
+    return folds;
+}
@@ -0,0 +1,175 @@
+#include <vix/EraseTextCommand.h>
+#include <vix/InsertTextCommand.h>
+#include <vix/SerialVarint.h>
+#include <vix/Utf8.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string OUT_OF_RANGE{"Inserted text is outside the buffer."};
+}
+
+/**
+ * Create a command inserting text at the given line and column.
+ */
+InsertTextCommand::InsertTextCommand(size_t line, size_t column, const wstring& text)
+    : line_(line), column_(column), text_(text)
+{
+}
+
+/**
+ * Returns the line into which text is inserted.
+ */
+size_t
+InsertTextCommand::line() const
+{
+    return line_;
+}
+
+/**
+ * Returns the column at which text is inserted.
+ */
+size_t
+InsertTextCommand::column() const
+{
+    return column_;
+}
+
+/**
+ * Returns the inserted text.
+ */
+const wstring&
+InsertTextCommand::text() const
+{
+    return text_;
+}
+
+/**
+ * Insert the text.
+ *
+ * \throw vix::exception::CommandRange if the position is outside the buffer.
+ */
+void
+InsertTextCommand::apply(weak_ptr<Buffer> buffer)
+{
+    auto b = buffer.lock();
+    if (!b || line_ >= b->lines())
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    auto line = b->line(line_);
+    auto& str = line->str();
+
+    if (column_ > str.size())
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    b->replace(line, column_, 0, text_);
+}
+
+/**
+ * Remove the inserted text.
+ *
+ * \throw vix::exception::CommandRange if the position is outside the buffer.
+ */
+void
+InsertTextCommand::revert(weak_ptr<Buffer> buffer)
+{
+    auto b = buffer.lock();
+    if (!b || line_ >= b->lines())
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    auto line = b->line(line_);
+    auto& str = line->str();
+
+    if (column_ + text_.size() > str.size())
+        throw exception::CommandRange(OUT_OF_RANGE);
+
+    b->replace(line, column_, text_.size(), wstring());
+}
+
+/**
+ * Returns true if the given command inserts text straight after this command's
+ * text, or erases the end of this command's text.
+ */
+bool
+InsertTextCommand::canMerge(const Command& next) const
+{
+    size_t end = column_ + text_.size();
+
+    auto insert = dynamic_cast<const InsertTextCommand*>(&next);
+    if (insert)
+        return insert->line_ == line_ && insert->column_ == end;
+
+    auto erase = dynamic_cast<const EraseTextCommand*>(&next);
+    if (erase)
+    {
+        return erase->line() == line_
+            && erase->column() >= column_
+            && erase->column() + erase->length() == end;
+    }
+
+    return false;
+}
+
+/**
+ * Merge an insertion straight after this command's text, or an erasure of the
+ * end of this command's text.
+ */
+bool
+InsertTextCommand::merge(const Command& next)
+{
+    if (!canMerge(next))
+        return false;
+
+    auto insert = dynamic_cast<const InsertTextCommand*>(&next);
+    if (insert)
+    {
+        text_ += insert->text_;
+
+        return true;
+    }
+
+    //backspacing over what was just typed shortens what was typed.
+    auto& erase = dynamic_cast<const EraseTextCommand&>(next);
+    text_.erase(erase.column() - column_);
+
+    return true;
+}
+
+/**
+ * Replace this command with one read from a binary input stream.
+ *
+ * \throw vix::exception::SerialRead if serialization fails.
+ */
+void
+InsertTextCommand::serialRead(std::istream& in)
+{
+    uint64_t line = 0;
+    uint64_t column = 0;
+    string text;
+
+    serialReadVarint(in, line);
+    serialReadVarint(in, column);
+    serialReadCompact(in, text);
+
+    line_ = line;
+    column_ = column;
+    text_.clear();
+    utf8Decode(text.data(), text.size(), text_);
+}
+
+/**
+ * Write this command to a binary output stream.
+ *
+ * \throw vix::exception::SerialWrite if serialization fails.
+ */
+void
+InsertTextCommand::serialWrite(std::ostream& out) const
+{
+    string text;
+    utf8Encode(text_, text);
+
+    serialWriteVarint(out, line_);
+    serialWriteVarint(out, column_);
+    serialWriteCompact(out, text);
+}
@@ -0,0 +1,710 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <mutex>
+#include <ostream>
+#include <typeinfo>
+#include <vix/Buffer.h>
+#include <vix/Instrumentation.h>
+
+using namespace std;
+using namespace vix;
+
+atomic<bool> Instrumentation::enabled_(false);
+
+namespace {
+    //each power of two is split into 1 << SUB_BITS buckets, up to 2^40ns,
+    //which is about eighteen minutes.
+    const unsigned SUB_BITS = 2;
+    const uint64_t SUB_BUCKETS = 1 << SUB_BITS;
+    const unsigned MAX_SHIFT = 40 - SUB_BITS;
+}
+
+const size_t LatencyStatistics::BUCKETS = (MAX_SHIFT + 2) * SUB_BUCKETS;
+
+namespace {
+    const char* COUNTER_NAMES[INSTRUMENTED_COUNTERS] = {
+        "journal_records_written",
+        "journal_bytes_written",
+        "journal_records_read",
+        "journal_bytes_read",
+        "snapshots_written",
+        "snapshot_bytes_written",
+        "snapshots_read",
+        "snapshot_bytes_read",
+        "allocations",
+        "allocated_bytes",
+        "lines_walked"
+    };
+
+    const char* TIMER_NAMES[INSTRUMENTED_TIMERS] = {
+        "buffer_insert",
+        "buffer_append",
+        "buffer_erase",
+        "buffer_replace",
+        "buffer_assign",
+        "buffer_clear",
+        "buffer_notify"
+    };
+
+    const char* OTHER_OBSERVERS = "(other)";
+
+    const size_t BUCKETS = LatencyStatistics::BUCKETS;
+
+    //the number of observers each thread can tell apart.
+    const size_t OBSERVER_SLOTS = 64;
+
+    //the number of resets so far.  Each thread clears its own statistics
+    //when it next records, so that only it ever writes them.
+    atomic<uint64_t> resets(0);
+
+    /**
+     * Add to a value which only one thread writes, which needs no atomic add.
+     */
+    inline void bump(atomic<uint64_t>& value, uint64_t amount)
+    {
+        value.store(value.load(memory_order_relaxed) + amount, memory_order_relaxed);
+    }
+
+    /**
+     * A histogram written by one thread and read by any.
+     */
+    struct Histogram
+    {
+        atomic<uint64_t> buckets[BUCKETS];
+        atomic<uint64_t> count;
+        atomic<uint64_t> total;
+        atomic<uint64_t> max;
+
+        void record(uint64_t nanoseconds)
+        {
+            bump(buckets[LatencyStatistics::bucketOf(nanoseconds)], 1);
+            bump(count, 1);
+            bump(total, nanoseconds);
+
+            if (nanoseconds > max.load(memory_order_relaxed))
+                max.store(nanoseconds, memory_order_relaxed);
+        }
+
+        void read(LatencyStatistics& statistics) const
+        {
+            for (size_t i = 0; i < BUCKETS; ++i)
+                statistics.buckets[i] += buckets[i].load(memory_order_relaxed);
+
+            statistics.count += count.load(memory_order_relaxed);
+            statistics.total += total.load(memory_order_relaxed);
+            statistics.max = std::max(statistics.max, max.load(memory_order_relaxed));
+        }
+
+        void clear()
+        {
+            for (auto& bucket : buckets)
+                bucket.store(0, memory_order_relaxed);
+
+            count.store(0, memory_order_relaxed);
+            total.store(0, memory_order_relaxed);
+            max.store(0, memory_order_relaxed);
+        }
+    };
+
+    /**
+     * The latencies of one observer.  A slot is claimed by the thread which
+     * owns it, which names it before publishing the observer, so the name is
+     * only ever written by one thread and read once published.
+     */
+    struct ObserverSlot
+    {
+        atomic<const BufferChangeObserver*> observer;
+        const type_info* type;
+        string name;
+        Histogram latency;
+    };
+
+    /**
+     * Everything one thread has recorded since the reset it was last cleared
+     * for.
+     */
+    struct ThreadStatistics
+    {
+        atomic<uint64_t> counters[INSTRUMENTED_COUNTERS];
+        Histogram timers[INSTRUMENTED_TIMERS];
+        ObserverSlot observers[OBSERVER_SLOTS];
+        Histogram otherObservers;
+        atomic<uint64_t> generation;
+
+        ThreadStatistics()
+            : generation(resets.load(memory_order_relaxed))
+        {
+            clear();
+        }
+
+        /**
+         * Zero everything, and free every observer slot for a new observer.
+         */
+        void clear()
+        {
+            for (auto& counter : counters)
+                counter.store(0, memory_order_relaxed);
+
+            for (auto& timer : timers)
+                timer.clear();
+
+            for (auto& slot : observers)
+            {
+                slot.observer.store(nullptr, memory_order_relaxed);
+                slot.latency.clear();
+            }
+
+            otherObservers.clear();
+        }
+
+        /**
+         * Returns true if these statistics were recorded before the last
+         * reset.
+         */
+        bool stale() const
+        {
+            return generation.load(memory_order_relaxed) != resets.load(memory_order_relaxed);
+        }
+    };
+
+    /**
+     * Returns the readable name of a class.
+     */
+    string className(const type_info& type)
+    {
+        int status = 0;
+        char* name = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+
+        string result = status == 0 && name ? name : type.name();
+        free(name);
+
+        return result;
+    }
+
+    /**
+     * Returns the name an observer is reported under: its own name, or its
+     * class's, and its address.
+     */
+    string observerName(const BufferChangeObserver& observer)
+    {
+        string name = observer.instrumentationName();
+        if (name.empty())
+            name = className(typeid(observer));
+
+        char address[32];
+        snprintf(address, sizeof(address), " [%p]", (const void*)&observer);
+
+        return name + address;
+    }
+
+    /**
+     * Add what a thread has recorded to a snapshot.
+     */
+    void read(const ThreadStatistics& statistics, InstrumentationSnapshot& snapshot)
+    {
+        if (statistics.stale())
+            return;
+
+        for (size_t i = 0; i < INSTRUMENTED_COUNTERS; ++i)
+            snapshot.counters[i] += statistics.counters[i].load(memory_order_relaxed);
+
+        for (size_t i = 0; i < INSTRUMENTED_TIMERS; ++i)
+            statistics.timers[i].read(snapshot.timers[i]);
+
+        for (const auto& slot : statistics.observers)
+        {
+            if (!slot.observer.load(memory_order_acquire))
+                continue;
+
+            LatencyStatistics latency;
+            slot.latency.read(latency);
+
+            if (latency.count > 0)
+                snapshot.observers[slot.name].merge(latency);
+        }
+
+        LatencyStatistics other;
+        statistics.otherObservers.read(other);
+
+        if (other.count > 0)
+            snapshot.observers[OTHER_OBSERVERS].merge(other);
+    }
+
+    /**
+     * Returns an empty snapshot.
+     */
+    InstrumentationSnapshot emptySnapshot()
+    {
+        InstrumentationSnapshot snapshot;
+        snapshot.counters.resize(INSTRUMENTED_COUNTERS);
+        snapshot.timers.resize(INSTRUMENTED_TIMERS);
+
+        return snapshot;
+    }
+
+    /**
+     * Every thread's statistics, and what threads which have finished
+     * recorded.
+     */
+    struct Registry
+    {
+        mutex lock;
+        vector<ThreadStatistics*> threads;
+        InstrumentationSnapshot finished = emptySnapshot();
+    };
+
+    //never destroyed, since threads may finish after static destruction.
+    Registry& registry()
+    {
+        static Registry* registry = new Registry;
+
+        return *registry;
+    }
+
+    //set while this thread is inside instrumentation, so that anything it
+    //allocates, when allocations are counted, doesn't come back in.
+    thread_local bool busy = false;
+
+    /**
+     * Holds this thread's statistics, and hands them to the registry when the
+     * thread finishes.
+     */
+    struct ThreadHolder
+    {
+        ThreadStatistics* statistics = nullptr;
+
+        ~ThreadHolder()
+        {
+            if (!statistics)
+                return;
+
+            busy = true;
+
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+
+            read(*statistics, r.finished);
+            r.threads.erase(find(r.threads.begin(), r.threads.end(), statistics));
+
+            delete statistics;
+            statistics = nullptr;
+        }
+    };
+
+    thread_local ThreadHolder holder;
+
+    /**
+     * Returns this thread's statistics, creating them the first time, or
+     * null if this thread is already inside instrumentation.
+     */
+    ThreadStatistics* threadStatistics()
+    {
+        ThreadStatistics* statistics = holder.statistics;
+
+        //statistics are cleared under the registry's lock, so that nothing
+        //reads them meanwhile.
+        if (statistics && statistics->stale() && !busy)
+        {
+            busy = true;
+
+            {
+                Registry& r = registry();
+                lock_guard<mutex> guard(r.lock);
+
+                statistics->clear();
+                statistics->generation.store(
+                    resets.load(memory_order_relaxed), memory_order_relaxed);
+            }
+
+            busy = false;
+        }
+
+        if (statistics || busy)
+            return statistics;
+
+        busy = true;
+        statistics = new ThreadStatistics;
+
+        {
+            Registry& r = registry();
+            lock_guard<mutex> guard(r.lock);
+            r.threads.push_back(statistics);
+        }
+
+        holder.statistics = statistics;
+        busy = false;
+
+        return statistics;
+    }
+
+    /**
+     * Write a string as a JSON string.
+     */
+    void writeJsonString(ostream& out, const string& value)
+    {
+        out << '"';
+
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+                out << '\\' << c;
+            else if ((unsigned char)c < 0x20)
+            {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                out << escape;
+            }
+            else
+                out << c;
+        }
+
+        out << '"';
+    }
+
+    void writeJsonLatency(ostream& out, const LatencyStatistics& latency)
+    {
+        out << "{\"count\": " << latency.count
+            << ", \"total_ns\": " << latency.total
+            << ", \"p50_ns\": " << latency.percentile(0.5)
+            << ", \"p90_ns\": " << latency.percentile(0.9)
+            << ", \"p99_ns\": " << latency.percentile(0.99)
+            << ", \"p999_ns\": " << latency.percentile(0.999)
+            << ", \"max_ns\": " << latency.max << "}";
+    }
+
+    void writeTextLatency(ostream& out, const string& name, const LatencyStatistics& latency)
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "  %-32s %10llu %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+            name.c_str(),
+            (unsigned long long)latency.count,
+            latency.mean() / 1000.0,
+            latency.percentile(0.5) / 1000.0,
+            latency.percentile(0.99) / 1000.0,
+            latency.percentile(0.999) / 1000.0,
+            latency.max / 1000.0);
+
+        out << line;
+    }
+
+    void writeTextHeading(ostream& out, const char* heading)
+    {
+        char line[256];
+        snprintf(line, sizeof(line), "%-34s %10s %10s %10s %10s %10s %10s\n",
+            heading, "count", "mean", "p50", "p99", "p99.9", "max");
+
+        out << line;
+    }
+}
+
+/**
+ * Returns the bucket the given latency is counted in.
+ */
+size_t
+LatencyStatistics::bucketOf(uint64_t nanoseconds)
+{
+    if (nanoseconds < SUB_BUCKETS)
+        return nanoseconds;
+
+    unsigned shift = 63 - __builtin_clzll(nanoseconds) - SUB_BITS;
+    if (shift > MAX_SHIFT)
+        return BUCKETS - 1;
+
+    return (shift + 1) * SUB_BUCKETS + ((nanoseconds >> shift) & (SUB_BUCKETS - 1));
+}
+
+/**
+ * Returns the largest latency counted in the given bucket.
+ */
+uint64_t
+LatencyStatistics::bucketTop(size_t bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+
+    unsigned shift = bucket / SUB_BUCKETS - 1;
+    uint64_t mantissa = SUB_BUCKETS + bucket % SUB_BUCKETS;
+
+    return ((mantissa + 1) << shift) - 1;
+}
+
+/**
+ * Create empty statistics.
+ */
+LatencyStatistics::LatencyStatistics()
+    : count(0), total(0), max(0), buckets(BUCKETS)
+{
+}
+
+/**
+ * Count a latency.
+ */
+void
+LatencyStatistics::record(uint64_t nanoseconds)
+{
+    ++buckets[bucketOf(nanoseconds)];
+    ++count;
+    total += nanoseconds;
+    max = std::max(max, nanoseconds);
+}
+
+/**
+ * Returns the mean latency.
+ */
+double
+LatencyStatistics::mean() const
+{
+    return count ? (double)total / count : 0;
+}
+
+/**
+ * Returns the latency which the given fraction of latencies are at or below,
+ * rounded up to the top of its bucket.
+ */
+uint64_t
+LatencyStatistics::percentile(double fraction) const
+{
+    if (count == 0)
+        return 0;
+
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)ceil(fraction * count));
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        seen += buckets[i];
+
+        if (seen >= rank)
+            return std::min(bucketTop(i), max);
+    }
+
+    return max;
+}
+
+/**
+ * Add the latencies of other statistics to these.
+ */
+void
+LatencyStatistics::merge(const LatencyStatistics& other)
+{
+    for (size_t i = 0; i < buckets.size() && i < other.buckets.size(); ++i)
+        buckets[i] += other.buckets[i];
+
+    count += other.count;
+    total += other.total;
+    max = std::max(max, other.max);
+}
+
+/**
+ * Write the snapshot as a JSON object.
+ */
+void
+InstrumentationSnapshot::writeJson(ostream& out) const
+{
+    out << "{\n  \"counters\": {";
+
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        out << (i ? ",\n    " : "\n    ");
+        writeJsonString(out, COUNTER_NAMES[i]);
+        out << ": " << counters[i];
+    }
+
+    out << "\n  },\n  \"timers\": {";
+
+    for (size_t i = 0; i < timers.size(); ++i)
+    {
+        out << (i ? ",\n    " : "\n    ");
+        writeJsonString(out, TIMER_NAMES[i]);
+        out << ": ";
+        writeJsonLatency(out, timers[i]);
+    }
+
+    out << "\n  },\n  \"observers\": {";
+
+    bool first = true;
+    for (const auto& observer : observers)
+    {
+        out << (first ? "\n    " : ",\n    ");
+        writeJsonString(out, observer.first);
+        out << ": ";
+        writeJsonLatency(out, observer.second);
+
+        first = false;
+    }
+
+    out << "\n  }\n}\n";
+}
+
+/**
+ * Write the snapshot as text tables, for people.
+ */
+void
+InstrumentationSnapshot::writeText(ostream& out) const
+{
+    char line[256];
+
+    out << "counters\n";
+
+    for (size_t i = 0; i < counters.size(); ++i)
+    {
+        snprintf(line, sizeof(line), "  %-32s %10llu\n",
+            COUNTER_NAMES[i], (unsigned long long)counters[i]);
+
+        out << line;
+    }
+
+    writeTextHeading(out, "timers (us)");
+
+    for (size_t i = 0; i < timers.size(); ++i)
+        writeTextLatency(out, TIMER_NAMES[i], timers[i]);
+
+    if (!observers.empty())
+    {
+        writeTextHeading(out, "observers (us)");
+
+        for (const auto& observer : observers)
+            writeTextLatency(out, observer.first, observer.second);
+    }
+}
+
+/**
+ * Start or stop recording.
+ */
+void
+Instrumentation::enable(bool enabled)
+{
+    enabled_.store(enabled, memory_order_relaxed);
+}
+
+/**
+ * Record the latency of an operation, in nanoseconds.
+ */
+void
+Instrumentation::record(InstrumentedTimer timer, uint64_t nanoseconds)
+{
+    ThreadStatistics* statistics = threadStatistics();
+
+    if (statistics && timer < INSTRUMENTED_TIMERS)
+        statistics->timers[timer].record(nanoseconds);
+}
+
+/**
+ * Record the time taken by a call to an observer, in nanoseconds.
+ */
+void
+Instrumentation::record(const BufferChangeObserver& observer, uint64_t nanoseconds)
+{
+    ThreadStatistics* statistics = threadStatistics();
+    if (!statistics)
+        return;
+
+    const type_info& type = typeid(observer);
+
+    //probe from the observer's address for its slot, or the first free one.
+    size_t start = (reinterpret_cast<uintptr_t>(&observer) >> 4) % OBSERVER_SLOTS;
+
+    for (size_t i = 0; i < OBSERVER_SLOTS; ++i)
+    {
+        ObserverSlot& slot = statistics->observers[(start + i) % OBSERVER_SLOTS];
+        const BufferChangeObserver* claimed = slot.observer.load(memory_order_relaxed);
+
+        if (!claimed)
+        {
+            slot.type = &type;
+            slot.name = observerName(observer);
+
+            slot.observer.store(&observer, memory_order_release);
+            claimed = &observer;
+        }
+
+        //another observer may since have been made at a gone one's address.
+        if (claimed == &observer && *slot.type == type)
+        {
+            slot.latency.record(nanoseconds);
+            return;
+        }
+    }
+
+    statistics->otherObservers.record(nanoseconds);
+}
+
+/**
+ * Returns what every thread has recorded since the last reset.
+ */
+InstrumentationSnapshot
+Instrumentation::snapshot()
+{
+    bool wasBusy = busy;
+    busy = true;
+
+    Registry& r = registry();
+    InstrumentationSnapshot snapshot;
+
+    {
+        lock_guard<mutex> guard(r.lock);
+
+        snapshot = r.finished;
+
+        for (auto statistics : r.threads)
+            read(*statistics, snapshot);
+    }
+
+    busy = wasBusy;
+
+    return snapshot;
+}
+
+/**
+ * Zero every counter and timer, and forget the observers seen so far.
+ */
+void
+Instrumentation::reset()
+{
+    bool wasBusy = busy;
+    busy = true;
+
+    Registry& r = registry();
+
+    {
+        lock_guard<mutex> guard(r.lock);
+
+        //each thread clears its own statistics when it next records, and
+        //they're ignored until then.
+        resets.fetch_add(1, memory_order_relaxed);
+
+        r.finished = emptySnapshot();
+    }
+
+    busy = wasBusy;
+}
+
+/**
+ * Add to a counter.
+ */
+void
+Instrumentation::add(InstrumentedCounter counter, uint64_t amount)
+{
+    ThreadStatistics* statistics = threadStatistics();
+
+    if (statistics && counter < INSTRUMENTED_COUNTERS)
+        bump(statistics->counters[counter], amount);
+}
+
+/**
+ * Record the time since construction.
+ */
+void
+InstrumentationTimer::stop()
+{
+    uint64_t nanoseconds = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now() - start_).count();
+
+    if (observer_)
+        Instrumentation::record(*observer_, nanoseconds);
+    else
+        Instrumentation::record(timer_, nanoseconds);
+}
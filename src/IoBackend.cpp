@@ -0,0 +1,518 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <vix/IoBackend.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define VIX_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string READ_FAILED{"File read failed."};
+    const string WRITE_FAILED{"File write failed."};
+
+    /**
+     * The state of the read or write on a staging buffer.
+     */
+    struct Operation
+    {
+        Operation()
+            : pending(false), writing(false), fd(-1), offset(0), size(0),
+              done(0), error(0)
+        {
+        }
+
+        bool pending;
+        bool writing;
+        int fd;
+        uint64_t offset;
+        size_t size;
+        size_t done;
+        int error;
+    };
+
+    /**
+     * Returns the result of a finished operation, throwing if it failed.
+     */
+    size_t result(Operation& operation)
+    {
+        if (operation.error != 0)
+        {
+            operation.error = 0;
+
+            if (operation.writing)
+                throw exception::FileWrite(WRITE_FAILED);
+
+            throw exception::FileRead(READ_FAILED);
+        }
+
+        return operation.done;
+    }
+
+    /**
+     * A BlockingBackend reads and writes each buffer as it is queued.
+     */
+    class BlockingBackend : public IoBackend
+    {
+    public:
+        BlockingBackend(size_t buffers, size_t bufferSize)
+            : IoBackend(buffers, bufferSize), operations_(IoBackend::buffers())
+        {
+        }
+
+        virtual void read(int fd, size_t index, size_t size, uint64_t offset)
+        {
+            Operation& operation = start(fd, index, size, offset, false);
+            char* p = buffer(index);
+
+            while (operation.done < operation.size)
+            {
+                ssize_t count = pread(
+                    fd, p + operation.done, operation.size - operation.done,
+                    offset + operation.done);
+
+                if (count < 0 && errno == EINTR)
+                    continue;
+
+                if (count < 0)
+                    operation.error = errno;
+
+                if (count <= 0)
+                    break;
+
+                operation.done += count;
+            }
+        }
+
+        virtual void write(int fd, size_t index, size_t size, uint64_t offset)
+        {
+            Operation& operation = start(fd, index, size, offset, true);
+            const char* p = buffer(index);
+
+            while (operation.done < operation.size)
+            {
+                ssize_t count = pwrite(
+                    fd, p + operation.done, operation.size - operation.done,
+                    offset + operation.done);
+
+                if (count < 0 && errno == EINTR)
+                    continue;
+
+                if (count < 0)
+                {
+                    operation.error = errno;
+                    break;
+                }
+
+                //a write which makes no progress never will.
+                if (count == 0)
+                {
+                    operation.error = EIO;
+                    break;
+                }
+
+                operation.done += count;
+            }
+        }
+
+        virtual void submit()
+        {
+        }
+
+        virtual size_t wait(size_t index)
+        {
+            return result(operations_[index]);
+        }
+
+        virtual bool asynchronous() const
+        {
+            return false;
+        }
+
+    private:
+        vector<Operation> operations_;
+
+        Operation& start(int fd, size_t index, size_t size, uint64_t offset, bool writing)
+        {
+            Operation& operation = operations_[index];
+
+            operation.writing = writing;
+            operation.fd = fd;
+            operation.offset = offset;
+            operation.size = min(size, bufferSize());
+            operation.done = 0;
+            operation.error = 0;
+
+            return operation;
+        }
+    };
+
+#ifdef VIX_IO_URING
+    /**
+     * A UringBackend queues reads and writes on an io_uring, talking to the
+     * kernel with the raw system calls.  Each buffer has at most one operation
+     * in flight, so a ring with an entry per buffer never overflows.
+     */
+    class UringBackend : public IoBackend
+    {
+    public:
+        UringBackend(size_t buffers, size_t bufferSize)
+            : IoBackend(buffers, bufferSize), ring_(-1), sqRing_(MAP_FAILED),
+              cqRing_(MAP_FAILED), sqes_(MAP_FAILED), sqRingSize_(0),
+              cqRingSize_(0), sqesSize_(0), registered_(false), queued_(0),
+              operations_(IoBackend::buffers()), vectors_(IoBackend::buffers())
+        {
+        }
+
+        virtual ~UringBackend()
+        {
+            //the kernel may still be reading or writing the buffers.
+            for (size_t i = 0; i < operations_.size(); ++i)
+            {
+                try
+                {
+                    wait(i);
+                }
+                catch (exception::File&)
+                {
+                }
+            }
+
+            if (sqes_ != MAP_FAILED)
+                munmap(sqes_, sqesSize_);
+
+            if (cqRing_ != MAP_FAILED && cqRing_ != sqRing_)
+                munmap(cqRing_, cqRingSize_);
+
+            if (sqRing_ != MAP_FAILED)
+                munmap(sqRing_, sqRingSize_);
+
+            if (ring_ >= 0)
+                close(ring_);
+        }
+
+        /**
+         * Set up the ring and register the buffers with it.
+         *
+         * \returns false if io_uring can't be used.
+         */
+        bool open()
+        {
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+
+            ring_ = syscall(__NR_io_uring_setup, (unsigned)buffers(), &params);
+            if (ring_ < 0)
+                return false;
+
+            sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+
+            bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single)
+                sqRingSize_ = cqRingSize_ = max(sqRingSize_, cqRingSize_);
+
+            sqRing_ = mmap(
+                nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+            if (sqRing_ == MAP_FAILED)
+                return false;
+
+            cqRing_ = single ? sqRing_ : mmap(
+                nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED)
+                return false;
+
+            sqes_ = mmap(
+                nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+            if (sqes_ == MAP_FAILED)
+                return false;
+
+            char* sq = (char*)sqRing_;
+            sqTail_ = (unsigned*)(sq + params.sq_off.tail);
+            sqMask_ = *(unsigned*)(sq + params.sq_off.ring_mask);
+            sqArray_ = (unsigned*)(sq + params.sq_off.array);
+
+            char* cq = (char*)cqRing_;
+            cqHead_ = (unsigned*)(cq + params.cq_off.head);
+            cqTail_ = (unsigned*)(cq + params.cq_off.tail);
+            cqMask_ = *(unsigned*)(cq + params.cq_off.ring_mask);
+            cqes_ = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+            //registered buffers are pinned, and count against the locked
+            //memory limit; without them, the buffers are passed each time.
+            for (size_t i = 0; i < buffers(); ++i)
+                vectors_[i] = iovec{buffer(i), bufferSize()};
+
+            registered_ = syscall(
+                __NR_io_uring_register, ring_, IORING_REGISTER_BUFFERS,
+                vectors_.data(), (unsigned)vectors_.size()) == 0;
+
+            return true;
+        }
+
+        virtual void read(int fd, size_t index, size_t size, uint64_t offset)
+        {
+            start(fd, index, size, offset, false);
+        }
+
+        virtual void write(int fd, size_t index, size_t size, uint64_t offset)
+        {
+            start(fd, index, size, offset, true);
+        }
+
+        virtual void submit()
+        {
+            enter(0);
+        }
+
+        virtual size_t wait(size_t index)
+        {
+            Operation& operation = operations_[index];
+
+            while (operation.pending)
+            {
+                reap();
+
+                if (operation.pending)
+                    enter(1);
+            }
+
+            return result(operation);
+        }
+
+        virtual bool asynchronous() const
+        {
+            return true;
+        }
+
+    private:
+        int ring_;
+        void* sqRing_;
+        void* cqRing_;
+        void* sqes_;
+        size_t sqRingSize_;
+        size_t cqRingSize_;
+        size_t sqesSize_;
+        unsigned* sqTail_;
+        unsigned sqMask_;
+        unsigned* sqArray_;
+        unsigned* cqHead_;
+        unsigned* cqTail_;
+        unsigned cqMask_;
+        io_uring_cqe* cqes_;
+        bool registered_;
+        unsigned queued_;
+        vector<Operation> operations_;
+        vector<iovec> vectors_;
+
+        void start(int fd, size_t index, size_t size, uint64_t offset, bool writing)
+        {
+            Operation& operation = operations_[index];
+
+            operation.pending = true;
+            operation.writing = writing;
+            operation.fd = fd;
+            operation.offset = offset;
+            operation.size = min(size, bufferSize());
+            operation.done = 0;
+            operation.error = 0;
+
+            queue(index);
+        }
+
+        /**
+         * Queue what is left of the operation on a buffer.
+         */
+        void queue(size_t index)
+        {
+            Operation& operation = operations_[index];
+            char* data = buffer(index) + operation.done;
+            size_t size = operation.size - operation.done;
+
+            //this is the only thread which moves the tail.
+            unsigned tail = *sqTail_;
+            unsigned slot = tail & sqMask_;
+            io_uring_sqe& sqe = ((io_uring_sqe*)sqes_)[slot];
+
+            memset(&sqe, 0, sizeof(sqe));
+            sqe.fd = operation.fd;
+            sqe.off = operation.offset + operation.done;
+            sqe.user_data = index;
+
+            if (registered_)
+            {
+                sqe.opcode = operation.writing
+                    ? IORING_OP_WRITE_FIXED
+                    : IORING_OP_READ_FIXED;
+                sqe.addr = (uint64_t)(uintptr_t)data;
+                sqe.len = size;
+                sqe.buf_index = index;
+            }
+            else
+            {
+                vectors_[index] = iovec{data, size};
+
+                sqe.opcode = operation.writing
+                    ? IORING_OP_WRITEV
+                    : IORING_OP_READV;
+                sqe.addr = (uint64_t)(uintptr_t)&vectors_[index];
+                sqe.len = 1;
+            }
+
+            sqArray_[slot] = slot;
+            __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+
+            ++queued_;
+        }
+
+        /**
+         * Submit everything queued, and wait for at least the given number of
+         * operations to finish.
+         */
+        void enter(unsigned waitFor)
+        {
+            if (queued_ == 0 && waitFor == 0)
+                return;
+
+            unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+            int submitted;
+
+            do
+            {
+                submitted = syscall(
+                    __NR_io_uring_enter, ring_, queued_, waitFor, flags,
+                    nullptr, 0);
+            }
+            while (submitted < 0 && errno == EINTR);
+
+            if (submitted < 0)
+                throw exception::File("Could not submit file operations.");
+
+            queued_ -= submitted;
+        }
+
+        /**
+         * Record the results of the operations which have finished.
+         */
+        void reap()
+        {
+            unsigned head = *cqHead_;
+            unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+
+            for (; head != tail; ++head)
+            {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                Operation& operation = operations_[cqe.user_data];
+                bool retry = cqe.res == -EINTR || cqe.res == -EAGAIN;
+
+                if (cqe.res < 0 && !retry)
+                    operation.error = -cqe.res;
+                else if (cqe.res > 0)
+                    operation.done += cqe.res;
+                else if (cqe.res == 0 && operation.writing)
+                    operation.error = EIO;
+
+                //a write which falls short goes on with the rest; a read only
+                //falls short at the end of the file.
+                bool more = operation.error == 0
+                    && operation.done < operation.size
+                    && (retry || (operation.writing && cqe.res > 0));
+
+                if (more)
+                    queue(cqe.user_data);
+                else
+                    operation.pending = false;
+            }
+
+            __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        }
+    };
+#endif
+}
+
+const size_t IoBackend::DEFAULT_BUFFERS = 2;
+const size_t IoBackend::DEFAULT_BUFFER_SIZE = 1 << 20;
+
+/**
+ * Returns the fastest backend available.
+ */
+unique_ptr<IoBackend>
+IoBackend::create(size_t buffers, size_t bufferSize)
+{
+#ifdef VIX_IO_URING
+    UringBackend* uring = new UringBackend(buffers, bufferSize);
+    unique_ptr<IoBackend> backend(uring);
+
+    //io_uring may be missing from the kernel, or turned off.
+    if (uring->open())
+        return backend;
+#endif
+
+    return blocking(buffers, bufferSize);
+}
+
+/**
+ * Returns a backend which reads and writes each buffer as it is queued.
+ */
+unique_ptr<IoBackend>
+IoBackend::blocking(size_t buffers, size_t bufferSize)
+{
+    return unique_ptr<IoBackend>(new BlockingBackend(buffers, bufferSize));
+}
+
+/**
+ * Allocate the given number of staging buffers of the given size.
+ */
+IoBackend::IoBackend(size_t buffers, size_t bufferSize)
+    : buffers_(max<size_t>(1, buffers)), bufferSize_(bufferSize),
+      storage_(buffers_ * bufferSize_)
+{
+}
+
+/**
+ * Destructor.
+ */
+IoBackend::~IoBackend()
+{
+}
+
+/**
+ * Returns the number of staging buffers.
+ */
+size_t
+IoBackend::buffers() const
+{
+    return buffers_;
+}
+
+/**
+ * Returns the size of each staging buffer.
+ */
+size_t
+IoBackend::bufferSize() const
+{
+    return bufferSize_;
+}
+
+/**
+ * Returns the staging buffer with the given index.
+ */
+char*
+IoBackend::buffer(size_t index)
+{
+    return storage_.data() + index * bufferSize_;
+}
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <thread>
+#include <vix/IoBudget.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Create a budget allowing the given number of bytes per second.  The burst
+ * defaults to one second's worth of writes.
+ */
+IoBudget::IoBudget(uint64_t bytesPerSecond, uint64_t burst)
+    : rate_((double)bytesPerSecond),
+      burst_((double)(burst ? burst : bytesPerSecond)),
+      tokens_(burst_),
+      refilled_(clock::now())
+{
+}
+
+/**
+ * Returns the number of bytes per second allowed, or zero if the budget is
+ * unlimited.
+ */
+uint64_t
+IoBudget::rate() const
+{
+    return (uint64_t)rate_;
+}
+
+/**
+ * Spend the given number of bytes, blocking the calling thread until the
+ * budget allows them.
+ */
+void
+IoBudget::consume(uint64_t bytes)
+{
+    if (rate_ <= 0)
+        return;
+
+    chrono::duration<double> wait(0);
+
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        clock::time_point now = clock::now();
+        chrono::duration<double> elapsed = now - refilled_;
+        refilled_ = now;
+
+        tokens_ = min(burst_, tokens_ + elapsed.count() * rate_);
+
+        //the write goes ahead now and the budget goes into debt; the writer
+        //then waits until the debt is repaid, which keeps large writes whole.
+        tokens_ -= (double)bytes;
+        if (tokens_ < 0)
+            wait = chrono::duration<double>(-tokens_ / rate_);
+    }
+
+    if (wait.count() > 0)
+        this_thread::sleep_for(wait);
+}
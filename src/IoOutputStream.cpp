@@ -0,0 +1,144 @@
+#include <vix/IoOutputStream.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string WRITE_SHORT{"File write fell short."};
+}
+
+/**
+ * Write to an open file, starting at the given offset.
+ */
+IoOutputStream::IoOutputStream(int fd, uint64_t offset, unique_ptr<IoBackend> backend)
+    : std::ostream(nullptr), buffer_(fd, offset, std::move(backend))
+{
+    //the buffer is only constructed after the ostream base.
+    rdbuf(&buffer_);
+}
+
+/**
+ * Destructor.  Write out everything written, ignoring any errors.
+ */
+IoOutputStream::~IoOutputStream()
+{
+    buffer_.pubsync();
+}
+
+/**
+ * Returns the offset in the file of the next byte written.
+ */
+uint64_t
+IoOutputStream::offset() const
+{
+    return buffer_.offset();
+}
+
+IoOutputStream::IoBuffer::IoBuffer(int fd, uint64_t offset, unique_ptr<IoBackend> backend)
+    : fd_(fd), backend_(std::move(backend)), offset_(offset), current_(0),
+      writing_(0), writingSize_(0), inFlight_(false)
+{
+    char* p = backend_->buffer(current_);
+
+    setp(p, p + backend_->bufferSize());
+}
+
+/**
+ * Returns the offset in the file of the next byte written.
+ */
+uint64_t
+IoOutputStream::IoBuffer::offset() const
+{
+    return offset_ + (pptr() - pbase());
+}
+
+/**
+ * Write out the full buffer, then buffer the character which didn't fit.
+ */
+IoOutputStream::IoBuffer::int_type
+IoOutputStream::IoBuffer::overflow(int_type c)
+{
+    try
+    {
+        writeCurrent();
+    }
+    catch (exception::File&)
+    {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+/**
+ * Write out everything buffered, and wait for it.
+ */
+int
+IoOutputStream::IoBuffer::sync()
+{
+    try
+    {
+        writeCurrent();
+        waitForWrite();
+    }
+    catch (exception::File&)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Start writing the current buffer, and move on to the next.
+ */
+void
+IoOutputStream::IoBuffer::writeCurrent()
+{
+    size_t size = pptr() - pbase();
+
+    if (size > 0)
+    {
+        //one write at a time keeps the file free of holes.
+        waitForWrite();
+
+        backend_->write(fd_, current_, size, offset_);
+        backend_->submit();
+
+        writing_ = current_;
+        writingSize_ = size;
+        inFlight_ = true;
+        offset_ += size;
+
+        current_ = (current_ + 1) % backend_->buffers();
+    }
+
+    //with a single buffer, there's nowhere else to go.
+    if (inFlight_ && writing_ == current_)
+        waitForWrite();
+
+    char* p = backend_->buffer(current_);
+
+    setp(p, p + backend_->bufferSize());
+}
+
+/**
+ * Wait for the buffer being written.
+ */
+void
+IoOutputStream::IoBuffer::waitForWrite()
+{
+    if (!inFlight_)
+        return;
+
+    inFlight_ = false;
+
+    if (backend_->wait(writing_) != writingSize_)
+        throw exception::FileWrite(WRITE_SHORT);
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <ostream>
+#include <streambuf>
+#include <unistd.h>
+#include <vix/Crc32c.h>
+#include <vix/Instrumentation.h>
+#include <vix/Journal.h>
+#include <vix/JournalScanner.h>
+#include <vix/MappedFile.h>
+#include <vix/MemoryInputStream.h>
+#include <vix/SerialEndian.h>
+#include <vix/SerialUtilities.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string RECORD_TOO_LARGE{"Journal record is too large."};
+
+    //frames up to this size keep their buffer for the next record.
+    const size_t FRAME_SCRATCH_LIMIT = 1024 * 1024;
+
+    //the buffer records are serialized into, reused from record to record.
+    thread_local string frameScratch;
+
+    /**
+     * A stream buffer which appends everything written to a string.
+     */
+    class FrameBuffer : public streambuf
+    {
+    public:
+        explicit FrameBuffer(string& frame)
+            : frame_(frame)
+        {
+        }
+
+    protected:
+        virtual int_type overflow(int_type c)
+        {
+            if (!traits_type::eq_int_type(c, traits_type::eof()))
+                frame_.push_back(traits_type::to_char_type(c));
+
+            return traits_type::not_eof(c);
+        }
+
+        virtual streamsize xsputn(const char* s, streamsize n)
+        {
+            frame_.append(s, n);
+
+            return n;
+        }
+
+    private:
+        string& frame_;
+    };
+
+    /**
+     * Fill in the frame header at the start of a frame whose payload follows
+     * it, and write the frame.
+     */
+    size_t writeFrame(ostream& out, uint8_t type, char* frame, size_t size)
+    {
+        size_t length = size - JOURNAL_FRAME_HEADER_SIZE;
+        if (length > JOURNAL_MAX_RECORD_SIZE)
+            throw exception::SerialWrite(RECORD_TOO_LARGE);
+
+        uint8_t* header = (uint8_t*)frame;
+        encodeBigEndian<uint32_t>(header + 4, length);
+        header[8] = type;
+        encodeBigEndian<uint32_t>(header, crc32c(header + 4, size - 4));
+
+        serialWriteFixedBuffer(out, frame, size);
+
+        Instrumentation::count(COUNTER_JOURNAL_RECORDS_WRITTEN);
+        Instrumentation::count(COUNTER_JOURNAL_BYTES_WRITTEN, size);
+
+        return size;
+    }
+}
+
+/**
+ * writeJournalHeader writes the header which starts a journal.
+ *
+ * \param out           The stream to which the header is written.
+ *
+ * \throw vix::exception::SerialWrite if the serial write fails.
+ */
+void
+vix::writeJournalHeader(std::ostream& out)
+{
+    uint8_t header[JOURNAL_HEADER_SIZE];
+    copy(JOURNAL_MAGIC, JOURNAL_MAGIC + sizeof(JOURNAL_MAGIC), header);
+    encodeBigEndian<uint16_t>(header + 4, JOURNAL_VERSION);
+    encodeBigEndian<uint16_t>(header + 6, 0);
+
+    serialWriteFixedBuffer(out, header, sizeof(header));
+}
+
+/**
+ * writeJournalRecord frames a raw payload as a record of the given type and
+ * writes the frame in a single write.
+ *
+ * \param out           The stream to which the record is written.
+ * \param type          The record type.
+ * \param payload       The payload.
+ * \param size          The size of the payload.
+ *
+ * \returns the size of the frame.
+ *
+ * \throw vix::exception::SerialWrite if the record is too large or the serial
+ *        write fails.
+ */
+size_t
+vix::writeJournalRecord(std::ostream& out, uint8_t type, const void* payload, size_t size)
+{
+    if (size > JOURNAL_MAX_RECORD_SIZE)
+        throw exception::SerialWrite(RECORD_TOO_LARGE);
+
+    string frame(JOURNAL_FRAME_HEADER_SIZE + size, '\0');
+    if (size > 0)
+        copy((const char*)payload, (const char*)payload + size, &frame[JOURNAL_FRAME_HEADER_SIZE]);
+
+    return writeFrame(out, type, &frame[0], frame.size());
+}
+
+/**
+ * writeJournalRecord frames a serialized object as a record of the given type
+ * and writes the frame in a single write.
+ *
+ * \param out           The stream to which the record is written.
+ * \param type          The record type.
+ * \param value         The object to write.
+ *
+ * \returns the size of the frame.
+ *
+ * \throw vix::exception::SerialWrite if the record is too large or the serial
+ *        write fails.
+ */
+size_t
+vix::writeJournalRecord(std::ostream& out, uint8_t type, const Serializable& value)
+{
+    //serialize behind room for the frame header, straight into the buffer the
+    //frame is written from.  The buffer is taken for the duration, so a
+    //record written while serializing this one gets its own.
+    string frame;
+    frame.swap(frameScratch);
+    frame.assign(JOURNAL_FRAME_HEADER_SIZE, '\0');
+
+    FrameBuffer buffer(frame);
+    ostream frameOut(&buffer);
+    value.serialWrite(frameOut);
+
+    size_t written = writeFrame(out, type, &frame[0], frame.size());
+
+    if (frame.capacity() <= FRAME_SCRATCH_LIMIT)
+        frame.swap(frameScratch);
+
+    return written;
+}
+
+/**
+ * readJournalRecord reads a serializable object from the payload of a journal
+ * record, without copying the payload.
+ *
+ * \param record        The record to read.
+ * \param value         The object to read.
+ *
+ * \throw vix::exception::SerialRead if the serial read fails.
+ */
+void
+vix::readJournalRecord(const JournalRecord& record, Serializable& value)
+{
+    MemoryInputStream in(record.payload.data(), record.payload.size());
+
+    value.serialRead(in);
+}
+
+/**
+ * recoverJournal scans the journal at the given path, passes each valid record
+ * to the replay function in order, and truncates the journal just past the
+ * last valid record if anything follows it.  Nothing before the first bad
+ * frame is discarded.
+ *
+ * \param path          The path of the journal.
+ * \param replay        The function called with each valid record.
+ *
+ * \throw vix::exception::FileOpen if the journal cannot be opened.
+ * \throw vix::exception::FileRead if the journal cannot be mapped.
+ * \throw vix::exception::FileWrite if the journal cannot be truncated.
+ * \throw vix::exception::SerialRead if the file is not a journal.
+ */
+JournalRecovery
+vix::recoverJournal(
+    const string& path, const function<void(const JournalRecord&)>& replay)
+{
+    JournalRecovery recovery{0, 0, 0};
+    size_t fileSize = 0;
+
+    //the mapping must be gone before the file is truncated beneath it.
+    {
+        MappedFile file(path);
+        JournalScanner scanner(file.data(), file.size());
+        JournalRecord record;
+
+        while (scanner.next(record))
+        {
+            replay(record);
+            ++recovery.records;
+        }
+
+        fileSize = file.size();
+        recovery.size = scanner.position();
+    }
+
+    recovery.discarded = fileSize - recovery.size;
+
+    if (recovery.discarded > 0 && truncate(path.c_str(), recovery.size) < 0)
+        throw exception::FileWrite("Could not truncate " + path + ".");
+
+    return recovery;
+}
@@ -0,0 +1,125 @@
+#include <vix/BufferSnapshot.h>
+#include <vix/JournalCheckpoint.h>
+#include <vix/JournalScanner.h>
+#include <vix/MappedFile.h>
+#include <vix/SerialEndian.h>
+
+using namespace std;
+using namespace vix;
+
+//a sequence number and an offset.
+const size_t JournalCheckpoint::SERIAL_SIZE = 16;
+
+/**
+ * Create a checkpoint.
+ */
+JournalCheckpoint::JournalCheckpoint(uint64_t sequence, uint64_t offset)
+    : sequence_(sequence), offset_(offset)
+{
+}
+
+/**
+ * Returns the sequence number of the checkpoint's snapshot.
+ */
+uint64_t
+JournalCheckpoint::sequence() const
+{
+    return sequence_;
+}
+
+/**
+ * Returns the journal offset from which records are replayed.
+ */
+uint64_t
+JournalCheckpoint::offset() const
+{
+    return offset_;
+}
+
+void
+JournalCheckpoint::serialRead(std::istream& in)
+{
+    serialReadBigEndian(in, sequence_);
+    serialReadBigEndian(in, offset_);
+}
+
+void
+JournalCheckpoint::serialWrite(std::ostream& out) const
+{
+    serialWriteBigEndian(out, sequence_);
+    serialWriteBigEndian(out, offset_);
+}
+
+/**
+ * checkpointSnapshotPath returns the path of the snapshot with the given
+ * sequence number taken for the journal at the given path.
+ */
+string
+vix::checkpointSnapshotPath(const string& journalPath, uint64_t sequence)
+{
+    return journalPath + ".checkpoint." + to_string(sequence);
+}
+
+/**
+ * loadJournal recovers the journal at the given path, loads the buffer from
+ * its latest checkpoint, if it has one, and replays the records written after
+ * that checkpoint.  Without a checkpoint, every record is replayed on top of
+ * the buffer as it is.
+ *
+ * \param path          The path of the journal.
+ * \param buffer        The buffer to load.
+ * \param replay        The function called with each record to replay.
+ * \param threads       The number of threads used to decode the snapshot.
+ *
+ * \returns the recovery of the journal, counting only replayed records.
+ *
+ * \throw vix::exception::File if the journal or snapshot can't be read, or the
+ *        journal can't be truncated.
+ * \throw vix::exception::SerialRead if the journal or snapshot is invalid.
+ */
+JournalRecovery
+vix::loadJournal(
+    const string& path, Buffer& buffer,
+    const function<void(const JournalRecord&)>& replay, unsigned threads)
+{
+    JournalCheckpoint checkpoint;
+    bool checkpointed = false;
+
+    //the first pass repairs the journal and finds the latest checkpoint; it
+    //only checksums, which is far cheaper than replaying.
+    JournalRecovery recovery =
+        recoverJournal(path, [&](const JournalRecord& record) {
+            if (record.type == JOURNAL_CHECKPOINT)
+            {
+                readJournalRecord(record, checkpoint);
+                checkpointed = true;
+            }
+        });
+
+    if (checkpointed)
+    {
+        MappedFile snapshot(checkpointSnapshotPath(path, checkpoint.sequence()));
+
+        readBufferSnapshot(snapshot.data(), snapshot.size(), buffer, threads);
+    }
+
+    //the second pass replays the tail.
+    MappedFile file(path);
+    JournalScanner scanner(file.data(), file.size());
+    JournalRecord record;
+
+    if (checkpointed)
+        scanner.position(checkpoint.offset());
+
+    recovery.records = 0;
+    while (scanner.next(record))
+    {
+        if (record.type == JOURNAL_CHECKPOINT)
+            continue;
+
+        replay(record);
+        ++recovery.records;
+    }
+
+    return recovery;
+}
@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include <vix/BudgetedOutputStream.h>
+#include <vix/BufferSnapshot.h>
+#include <vix/JournalCheckpoint.h>
+#include <vix/JournalCheckpointer.h>
+#include <vix/JournalScanner.h>
+#include <vix/MappedFile.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //compaction catches up with the journal outside the lock until no more
+    //than this much is left to copy under it.
+    const uint64_t CATCH_UP_TAIL = 64 * 1024;
+
+    //but gives up on catching up after this many passes, if edits keep
+    //outpacing the budget.
+    const int CATCH_UP_PASSES = 8;
+
+    /**
+     * Rename a file, throwing if it can't be.
+     */
+    void renameFile(const string& from, const string& to)
+    {
+        if (rename(from.c_str(), to.c_str()) < 0)
+            throw exception::FileWrite("Could not rename " + from + ".");
+    }
+}
+
+/**
+ * Open the journal at the given path, creating it if necessary.
+ *
+ * \param path          The path of the journal.
+ * \param bytesPerSecond The background IO budget; zero is unlimited.
+ * \param archive       Keep each journal replaced by compaction, and the
+ *                      snapshot it refers to, rather than deleting them.
+ * \param scheduler     The scheduler which runs checkpoints.
+ *
+ * \throw vix::exception::File if the journal can't be opened.
+ * \throw vix::exception::SerialRead if the file is not a journal.
+ */
+JournalCheckpointer::JournalCheckpointer(
+    const string& path, uint64_t bytesPerSecond, bool archive,
+    TaskScheduler& scheduler)
+    : path_(path), budget_(bytesPerSecond), archive_(archive),
+      scheduler_(scheduler), writer_(new JournalWriter(path)),
+      pendingOffset_(0), requested_(0), requestedOffset_(0), awaiting_(false),
+      busy_(false), sequence_(0)
+{
+    writer_->flush();
+
+    //carry on numbering snapshots from the latest checkpoint.
+    MappedFile file(path_);
+    JournalScanner scanner(file.data(), file.size());
+    JournalRecord record;
+
+    while (scanner.next(record))
+    {
+        if (record.type == JOURNAL_CHECKPOINT)
+        {
+            JournalCheckpoint checkpoint;
+            readJournalRecord(record, checkpoint);
+
+            sequence_ = max(sequence_, checkpoint.sequence());
+        }
+    }
+}
+
+/**
+ * Destructor.  Finish any pending checkpoint.
+ */
+JournalCheckpointer::~JournalCheckpointer()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    idle_.wait(lock, [this] { return !busy_ && !awaiting_; });
+}
+
+/**
+ * Append a record to the journal.
+ *
+ * \throw vix::exception::SerialWrite if the write fails.
+ */
+void
+JournalCheckpointer::append(const Serializable& record, uint8_t type)
+{
+    lock_guard<mutex> lock(mutex_);
+
+    writer_->append(type, record);
+}
+
+/**
+ * Flush appended records to the operating system.
+ *
+ * \throw vix::exception::FileWrite if the flush fails.
+ */
+void
+JournalCheckpointer::flush()
+{
+    lock_guard<mutex> lock(mutex_);
+
+    writer_->flush();
+}
+
+/**
+ * Checkpoint the buffer, which must reflect every record appended so far.  The
+ * snapshot and compaction run in the background; if another checkpoint is
+ * still waiting to start, it is replaced by this one.
+ *
+ * \throw any exception raised by a previous background checkpoint.
+ */
+void
+JournalCheckpointer::checkpoint(const Buffer& buffer)
+{
+    uint64_t request;
+
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        rethrowError();
+
+        request = ++requested_;
+        requestedOffset_ = writer_->size();
+        awaiting_ = true;
+    }
+
+    //the lines are copied as they were now, by a task, so the editing thread
+    //never copies their contents.  The copies share their contents with the
+    //buffer's lines.  Only the asynchronous observers' copy, if this makes
+    //it, is made here.
+    buffer.readLines([this, request](const Buffer::LineList& current) {
+        shared_ptr<Buffer::LineList> lines;
+        exception_ptr error;
+
+        try
+        {
+            lines = make_shared<Buffer::LineList>(current);
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+
+        bool start = false;
+
+        {
+            lock_guard<mutex> lock(mutex_);
+
+            //a checkpoint requested since replaces this one.
+            if (request != requested_)
+                return;
+
+            awaiting_ = false;
+
+            if (error)
+            {
+                error_ = error;
+                idle_.notify_all();
+                return;
+            }
+
+            pendingLines_ = lines;
+            pendingOffset_ = requestedOffset_;
+
+            //a checkpoint requested while another runs waits for it to
+            //finish.
+            start = !busy_;
+            busy_ = true;
+        }
+
+        if (start)
+            scheduler_.submit([this] { run(); });
+    });
+}
+
+/**
+ * Wait until no checkpoint is pending or running.
+ *
+ * \throw any exception raised by a background checkpoint.
+ */
+void
+JournalCheckpointer::wait()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    idle_.wait(lock, [this] { return !busy_ && !awaiting_; });
+
+    rethrowError();
+}
+
+/**
+ * Returns the archive path of the journal replaced by the checkpoint with the
+ * given sequence number.
+ */
+string
+JournalCheckpointer::archivePath(uint64_t sequence) const
+{
+    return path_ + ".archive." + to_string(sequence);
+}
+
+/**
+ * Run the pending checkpoint, as a task.
+ */
+void
+JournalCheckpointer::run()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    shared_ptr<Buffer::LineList> lines;
+    lines.swap(pendingLines_);
+    uint64_t offset = pendingOffset_;
+
+    lock.unlock();
+
+    exception_ptr error;
+    try
+    {
+        runCheckpoint(*lines, offset);
+    }
+    catch (...)
+    {
+        error = current_exception();
+    }
+
+    //release the lines before reporting the checkpoint done.
+    lines.reset();
+
+    lock.lock();
+
+    if (error)
+        error_ = error;
+
+    //a checkpoint requested in the meantime runs next.
+    if (pendingLines_)
+    {
+        lock.unlock();
+        scheduler_.submit([this] { run(); });
+
+        return;
+    }
+
+    busy_ = false;
+    idle_.notify_all();
+}
+
+/**
+ * Snapshot the given lines, which reflect the journal up to the given offset,
+ * then compact the journal.
+ */
+void
+JournalCheckpointer::runCheckpoint(Buffer::LineList& lines, uint64_t offset)
+{
+    uint64_t previous = sequence_;
+    uint64_t sequence = previous + 1;
+    string snapshotPath = checkpointSnapshotPath(path_, sequence);
+
+    //the snapshot only appears under its real name once it is complete.
+    {
+        Buffer snapshot;
+        snapshot.assign(lines);
+
+        BudgetedOutputStream out(snapshotPath + ".tmp", budget_);
+        writeBufferSnapshot(out, snapshot);
+        out.commit();
+    }
+
+    renameFile(snapshotPath + ".tmp", snapshotPath);
+
+    //from here on, recovery can start at the new snapshot, even if compaction
+    //doesn't finish.
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        writer_->append(JOURNAL_CHECKPOINT, JournalCheckpoint(sequence, offset));
+        writer_->flush();
+    }
+
+    sequence_ = sequence;
+
+    compact(sequence, offset);
+
+    //nothing refers to the previous snapshot any more, unless it was
+    //archived along with its journal.
+    if (previous > 0 && !archive_)
+        unlink(checkpointSnapshotPath(path_, previous).c_str());
+}
+
+/**
+ * Replace the journal with one starting at the given checkpoint.
+ */
+void
+JournalCheckpointer::compact(uint64_t sequence, uint64_t offset)
+{
+    string compactPath = path_ + ".compact";
+    BudgetedOutputStream out(compactPath, budget_);
+
+    //the compacted journal starts with the checkpoint, and its records follow
+    //straight after it.
+    uint64_t start =
+        JOURNAL_HEADER_SIZE + JOURNAL_FRAME_HEADER_SIZE
+      + JournalCheckpoint::SERIAL_SIZE;
+
+    writeJournalHeader(out);
+    writeJournalRecord(out, JOURNAL_CHECKPOINT, JournalCheckpoint(sequence, start));
+
+    //copy the bulk of the journal, then whatever was appended meanwhile, in
+    //passes, without holding up the editing thread.
+    vector<pair<uint64_t, uint64_t>> skipped;
+    uint64_t copied = offset;
+
+    for (int pass = 0; pass < CATCH_UP_PASSES; ++pass)
+    {
+        uint64_t size;
+
+        {
+            lock_guard<mutex> lock(mutex_);
+
+            writer_->flush();
+            size = writer_->size();
+        }
+
+        if (pass > 0 && size - copied <= CATCH_UP_TAIL)
+            break;
+
+        copied = copyRecords(out, copied, skipped);
+    }
+
+    out.commit();
+
+    unique_lock<mutex> lock(mutex_);
+
+    //the short tail left is copied without charging the budget or syncing,
+    //so the editing thread only waits for that copy and the swap.
+    writer_->flush();
+    out.budgeted(false);
+    copyRecords(out, copied, skipped);
+
+    if (out.flush().bad())
+        throw exception::FileWrite("Could not write " + compactPath + ".");
+
+    //the new journal is opened before it replaces the old one, which stays in
+    //use if either step fails, rather than leaving a writer on an unlinked
+    //file.  The descriptor follows the file when it is renamed.
+    unique_ptr<JournalWriter> writer(new JournalWriter(compactPath));
+
+    if (archive_ && link(path_.c_str(), archivePath(sequence).c_str()) < 0)
+        throw exception::FileWrite("Could not archive " + path_ + ".");
+
+    renameFile(compactPath, path_);
+    writer_.swap(writer);
+
+    //a checkpoint requested meanwhile refers to an offset in the old journal;
+    //move it to the same record in the new one.
+    auto moved = [&](uint64_t old) {
+        uint64_t removed = 0;
+        for (auto& frame : skipped)
+        {
+            if (frame.first < old)
+                removed += frame.second;
+        }
+
+        return start + (old - offset) - removed;
+    };
+
+    if (pendingLines_)
+        pendingOffset_ = moved(pendingOffset_);
+
+    if (awaiting_)
+        requestedOffset_ = moved(requestedOffset_);
+
+    lock.unlock();
+
+    //the tail is synced once the editing thread can carry on; until then,
+    //recovery treats it like any unsynced end of the journal.
+    out.commit();
+}
+
+/**
+ * Copy the records from the given journal offset on, leaving out checkpoints,
+ * and return the offset of the end of the last record copied.  The offset and
+ * size of each checkpoint left out is added to skipped.
+ */
+uint64_t
+JournalCheckpointer::copyRecords(
+    ostream& out, uint64_t offset, vector<pair<uint64_t, uint64_t>>& skipped)
+{
+    MappedFile file(path_);
+    JournalScanner scanner(file.data(), file.size());
+    JournalRecord record;
+
+    scanner.position(offset);
+
+    //records are copied frame and all, since they are already validated.
+    while (scanner.next(record))
+    {
+        uint64_t size = JOURNAL_FRAME_HEADER_SIZE + record.payload.size();
+
+        if (record.type == JOURNAL_CHECKPOINT)
+        {
+            skipped.push_back(make_pair(record.offset, size));
+            continue;
+        }
+
+        out.write(record.payload.data() - JOURNAL_FRAME_HEADER_SIZE, size);
+    }
+
+    return scanner.position();
+}
+
+/**
+ * Rethrow a background error, if there has been one.  The mutex must be held.
+ */
+void
+JournalCheckpointer::rethrowError()
+{
+    if (error_)
+    {
+        exception_ptr error = error_;
+        error_ = nullptr;
+
+        rethrow_exception(error);
+    }
+}
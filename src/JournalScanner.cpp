@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <vix/Crc32c.h>
+#include <vix/Instrumentation.h>
+#include <vix/JournalScanner.h>
+#include <vix/SerialEndian.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string NOT_A_JOURNAL{"Not a journal."};
+    const string UNSUPPORTED_VERSION{"Unsupported journal version."};
+    const string OFFSET_OUT_OF_RANGE{"Journal offset is out of range."};
+}
+
+/**
+ * Create a scanner over a journal.  An empty range is an empty journal, and a
+ * range too short to hold the header is a journal whose header was torn.
+ *
+ * \throw vix::exception::SerialRead if the range holds something other than a
+ *        journal.
+ */
+JournalScanner::JournalScanner(const void* data, size_t size)
+    : data_((const uint8_t*)data), size_(size), position_(0), corrupt_(false)
+{
+    //a torn header is still recognisable by whatever made it to disk.
+    size_t magic = min(size, sizeof(JOURNAL_MAGIC));
+    if (!equal(data_, data_ + magic, JOURNAL_MAGIC))
+        throw exception::SerialRead(NOT_A_JOURNAL);
+
+    if (size < JOURNAL_HEADER_SIZE)
+    {
+        corrupt_ = size > 0;
+        size_ = 0;
+        return;
+    }
+
+    if (decodeBigEndian<uint16_t>(data_ + 4) != JOURNAL_VERSION)
+        throw exception::SerialRead(UNSUPPORTED_VERSION);
+
+    position_ = JOURNAL_HEADER_SIZE;
+}
+
+/**
+ * Read the next valid record.
+ *
+ * \returns false at the end of the journal or at a bad frame.
+ */
+bool
+JournalScanner::next(JournalRecord& record)
+{
+    if (corrupt_ || position_ == size_)
+        return false;
+
+    const uint8_t* frame = data_ + position_;
+    size_t remaining = size_ - position_;
+
+    //a frame whose header or payload runs off the end was torn.
+    if (remaining < JOURNAL_FRAME_HEADER_SIZE)
+    {
+        corrupt_ = true;
+        return false;
+    }
+
+    uint32_t crc = decodeBigEndian<uint32_t>(frame);
+    uint32_t length = decodeBigEndian<uint32_t>(frame + 4);
+
+    if (length > JOURNAL_MAX_RECORD_SIZE
+     || length > remaining - JOURNAL_FRAME_HEADER_SIZE)
+    {
+        corrupt_ = true;
+        return false;
+    }
+
+    //the checksum covers the length, the type and the payload.
+    if (crc32c(frame + 4, JOURNAL_FRAME_HEADER_SIZE - 4 + length) != crc)
+    {
+        corrupt_ = true;
+        return false;
+    }
+
+    record.offset = position_;
+    record.type = frame[8];
+    record.payload =
+        StringRef((const char*)frame + JOURNAL_FRAME_HEADER_SIZE, length);
+
+    position_ += JOURNAL_FRAME_HEADER_SIZE + length;
+
+    Instrumentation::count(COUNTER_JOURNAL_RECORDS_READ);
+    Instrumentation::count(COUNTER_JOURNAL_BYTES_READ, JOURNAL_FRAME_HEADER_SIZE + length);
+
+    return true;
+}
+
+/**
+ * Returns the offset just past the last valid record scanned.
+ */
+size_t
+JournalScanner::position() const
+{
+    return position_;
+}
+
+/**
+ * Continue scanning from the given offset, which must be the start of a frame
+ * or the end of the journal, such as the offset recorded by a checkpoint.
+ *
+ * \throw vix::exception::SerialRead if the offset is out of range.
+ */
+void
+JournalScanner::position(size_t offset)
+{
+    if (offset < JOURNAL_HEADER_SIZE || offset > size_)
+        throw exception::SerialRead(OFFSET_OUT_OF_RANGE);
+
+    position_ = offset;
+    corrupt_ = false;
+}
+
+/**
+ * Returns true if scanning stopped at a torn or corrupt frame.
+ */
+bool
+JournalScanner::corrupt() const
+{
+    return corrupt_;
+}
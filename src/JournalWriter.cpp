@@ -0,0 +1,116 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vix/JournalWriter.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string WRITE_FAILED{"Journal write failed."};
+
+    //records are collected in staging buffers of this size.
+    const size_t JOURNAL_BUFFER_SIZE = 64 * 1024;
+}
+
+/**
+ * Open a journal for appending, creating it if necessary.
+ *
+ * \throw vix::exception::FileOpen if the journal cannot be opened.
+ * \throw vix::exception::FileWrite if the header cannot be written.
+ */
+JournalWriter::JournalWriter(const string& path)
+    : fd_(open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644)), size_(0)
+{
+    if (fd_ < 0)
+        throw exception::FileOpen("Could not open " + path + ".");
+
+    //the destructor won't run if this throws, so close the journal here.
+    try
+    {
+        struct stat st;
+        if (fstat(fd_, &st) < 0)
+            throw exception::FileOpen("Could not stat " + path + ".");
+
+        size_ = st.st_size;
+        out_.reset(new IoOutputStream(
+            fd_, size_, IoBackend::create(IoBackend::DEFAULT_BUFFERS, JOURNAL_BUFFER_SIZE)));
+
+        if (size_ == 0)
+        {
+            try
+            {
+                writeJournalHeader(*out_);
+            }
+            catch (exception::SerialWrite&)
+            {
+                throw exception::FileWrite("Could not write " + path + ".");
+            }
+
+            size_ = JOURNAL_HEADER_SIZE;
+        }
+    }
+    catch (...)
+    {
+        out_.reset();
+        close(fd_);
+        throw;
+    }
+}
+
+/**
+ * Destructor.  Flush appended records, ignoring any errors, and close the
+ * journal.
+ */
+JournalWriter::~JournalWriter()
+{
+    out_.reset();
+    close(fd_);
+}
+
+/**
+ * Append a serialized object as a record of the given type.
+ *
+ * \throw vix::exception::SerialWrite if the record is too large or the write
+ *        fails.
+ */
+void
+JournalWriter::append(uint8_t type, const Serializable& record)
+{
+    size_ += writeJournalRecord(*out_, type, record);
+}
+
+/**
+ * Append a raw payload as a record of the given type.
+ *
+ * \throw vix::exception::SerialWrite if the record is too large or the write
+ *        fails.
+ */
+void
+JournalWriter::append(uint8_t type, const void* payload, size_t size)
+{
+    size_ += writeJournalRecord(*out_, type, payload, size);
+}
+
+/**
+ * Flush appended records to the operating system.
+ *
+ * \throw vix::exception::FileWrite if the flush fails.
+ */
+void
+JournalWriter::flush()
+{
+    out_->flush();
+
+    if (out_->bad())
+        throw exception::FileWrite(WRITE_FAILED);
+}
+
+/**
+ * Returns the size of the journal, including records not yet flushed.
+ */
+uint64_t
+JournalWriter::size() const
+{
+    return size_;
+}
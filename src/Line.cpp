@@ -1,38 +1,256 @@
+#include <new>
+#include <utility>
 #include <vix/Line.h>
 
 using namespace std;
 using namespace vix;
 
 Line::Line()
+    : str_(), stamp_(0), storage_(OWNED)
 {
 }
 
 Line::Line(const wstring& s)
-    : str_(s)
+    : str_(s), stamp_(0), storage_(OWNED)
+{
+}
+
+Line::Line(wstring&& s)
+    : str_(move(s)), stamp_(0), storage_(OWNED)
 {
 }
 
 Line::Line(const Line& l)
-    : str_(l.str())
+    : stamp_(l.stamp_), storage_(l.storage_)
+{
+    switch (storage_)
+    {
+    case OWNED:
+        new (&str_) wstring(l.str_);
+        break;
+
+    case SHARED:
+        new (&shared_) shared_ptr<const wstring>(l.shared_);
+        break;
+
+    case COMPRESSED:
+        new (&block_) BlockLine(l.block_);
+        break;
+    }
+}
+
+Line::Line(Line&& l) noexcept
+    : stamp_(l.stamp_), storage_(OWNED)
 {
+    take(l);
 }
 
 const Line&
 Line::operator =(const Line& l)
 {
-    str(l.str());
+    //copying first leaves this line as it was if the copy fails.
+    Line copy(l);
+
+    return *this = move(copy);
+}
+
+const Line&
+Line::operator =(Line&& l) noexcept
+{
+    if (this != &l)
+    {
+        release();
+        take(l);
+        stamp_ = l.stamp_;
+    }
 
     return *this;
 }
 
+Line::~Line()
+{
+    release();
+}
+
 const wstring&
 Line::str() const
 {
-    return str_;
+    switch (storage_)
+    {
+    case SHARED:
+        return *shared_;
+
+    case COMPRESSED:
+        return block_.block->line(block_.index);
+
+    default:
+        return str_;
+    }
 }
 
 void
 Line::str(const wstring& str)
 {
-    str_ = str;
+    //never modify shared storage in place; other lines may refer to it.
+    wstring contents(str);
+
+    release();
+    new (&str_) wstring(move(contents));
+    storage_ = OWNED;
+    stamp_ = 0;
+}
+
+bool
+Line::compressed() const
+{
+    return storage_ == COMPRESSED && !block_.block->decompressed();
+}
+
+bool
+Line::shares(const Line& other) const
+{
+    if (storage_ != other.storage_)
+        return false;
+
+    switch (storage_)
+    {
+    case SHARED:
+        return shared_ == other.shared_;
+
+    case COMPRESSED:
+        return block_.block == other.block_.block && block_.index == other.block_.index;
+
+    default:
+        return this == &other;
+    }
+}
+
+uint64_t
+Line::stamp() const
+{
+    return stamp_;
+}
+
+bool
+Line::operator ==(const Line& other) const
+{
+    return shares(other) || str() == other.str();
+}
+
+bool
+Line::operator !=(const Line& other) const
+{
+    return !(*this == other);
+}
+
+/**
+ * Take the contents of the given line, leaving it empty.  This line must have
+ * no contents.
+ */
+void
+Line::take(Line& other) noexcept
+{
+    switch (other.storage_)
+    {
+    case OWNED:
+        new (&str_) wstring(move(other.str_));
+        break;
+
+    case SHARED:
+        new (&shared_) shared_ptr<const wstring>(move(other.shared_));
+        break;
+
+    case COMPRESSED:
+        new (&block_) BlockLine(move(other.block_));
+        break;
+    }
+
+    storage_ = other.storage_;
+
+    other.release();
+    new (&other.str_) wstring();
+    other.storage_ = OWNED;
+}
+
+/**
+ * Destroy the contents of this line, leaving it with none.  The caller gives
+ * it new contents straight after.
+ */
+void
+Line::release() noexcept
+{
+    switch (storage_)
+    {
+    case OWNED:
+        str_.~wstring();
+        break;
+
+    case SHARED:
+        shared_.~shared_ptr();
+        break;
+
+    case COMPRESSED:
+        block_.~BlockLine();
+        break;
+    }
+}
+
+/**
+ * Hold the contents of this line itself, if it doesn't already, and return
+ * them for changing in place.
+ */
+wstring&
+Line::own()
+{
+    if (storage_ != OWNED)
+    {
+        wstring contents(str());
+
+        release();
+        new (&str_) wstring(move(contents));
+        storage_ = OWNED;
+    }
+
+    return str_;
+}
+
+/**
+ * Hold the contents of this line in the given shared storage.
+ */
+void
+Line::share(const shared_ptr<const wstring>& storage)
+{
+    auto copy = storage;
+
+    release();
+    new (&shared_) shared_ptr<const wstring>(move(copy));
+    storage_ = SHARED;
+}
+
+/**
+ * Hold the contents of this line at the given index of a block.
+ */
+void
+Line::compress(const shared_ptr<LineBlock>& block, uint32_t index)
+{
+    BlockLine place{block, index};
+
+    release();
+    new (&block_) BlockLine(move(place));
+    storage_ = COMPRESSED;
+}
+
+/**
+ * Move the contents of this line into shared storage, if it holds its own and
+ * they are too long to copy cheaply, so its copies share them.
+ */
+void
+Line::publish()
+{
+    //contents short enough to fit in the string itself cost less to copy
+    //than to share.
+    if (storage_ != OWNED || str_.size() <= wstring().capacity())
+        return;
+
+    share(make_shared<const wstring>(move(str_)));
 }
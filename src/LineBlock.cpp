@@ -0,0 +1,173 @@
+#include <cassert>
+#include <vix/BlockCompression.h>
+#include <vix/LineBlock.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Create a block holding the given line contents, which are moved out of the
+ * given vector.
+ */
+LineBlock::LineBlock(vector<wstring>& lines)
+    : lines_(lines.size()), decompressed_(true), accessed_(false)
+{
+    contents_.swap(lines);
+}
+
+/**
+ * Create a block from compressed contents.
+ */
+LineBlock::LineBlock(shared_ptr<const Compressed> compressed, DecompressHandler handler)
+    : lines_(compressed->ends.size()), compressed_(compressed), handler_(handler),
+      decompressed_(false), accessed_(false)
+{
+}
+
+/**
+ * Returns the number of lines in this block.
+ */
+size_t
+LineBlock::lines() const
+{
+    return lines_;
+}
+
+/**
+ * Compress the contents of this block.  This is safe to call while the block
+ * is being read.
+ */
+void
+LineBlock::compress()
+{
+    //the contents of a block made by the constructor are there from the
+    //start, and never change, so they can be read without the lock.
+    assert(decompressed_);
+
+    auto compressed = make_shared<Compressed>();
+
+    //lay the lines out end to end, remembering where each one ends.
+    wstring text;
+    uint32_t end = 0;
+
+    compressed->ends.reserve(contents_.size());
+    for (auto& line : contents_)
+    {
+        text += line;
+        end += line.size();
+
+        compressed->ends.push_back(end);
+    }
+
+    compressBlock(text.data(), text.size() * sizeof(wchar_t), compressed->data);
+    compressed->data.shrink_to_fit();
+
+    lock_guard<mutex> lock(mutex_);
+
+    compressed_ = compressed;
+}
+
+/**
+ * Returns true once compress has finished.
+ */
+bool
+LineBlock::compressed() const
+{
+    lock_guard<mutex> lock(mutex_);
+
+    return compressed_ != nullptr;
+}
+
+/**
+ * Returns the size of this block's compressed data in bytes, or zero if it has
+ * not been compressed.
+ */
+size_t
+LineBlock::compressedSize() const
+{
+    lock_guard<mutex> lock(mutex_);
+
+    return compressed_ ? compressed_->data.size() : 0;
+}
+
+/**
+ * Returns the contents of the line at the given index, decompressing the block
+ * if needed.  The reference stays valid for as long as this block exists.
+ *
+ * \throw vix::exception::Decompression if the block is corrupt.
+ */
+const wstring&
+LineBlock::line(size_t index) const
+{
+    assert(index < lines_);
+
+    accessed_.store(true, memory_order_relaxed);
+
+    if (!decompressed_.load(memory_order_acquire))
+    {
+        lock_guard<mutex> lock(mutex_);
+
+        if (!decompressed_.load(memory_order_relaxed))
+        {
+            auto& ends = compressed_->ends;
+            size_t length = ends.empty() ? 0 : ends.back();
+            wstring text(length, L'\0');
+
+            decompressBlock(
+                compressed_->data.data(), compressed_->data.size(), &text[0],
+                length * sizeof(wchar_t));
+
+            contents_.clear();
+            contents_.reserve(ends.size());
+
+            uint32_t begin = 0;
+            for (auto end : ends)
+            {
+                contents_.emplace_back(text, begin, end - begin);
+                begin = end;
+            }
+
+            decompressed_.store(true, memory_order_release);
+
+            if (handler_)
+                handler_(this);
+        }
+    }
+
+    return contents_[index];
+}
+
+/**
+ * Returns true if this block's contents are decompressed.
+ */
+bool
+LineBlock::decompressed() const
+{
+    return decompressed_.load(memory_order_acquire);
+}
+
+/**
+ * Sweep this block.  A block which has not been read since the last sweep is
+ * cold.
+ *
+ * \returns true if the block is cold.
+ */
+bool
+LineBlock::sweep()
+{
+    return !accessed_.exchange(false, memory_order_relaxed);
+}
+
+/**
+ * Returns a new block sharing this one's compressed data, whose contents are
+ * only decompressed when one of its lines is read.
+ */
+shared_ptr<LineBlock>
+LineBlock::cold(DecompressHandler handler) const
+{
+    lock_guard<mutex> lock(mutex_);
+
+    assert(compressed_);
+
+    return shared_ptr<LineBlock>(new LineBlock(compressed_, handler));
+}
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <vix/LineIndex.h>
+#include <vix/TaskScheduler.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VIX_LINE_INDEX_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace vix;
+
+const size_t LineIndex::MIN_BYTES_PER_THREAD = 1 << 20;
+
+namespace {
+    /**
+     * What a scan of part of a text finds.
+     */
+    struct Scan
+    {
+        //the offset of each separator found.
+        vector<uint64_t> ends;
+        uint64_t carriageReturns;
+        uint64_t pairs;
+    };
+
+    /**
+     * Note the line feeds and carriage returns in a block of up to 64 bytes,
+     * given as masks with a bit per byte.
+     *
+     * \param carry         True if the byte before the block was a carriage
+     *                      return; updated for the next block.
+     */
+    inline void note(
+        uint64_t lineFeeds, uint64_t carriageReturns, uint64_t offset,
+        char separator, bool& carry, Scan& scan)
+    {
+        //carriage returns are rare, so only counted when there are some.
+        if (carriageReturns || carry)
+        {
+            scan.carriageReturns += __builtin_popcountll(carriageReturns);
+            scan.pairs += __builtin_popcountll(
+                lineFeeds & ((carriageReturns << 1) | (uint64_t)carry));
+            carry = carriageReturns >> 63;
+        }
+
+        uint64_t ends = separator == '\n' ? lineFeeds : carriageReturns;
+
+        while (ends)
+        {
+            scan.ends.push_back(offset + __builtin_ctzll(ends));
+            ends &= ends - 1;
+        }
+    }
+
+    /**
+     * Scan up to 64 bytes a byte at a time.
+     */
+    inline void scanBytes(
+        const uint8_t* p, size_t size, uint64_t offset, char separator,
+        bool& carry, Scan& scan)
+    {
+        uint64_t lineFeeds = 0;
+        uint64_t carriageReturns = 0;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            lineFeeds |= (uint64_t)(p[i] == '\n') << i;
+            carriageReturns |= (uint64_t)(p[i] == '\r') << i;
+        }
+
+        note(lineFeeds, carriageReturns, offset, separator, carry, scan);
+    }
+
+    /**
+     * Scan part of a text a byte at a time.
+     */
+    void scanPortable(
+        const uint8_t* p, size_t size, uint64_t offset, char separator,
+        bool carry, Scan& scan)
+    {
+        for (size_t i = 0; i < size; i += 64)
+            scanBytes(p + i, min<size_t>(64, size - i), offset + i, separator, carry, scan);
+    }
+
+#ifdef VIX_LINE_INDEX_X86
+    /**
+     * Scan part of a text 64 bytes at a time with SSE2.
+     */
+    __attribute__((target("sse2")))
+    void scanSse2(
+        const uint8_t* p, size_t size, uint64_t offset, char separator,
+        bool carry, Scan& scan)
+    {
+        const __m128i lineFeed = _mm_set1_epi8('\n');
+        const __m128i carriageReturn = _mm_set1_epi8('\r');
+        size_t i = 0;
+
+        for (; i + 64 <= size; i += 64)
+        {
+            uint64_t lineFeeds = 0;
+            uint64_t carriageReturns = 0;
+
+            for (size_t j = 0; j < 64; j += 16)
+            {
+                __m128i bytes = _mm_loadu_si128((const __m128i*)(p + i + j));
+
+                lineFeeds |= (uint64_t)(uint32_t)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(bytes, lineFeed)) << j;
+                carriageReturns |= (uint64_t)(uint32_t)_mm_movemask_epi8(
+                    _mm_cmpeq_epi8(bytes, carriageReturn)) << j;
+            }
+
+            note(lineFeeds, carriageReturns, offset + i, separator, carry, scan);
+        }
+
+        scanBytes(p + i, size - i, offset + i, separator, carry, scan);
+    }
+
+    /**
+     * Scan part of a text 64 bytes at a time with AVX2.
+     */
+    __attribute__((target("avx2,popcnt,bmi")))
+    void scanAvx2(
+        const uint8_t* p, size_t size, uint64_t offset, char separator,
+        bool carry, Scan& scan)
+    {
+        const __m256i lineFeed = _mm256_set1_epi8('\n');
+        const __m256i carriageReturn = _mm256_set1_epi8('\r');
+        size_t i = 0;
+
+        for (; i + 64 <= size; i += 64)
+        {
+            __m256i low = _mm256_loadu_si256((const __m256i*)(p + i));
+            __m256i high = _mm256_loadu_si256((const __m256i*)(p + i + 32));
+
+            uint64_t lineFeeds =
+                (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, lineFeed))
+                | (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, lineFeed)) << 32;
+            uint64_t carriageReturns =
+                (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, carriageReturn))
+                | (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, carriageReturn)) << 32;
+
+            note(lineFeeds, carriageReturns, offset + i, separator, carry, scan);
+        }
+
+        scanBytes(p + i, size - i, offset + i, separator, carry, scan);
+    }
+#endif
+
+    typedef void (*ScanImplementation)(
+        const uint8_t*, size_t, uint64_t, char, bool, Scan&);
+
+    /**
+     * Pick the fastest implementation the CPU supports.
+     */
+    ScanImplementation selectImplementation()
+    {
+#ifdef VIX_LINE_INDEX_X86
+        if (__builtin_cpu_supports("avx2")
+         && __builtin_cpu_supports("popcnt")
+         && __builtin_cpu_supports("bmi"))
+            return &scanAvx2;
+
+        if (__builtin_cpu_supports("sse2"))
+            return &scanSse2;
+#endif
+
+        return &scanPortable;
+    }
+
+    ScanImplementation implementation()
+    {
+        static const ScanImplementation IMPLEMENTATION = selectImplementation();
+
+        return IMPLEMENTATION;
+    }
+
+    /**
+     * Scan a text for the given separator, splitting the work across several
+     * threads of the standard scheduler.
+     */
+    Scan scanText(const char* data, size_t size, char separator, unsigned threads)
+    {
+        auto scan = implementation();
+
+        size_t parts = min<size_t>(
+            max(1U, threads), max<size_t>(1, size / LineIndex::MIN_BYTES_PER_THREAD));
+        size_t bytesPerPart = (size + parts - 1) / parts;
+
+        vector<Scan> scans(parts, Scan{vector<uint64_t>(), 0, 0});
+
+        TaskScheduler::standard().parallelFor(parts, [&](size_t part) {
+            size_t start = part * bytesPerPart;
+            size_t end = min(size, start + bytesPerPart);
+
+            //a pair split between two parts is counted by the second.
+            bool carry = start > 0 && data[start - 1] == '\r';
+
+            scan((const uint8_t*)data + start, end - start, start, separator,
+                carry, scans[part]);
+        });
+
+        if (parts == 1)
+            return move(scans[0]);
+
+        Scan total{vector<uint64_t>(), 0, 0};
+        size_t ends = 0;
+
+        for (auto& part : scans)
+            ends += part.ends.size();
+
+        total.ends.reserve(ends);
+
+        for (auto& part : scans)
+        {
+            total.ends.insert(total.ends.end(), part.ends.begin(), part.ends.end());
+            total.carriageReturns += part.carriageReturns;
+            total.pairs += part.pairs;
+
+            vector<uint64_t>().swap(part.ends);
+        }
+
+        return total;
+    }
+}
+
+/**
+ * Index a text.
+ *
+ * \param data          The text.
+ * \param size          The size of the text in bytes.
+ * \param threads       The number of threads used to scan it.
+ */
+LineIndex::LineIndex(const char* data, size_t size, unsigned threads)
+    : data_(data), size_(size), separator_('\n')
+{
+    Scan scan = scanText(data, size, '\n', threads);
+    uint64_t lineFeeds = scan.ends.size();
+
+    endings_[LINE_ENDING_LF] = lineFeeds - scan.pairs;
+    endings_[LINE_ENDING_CRLF] = scan.pairs;
+    endings_[LINE_ENDING_CR] = scan.carriageReturns - scan.pairs;
+
+    //only a text with no line feeds at all is split at carriage returns.
+    if (lineFeeds == 0 && scan.carriageReturns > 0)
+    {
+        scan = scanText(data, size, '\r', threads);
+        separator_ = '\r';
+    }
+
+    ends_.swap(scan.ends);
+
+    //lone carriage returns in a text split at line feeds don't end lines.
+    if (separator_ == '\r')
+        ending_ = LINE_ENDING_CR;
+    else if (endings_[LINE_ENDING_CRLF] > endings_[LINE_ENDING_LF])
+        ending_ = LINE_ENDING_CRLF;
+    else
+        ending_ = LINE_ENDING_LF;
+}
+
+/**
+ * Returns the number of lines.
+ */
+size_t
+LineIndex::lines() const
+{
+    size_t last = ends_.empty() ? 0 : ends_.back() + 1;
+
+    return ends_.size() + (last < size_ ? 1 : 0);
+}
+
+/**
+ * Returns a line, without its ending.
+ */
+StringRef
+LineIndex::line(size_t index) const
+{
+    size_t start = index == 0 ? 0 : ends_[index - 1] + 1;
+    size_t end = index < ends_.size() ? ends_[index] : size_;
+
+    if (ending_ == LINE_ENDING_CRLF
+     && separator_ == '\n'
+     && index < ends_.size()
+     && end > start
+     && data_[end - 1] == '\r')
+        --end;
+
+    return StringRef(data_ + start, end - start);
+}
+
+/**
+ * Returns the index of the line holding the given byte of the text.
+ */
+size_t
+LineIndex::lineAt(uint64_t offset) const
+{
+    if (offset >= size_)
+        return lines();
+
+    //the first line ending at or after the byte.
+    return lower_bound(ends_.begin(), ends_.end(), offset) - ends_.begin();
+}
+
+/**
+ * Returns the most common line ending.
+ */
+LineEnding
+LineIndex::ending() const
+{
+    return ending_;
+}
+
+/**
+ * Returns true if lines end in more than one way.
+ */
+bool
+LineIndex::mixed() const
+{
+    if (separator_ == '\r')
+        return false;
+
+    return endings_[LINE_ENDING_LF] > 0 && endings_[LINE_ENDING_CRLF] > 0;
+}
+
+/**
+ * Returns the number of lines which end in the given way.
+ */
+uint64_t
+LineIndex::endings(LineEnding ending) const
+{
+    return endings_[ending];
+}
+
+/**
+ * Returns true if the last line has an ending.
+ */
+bool
+LineIndex::finalNewline() const
+{
+    return !ends_.empty() && ends_.back() + 1 == size_;
+}
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vix/LineInternTable.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //the table is never purged while it has fewer entries than this.
+    const size_t MINIMUM_PURGE_THRESHOLD = 64;
+}
+
+/**
+ * Default constructor.  Create an empty intern table.
+ */
+LineInternTable::LineInternTable()
+    : purgeThreshold_(MINIMUM_PURGE_THRESHOLD)
+{
+}
+
+/**
+ * Intern the given line.  On return, the line shares storage with every other
+ * line in this table holding the same contents.
+ */
+void
+LineInternTable::intern(Line& line)
+{
+    //empty and compressed lines have no storage to share.
+    if (line.storage_ == Line::COMPRESSED || line.str().empty())
+        return;
+
+    const wstring& contents = line.str();
+    size_t hash = std::hash<wstring>()(contents);
+    auto range = entries_.equal_range(hash);
+
+    for (auto i = range.first; i != range.second; )
+    {
+        auto storage = i->second.lock();
+
+        if (!storage)
+        {
+            //drop expired entries as we come across them.
+            i = entries_.erase(i);
+        }
+        else if (line.storage_ == Line::SHARED && storage == line.shared_)
+        {
+            //this line is already interned.
+            return;
+        }
+        else if (*storage == contents)
+        {
+            line.share(storage);
+            return;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    //the first line with these contents gives up its own string to the
+    //storage the others will share.
+    if (line.storage_ == Line::OWNED)
+        line.share(make_shared<const wstring>(move(line.str_)));
+
+    entries_.emplace(hash, line.shared_);
+
+    //expired entries only go away when their bucket is searched, so sweep the
+    //table whenever it doubles in size.
+    if (entries_.size() > purgeThreshold_)
+    {
+        purge();
+        purgeThreshold_ = max(MINIMUM_PURGE_THRESHOLD, 2 * entries_.size());
+    }
+}
+
+/**
+ * Returns the number of entries in this table, including entries whose storage
+ * has since been released but which have not yet been purged.
+ */
+size_t
+LineInternTable::size() const
+{
+    return entries_.size();
+}
+
+/**
+ * Remove all entries whose storage has been released.
+ */
+void
+LineInternTable::purge()
+{
+    for (auto i = entries_.begin(); i != entries_.end(); )
+    {
+        if (i->second.expired())
+            i = entries_.erase(i);
+        else
+            ++i;
+    }
+}
+
+/**
+ * Remove all entries from this table.  Lines which were interned continue to
+ * share their storage.
+ */
+void
+LineInternTable::clear()
+{
+    entries_.clear();
+    purgeThreshold_ = MINIMUM_PURGE_THRESHOLD;
+}
@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <vix/LineRowMap.h>
+#include <vix/TreapPriority.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Create a map of the given number of visible lines.
+ */
+LineRowMap::LineRowMap(size_t lines)
+    : seed_(TREAP_PRIORITY_SEED)
+{
+    if (lines > 0)
+        root_ = makeRun(lines, 0);
+}
+
+/**
+ * Destructor.
+ */
+LineRowMap::~LineRowMap()
+{
+}
+
+/**
+ * Insert lines before the given line.
+ */
+void
+LineRowMap::insert(size_t line, size_t count)
+{
+    if (count == 0)
+        return;
+
+    //lines appended after a visible last line join its run.
+    if (line >= lines())
+    {
+        if (!root_ || !grow(root_.get(), lines() - 1, count, true))
+            root_ = merge(move(root_), makeRun(count, 0));
+
+        return;
+    }
+
+    grow(root_.get(), line, count, false);
+}
+
+/**
+ * Erase lines starting at the given line.
+ */
+void
+LineRowMap::erase(size_t line, size_t count)
+{
+    unique_ptr<Run> left;
+    unique_ptr<Run> middle;
+    unique_ptr<Run> right;
+
+    split(move(root_), line, left, right);
+    split(move(right), count, middle, right);
+
+    root_ = merge(move(left), move(right));
+}
+
+/**
+ * Add to the cover count of each line in a range.
+ */
+void
+LineRowMap::cover(size_t first, size_t last, int delta)
+{
+    if (first > last)
+        return;
+
+    unique_ptr<Run> left;
+    unique_ptr<Run> middle;
+    unique_ptr<Run> right;
+
+    split(move(root_), first, left, right);
+    split(move(right), last - first + 1, middle, right);
+
+    add(middle.get(), delta);
+
+    root_ = merge(merge(move(left), move(middle)), move(right));
+}
+
+/**
+ * Returns the number of lines.
+ */
+size_t
+LineRowMap::lines() const
+{
+    return root_ ? root_->lines : 0;
+}
+
+/**
+ * Returns the number of rows.
+ */
+size_t
+LineRowMap::rows() const
+{
+    return visible(root_.get(), 0);
+}
+
+/**
+ * Returns true if a line is hidden.
+ */
+bool
+LineRowMap::hidden(size_t line) const
+{
+    const Run* run = root_.get();
+    int pending = 0;
+
+    while (run)
+    {
+        size_t left = run->left ? run->left->lines : 0;
+
+        if (line >= left && line < left + run->length)
+            return run->count + pending > 0;
+
+        pending += run->pending;
+
+        if (line < left)
+        {
+            run = run->left.get();
+        }
+        else
+        {
+            line -= left + run->length;
+            run = run->right.get();
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Returns the row a line is displayed on.
+ */
+size_t
+LineRowMap::row(size_t line) const
+{
+    const Run* run = root_.get();
+    int pending = 0;
+    size_t rows = 0;
+
+    while (run)
+    {
+        size_t left = run->left ? run->left->lines : 0;
+        bool shown = run->count + pending == 0;
+
+        pending += run->pending;
+
+        if (line < left)
+        {
+            run = run->left.get();
+            continue;
+        }
+
+        rows += visible(run->left.get(), pending);
+
+        if (line < left + run->length)
+        {
+            //a hidden line shares the row of the visible line above it.
+            if (shown)
+                return rows + line - left;
+
+            return rows > 0 ? rows - 1 : 0;
+        }
+
+        rows += shown ? run->length : 0;
+        line -= left + run->length;
+        run = run->right.get();
+    }
+
+    return rows;
+}
+
+/**
+ * Returns the visible line displayed on a row.
+ */
+size_t
+LineRowMap::line(size_t row) const
+{
+    const Run* run = root_.get();
+    int pending = 0;
+    size_t line = 0;
+
+    while (run)
+    {
+        size_t left = run->left ? run->left->lines : 0;
+        size_t shown = run->count + pending == 0 ? run->length : 0;
+
+        pending += run->pending;
+
+        size_t before = visible(run->left.get(), pending);
+
+        if (row < before)
+        {
+            run = run->left.get();
+            continue;
+        }
+
+        if (row < before + shown)
+            return line + left + row - before;
+
+        row -= before + shown;
+        line += left + run->length;
+        run = run->right.get();
+    }
+
+    return lines();
+}
+
+/**
+ * Create a run with a random priority.
+ */
+unique_ptr<LineRowMap::Run>
+LineRowMap::makeRun(size_t length, int count)
+{
+    unique_ptr<Run> run(new Run);
+    run->length = length;
+    run->count = count;
+    run->priority = treapPriority(seed_);
+    run->pending = 0;
+    update(run.get());
+
+    return run;
+}
+
+/**
+ * Recompute a run's subtree totals from its children.
+ */
+void
+LineRowMap::update(Run* run)
+{
+    run->lines = run->length;
+    run->lowest = run->count;
+    run->lowestLines = run->length;
+
+    for (Run* child : {run->left.get(), run->right.get()})
+    {
+        if (!child)
+            continue;
+
+        run->lines += child->lines;
+
+        if (child->lowest < run->lowest)
+        {
+            run->lowest = child->lowest;
+            run->lowestLines = child->lowestLines;
+        }
+        else if (child->lowest == run->lowest)
+        {
+            run->lowestLines += child->lowestLines;
+        }
+    }
+}
+
+/**
+ * Add to the count of every line in a subtree.
+ */
+void
+LineRowMap::add(Run* run, int delta)
+{
+    if (!run)
+        return;
+
+    run->count += delta;
+    run->lowest += delta;
+    run->pending += delta;
+}
+
+/**
+ * Pass a run's pending count down to its children.
+ */
+void
+LineRowMap::push(Run* run)
+{
+    if (run->pending == 0)
+        return;
+
+    add(run->left.get(), run->pending);
+    add(run->right.get(), run->pending);
+    run->pending = 0;
+}
+
+/**
+ * Returns the number of visible lines in a subtree, given the count still
+ * pending above it.
+ */
+size_t
+LineRowMap::visible(const Run* run, int pending)
+{
+    return run && run->lowest + pending == 0 ? run->lowestLines : 0;
+}
+
+/**
+ * Join two treaps, every line of the first coming before the second.
+ */
+unique_ptr<LineRowMap::Run>
+LineRowMap::merge(unique_ptr<Run> left, unique_ptr<Run> right)
+{
+    if (!left)
+        return right;
+
+    if (!right)
+        return left;
+
+    if (left->priority > right->priority)
+    {
+        push(left.get());
+        left->right = merge(move(left->right), move(right));
+        update(left.get());
+
+        return left;
+    }
+
+    push(right.get());
+    right->left = merge(move(left), move(right->left));
+    update(right.get());
+
+    return right;
+}
+
+/**
+ * Split a treap after the given number of lines, splitting the run the cut
+ * falls in two if need be.
+ */
+void
+LineRowMap::split(
+    unique_ptr<Run> run, size_t lines, unique_ptr<Run>& left,
+    unique_ptr<Run>& right)
+{
+    if (!run)
+    {
+        left.reset();
+        right.reset();
+
+        return;
+    }
+
+    push(run.get());
+
+    size_t before = run->left ? run->left->lines : 0;
+
+    if (lines <= before)
+    {
+        split(move(run->left), lines, left, run->left);
+        update(run.get());
+        right = move(run);
+    }
+    else if (lines >= before + run->length)
+    {
+        split(move(run->right), lines - before - run->length, run->right, right);
+        update(run.get());
+        left = move(run);
+    }
+    else
+    {
+        auto rest = makeRun(before + run->length - lines, run->count);
+        run->length = lines - before;
+        right = merge(move(rest), move(run->right));
+        update(run.get());
+        left = move(run);
+    }
+}
+
+/**
+ * Lengthen the run holding a line.
+ *
+ * \returns false, changing nothing, if onlyVisible is set and the line is
+ *          hidden.
+ */
+bool
+LineRowMap::grow(Run* run, size_t line, size_t count, bool onlyVisible)
+{
+    push(run);
+
+    size_t before = run->left ? run->left->lines : 0;
+    bool grown = true;
+
+    if (line < before)
+        grown = grow(run->left.get(), line, count, onlyVisible);
+    else if (line >= before + run->length)
+        grown = grow(run->right.get(), line - before - run->length, count, onlyVisible);
+    else if (onlyVisible && run->count != 0)
+        return false;
+    else
+        run->length += count;
+
+    update(run);
+
+    return grown;
+}
@@ -0,0 +1,86 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vix/MappedFile.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Map the file at the given path.
+ *
+ * \throw vix::exception::FileOpen if the file cannot be opened.
+ * \throw vix::exception::FileRead if the file cannot be mapped.
+ */
+MappedFile::MappedFile(const string& path)
+    : data_(nullptr), size_(0)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw exception::FileOpen("Could not open " + path + ".");
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        throw exception::FileRead("Could not stat " + path + ".");
+    }
+
+    size_ = st.st_size;
+
+    //an empty file can't be mapped, and doesn't need to be.
+    if (size_ > 0)
+    {
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data_ == MAP_FAILED)
+        {
+            close(fd);
+            throw exception::FileRead("Could not map " + path + ".");
+        }
+
+        //the mapping is usually read front to back.
+        madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+
+    //the mapping stays valid after the descriptor is closed.
+    close(fd);
+}
+
+/**
+ * Move constructor.
+ */
+MappedFile::MappedFile(MappedFile&& other)
+    : data_(other.data_), size_(other.size_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+}
+
+/**
+ * Destructor.  Unmap the file.
+ */
+MappedFile::~MappedFile()
+{
+    if (data_)
+        munmap(data_, size_);
+}
+
+/**
+ * Returns the start of the mapping, or null if the file is empty.
+ */
+const void*
+MappedFile::data() const
+{
+    return data_;
+}
+
+/**
+ * Returns the size of the file in bytes.
+ */
+size_t
+MappedFile::size() const
+{
+    return size_;
+}
@@ -0,0 +1,25 @@
+#include <vix/MemoryInputStream.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Create a stream over the given range of memory.
+ */
+MemoryInputStream::MemoryInputStream(const void* data, size_t size)
+    : std::istream(nullptr), buffer_(data, size)
+{
+    //the buffer is only constructed after the istream base.
+    rdbuf(&buffer_);
+}
+
+/**
+ * The stream buffer's get area is the whole range; it is never written, so the
+ * const cast required by the streambuf interface is safe.
+ */
+MemoryInputStream::MemoryBuffer::MemoryBuffer(const void* data, size_t size)
+{
+    char* begin = const_cast<char*>((const char*)data);
+
+    setg(begin, begin, begin + size);
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <vix/ObserverBudget.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //each call moves the rolling average an eighth of the way to it.
+    const int ROLLING_WEIGHT = 8;
+}
+
+/**
+ * Create a budget for each call to an observer.
+ */
+ObserverBudget::ObserverBudget(clock::duration budget, bool demote, SlowHandler handler)
+    : budget_(budget), demote_(demote), handler_(handler)
+{
+}
+
+/**
+ * Returns the time each call should take at most.
+ */
+ObserverBudget::clock::duration
+ObserverBudget::budget() const
+{
+    return budget_;
+}
+
+/**
+ * Returns true if slow observers are deferred.
+ */
+bool
+ObserverBudget::demotes() const
+{
+    return demote_;
+}
+
+/**
+ * Returns true if the given observer is deferred.
+ */
+bool
+ObserverBudget::deferred(const BufferChangeObserver& observer) const
+{
+    auto found = observers_.find(&observer);
+
+    return found != observers_.end() && found->second.statistics.deferred;
+}
+
+/**
+ * Record the time a call to an observer took, and tell the handler if that
+ * made the observer slow.
+ */
+void
+ObserverBudget::record(BufferChangeObserver& observer, clock::duration elapsed)
+{
+    Statistics& statistics = observers_[&observer].statistics;
+
+    ++statistics.calls;
+    statistics.total += elapsed;
+    statistics.max = std::max(statistics.max, elapsed);
+
+    if (elapsed > budget_)
+        ++statistics.overBudget;
+
+    if (statistics.calls == 1)
+        statistics.recent = elapsed;
+    else
+        statistics.recent += (elapsed - statistics.recent) / ROLLING_WEIGHT;
+
+    bool wasSlow = statistics.slow;
+    statistics.slow = statistics.recent > budget_;
+
+    //promotion waits for half the budget, so an observer near the budget
+    //doesn't flip back and forth.
+    if (demote_)
+    {
+        if (statistics.slow)
+            statistics.deferred = true;
+        else if (statistics.recent < budget_ / 2)
+            statistics.deferred = false;
+    }
+
+    if (statistics.slow && !wasSlow && handler_)
+        handler_(observer, statistics);
+}
+
+/**
+ * Returns what is known about an observer.
+ */
+ObserverBudget::Statistics
+ObserverBudget::statistics(const BufferChangeObserver& observer) const
+{
+    auto found = observers_.find(&observer);
+
+    return found != observers_.end() ? found->second.statistics : Statistics();
+}
+
+/**
+ * Note a change a deferred observer wasn't called for.
+ */
+void
+ObserverBudget::skipped(const BufferChangeObserver& observer, const BufferChange& change)
+{
+    Entry& entry = observers_[&observer];
+
+    if (entry.skipped)
+        entry.change.merge(change);
+    else
+        entry.change = change;
+
+    entry.skipped = true;
+}
+
+/**
+ * Take the changes an observer has missed since it was last called.
+ */
+bool
+ObserverBudget::takeSkipped(const BufferChangeObserver& observer, BufferChange& change)
+{
+    auto found = observers_.find(&observer);
+    if (found == observers_.end() || !found->second.skipped)
+        return false;
+
+    change = found->second.change;
+    found->second.skipped = false;
+
+    return true;
+}
+
+/**
+ * Forget what is known about an observer.
+ */
+void
+ObserverBudget::forget(const BufferChangeObserver& observer)
+{
+    observers_.erase(&observer);
+}
+
+/**
+ * Forget what is known about every observer but the given ones.
+ */
+void
+ObserverBudget::retain(const vector<const BufferChangeObserver*>& live)
+{
+    for (auto i = observers_.begin(); i != observers_.end();)
+    {
+        if (find(live.begin(), live.end(), i->first) == live.end())
+            i = observers_.erase(i);
+        else
+            ++i;
+    }
+}
+
+/**
+ * Returns the number of observers something is known about.
+ */
+size_t
+ObserverBudget::size() const
+{
+    return observers_.size();
+}
@@ -0,0 +1,169 @@
+#include <cstring>
+#include <vix/SerialMemoryReader.h>
+#include <vix/SerialVarint.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string READ_FAILED{"Serial read failed."};
+}
+
+/**
+ * Create a reader over the given range of memory.
+ */
+SerialMemoryReader::SerialMemoryReader(const void* data, size_t size)
+    : data_((const uint8_t*)data), size_(size), position_(0)
+{
+}
+
+/**
+ * Returns the current read offset.
+ */
+size_t
+SerialMemoryReader::position() const
+{
+    return position_;
+}
+
+/**
+ * Move the read offset.
+ *
+ * \throw vix::exception::SerialRead if the offset is out of range.
+ */
+void
+SerialMemoryReader::position(size_t offset)
+{
+    if (offset > size_)
+        throwTruncated();
+
+    position_ = offset;
+}
+
+/**
+ * Returns the number of bytes left to read.
+ */
+size_t
+SerialMemoryReader::remaining() const
+{
+    return size_ - position_;
+}
+
+/**
+ * Returns the size of the range.
+ */
+size_t
+SerialMemoryReader::size() const
+{
+    return size_;
+}
+
+/**
+ * Read a fixed size buffer, as written by serialWriteFixedBuffer.
+ *
+ * \throw vix::exception::SerialRead if the read is out of range.
+ */
+void
+SerialMemoryReader::readFixedBuffer(void* buffer, size_t size)
+{
+    const uint8_t* p = advance(size);
+
+    if (size > 0)
+        memcpy(buffer, p, size);
+}
+
+/**
+ * Return a reference to the next size bytes, and skip past them.
+ *
+ * \throw vix::exception::SerialRead if the read is out of range.
+ */
+StringRef
+SerialMemoryReader::readFixedRef(size_t size)
+{
+    return StringRef((const char*)advance(size), size);
+}
+
+/**
+ * Read a reference to a string, as written by serialWrite.
+ *
+ * \throw vix::exception::SerialRead if the read is out of range.
+ */
+void
+SerialMemoryReader::read(StringRef& value)
+{
+    size_t start = position_;
+    uint32_t size = 0;
+
+    //strings use a full 32-bit size field.
+    read(size);
+
+    //leave the reader where it was if the string is truncated.
+    if (size > remaining())
+    {
+        position_ = start;
+        throwTruncated();
+    }
+
+    value = readFixedRef(size);
+}
+
+/**
+ * Read an unsigned varint, as written by serialWriteVarint.
+ *
+ * \throw vix::exception::SerialRead if the read is out of range or the
+ *        encoding is malformed.
+ */
+void
+SerialMemoryReader::readVarint(uint64_t& value)
+{
+    position_ += decodeVarint(data_ + position_, remaining(), value);
+}
+
+/**
+ * Read a signed varint, as written by serialWriteZigzag.
+ *
+ * \throw vix::exception::SerialRead if the read is out of range or the
+ *        encoding is malformed.
+ */
+void
+SerialMemoryReader::readZigzag(int64_t& value)
+{
+    uint64_t encoded = 0;
+
+    readVarint(encoded);
+
+    value = zigzagDecode(encoded);
+}
+
+/**
+ * Read a reference to a string, as written by serialWriteCompact.
+ *
+ * \throw vix::exception::SerialRead if the read is out of range or the
+ *        encoding is malformed.
+ */
+void
+SerialMemoryReader::readCompact(StringRef& value)
+{
+    size_t start = position_;
+    uint64_t size = 0;
+
+    readVarint(size);
+
+    //leave the reader where it was if the string is truncated.
+    if (size > remaining())
+    {
+        position_ = start;
+        throwTruncated();
+    }
+
+    value = readFixedRef(size);
+}
+
+/**
+ * Throw a SerialRead exception for a read past the end of the range.
+ */
+void
+SerialMemoryReader::throwTruncated()
+{
+    throw exception::SerialRead(READ_FAILED);
+}
@@ -1,6 +1,6 @@
 #include <cassert>
 #include <iostream>
-#include <vix/SerialUtilities.h>
+#include <vix/SerialEndian.h>
 
 using namespace std;
 using namespace vix;
@@ -57,23 +57,11 @@ serialWriteBigEndianUnsigned(std::ostream& out, std::uint32_t value, std::size_t
     //we support between 1 and 4 size bytes.
     assert(sizeBytes >= 1 && sizeBytes <= 4);
 
-    switch (sizeBytes)
-    {
-        case 4:
-            serialWrite(out, (uint8_t)((value >> 24) & 0xFF));
-            // fall-through
-
-        case 3:
-            serialWrite(out, (uint8_t)((value >> 16) & 0xFF));
-            // fall-through
-
-        case 2:
-            serialWrite(out, (uint8_t)((value >> 8) & 0xFF));
-            // fall-through
+    uint8_t buffer[sizeof(value)];
+    encodeBigEndian(buffer, value);
 
-        case 1:
-            serialWrite(out, (uint8_t)((value) & 0xFF));
-    }
+    //write the low sizeBytes bytes in a single write.
+    serialWriteFixedBuffer(out, buffer + sizeof(buffer) - sizeBytes, sizeBytes);
 }
 
 /**
@@ -112,7 +100,7 @@ vix::serialWriteBuffer(std::ostream& out, const void* buffer, std::size_t size,
 void
 vix::serialWrite(std::ostream& out, std::uint8_t value)
 {
-    serialWriteFixedBuffer(out, &value, sizeof(value));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -127,7 +115,7 @@ vix::serialWrite(std::ostream& out, std::uint8_t value)
 void
 vix::serialRead(std::istream& in, std::uint8_t& value)
 {
-    serialReadFixedBuffer(in, &value, sizeof(value));
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -143,12 +131,7 @@ vix::serialRead(std::istream& in, std::uint8_t& value)
 void
 vix::serialWrite(std::ostream& out, std::uint16_t value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    buffer[0] = (value >> 8) & 0xFF;
-    buffer[1] = value & 0xFF;
-
-    serialWriteFixedBuffer(out, buffer, sizeof(buffer));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -164,12 +147,7 @@ vix::serialWrite(std::ostream& out, std::uint16_t value)
 void
 vix::serialRead(std::istream& in, std::uint16_t& value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    serialReadFixedBuffer(in, buffer, sizeof(buffer));
-
-    value  = ((uint16_t)buffer[0]) << 8;
-    value |= ((uint16_t)buffer[1]);
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -185,14 +163,7 @@ vix::serialRead(std::istream& in, std::uint16_t& value)
 void
 vix::serialWrite(std::ostream& out, std::uint32_t value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    buffer[0] = (value >> 24) & 0xFF;
-    buffer[1] = (value >> 16) & 0xFF;
-    buffer[2] = (value >>  8) & 0xFF;
-    buffer[3] = (value      ) & 0xFF;
-
-    serialWriteFixedBuffer(out, buffer, sizeof(buffer));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -208,14 +179,7 @@ vix::serialWrite(std::ostream& out, std::uint32_t value)
 void
 vix::serialRead(std::istream& in, std::uint32_t& value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    serialReadFixedBuffer(in, buffer, sizeof(buffer));
-
-    value  = ((uint32_t)buffer[0]) << 24;
-    value |= ((uint32_t)buffer[1]) << 16;
-    value |= ((uint32_t)buffer[2]) <<  8;
-    value |= ((uint32_t)buffer[3]);
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -231,18 +195,7 @@ vix::serialRead(std::istream& in, std::uint32_t& value)
 void
 vix::serialWrite(std::ostream& out, std::uint64_t value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    buffer[0] = (value >> 56) & 0xFF;
-    buffer[1] = (value >> 48) & 0xFF;
-    buffer[2] = (value >> 40) & 0xFF;
-    buffer[3] = (value >> 32) & 0xFF;
-    buffer[4] = (value >> 24) & 0xFF;
-    buffer[5] = (value >> 16) & 0xFF;
-    buffer[6] = (value >>  8) & 0xFF;
-    buffer[7] = (value      ) & 0xFF;
-
-    serialWriteFixedBuffer(out, buffer, sizeof(buffer));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -258,18 +211,7 @@ vix::serialWrite(std::ostream& out, std::uint64_t value)
 void
 vix::serialRead(std::istream& in, std::uint64_t& value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    serialReadFixedBuffer(in, buffer, sizeof(buffer));
-
-    value  = ((uint64_t)buffer[0]) << 56;
-    value |= ((uint64_t)buffer[1]) << 48;
-    value |= ((uint64_t)buffer[2]) << 40;
-    value |= ((uint64_t)buffer[3]) << 32;
-    value |= ((uint64_t)buffer[4]) << 24;
-    value |= ((uint64_t)buffer[5]) << 16;
-    value |= ((uint64_t)buffer[6]) <<  8;
-    value |= ((uint64_t)buffer[7]);
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -284,7 +226,7 @@ vix::serialRead(std::istream& in, std::uint64_t& value)
 void
 vix::serialWrite(std::ostream& out, std::int8_t value)
 {
-    serialWriteFixedBuffer(out, &value, sizeof(value));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -299,7 +241,7 @@ vix::serialWrite(std::ostream& out, std::int8_t value)
 void
 vix::serialRead(std::istream& in, std::int8_t& value)
 {
-    serialReadFixedBuffer(in, &value, sizeof(value));
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -315,12 +257,7 @@ vix::serialRead(std::istream& in, std::int8_t& value)
 void
 vix::serialWrite(std::ostream& out, std::int16_t value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    buffer[0] = (value >> 8) & 0xFF;
-    buffer[1] = value & 0xFF;
-
-    serialWriteFixedBuffer(out, buffer, sizeof(buffer));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -336,12 +273,7 @@ vix::serialWrite(std::ostream& out, std::int16_t value)
 void
 vix::serialRead(std::istream& in, std::int16_t& value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    serialReadFixedBuffer(in, buffer, sizeof(buffer));
-
-    value  = ((int16_t)buffer[0]) << 8;
-    value |= ((int16_t)buffer[1]);
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -357,14 +289,7 @@ vix::serialRead(std::istream& in, std::int16_t& value)
 void
 vix::serialWrite(std::ostream& out, std::int32_t value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    buffer[0] = (value >> 24) & 0xFF;
-    buffer[1] = (value >> 16) & 0xFF;
-    buffer[2] = (value >>  8) & 0xFF;
-    buffer[3] = (value      ) & 0xFF;
-
-    serialWriteFixedBuffer(out, buffer, sizeof(buffer));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -380,14 +305,7 @@ vix::serialWrite(std::ostream& out, std::int32_t value)
 void
 vix::serialRead(std::istream& in, std::int32_t& value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    serialReadFixedBuffer(in, buffer, sizeof(buffer));
-
-    value  = ((int32_t)buffer[0]) << 24;
-    value |= ((int32_t)buffer[1]) << 16;
-    value |= ((int32_t)buffer[2]) <<  8;
-    value |= ((int32_t)buffer[3]);
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -403,18 +321,7 @@ vix::serialRead(std::istream& in, std::int32_t& value)
 void
 vix::serialWrite(std::ostream& out, std::int64_t value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    buffer[0] = (value >> 56) & 0xFF;
-    buffer[1] = (value >> 48) & 0xFF;
-    buffer[2] = (value >> 40) & 0xFF;
-    buffer[3] = (value >> 32) & 0xFF;
-    buffer[4] = (value >> 24) & 0xFF;
-    buffer[5] = (value >> 16) & 0xFF;
-    buffer[6] = (value >>  8) & 0xFF;
-    buffer[7] = (value      ) & 0xFF;
-
-    serialWriteFixedBuffer(out, buffer, sizeof(buffer));
+    serialWriteBigEndian(out, value);
 }
 
 /**
@@ -430,18 +337,7 @@ vix::serialWrite(std::ostream& out, std::int64_t value)
 void
 vix::serialRead(std::istream& in, std::int64_t& value)
 {
-    uint8_t buffer[sizeof(value)];
-
-    serialReadFixedBuffer(in, buffer, sizeof(buffer));
-
-    value  = ((int64_t)buffer[0]) << 56;
-    value |= ((int64_t)buffer[1]) << 48;
-    value |= ((int64_t)buffer[2]) << 40;
-    value |= ((int64_t)buffer[3]) << 32;
-    value |= ((int64_t)buffer[4]) << 24;
-    value |= ((int64_t)buffer[5]) << 16;
-    value |= ((int64_t)buffer[6]) <<  8;
-    value |= ((int64_t)buffer[7]);
+    serialReadBigEndian(in, value);
 }
 
 /**
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vix/SerialUtilities.h>
+#include <vix/SerialVarint.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string READ_TRUNCATED{"Varint is truncated."};
+    const string READ_OVERLONG{"Varint is too long."};
+    const string READ_STRING_SIZE{"String is larger than can be held."};
+    const string READ_PUTBACK{"Could not return unread bytes to the stream."};
+
+    //compact strings are read in chunks of this size, so a corrupt length
+    //can't ask for more memory than the stream actually holds.
+    const size_t COMPACT_READ_CHUNK = 64 * 1024;
+
+    //the continuation bit of each byte in a word.
+    const uint64_t CONTINUATION_BITS = 0x8080808080808080ULL;
+
+    //the payload bits of each byte in a word.
+    const uint64_t PAYLOAD_BITS = 0x7F7F7F7F7F7F7F7FULL;
+
+    /**
+     * Load a little endian word.
+     */
+    inline uint64_t load64(const uint8_t* p)
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+
+        return word;
+    }
+
+    /**
+     * Store a little endian word.
+     */
+    inline void store64(uint8_t* p, uint64_t word)
+    {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+
+        memcpy(p, &word, sizeof(word));
+    }
+
+    /**
+     * Spread the low 56 bits of a value into the low seven bits of each byte
+     * of a word.
+     */
+    inline uint64_t spread7(uint64_t value)
+    {
+#ifdef __BMI2__
+        return _pdep_u64(value, PAYLOAD_BITS);
+#else
+        uint64_t word = 0;
+
+        //constant trip count; the compiler unrolls this into shifts and masks.
+        for (unsigned i = 0; i < 8; ++i)
+            word |= ((value >> (7 * i)) & 0x7F) << (8 * i);
+
+        return word;
+#endif
+    }
+
+    /**
+     * Gather the low seven bits of each byte of a word into a value.
+     */
+    inline uint64_t compact7(uint64_t word)
+    {
+#ifdef __BMI2__
+        return _pext_u64(word, PAYLOAD_BITS);
+#else
+        uint64_t value = 0;
+
+        for (unsigned i = 0; i < 8; ++i)
+            value |= ((word >> (8 * i)) & 0x7F) << (7 * i);
+
+        return value;
+#endif
+    }
+}
+
+/**
+ * varintSize returns the number of bytes needed to encode the given value.
+ *
+ * \param value         The value to be encoded.
+ */
+size_t
+vix::varintSize(uint64_t value)
+{
+    unsigned bits = 64 - __builtin_clzll(value | 1);
+
+    return (bits + 6) / 7;
+}
+
+/**
+ * encodeVarint encodes a value into memory.  The encoder writes whole words at
+ * a time, so the output must have room for VARINT_ENCODE_SPACE bytes, even
+ * though only the returned number of bytes are meaningful.
+ *
+ * \param out           The memory to which the value is encoded.
+ * \param value         The value to encode.
+ *
+ * \returns the number of bytes in the encoding.
+ */
+size_t
+vix::encodeVarint(void* out, uint64_t value)
+{
+    uint8_t* p = (uint8_t*)out;
+    size_t size = varintSize(value);
+
+    if (size <= 8)
+    {
+        //every byte but the last has its continuation bit set.
+        uint64_t continuation =
+            CONTINUATION_BITS & ((1ULL << (8 * (size - 1))) - 1);
+
+        store64(p, spread7(value) | continuation);
+    }
+    else
+    {
+        uint64_t high = value >> 56;
+
+        store64(p, spread7(value) | CONTINUATION_BITS);
+        p[8] = (high & 0x7F) | (size == 10 ? 0x80 : 0);
+        p[9] = (uint8_t)(high >> 7);
+    }
+
+    return size;
+}
+
+/**
+ * decodeVarint decodes a value from memory.
+ *
+ * \param in            The memory from which the value is decoded.
+ * \param size          The number of bytes available to decode.
+ * \param value         The decoded value.
+ *
+ * \returns the number of bytes consumed.
+ *
+ * \throw vix::exception::SerialRead if the encoding is truncated or is longer
+ *        than VARINT_MAX_SIZE bytes.
+ */
+size_t
+vix::decodeVarint(const void* in, size_t size, uint64_t& value)
+{
+    const uint8_t* p = (const uint8_t*)in;
+
+    //fast path: find the terminating byte within the next word, and gather
+    //its payload without looking at each byte in turn.
+    if (size >= 8)
+    {
+        uint64_t word = load64(p);
+        uint64_t stops = ~word & CONTINUATION_BITS;
+
+        if (stops)
+        {
+            //keep every bit up to and including the first stop bit.
+            value = compact7(word & (stops ^ (stops - 1)));
+
+            return (__builtin_ctzll(stops) >> 3) + 1;
+        }
+    }
+
+    //slow path: near the end of the input, or longer than a word.
+    value = 0;
+    for (size_t i = 0; i < VARINT_MAX_SIZE; ++i)
+    {
+        if (i >= size)
+            throw exception::SerialRead(READ_TRUNCATED);
+
+        uint8_t b = p[i];
+
+        //the tenth byte can only hold the top bit of the value.
+        if (i == VARINT_MAX_SIZE - 1 && b > 1)
+            throw exception::SerialRead(READ_OVERLONG);
+
+        value |= ((uint64_t)(b & 0x7F)) << (7 * i);
+
+        if (!(b & 0x80))
+            return i + 1;
+    }
+
+    throw exception::SerialRead(READ_OVERLONG);
+}
+
+/**
+ * serialWriteVarint writes an unsigned value to the output stream as a varint.
+ *
+ * \param out           The output stream to which this value is written.
+ * \param value         The value to write.
+ *
+ * \throw vix::exception::SerialWrite if the serial write fails.
+ */
+void
+vix::serialWriteVarint(std::ostream& out, uint64_t value)
+{
+    uint8_t buffer[VARINT_ENCODE_SPACE];
+
+    serialWriteFixedBuffer(out, buffer, encodeVarint(buffer, value));
+}
+
+/**
+ * serialReadVarint reads an unsigned varint from the input stream.
+ *
+ * \param in            The input stream from which this value is read.
+ * \param value         The value to be read.
+ *
+ * \throw vix::exception::SerialRead if the serial read fails, or if the
+ *        encoding is malformed.
+ */
+void
+vix::serialReadVarint(std::istream& in, uint64_t& value)
+{
+    uint8_t buffer[VARINT_MAX_SIZE];
+
+    size_t size = 0;
+
+    //fast path: take as much of the value as the stream has buffered in a
+    //single read, past a single sentry, and give back whatever follows it.
+    {
+        istream::sentry sentry(in, true);
+        streambuf* source = in.rdbuf();
+
+        if (sentry && source->in_avail() > 0)
+        {
+            size = source->sgetn((char*)buffer, min<streamsize>(
+                VARINT_MAX_SIZE, source->in_avail()));
+        }
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            if (!(buffer[i] & 0x80))
+            {
+                decodeVarint(buffer, i + 1, value);
+
+                for (size_t unread = size - i - 1; unread > 0; --unread)
+                {
+                    if (source->sungetc() == char_traits<char>::eof())
+                    {
+                        in.setstate(ios::badbit);
+                        throw exception::SerialRead(READ_PUTBACK);
+                    }
+                }
+
+                return;
+            }
+        }
+    }
+
+    //slow path: a stream can't be read past the end of the value, so read
+    //the rest a byte at a time until the terminating byte is found.
+    for (size_t i = size; i < VARINT_MAX_SIZE; ++i)
+    {
+        serialRead(in, buffer[i]);
+
+        if (!(buffer[i] & 0x80))
+        {
+            decodeVarint(buffer, i + 1, value);
+            return;
+        }
+    }
+
+    throw exception::SerialRead(READ_OVERLONG);
+}
+
+/**
+ * serialWriteZigzag writes a signed value to the output stream as a zigzag
+ * encoded varint.
+ *
+ * \param out           The output stream to which this value is written.
+ * \param value         The value to write.
+ *
+ * \throw vix::exception::SerialWrite if the serial write fails.
+ */
+void
+vix::serialWriteZigzag(std::ostream& out, int64_t value)
+{
+    serialWriteVarint(out, zigzagEncode(value));
+}
+
+/**
+ * serialReadZigzag reads a signed, zigzag encoded varint from the input
+ * stream.
+ *
+ * \param in            The input stream from which this value is read.
+ * \param value         The value to be read.
+ *
+ * \throw vix::exception::SerialRead if the serial read fails, or if the
+ *        encoding is malformed.
+ */
+void
+vix::serialReadZigzag(std::istream& in, int64_t& value)
+{
+    uint64_t encoded = 0;
+
+    serialReadVarint(in, encoded);
+
+    value = zigzagDecode(encoded);
+}
+
+/**
+ * serialWriteCompact writes a string to the output stream, preceded by its
+ * length as a varint.
+ *
+ * \param out           The output stream to which this value is written.
+ * \param value         The string value to write.
+ *
+ * \throw vix::exception::SerialWrite if the serial write fails.
+ */
+void
+vix::serialWriteCompact(std::ostream& out, const std::string& value)
+{
+    serialWriteVarint(out, value.size());
+    serialWriteFixedBuffer(out, value.data(), value.size());
+}
+
+/**
+ * serialReadCompact reads a string written by serialWriteCompact from the
+ * input stream.
+ *
+ * \param in            The input stream from which this value is read.
+ * \param value         The string value to read.
+ *
+ * \throw vix::exception::SerialRead if the serial read fails.
+ */
+void
+vix::serialReadCompact(std::istream& in, std::string& value)
+{
+    uint64_t size = 0;
+
+    serialReadVarint(in, size);
+
+    if (size > value.max_size())
+        throw exception::SerialRead(READ_STRING_SIZE);
+
+    value.clear();
+
+    //grow the string only as its bytes arrive.
+    while (value.size() < size)
+    {
+        size_t offset = value.size();
+        size_t chunk = min<uint64_t>(size - offset, COMPACT_READ_CHUNK);
+
+        value.resize(offset + chunk);
+        serialReadFixedBuffer(in, &value[offset], chunk);
+    }
+}
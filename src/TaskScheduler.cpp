@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <exception>
+#include <vix/TaskScheduler.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * The scheduler and index of the pool thread running on this thread, if
+     * any, so tasks submitted from a task stay on their thread's deque.
+     */
+    thread_local const TaskScheduler* currentScheduler = nullptr;
+    thread_local size_t currentIndex = 0;
+
+    /**
+     * The state of a parallelFor, shared with the tasks helping it, which may
+     * only start once it has returned.
+     */
+    struct ParallelLoop
+    {
+        const function<void(size_t)>* body;
+        size_t count;
+        atomic<size_t> next;
+
+        std::mutex mutex;
+        condition_variable done;
+        size_t finished;
+        vector<exception_ptr> errors;
+
+        /**
+         * Take indices and call the body with them, until none are left.
+         */
+        void work()
+        {
+            for (;;)
+            {
+                size_t index = next++;
+                if (index >= count)
+                    return;
+
+                exception_ptr error;
+                try
+                {
+                    (*body)(index);
+                }
+                catch (...)
+                {
+                    error = current_exception();
+                }
+
+                lock_guard<std::mutex> lock(mutex);
+
+                errors[index] = error;
+                if (++finished == count)
+                    done.notify_all();
+            }
+        }
+    };
+}
+
+/**
+ * Start a scheduler with the given number of threads, or one per core if zero.
+ */
+TaskScheduler::TaskScheduler(size_t threads)
+    : next_(0), queued_(0), outstanding_(0), executed_(0), stolen_(0),
+      cancelled_(0), failed_(0), totalLatency_(0), maxLatency_(0),
+      sleepers_(0), stop_(false)
+{
+    if (threads == 0)
+        threads = max(1U, thread::hardware_concurrency());
+
+    for (size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(new Worker);
+
+    for (size_t i = 0; i < threads; ++i)
+        threads_.emplace_back(&TaskScheduler::run, this, i);
+}
+
+/**
+ * Destructor.  Run every task already submitted, then stop the threads.
+ */
+TaskScheduler::~TaskScheduler()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    work_.notify_all();
+
+    for (auto& t : threads_)
+        t.join();
+}
+
+/**
+ * Submit a task.
+ */
+void
+TaskScheduler::submit(Task task, Priority priority, CancellationToken token)
+{
+    size_t index = currentScheduler == this
+        ? currentIndex
+        : next_++ % workers_.size();
+
+    //count the task first, so it can't be finished before it's counted.
+    ++outstanding_;
+
+    {
+        Worker& worker = *workers_[index];
+        lock_guard<mutex> lock(worker.mutex);
+
+        worker.tasks[priority].push_back(
+            QueuedTask{move(task), token, clock::now()});
+        ++queued_;
+    }
+
+    //a thread about to park counts itself as a sleeper before it checks for
+    //tasks, and this checks for sleepers after counting the task, so one of
+    //the two always sees the other.  Taking the mutex makes sure a sleeper
+    //which missed the task is waiting before it is woken.
+    if (sleepers_ > 0)
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+        }
+
+        work_.notify_one();
+    }
+}
+
+/**
+ * Wait until every task submitted so far, and every task they submit, has run
+ * or been dropped.
+ */
+void
+TaskScheduler::wait()
+{
+    unique_lock<mutex> lock(mutex_);
+
+    idle_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+/**
+ * Call the given function with each index from zero up to count, spread across
+ * the pool, and wait for every call to return.
+ */
+void
+TaskScheduler::parallelFor(size_t count, const function<void(size_t)>& body, Priority priority)
+{
+    if (count == 0)
+        return;
+
+    auto loop = make_shared<ParallelLoop>();
+    loop->body = &body;
+    loop->count = count;
+    loop->next = 0;
+    loop->finished = 0;
+    loop->errors.resize(count);
+
+    //a helper which starts late finds nothing left, and never touches body.
+    size_t helpers = min(count - 1, workers_.size());
+    for (size_t i = 0; i < helpers; ++i)
+        submit([loop] { loop->work(); }, priority);
+
+    loop->work();
+
+    unique_lock<mutex> lock(loop->mutex);
+
+    loop->done.wait(lock, [&] { return loop->finished == count; });
+
+    for (auto& error : loop->errors)
+    {
+        if (error)
+            rethrow_exception(error);
+    }
+}
+
+/**
+ * Returns the number of threads in the pool.
+ */
+size_t
+TaskScheduler::threads() const
+{
+    return workers_.size();
+}
+
+/**
+ * Returns the scheduler's counters.
+ */
+TaskScheduler::Statistics
+TaskScheduler::statistics() const
+{
+    return Statistics{
+        queued_.load(memory_order_relaxed),
+        executed_.load(memory_order_relaxed),
+        stolen_.load(memory_order_relaxed),
+        cancelled_.load(memory_order_relaxed),
+        failed_.load(memory_order_relaxed),
+        clock::duration(totalLatency_.load(memory_order_relaxed)),
+        clock::duration(maxLatency_.load(memory_order_relaxed))};
+}
+
+/**
+ * Returns the scheduler shared by the editor's services.
+ */
+TaskScheduler&
+TaskScheduler::standard()
+{
+    static TaskScheduler STANDARD;
+
+    return STANDARD;
+}
+
+/**
+ * The body of the pool thread with the given index.
+ */
+void
+TaskScheduler::run(size_t index)
+{
+    currentScheduler = this;
+    currentIndex = index;
+
+    for (;;)
+    {
+        QueuedTask task;
+
+        if (!take(index, task))
+        {
+            unique_lock<mutex> lock(mutex_);
+
+            //a task counted as queued is on a deque, so there is no point
+            //parking until there are none.
+            ++sleepers_;
+            work_.wait(lock, [this] { return queued_ > 0 || stop_; });
+            --sleepers_;
+
+            if (stop_ && queued_ == 0)
+                return;
+
+            continue;
+        }
+
+        auto started = clock::now();
+        bool cancelled = task.token.cancelled();
+        bool failed = false;
+
+        clock::rep latency = (started - task.submitted).count();
+        clock::rep longest = maxLatency_.load(memory_order_relaxed);
+
+        totalLatency_.fetch_add(latency, memory_order_relaxed);
+        while (latency > longest
+            && !maxLatency_.compare_exchange_weak(longest, latency, memory_order_relaxed))
+        {
+        }
+
+        if (!cancelled)
+        {
+            try
+            {
+                task.task();
+            }
+            catch (...)
+            {
+                failed = true;
+            }
+        }
+
+        //release whatever the task holds before anyone waiting is woken.
+        task = QueuedTask();
+
+        if (cancelled)
+            cancelled_.fetch_add(1, memory_order_relaxed);
+        else
+            executed_.fetch_add(1, memory_order_relaxed);
+
+        if (failed)
+            failed_.fetch_add(1, memory_order_relaxed);
+
+        //as with sleepers, taking the mutex makes sure a waiter which missed
+        //the count reaching zero is waiting before it is woken.
+        if (--outstanding_ == 0)
+        {
+            {
+                lock_guard<mutex> lock(mutex_);
+            }
+
+            idle_.notify_all();
+        }
+    }
+}
+
+/**
+ * Take the next task for the pool thread with the given index.
+ *
+ * \returns false if there are no tasks.
+ */
+bool
+TaskScheduler::take(size_t index, QueuedTask& task)
+{
+    for (auto priority : {INTERACTIVE, BACKGROUND})
+    {
+        //the newest of our own tasks.
+        {
+            Worker& worker = *workers_[index];
+            lock_guard<mutex> lock(worker.mutex);
+            auto& tasks = worker.tasks[priority];
+
+            if (!tasks.empty())
+            {
+                task = move(tasks.back());
+                tasks.pop_back();
+                --queued_;
+
+                return true;
+            }
+        }
+
+        //or the oldest of someone else's.
+        for (size_t i = 1; i < workers_.size(); ++i)
+        {
+            Worker& victim = *workers_[(index + i) % workers_.size()];
+            lock_guard<mutex> lock(victim.mutex);
+            auto& tasks = victim.tasks[priority];
+
+            if (!tasks.empty())
+            {
+                task = move(tasks.front());
+                tasks.pop_front();
+
+                //counted before the task stops counting as queued.
+                stolen_.fetch_add(1, memory_order_relaxed);
+                --queued_;
+
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
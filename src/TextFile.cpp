@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <ostream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <vix/IoOutputStream.h>
+#include <vix/MappedFile.h>
+#include <vix/SerialUtilities.h>
+#include <vix/TaskScheduler.h>
+#include <vix/TextFile.h>
+#include <vix/Utf8.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //text is written in pieces of about this size.
+    const size_t WRITE_CHUNK_SIZE = 1 << 20;
+
+    /**
+     * Returns the characters of a line ending.
+     */
+    const char* endingCharacters(LineEnding ending)
+    {
+        switch (ending)
+        {
+        case LINE_ENDING_CRLF:
+            return "\r\n";
+
+        case LINE_ENDING_CR:
+            return "\r";
+
+        default:
+            return "\n";
+        }
+    }
+
+    /**
+     * A TemporaryFile is written beside the file it replaces, and is removed
+     * unless it is committed, which renames it over that file.
+     */
+    class TemporaryFile
+    {
+    public:
+        /**
+         * Create the temporary file for the given path, with the permissions
+         * of the file already there, if any.
+         *
+         * \throw vix::exception::FileOpen if the file can't be created.
+         */
+        explicit TemporaryFile(const string& path)
+            : path_(path), temporary_(path + ".tmp"), fd_(-1)
+        {
+            struct stat existing;
+            bool exists = stat(path.c_str(), &existing) == 0;
+
+            fd_ = open(
+                temporary_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644);
+            if (fd_ < 0)
+                throw exception::FileOpen("Could not create " + path + ".");
+
+            if (exists)
+                fchmod(fd_, existing.st_mode & 07777);
+        }
+
+        /**
+         * Destructor.  Close and remove the file if it wasn't committed.
+         */
+        ~TemporaryFile()
+        {
+            if (fd_ < 0)
+                return;
+
+            close(fd_);
+            unlink(temporary_.c_str());
+        }
+
+        /**
+         * Returns the descriptor of the open file.
+         */
+        int fd() const
+        {
+            return fd_;
+        }
+
+        /**
+         * Flush the file to disk, close it, and rename it over the file it
+         * replaces.
+         *
+         * \returns false, having removed the file, if any step fails.
+         */
+        bool commit()
+        {
+            bool synced = fsync(fd_) == 0;
+            bool closed = close(fd_) == 0;
+            fd_ = -1;
+
+            if (synced && closed && rename(temporary_.c_str(), path_.c_str()) == 0)
+                return true;
+
+            unlink(temporary_.c_str());
+            return false;
+        }
+
+    private:
+        string path_;
+        string temporary_;
+        int fd_;
+
+        TemporaryFile(const TemporaryFile&) = delete;
+        TemporaryFile& operator=(const TemporaryFile&) = delete;
+    };
+
+    /**
+     * Decode the lines of an indexed text into a line list, splitting the
+     * work across several threads of the standard scheduler.  Each thread
+     * decodes the lines in an equal share of the text into a list of its
+     * own, and the lists are spliced together in order.
+     *
+     * \returns true if the text was well formed UTF-8.
+     */
+    bool decodeLines(
+        const LineIndex& index, size_t size, unsigned threads,
+        Buffer::LineList& out)
+    {
+        size_t parts = min<size_t>(
+            max(1U, threads), max<size_t>(1, size / LineIndex::MIN_BYTES_PER_THREAD));
+
+        //parts start at the line holding each share's first byte.
+        vector<size_t> partStart(parts + 1, index.lines());
+        for (size_t part = 0; part < parts; ++part)
+            partStart[part] = index.lineAt((uint64_t)size * part / parts);
+
+        vector<Buffer::LineList> decoded(parts);
+        vector<char> valid(parts, true);
+
+        TaskScheduler::standard().parallelFor(parts, [&](size_t part) {
+            for (size_t i = partStart[part]; i < partStart[part + 1]; ++i)
+            {
+                StringRef line = index.line(i);
+                wstring str;
+
+                if (!utf8Decode(line.data(), line.size(), str))
+                    valid[part] = false;
+
+                decoded[part].emplace_back(move(str));
+            }
+        });
+
+        bool utf8 = true;
+
+        for (size_t part = 0; part < parts; ++part)
+        {
+            utf8 &= valid[part] != 0;
+            out.splice(out.end(), decoded[part]);
+        }
+
+        return utf8;
+    }
+}
+
+/**
+ * The format of a new file: lines ending in line feeds, including the last.
+ */
+TextFormat::TextFormat()
+    : ending(LINE_ENDING_LF), mixed(false), finalNewline(true), utf8(true)
+{
+}
+
+/**
+ * readText replaces the contents of a buffer with a text held in memory.
+ *
+ * \param data          The text.
+ * \param size          The size of the text in bytes.
+ * \param buffer        The buffer to fill.
+ * \param format        Set to the format of the text.
+ * \param threads       The number of threads used to read the text.
+ */
+void
+vix::readText(
+    const void* data, size_t size, Buffer& buffer, TextFormat& format,
+    unsigned threads)
+{
+    LineIndex index((const char*)data, size, threads);
+    Buffer::LineList lines;
+    bool utf8 = decodeLines(index, size, threads, lines);
+
+    format.ending = index.ending();
+    format.mixed = index.mixed();
+    format.finalNewline = index.finalNewline();
+    format.utf8 = utf8;
+
+    buffer.assign(lines);
+}
+
+/**
+ * readTextFile replaces the contents of a buffer with a text file.
+ *
+ * \param path          The path of the file.
+ * \param buffer        The buffer to fill.
+ * \param format        Set to the format of the file.
+ * \param threads       The number of threads used to read the file.
+ *
+ * \throw vix::exception::File if the file can't be read.
+ */
+void
+vix::readTextFile(
+    const string& path, Buffer& buffer, TextFormat& format, unsigned threads)
+{
+    MappedFile file(path);
+
+    readText(file.data(), file.size(), buffer, format, threads);
+}
+
+/**
+ * writeText writes the lines of a buffer to a stream as text.
+ *
+ * \param out           The stream to which the text is written.
+ * \param buffer        The buffer to write.
+ * \param format        The format to write it in.
+ *
+ * \throw vix::exception::SerialWrite if the write fails.
+ */
+void
+vix::writeText(ostream& out, const Buffer& buffer, const TextFormat& format)
+{
+    string ending(endingCharacters(format.ending));
+    string text;
+    size_t remaining = buffer.lines();
+
+    text.reserve(WRITE_CHUNK_SIZE + WRITE_CHUNK_SIZE / 4);
+
+    for (auto& line : buffer)
+    {
+        utf8Encode(line.str(), text);
+
+        if (--remaining > 0 || format.finalNewline)
+            text += ending;
+
+        if (text.size() >= WRITE_CHUNK_SIZE)
+        {
+            serialWriteFixedBuffer(out, text.data(), text.size());
+            text.clear();
+        }
+    }
+
+    serialWriteFixedBuffer(out, text.data(), text.size());
+}
+
+/**
+ * writeTextFile creates or replaces a text file with the lines of a buffer.
+ * The text goes to a temporary file beside the file, which is flushed to disk
+ * and then renamed over it, so a save which fails leaves the file as it was.
+ *
+ * \param path          The path of the file.
+ * \param buffer        The buffer to write.
+ * \param format        The format to write it in.
+ *
+ * \throw vix::exception::FileOpen if the file can't be created.
+ * \throw vix::exception::FileWrite if the file can't be written.
+ */
+void
+vix::writeTextFile(const string& path, const Buffer& buffer, const TextFormat& format)
+{
+    //the text is written beside the file and renamed over it once it is safely
+    //on disk, so a failed save leaves the file as it was.
+    TemporaryFile file(path);
+
+    bool written;
+
+    {
+        IoOutputStream out(file.fd(), 0);
+
+        try
+        {
+            writeText(out, buffer, format);
+            written = static_cast<bool>(out.flush());
+        }
+        catch (exception::SerialWrite&)
+        {
+            written = false;
+        }
+    }
+
+    if (!written || !file.commit())
+        throw exception::FileWrite("Could not write " + path + ".");
+}
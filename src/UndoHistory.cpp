@@ -0,0 +1,341 @@
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <vix/Crc32c.h>
+#include <vix/JournalScanner.h>
+#include <vix/JournalWriter.h>
+#include <vix/SerialMemoryReader.h>
+#include <vix/SerialUtilities.h>
+#include <vix/SerialVarint.h>
+#include <vix/UndoHistory.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    const string MALFORMED_HISTORY{"Undo history is malformed."};
+
+    /**
+     * The size and checksum of a file's contents.
+     */
+    struct FileHash
+    {
+        uint64_t size;
+        uint32_t crc;
+    };
+
+    /**
+     * Hash the contents of a file.
+     */
+    FileHash hashFile(const string& path)
+    {
+        MappedFile file(path);
+
+        return FileHash{file.size(), crc32c(file.data(), file.size())};
+    }
+
+    /**
+     * The fixed part of a saved node, and where its command lies in the
+     * journal.
+     */
+    struct SavedNode
+    {
+        uint8_t tag;
+        uint64_t parent;
+        uint64_t time;
+        size_t offset;
+        size_t size;
+    };
+
+    /**
+     * A LazyCommand stands in for a command saved in a mapped history
+     * journal, and only deserializes it the first time it is needed.
+     */
+    class LazyCommand : public Command
+    {
+    public:
+        LazyCommand(
+            shared_ptr<MappedFile> journal, const CommandRegistry& registry,
+            uint8_t tag, size_t offset, size_t size)
+            : journal_(journal), registry_(registry), tag_(tag),
+              offset_(offset), size_(size)
+        {
+        }
+
+        virtual void apply(weak_ptr<Buffer> buffer)
+        {
+            decoded().apply(buffer);
+        }
+
+        virtual void revert(weak_ptr<Buffer> buffer)
+        {
+            decoded().revert(buffer);
+        }
+
+        virtual bool canMerge(const Command& next) const
+        {
+            return decoded().canMerge(next);
+        }
+
+        virtual bool merge(const Command& next)
+        {
+            return decoded().merge(next);
+        }
+
+        virtual void serialRead(istream& in)
+        {
+            decoded().serialRead(in);
+        }
+
+        /**
+         * Write the command exactly as it was saved, without decoding it.
+         */
+        virtual void serialWrite(ostream& out) const
+        {
+            serialWriteFixedBuffer(out, payload(), size_);
+        }
+
+        uint8_t tag() const
+        {
+            return tag_;
+        }
+
+    private:
+        shared_ptr<MappedFile> journal_;
+        const CommandRegistry& registry_;
+        uint8_t tag_;
+        size_t offset_;
+        size_t size_;
+        mutable shared_ptr<Command> command_;
+
+        const char* payload() const
+        {
+            return (const char*)journal_->data() + offset_;
+        }
+
+        Command& decoded() const
+        {
+            if (!command_)
+            {
+                shared_ptr<Command> command = registry_.create(tag_);
+                readJournalRecord(
+                    JournalRecord{offset_, JOURNAL_UNDO_NODE, StringRef(payload(), size_)},
+                    *command);
+
+                command_ = command;
+            }
+
+            return *command_;
+        }
+    };
+
+    /**
+     * Returns the tag of a command, which for a saved command is the tag it
+     * was saved with.
+     */
+    uint8_t commandTag(const CommandRegistry& registry, const Command& command)
+    {
+        auto lazy = dynamic_cast<const LazyCommand*>(&command);
+
+        return lazy ? lazy->tag() : registry.tag(command);
+    }
+
+    void renameFile(const string& from, const string& to)
+    {
+        if (rename(from.c_str(), to.c_str()) < 0)
+            throw exception::FileWrite("Could not rename " + from + ".");
+    }
+}
+
+/**
+ * Use the history journal at the given path.  Nothing is read or written until
+ * load or save.
+ *
+ * \param path          The path of the history journal.
+ * \param registry      The registry of the commands in the history, which must
+ *                      outlive every tree loaded.
+ */
+UndoHistory::UndoHistory(const string& path, const CommandRegistry& registry)
+    : path_(path), registry_(registry), saved_(0), end_(0), attached_(false)
+{
+}
+
+/**
+ * Returns the path of the history journal for a file: a hidden file in the
+ * same directory.
+ */
+string
+UndoHistory::historyPath(const string& filePath)
+{
+    size_t slash = filePath.rfind('/');
+    size_t start = slash == string::npos ? 0 : slash + 1;
+
+    return filePath.substr(0, start) + "." + filePath.substr(start) + ".vixundo";
+}
+
+/**
+ * Load the saved history into a new tree, whose buffer holds the file's
+ * contents, and make the saved current node the tree's current state.
+ *
+ * \param tree          A tree with no nodes beyond its root.
+ * \param filePath      The file the history belongs to.
+ *
+ * \returns false, leaving the tree alone, if there is no history, or if the
+ *          file has changed since the history was saved.
+ *
+ * \throw vix::exception::File if a file can't be read.
+ * \throw vix::exception::SerialRead if the history is malformed.
+ */
+bool
+UndoHistory::load(UndoTree& tree, const string& filePath)
+{
+    struct stat st;
+    if (tree.size() != 1 || stat(path_.c_str(), &st) < 0)
+        return false;
+
+    vector<SavedNode> nodes;
+    bool stated = false;
+    uint64_t count = 0;
+    uint64_t current = 0;
+    FileHash saved{0, 0};
+
+    //the journal is only read here, even if its tail is torn; a save cuts
+    //that off before appending.  Only the fixed part of each node is read;
+    //commands are left in place in the mapping.
+    auto journal = make_shared<MappedFile>(path_);
+    JournalScanner scanner(journal->data(), journal->size());
+    JournalRecord record;
+
+    while (scanner.next(record))
+    {
+        SerialMemoryReader reader(record.payload.data(), record.payload.size());
+
+        if (record.type == JOURNAL_UNDO_NODE)
+        {
+            SavedNode node;
+            reader.read(node.tag);
+            reader.readVarint(node.parent);
+            reader.readVarint(node.time);
+
+            //node ids start at one, after the root.
+            if (node.parent > nodes.size())
+                throw exception::SerialRead(MALFORMED_HISTORY);
+
+            node.offset =
+                record.offset + JOURNAL_FRAME_HEADER_SIZE + reader.position();
+            node.size = reader.remaining();
+
+            nodes.push_back(node);
+        }
+        else if (record.type == JOURNAL_UNDO_STATE)
+        {
+            reader.readVarint(count);
+            reader.readVarint(current);
+            reader.read(saved.size);
+            reader.read(saved.crc);
+
+            if (count > nodes.size() || current > count)
+                throw exception::SerialRead(MALFORMED_HISTORY);
+
+            stated = true;
+        }
+    }
+
+    if (!stated)
+        return false;
+
+    FileHash hash = hashFile(filePath);
+    if (hash.size != saved.size || hash.crc != saved.crc)
+        return false;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const SavedNode& node = nodes[i];
+
+        if (node.offset + node.size > journal->size())
+            throw exception::SerialRead(MALFORMED_HISTORY);
+
+        tree.graft(
+            node.parent,
+            make_shared<LazyCommand>(
+                journal, registry_, node.tag, node.offset, node.size),
+            UndoTree::clock::time_point(chrono::milliseconds(node.time)));
+    }
+
+    tree.rebase(current);
+
+    //nodes left behind by an interrupted save aren't part of the tree, so the
+    //next save starts the journal afresh rather than appending after them.
+    saved_ = tree.size();
+    end_ = scanner.position();
+    attached_ = count == nodes.size();
+
+    return true;
+}
+
+/**
+ * Save the tree's history, as it stands just after the file has been written.
+ * Only nodes created since the last load or save are written.  Any command
+ * being coalesced must be closed first, since nodes are never written twice.
+ *
+ * \param tree          The tree loaded from, or first saved to, this history.
+ * \param filePath      The file the history belongs to.
+ *
+ * \throw vix::exception::File if a file can't be read or written.
+ * \throw vix::exception::SerialWrite if a command can't be written.
+ */
+void
+UndoHistory::save(const UndoTree& tree, const string& filePath)
+{
+    //a journal which doesn't match the tree is replaced whole, leaving the
+    //old one intact until the new one is complete.
+    string path = attached_ ? path_ : path_ + ".tmp";
+    size_t first = attached_ ? saved_ : 1;
+
+    //a torn record left after the last valid one would hide those appended
+    //behind it.
+    if (!attached_)
+        unlink(path.c_str());
+    else if (truncate(path.c_str(), end_) < 0)
+        throw exception::FileWrite("Could not truncate " + path + ".");
+
+    JournalWriter writer(path);
+
+    for (UndoTree::NodeId id = first; id < tree.size(); ++id)
+    {
+        auto command = tree.command(id);
+        uint64_t time = chrono::duration_cast<chrono::milliseconds>(
+            tree.timestamp(id).time_since_epoch()).count();
+
+        ostringstream out;
+        serialWrite(out, commandTag(registry_, *command));
+        serialWriteVarint(out, tree.parent(id));
+        serialWriteVarint(out, time);
+        command->serialWrite(out);
+
+        string payload = out.str();
+        writer.append(JOURNAL_UNDO_NODE, payload.data(), payload.size());
+    }
+
+    FileHash hash = hashFile(filePath);
+
+    ostringstream out;
+    serialWriteVarint(out, tree.size() - 1);
+    serialWriteVarint(out, tree.current());
+    serialWrite(out, hash.size);
+    serialWrite(out, hash.crc);
+
+    string state = out.str();
+    writer.append(JOURNAL_UNDO_STATE, state.data(), state.size());
+    writer.flush();
+
+    if (!attached_)
+        renameFile(path, path_);
+
+    saved_ = tree.size();
+    end_ = writer.size();
+    attached_ = true;
+}
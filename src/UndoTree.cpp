@@ -0,0 +1,598 @@
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vix/UndoTree.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //the most lines copied into a single run of a checkpoint.
+    const size_t RUN_LINES = 256;
+
+    /**
+     * Hashes the key of a line.
+     */
+    struct LineKeyHash
+    {
+        template <typename Key>
+        size_t operator()(const Key& key) const
+        {
+            return hash<const void*>()(key.first) ^ (key.second * 0x9E3779B9U);
+        }
+    };
+}
+
+const size_t UndoTree::DEFAULT_CHECKPOINT_INTERVAL = 256;
+const size_t UndoTree::DEFAULT_MAX_CHECKPOINT_BYTES = 64 << 20;
+
+/**
+ * A run takes its size out of the tree's total as it goes.
+ */
+UndoTree::Run::~Run()
+{
+    if (total)
+        *total -= bytes;
+}
+
+/**
+ * Create an undo tree for a buffer, with its current contents as the root
+ * state.
+ */
+UndoTree::UndoTree(weak_ptr<Buffer> buffer, size_t checkpointInterval, size_t maxCheckpointBytes)
+    : buffer_(buffer), current_(0), base_(0),
+      checkpointInterval_(max<size_t>(1, checkpointInterval)),
+      maxCheckpointBytes_(maxCheckpointBytes),
+      checkpointBytes_(make_shared<size_t>(0)), pinnedBytes_(0)
+{
+    Node root;
+    root.parent = 0;
+    root.jump = 0;
+    root.redo = 0;
+    root.depth = 0;
+    root.time = clock::now();
+
+    //the root is checkpointed until a rebase, and the rebased state after, so
+    //any state can be rebuilt from one or the other.
+    auto b = buffer_.lock();
+    if (b)
+        root.checkpoint = checkpoint(*b, nullptr);
+
+    pinnedBytes_ = *checkpointBytes_;
+
+    nodes_.push_back(move(root));
+}
+
+/**
+ * Apply a command to the buffer and record it as a new child of the current
+ * state, which it then becomes.
+ */
+void
+UndoTree::apply(shared_ptr<Command> command, clock::time_point when)
+{
+    seal();
+
+    command->apply(buffer_);
+
+    current_ = addNode(current_, command, when);
+}
+
+/**
+ * Add a node for a command as a child of the given node, without touching the
+ * buffer or the current state.  This rebuilds a tree from saved history; the
+ * node's id is the tree's size beforehand.
+ */
+UndoTree::NodeId
+UndoTree::graft(NodeId parent, shared_ptr<Command> command, clock::time_point when)
+{
+    return addNode(parent, command, when);
+}
+
+/**
+ * Declare that the buffer now holds the given node's state, without applying
+ * or reverting anything.  Checkpoints taken so far are dropped, since they may
+ * not match the history grafted since, and the buffer's contents are kept as
+ * the given node's checkpoint.
+ */
+void
+UndoTree::rebase(NodeId current)
+{
+    for (auto& node : nodes_)
+        node.checkpoint.reset();
+
+    checkpoints_.clear();
+    current_ = current;
+    base_ = current;
+
+    //like the root's, this checkpoint is never dropped for a newer one.
+    auto buffer = buffer_.lock();
+    if (buffer)
+        nodes_[current_].checkpoint = checkpoint(*buffer, nullptr);
+
+    pinnedBytes_ = *checkpointBytes_;
+
+    //redo from the root should lead back here.
+    for (NodeId node = current_; node != 0; node = nodes_[node].parent)
+        nodes_[nodes_[node].parent].redo = node;
+}
+
+/**
+ * Revert the current state's command, moving to its parent.
+ *
+ * \returns false if the current state is the root.
+ */
+bool
+UndoTree::undo()
+{
+    if (current_ == 0)
+        return false;
+
+    seal();
+    revertTo(nodes_[current_].parent);
+
+    return true;
+}
+
+/**
+ * Apply the command of the child most recently left by undo, or most recently
+ * created.
+ *
+ * \returns false if the current state has no children.
+ */
+bool
+UndoTree::redo()
+{
+    NodeId child = nodes_[current_].redo;
+    if (child == 0)
+        return false;
+
+    seal();
+    applyTo(child);
+
+    return true;
+}
+
+/**
+ * Move the buffer to the given state by the cheapest route.
+ */
+void
+UndoTree::jump(NodeId target)
+{
+    if (target == current_)
+        return;
+
+    seal();
+
+    NodeId start = current_;
+    size_t cost = distance(current_, target);
+
+    //a restore is only worth it if it saves at least a checkpoint interval's
+    //worth of commands, since it costs a copy of the whole list of lines.
+    auto consider = [&](NodeId candidate) {
+        if (!nodes_[candidate].checkpoint)
+            return;
+
+        size_t candidateCost = distance(candidate, target) + checkpointInterval_;
+        if (candidateCost < cost)
+        {
+            start = candidate;
+            cost = candidateCost;
+        }
+    };
+
+    consider(0);
+    consider(base_);
+    for (NodeId checkpoint : checkpoints_)
+        consider(checkpoint);
+
+    if (start != current_)
+        restore(start);
+
+    revertTo(ancestor(current_, target));
+    applyTo(target);
+}
+
+/**
+ * Move the buffer to the latest state created at or before the given time, or
+ * to the root if there is none.
+ */
+void
+UndoTree::jump(clock::time_point when)
+{
+    jump(at(when));
+}
+
+/**
+ * Move the buffer to the state it had the given time before the current state
+ * was created, as vi's :earlier does.
+ */
+void
+UndoTree::earlier(clock::duration duration)
+{
+    jump(nodes_[current_].time - duration);
+}
+
+/**
+ * Move the buffer to the state created the given time after the current
+ * state, as vi's :later does.
+ */
+void
+UndoTree::later(clock::duration duration)
+{
+    jump(nodes_[current_].time + duration);
+}
+
+/**
+ * Returns the buffer this tree applies commands to.
+ */
+weak_ptr<Buffer>
+UndoTree::buffer() const
+{
+    return buffer_;
+}
+
+/**
+ * Returns the current state.
+ */
+UndoTree::NodeId
+UndoTree::current() const
+{
+    return current_;
+}
+
+/**
+ * Returns the number of nodes, including the root.
+ */
+size_t
+UndoTree::size() const
+{
+    return nodes_.size();
+}
+
+/**
+ * Returns the latest node created at or before the given time, or the root if
+ * there is none.
+ */
+UndoTree::NodeId
+UndoTree::at(clock::time_point when) const
+{
+    auto after = upper_bound(
+        nodes_.begin(), nodes_.end(), when,
+        [](const clock::time_point& t, const Node& node) { return t < node.time; });
+
+    if (after == nodes_.begin())
+        return 0;
+
+    return (after - nodes_.begin()) - 1;
+}
+
+/**
+ * Returns the parent of a node.  The root is its own parent.
+ */
+UndoTree::NodeId
+UndoTree::parent(NodeId node) const
+{
+    return nodes_[node].parent;
+}
+
+/**
+ * Returns the depth of a node, which is the number of commands applied between
+ * the root and the node.
+ */
+size_t
+UndoTree::depth(NodeId node) const
+{
+    return nodes_[node].depth;
+}
+
+/**
+ * Returns the nearest common ancestor of two nodes.
+ */
+UndoTree::NodeId
+UndoTree::ancestor(NodeId a, NodeId b) const
+{
+    if (nodes_[a].depth > nodes_[b].depth)
+        a = ancestorAtDepth(a, nodes_[b].depth);
+    else
+        b = ancestorAtDepth(b, nodes_[a].depth);
+
+    //nodes at the same depth have jumps of the same length, so the two can
+    //climb in step.
+    while (a != b)
+    {
+        if (nodes_[a].jump != nodes_[b].jump)
+        {
+            a = nodes_[a].jump;
+            b = nodes_[b].jump;
+        }
+        else
+        {
+            a = nodes_[a].parent;
+            b = nodes_[b].parent;
+        }
+    }
+
+    return a;
+}
+
+/**
+ * Returns the time a node was created.
+ */
+UndoTree::clock::time_point
+UndoTree::timestamp(NodeId node) const
+{
+    return nodes_[node].time;
+}
+
+/**
+ * Returns the command which leads to a node from its parent, or null for the
+ * root.
+ */
+shared_ptr<Command>
+UndoTree::command(NodeId node) const
+{
+    return nodes_[node].command;
+}
+
+/**
+ * Returns the number of bytes checkpoints hold, not counting the storage of
+ * their lines.
+ */
+size_t
+UndoTree::checkpointBytes() const
+{
+    return *checkpointBytes_;
+}
+
+/**
+ * Add a node for a command as a child of the given node.
+ */
+UndoTree::NodeId
+UndoTree::addNode(NodeId parent, shared_ptr<Command> command, clock::time_point when)
+{
+    NodeId id = nodes_.size();
+
+    Node node;
+    node.command = command;
+    node.parent = parent;
+    node.redo = 0;
+    node.depth = nodes_[parent].depth + 1;
+
+    //history grafted from a previous session predates the root.
+    if (nodes_.size() == 1)
+        nodes_[0].time = min(nodes_[0].time, when);
+
+    //timestamps never go backwards, so nodes stay sorted by time.
+    node.time = max(when, nodes_.back().time);
+
+    //a node jumps to its parent's jump's jump when the two jumps above its
+    //parent are the same length, and to its parent otherwise.  This gives
+    //every node a path of O(log n) jumps to any of its ancestors.
+    NodeId jump = nodes_[parent].jump;
+    if (nodes_[parent].depth - nodes_[jump].depth
+     == nodes_[jump].depth - nodes_[nodes_[jump].jump].depth)
+        node.jump = nodes_[jump].jump;
+    else
+        node.jump = parent;
+
+    nodes_.push_back(move(node));
+
+    nodes_[parent].redo = id;
+
+    return id;
+}
+
+/**
+ * Returns the number of commands between two nodes.
+ */
+size_t
+UndoTree::distance(NodeId a, NodeId b) const
+{
+    return nodes_[a].depth + nodes_[b].depth - 2 * nodes_[ancestor(a, b)].depth;
+}
+
+/**
+ * Returns the ancestor of a node at the given depth.
+ */
+UndoTree::NodeId
+UndoTree::ancestorAtDepth(NodeId node, size_t depth) const
+{
+    while (nodes_[node].depth > depth)
+    {
+        NodeId jump = nodes_[node].jump;
+
+        if (nodes_[jump].depth >= depth)
+            node = jump;
+        else
+            node = nodes_[node].parent;
+    }
+
+    return node;
+}
+
+/**
+ * Checkpoint the current state if it is due one.  This happens as the state is
+ * left rather than when it is created, so a command can still be amended while
+ * its state is current.
+ */
+void
+UndoTree::seal()
+{
+    Node& node = nodes_[current_];
+
+    if (node.checkpoint || node.depth % checkpointInterval_ != 0 || maxCheckpointBytes_ == 0)
+        return;
+
+    auto buffer = buffer_.lock();
+    if (!buffer)
+        return;
+
+    //the latest checkpoint is the likeliest to share runs with this one.
+    NodeId previous = checkpoints_.empty() ? base_ : checkpoints_.back();
+
+    node.checkpoint = checkpoint(*buffer, nodes_[previous].checkpoint.get());
+    checkpoints_.push_back(current_);
+
+    //the oldest checkpoints are the least likely to be wanted.
+    size_t dropped = 0;
+    while (*checkpointBytes_ - pinnedBytes_ > maxCheckpointBytes_
+        && checkpoints_.size() - dropped > 1)
+        nodes_[checkpoints_[dropped++]].checkpoint.reset();
+
+    checkpoints_.erase(checkpoints_.begin(), checkpoints_.begin() + dropped);
+}
+
+/**
+ * Returns a checkpoint of the buffer's contents, sharing the runs of the given
+ * checkpoint, if any, whose lines are unchanged.
+ */
+unique_ptr<UndoTree::Checkpoint>
+UndoTree::checkpoint(const Buffer& buffer, const Checkpoint* previous) const
+{
+    //the runs of the previous checkpoint, by their first line.
+    unordered_map<LineKey, const shared_ptr<const Run>*, LineKeyHash> starts;
+    if (previous)
+    {
+        for (auto& run : *previous)
+            starts.emplace(run->keys.front(), &run);
+    }
+
+    unique_ptr<Checkpoint> checkpoint(new Checkpoint);
+    shared_ptr<Run> copied;
+
+    auto finish = [&] {
+        copied->lines.shrink_to_fit();
+        copied->keys.shrink_to_fit();
+        copied->bytes += sizeof(Run)
+            + copied->lines.capacity() * (sizeof(Line) + sizeof(LineKey));
+        copied->total = checkpointBytes_;
+        *checkpointBytes_ += copied->bytes;
+
+        checkpoint->push_back(move(copied));
+    };
+
+    auto line = buffer.begin();
+    while (line != buffer.end())
+    {
+        //share a run of the previous checkpoint if it starts here and every
+        //one of its lines is unchanged.  A line given a new value behind the
+        //buffer's back has lost its stamp, and always counts as changed.
+        auto start = line->stamp() ? starts.find(key(*line)) : starts.end();
+        if (start != starts.end())
+        {
+            const auto& run = *start->second;
+            auto end = line;
+            size_t same = 0;
+
+            while (same < run->lines.size()
+                && end != buffer.end()
+                && end->stamp()
+                && key(*end) == run->keys[same])
+            {
+                ++end;
+                ++same;
+            }
+
+            if (same == run->lines.size())
+            {
+                if (copied)
+                    finish();
+
+                checkpoint->push_back(run);
+                line = end;
+                continue;
+            }
+        }
+
+        //otherwise, the line is copied into a new run.
+        if (!copied)
+        {
+            copied = make_shared<Run>();
+            copied->lines.reserve(RUN_LINES);
+            copied->keys.reserve(RUN_LINES);
+            copied->bytes = 0;
+        }
+
+        copied->lines.push_back(*line);
+        copied->keys.push_back(key(*line));
+        ++line;
+
+        //a copy of a line which holds its own contents holds its own copy.
+        if (copied->lines.back().storage_ == Line::OWNED)
+            copied->bytes += copied->lines.back().str_.capacity() * sizeof(wchar_t);
+
+        if (copied->lines.size() == RUN_LINES)
+            finish();
+    }
+
+    if (copied)
+        finish();
+
+    return checkpoint;
+}
+
+/**
+ * Returns what tells a line of the buffer apart from a different one.
+ */
+UndoTree::LineKey
+UndoTree::key(const Line& line)
+{
+    //a line put where an earlier one was kept is stamped with a later version.
+    return LineKey(&line, line.stamp());
+}
+
+/**
+ * Revert commands from the current state up to an ancestor.
+ */
+void
+UndoTree::revertTo(NodeId ancestor)
+{
+    while (current_ != ancestor)
+    {
+        Node& node = nodes_[current_];
+
+        node.command->revert(buffer_);
+
+        nodes_[node.parent].redo = current_;
+        current_ = node.parent;
+    }
+}
+
+/**
+ * Apply commands from the current state down to a descendant.
+ */
+void
+UndoTree::applyTo(NodeId descendant)
+{
+    vector<NodeId> path;
+    for (NodeId node = descendant; node != current_; node = nodes_[node].parent)
+        path.push_back(node);
+
+    for (auto node = path.rbegin(); node != path.rend(); ++node)
+    {
+        nodes_[*node].command->apply(buffer_);
+
+        nodes_[current_].redo = *node;
+        current_ = *node;
+    }
+}
+
+/**
+ * Replace the buffer's contents with a node's checkpoint.
+ */
+void
+UndoTree::restore(NodeId node)
+{
+    auto buffer = buffer_.lock();
+
+    if (buffer)
+    {
+        Buffer::LineList lines;
+        for (auto& run : *nodes_[node].checkpoint)
+            lines.insert(lines.end(), run->lines.begin(), run->lines.end());
+
+        buffer->assign(lines);
+    }
+
+    current_ = node;
+}
@@ -0,0 +1,676 @@
+#include <cstdint>
+#include <cstring>
+#include <vix/Utf8.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VIX_UTF8_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace vix;
+
+static_assert(sizeof(wchar_t) == 4, "Line expects UTF-32 wide characters.");
+
+namespace {
+    /**
+     * Returns true if the given value is a Unicode scalar value.
+     */
+    inline bool isScalarValue(uint32_t c)
+    {
+        return c < 0xD800 || (c > 0xDFFF && c <= 0x10FFFF);
+    }
+
+    /**
+     * Returns true if the given byte is a continuation byte.
+     */
+    inline bool isContinuation(uint8_t b)
+    {
+        return (b & 0xC0) == 0x80;
+    }
+
+    /**
+     * Decode the sequence starting with the given byte, which isn't ASCII.
+     * A malformed sequence is decoded as the replacement character, and
+     * takes as many bytes as were consumed before it went wrong.
+     *
+     * \returns the number of bytes consumed.
+     */
+    inline size_t decodeSequence(
+        const uint8_t* p, const uint8_t* end, uint32_t& c, bool& valid)
+    {
+        uint8_t b = *p;
+
+        //work out the sequence length and the smallest value it may encode.
+        size_t length;
+        uint32_t minimum;
+
+        if ((b & 0xE0) == 0xC0)
+        {
+            length = 2;
+            c = b & 0x1F;
+            minimum = 0x80;
+        }
+        else if ((b & 0xF0) == 0xE0)
+        {
+            length = 3;
+            c = b & 0x0F;
+            minimum = 0x800;
+        }
+        else if ((b & 0xF8) == 0xF0)
+        {
+            length = 4;
+            c = b & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            //a stray continuation byte or an invalid lead byte.
+            c = UTF8_REPLACEMENT_CHARACTER;
+            valid = false;
+
+            return 1;
+        }
+
+        size_t i = 1;
+        for (; i < length && p + i < end && isContinuation(p[i]); ++i)
+            c = (c << 6) | (p[i] & 0x3F);
+
+        if (i < length || c < minimum || !isScalarValue(c))
+        {
+            //truncated, overlong, or not a scalar value.  Skip the bytes
+            //consumed so far as one malformed sequence.
+            c = UTF8_REPLACEMENT_CHARACTER;
+            valid = false;
+
+            return i;
+        }
+
+        return length;
+    }
+
+    /**
+     * Encode a character which isn't ASCII.
+     *
+     * \returns the position after the encoding.
+     */
+    inline char* encodeCharacter(uint32_t c, char* p)
+    {
+        if (!isScalarValue(c))
+            c = UTF8_REPLACEMENT_CHARACTER;
+
+        if (c < 0x800)
+        {
+            *p++ = (char)(0xC0 | (c >> 6));
+            *p++ = (char)(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            *p++ = (char)(0xE0 | (c >> 12));
+            *p++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            *p++ = (char)(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            *p++ = (char)(0xF0 | (c >> 18));
+            *p++ = (char)(0x80 | ((c >> 12) & 0x3F));
+            *p++ = (char)(0x80 | ((c >> 6) & 0x3F));
+            *p++ = (char)(0x80 | (c & 0x3F));
+        }
+
+        return p;
+    }
+
+    /**
+     * Widen whole words of ASCII from the start of a buffer, eight bytes at a
+     * time.
+     *
+     * \returns the number of bytes widened.
+     */
+    size_t widenPortable(const uint8_t* in, size_t size, wchar_t* out)
+    {
+        size_t i = 0;
+
+        for (; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, in + i, sizeof(word));
+
+            if (word & 0x8080808080808080ULL)
+                break;
+
+            for (size_t j = 0; j < 8; ++j)
+                out[i + j] = in[i + j];
+        }
+
+        return i;
+    }
+
+    /**
+     * Narrow ASCII characters from the start of a wide string, four at a
+     * time.
+     *
+     * \returns the number of characters narrowed.
+     */
+    size_t narrowPortable(const wchar_t* in, size_t size, char* out)
+    {
+        size_t i = 0;
+
+        for (; i + 4 <= size; i += 4)
+        {
+            uint32_t any = (uint32_t)in[i] | (uint32_t)in[i + 1]
+                | (uint32_t)in[i + 2] | (uint32_t)in[i + 3];
+
+            if (any >= 0x80)
+                break;
+
+            for (size_t j = 0; j < 4; ++j)
+                out[i + j] = (char)in[i + j];
+        }
+
+        return i;
+    }
+
+    /**
+     * Validate a buffer a character at a time, skipping words of ASCII.
+     */
+    bool validatePortable(const uint8_t* p, size_t size)
+    {
+        const uint8_t* end = p + size;
+        bool valid = true;
+
+        while (p < end && valid)
+        {
+            uint64_t word;
+            if (end - p >= 8)
+            {
+                memcpy(&word, p, sizeof(word));
+
+                if (!(word & 0x8080808080808080ULL))
+                {
+                    p += 8;
+                    continue;
+                }
+            }
+
+            if (*p < 0x80)
+            {
+                ++p;
+                continue;
+            }
+
+            uint32_t c;
+            p += decodeSequence(p, end, c, valid);
+        }
+
+        return valid;
+    }
+
+#ifdef VIX_UTF8_X86
+    /**
+     * Widen ASCII sixteen bytes at a time with SSE2.
+     */
+    __attribute__((target("sse2")))
+    size_t widenSse2(const uint8_t* in, size_t size, wchar_t* out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        size_t i = 0;
+
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(in + i));
+
+            if (_mm_movemask_epi8(bytes))
+                break;
+
+            __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            __m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+            _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(high, zero));
+        }
+
+        return i;
+    }
+
+    /**
+     * Narrow ASCII sixteen characters at a time with SSE2.
+     */
+    __attribute__((target("sse2")))
+    size_t narrowSse2(const wchar_t* in, size_t size, char* out)
+    {
+        const __m128i notAscii = _mm_set1_epi32(~0x7F);
+        size_t i = 0;
+
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(in + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(in + i + 4));
+            __m128i c = _mm_loadu_si128((const __m128i*)(in + i + 8));
+            __m128i d = _mm_loadu_si128((const __m128i*)(in + i + 12));
+
+            __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            __m128i high = _mm_and_si128(any, notAscii);
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128())) != 0xFFFF)
+                break;
+
+            //every value fits a byte, so the saturating packs just narrow.
+            __m128i bytes = _mm_packus_epi16(
+                _mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+
+            _mm_storeu_si128((__m128i*)(out + i), bytes);
+        }
+
+        return i;
+    }
+
+    /**
+     * Widen ASCII thirty two bytes at a time with AVX2.
+     */
+    __attribute__((target("avx2")))
+    size_t widenAvx2(const uint8_t* in, size_t size, wchar_t* out)
+    {
+        size_t i = 0;
+
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i bytes = _mm256_loadu_si256((const __m256i*)(in + i));
+
+            if (_mm256_movemask_epi8(bytes))
+                break;
+
+            for (size_t j = 0; j < 32; j += 8)
+            {
+                __m128i eight = _mm_loadl_epi64((const __m128i*)(in + i + j));
+                _mm256_storeu_si256(
+                    (__m256i*)(out + i + j), _mm256_cvtepu8_epi32(eight));
+            }
+        }
+
+        return i;
+    }
+
+    /**
+     * Narrow ASCII thirty two characters at a time with AVX2.
+     */
+    __attribute__((target("avx2")))
+    size_t narrowAvx2(const wchar_t* in, size_t size, char* out)
+    {
+        const __m256i notAscii = _mm256_set1_epi32(~0x7F);
+
+        //the packs work within each half, leaving each group of four in the
+        //order a, b, c, d of the low halves, then of the high halves.
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+        size_t i = 0;
+
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(in + i));
+            __m256i b = _mm256_loadu_si256((const __m256i*)(in + i + 8));
+            __m256i c = _mm256_loadu_si256((const __m256i*)(in + i + 16));
+            __m256i d = _mm256_loadu_si256((const __m256i*)(in + i + 24));
+
+            __m256i any = _mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d));
+
+            if (!_mm256_testz_si256(any, notAscii))
+                break;
+
+            __m256i bytes = _mm256_packus_epi16(
+                _mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+
+            _mm256_storeu_si256(
+                (__m256i*)(out + i), _mm256_permutevar8x32_epi32(bytes, order));
+        }
+
+        return i;
+    }
+
+    /**
+     * The errors a pair of bytes may show, for the lookup tables below.
+     */
+    enum : uint8_t
+    {
+        TOO_SHORT = 1 << 0,
+        TOO_LONG = 1 << 1,
+        OVERLONG_3 = 1 << 2,
+        TOO_LARGE = 1 << 3,
+        SURROGATE = 1 << 4,
+        OVERLONG_2 = 1 << 5,
+        TOO_LARGE_1000 = 1 << 6,
+        OVERLONG_4 = 1 << 6,
+        TWO_CONTS = 1 << 7,
+        CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS
+    };
+
+    /**
+     * The state carried from one block to the next by validateSsse3.
+     */
+    struct Ssse3Validation
+    {
+        __m128i previous;
+        __m128i incomplete;
+        __m128i error;
+    };
+
+    /**
+     * Check a block of sixteen bytes, after Keiser and Lemire's "Validating
+     * UTF-8 in less than one instruction per byte".  Each byte is classified,
+     * together with the byte before it, by three table lookups on their
+     * nibbles; any bit set in all three is an error.  The continuation bytes
+     * expected two and three bytes after a lead are checked separately.
+     */
+    __attribute__((target("ssse3"), always_inline))
+    inline void checkSsse3(__m128i input, Ssse3Validation& state)
+    {
+        if (_mm_movemask_epi8(input) == 0)
+        {
+            state.error = _mm_or_si128(state.error, state.incomplete);
+            state.previous = input;
+            state.incomplete = _mm_setzero_si128();
+
+            return;
+        }
+
+        const __m128i byte1High = _mm_setr_epi8(
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2,
+            TOO_SHORT,
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+
+        const __m128i byte1Low = _mm_setr_epi8(
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+            CARRY | OVERLONG_2,
+            CARRY,
+            CARRY,
+            CARRY | TOO_LARGE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000);
+
+        const __m128i byte2High = _mm_setr_epi8(
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+        //a block ending part way through a sequence is incomplete.
+        const __m128i lastComplete = _mm_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+
+        __m128i prev1 = _mm_alignr_epi8(input, state.previous, 15);
+
+        __m128i special = _mm_and_si128(
+            _mm_and_si128(
+                _mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)),
+                _mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibble))),
+            _mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(input, 4), nibble)));
+
+        //bytes two after a three or four byte lead, or three after a four
+        //byte lead, must be continuations.
+        __m128i prev2 = _mm_alignr_epi8(input, state.previous, 14);
+        __m128i prev3 = _mm_alignr_epi8(input, state.previous, 13);
+        __m128i must23 = _mm_or_si128(
+            _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+            _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80)));
+
+        __m128i must23Continuation = _mm_and_si128(must23, _mm_set1_epi8((char)0x80));
+
+        state.error = _mm_or_si128(
+            state.error, _mm_xor_si128(must23Continuation, special));
+        state.previous = input;
+        state.incomplete = _mm_subs_epu8(input, lastComplete);
+    }
+
+    /**
+     * Validate a buffer sixteen bytes at a time with SSSE3.
+     */
+    __attribute__((target("ssse3")))
+    bool validateSsse3(const uint8_t* p, size_t size)
+    {
+        Ssse3Validation state{
+            _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+            checkSsse3(_mm_loadu_si128((const __m128i*)(p + i)), state);
+
+        //the rest is padded with zeros, which end any sequence in progress.
+        if (i < size)
+        {
+            uint8_t rest[16] = {0};
+            memcpy(rest, p + i, size - i);
+
+            checkSsse3(_mm_loadu_si128((const __m128i*)rest), state);
+        }
+
+        __m128i error = _mm_or_si128(state.error, state.incomplete);
+
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+    }
+#endif
+
+    /**
+     * The implementations of each function which has one.
+     */
+    struct Utf8Implementation
+    {
+        size_t (*widen)(const uint8_t*, size_t, wchar_t*);
+        size_t (*narrow)(const wchar_t*, size_t, char*);
+        bool (*validate)(const uint8_t*, size_t);
+    };
+
+    /**
+     * Pick the fastest implementations the CPU supports.
+     */
+    Utf8Implementation selectImplementation()
+    {
+        Utf8Implementation selected{
+            &widenPortable, &narrowPortable, &validatePortable};
+
+#ifdef VIX_UTF8_X86
+        if (__builtin_cpu_supports("sse2"))
+        {
+            selected.widen = &widenSse2;
+            selected.narrow = &narrowSse2;
+        }
+
+        if (__builtin_cpu_supports("ssse3"))
+            selected.validate = &validateSsse3;
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            selected.widen = &widenAvx2;
+            selected.narrow = &narrowAvx2;
+        }
+#endif
+
+        return selected;
+    }
+
+    const Utf8Implementation& implementation()
+    {
+        static const Utf8Implementation IMPLEMENTATION = selectImplementation();
+
+        return IMPLEMENTATION;
+    }
+}
+
+/**
+ * utf8EncodedSize returns the number of bytes needed to encode the given wide
+ * string as UTF-8.
+ *
+ * \param in            The wide string to measure.
+ * \param size          The number of characters in the wide string.
+ */
+size_t
+vix::utf8EncodedSize(const wchar_t* in, size_t size)
+{
+    size_t encoded = 0;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        uint32_t c = in[i];
+
+        if (c < 0x80)
+            encoded += 1;
+        else if (c < 0x800)
+            encoded += 2;
+        else if (c < 0x10000 || !isScalarValue(c))
+            encoded += 3;
+        else
+            encoded += 4;
+    }
+
+    return encoded;
+}
+
+/**
+ * utf8Encode appends the UTF-8 encoding of a wide string to the output.
+ * Characters which are not Unicode scalar values are encoded as the
+ * replacement character.
+ *
+ * \param in            The wide string to encode.
+ * \param size          The number of characters in the wide string.
+ * \param out           The string to which the encoding is appended.
+ */
+void
+vix::utf8Encode(const wchar_t* in, size_t size, string& out)
+{
+    if (size == 0)
+        return;
+
+    auto narrow = implementation().narrow;
+
+    //room for ASCII, until something else turns up.
+    size_t start = out.size();
+    out.resize(start + size);
+
+    char* p = &out[start];
+    bool measured = false;
+    size_t i = 0;
+
+    while (i < size)
+    {
+        size_t ascii = narrow(in + i, size - i, p);
+        i += ascii;
+        p += ascii;
+
+        for (; i < size && (uint32_t)in[i] < 0x80; ++i)
+            *p++ = (char)in[i];
+
+        if (i == size)
+            break;
+
+        if (!measured)
+        {
+            size_t used = p - &out[0];
+            out.resize(used + utf8EncodedSize(in + i, size - i));
+            p = &out[0] + used;
+            measured = true;
+        }
+
+        p = encodeCharacter(in[i++], p);
+    }
+}
+
+/**
+ * utf8Encode appends the UTF-8 encoding of a wide string to the output.
+ */
+void
+vix::utf8Encode(const wstring& in, string& out)
+{
+    utf8Encode(in.data(), in.size(), out);
+}
+
+/**
+ * utf8Decode appends the characters of a UTF-8 encoded buffer to the output.
+ * Each malformed sequence is decoded as a single replacement character.
+ *
+ * \param in            The UTF-8 encoded buffer.
+ * \param size          The number of bytes in the buffer.
+ * \param out           The wide string to which the characters are appended.
+ *
+ * \returns true if the buffer was well formed.
+ */
+bool
+vix::utf8Decode(const char* in, size_t size, wstring& out)
+{
+    if (size == 0)
+        return true;
+
+    auto widen = implementation().widen;
+
+    const uint8_t* p = (const uint8_t*)in;
+    const uint8_t* end = p + size;
+    bool valid = true;
+
+    //the output never has more characters than the input has bytes.
+    size_t start = out.size();
+    out.resize(start + size);
+
+    wchar_t* w = &out[start];
+
+    while (p < end)
+    {
+        size_t ascii = widen(p, end - p, w);
+        p += ascii;
+        w += ascii;
+
+        //what's left of the vector which stopped the fast path.
+        for (; p < end && *p < 0x80; ++p)
+            *w++ = *p;
+
+        if (p == end)
+            break;
+
+        uint32_t c;
+        p += decodeSequence(p, end, c, valid);
+        *w++ = (wchar_t)c;
+    }
+
+    out.resize(w - &out[0]);
+
+    return valid;
+}
+
+/**
+ * utf8Validate returns true if a buffer is well formed UTF-8.
+ *
+ * \param in            The UTF-8 encoded buffer.
+ * \param size          The number of bytes in the buffer.
+ */
+bool
+vix::utf8Validate(const char* in, size_t size)
+{
+    return implementation().validate((const uint8_t*)in, size);
+}
+
+/**
+ * utf8Accelerated returns true if the UTF-8 functions use the CPU's vector
+ * instructions.
+ */
+bool
+vix::utf8Accelerated()
+{
+    return implementation().widen != &widenPortable;
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstring>
+#include <vix/Utf8.h>
+#include <vix/Utf8Decoder.h>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Returns the length of the sequence a lead byte starts, or zero if the
+     * byte can't start a sequence of more than one byte.
+     */
+    size_t sequenceLength(uint8_t b)
+    {
+        if ((b & 0xE0) == 0xC0)
+            return 2;
+
+        if ((b & 0xF0) == 0xE0)
+            return 3;
+
+        if ((b & 0xF8) == 0xF0)
+            return 4;
+
+        return 0;
+    }
+
+    /**
+     * Returns the number of bytes at the end of a buffer which begin a
+     * sequence that isn't finished within it.
+     */
+    size_t unfinishedTail(const uint8_t* p, size_t size)
+    {
+        for (size_t back = 1; back <= min<size_t>(3, size); ++back)
+        {
+            uint8_t b = p[size - back];
+
+            if ((b & 0xC0) == 0x80)
+                continue;
+
+            return sequenceLength(b) > back ? back : 0;
+        }
+
+        return 0;
+    }
+}
+
+/**
+ * Create a decoder at the start of its input.
+ */
+Utf8Decoder::Utf8Decoder()
+    : pendingSize_(0), valid_(true)
+{
+}
+
+/**
+ * Append the characters of the next chunk of input to the output.
+ *
+ * \param in            The chunk.
+ * \param size          The number of bytes in the chunk.
+ * \param out           The wide string to which the characters are appended.
+ */
+void
+Utf8Decoder::decode(const char* in, size_t size, wstring& out)
+{
+    const uint8_t* p = (const uint8_t*)in;
+
+    //finish the sequence held back, which ends at its full length or at the
+    //first byte which isn't a continuation.
+    if (pendingSize_ > 0)
+    {
+        size_t length = sequenceLength(pending_[0]);
+        size_t taken = 0;
+
+        while (pendingSize_ < length && taken < size && (p[taken] & 0xC0) == 0x80)
+            pending_[pendingSize_++] = p[taken++];
+
+        bool ended = pendingSize_ == length || taken < size;
+        if (!ended)
+            return;
+
+        valid_ &= utf8Decode(pending_, pendingSize_, out);
+        pendingSize_ = 0;
+
+        p += taken;
+        size -= taken;
+    }
+
+    size_t tail = unfinishedTail(p, size);
+
+    valid_ &= utf8Decode((const char*)p, size - tail, out);
+
+    memcpy(pending_, p + size - tail, tail);
+    pendingSize_ = tail;
+}
+
+/**
+ * Append anything held back to the output, as the input has ended, and start
+ * again.
+ *
+ * \param out           The wide string to which the characters are appended.
+ *
+ * \returns true if the input was well formed.
+ */
+bool
+Utf8Decoder::finish(wstring& out)
+{
+    if (pendingSize_ > 0)
+        valid_ &= utf8Decode(pending_, pendingSize_, out);
+
+    bool valid = valid_;
+
+    pendingSize_ = 0;
+    valid_ = true;
+
+    return valid;
+}
+
+/**
+ * Returns true if the input decoded so far was well formed.
+ */
+bool
+Utf8Decoder::valid() const
+{
+    return valid_;
+}
+
+/**
+ * Returns the number of bytes held back.
+ */
+size_t
+Utf8Decoder::pending() const
+{
+    return pendingSize_;
+}
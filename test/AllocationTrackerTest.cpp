@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <vix/AllocationTracker.h>
+#include <vix/Buffer.h>
+#include <vix/Line.h>
+#include <vix/SerialUtilities.h>
+#include <vix/SerialVarint.h>
+
+#include <limits>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+/*
+ * These tests only mean something when libvix is built with
+ * VIX_TRACK_ALLOCATIONS, as the checked build is.  Otherwise they pass
+ * without checking anything.
+ */
+
+namespace {
+    /**
+     * A stream buffer over a fixed array, which never allocates.
+     */
+    class FixedBuffer : public streambuf
+    {
+    public:
+        FixedBuffer()
+        {
+            setp(data_, data_ + sizeof(data_));
+        }
+
+        size_t size() const
+        {
+            return pptr() - pbase();
+        }
+
+    private:
+        char data_[64];
+    };
+}
+
+/**
+ * A tracker counts each allocation made while it is in scope, and nested
+ * trackers each count from when they were created.
+ */
+TEST(AllocationTrackerTest, counts)
+{
+    if (!AllocationTracker::enabled())
+        return;
+
+    AllocationTracker outer;
+    unique_ptr<int> one(new int(1));
+
+    EXPECT_EQ(1U, outer.allocations());
+    EXPECT_LE(sizeof(int), outer.bytes());
+
+    {
+        AllocationTracker inner;
+        unique_ptr<vector<char>> two(new vector<char>(100));
+
+        EXPECT_EQ(2U, inner.allocations());
+        EXPECT_LE(100U, inner.bytes());
+    }
+
+    EXPECT_EQ(3U, outer.allocations());
+
+    outer.reset();
+    EXPECT_EQ(0U, outer.allocations());
+    EXPECT_EQ(0U, outer.bytes());
+}
+
+/**
+ * Iterating a buffer doesn't allocate.
+ */
+TEST(AllocationTrackerTest, iterateBuffer)
+{
+    if (!AllocationTracker::enabled())
+        return;
+
+    Buffer buffer;
+    for (int i = 0; i < 100; ++i)
+        buffer.append(Line(L"line " + to_wstring(i)));
+
+    size_t characters = 0;
+
+    AllocationTracker tracker;
+
+    for (const auto& line : buffer)
+        characters += line.str().size();
+
+    for (auto i = buffer.rbegin(); i != buffer.rend(); ++i)
+        characters += i->str().size();
+
+    EXPECT_EQ(0U, tracker.allocations());
+    EXPECT_LT(0U, characters);
+}
+
+/**
+ * Moving a line into another doesn't allocate, and building one from a moved
+ * string allocates only its shared storage.
+ */
+TEST(AllocationTrackerTest, moveLine)
+{
+    if (!AllocationTracker::enabled())
+        return;
+
+    wstring text(200, L'x');
+    Line line(L"old");
+    Line replacement(L"new");
+
+    AllocationTracker tracker;
+
+    line = move(replacement);
+    EXPECT_EQ(0U, tracker.allocations());
+
+    Line moved(move(line));
+    EXPECT_EQ(0U, tracker.allocations());
+
+    Line built(move(text));
+    EXPECT_GE(1U, tracker.allocations());
+    EXPECT_EQ(L"new", moved.str());
+}
+
+/**
+ * Writing integers to a stream over preallocated memory doesn't allocate.
+ */
+TEST(AllocationTrackerTest, serializeInteger)
+{
+    if (!AllocationTracker::enabled())
+        return;
+
+    FixedBuffer buffer;
+    ostream out(&buffer);
+
+    AllocationTracker tracker;
+
+    serialWrite(out, static_cast<uint64_t>(0x0102030405060708ULL));
+    serialWrite(out, static_cast<int32_t>(-42));
+    serialWriteVarint(out, 300);
+    serialWriteZigzag(out, -300);
+
+    EXPECT_EQ(0U, tracker.allocations());
+    EXPECT_EQ(8U + 4U + 2U + 2U, buffer.size());
+}
+
+namespace {
+    //the number of times failingHandler has been called.
+    unsigned handlerCalls = 0;
+
+    /**
+     * A new handler which can't free anything, and so gives up the second
+     * time it is called.
+     */
+    void failingHandler()
+    {
+        if (++handlerCalls == 2)
+            set_new_handler(nullptr);
+    }
+}
+
+/**
+ * An allocation which fails calls the new handler until it goes, then throws,
+ * or returns null from the nothrow form, as the standard operator new does.
+ */
+TEST(AllocationTrackerTest, newHandler)
+{
+    if (!AllocationTracker::enabled())
+        return;
+
+    //too large for malloc ever to succeed.
+    volatile size_t size = numeric_limits<size_t>::max() / 2;
+
+    handlerCalls = 0;
+    set_new_handler(failingHandler);
+    EXPECT_THROW(operator new(size), bad_alloc);
+    EXPECT_EQ(2U, handlerCalls);
+
+    handlerCalls = 0;
+    set_new_handler(failingHandler);
+    EXPECT_EQ(nullptr, operator new[](size, nothrow));
+    EXPECT_EQ(2U, handlerCalls);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <vix/BlockCompression.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Compress and decompress the given buffer, returning the compressed size.
+ */
+static size_t roundTrip(const vector<uint8_t>& in)
+{
+    vector<uint8_t> compressed;
+    vector<uint8_t> out(in.size() + 1, 0xCC);
+
+    compressBlock(in.data(), in.size(), compressed);
+    EXPECT_LE(compressed.size(), compressBlockBound(in.size()));
+
+    decompressBlock(compressed.data(), compressed.size(), out.data(), in.size());
+
+    EXPECT_TRUE(equal(in.begin(), in.end(), out.begin()));
+    //nothing should be written past the end of the output.
+    EXPECT_EQ(0xCC, out[in.size()]);
+
+    return compressed.size();
+}
+
+/**
+ * An empty block round trips.
+ */
+TEST(BlockCompressionTest, empty)
+{
+    roundTrip(vector<uint8_t>());
+}
+
+/**
+ * Blocks too small to hold a match round trip.
+ */
+TEST(BlockCompressionTest, small)
+{
+    for (size_t size = 1; size < 20; ++size)
+        roundTrip(vector<uint8_t>(size, 'a'));
+}
+
+/**
+ * Repetitive data compresses well and round trips.
+ */
+TEST(BlockCompressionTest, repetitive)
+{
+    string line = "2014-03-01 12:00:00 INFO request served in 12ms\n";
+    string text;
+    for (int i = 0; i < 1000; ++i)
+        text += line;
+
+    vector<uint8_t> in(text.begin(), text.end());
+
+    EXPECT_LT(roundTrip(in), in.size() / 10);
+}
+
+/**
+ * Random data round trips, even though it doesn't compress.
+ */
+TEST(BlockCompressionTest, random)
+{
+    mt19937 rng(1234);
+    vector<uint8_t> in(100000);
+    for (auto& b : in)
+        b = rng() & 0xFF;
+
+    roundTrip(in);
+}
+
+/**
+ * Data mixing long literal runs and long matches round trips.
+ */
+TEST(BlockCompressionTest, mixed)
+{
+    mt19937 rng(4321);
+    vector<uint8_t> in;
+    for (int i = 0; i < 50; ++i)
+    {
+        size_t literals = rng() % 600;
+        for (size_t j = 0; j < literals; ++j)
+            in.push_back(rng() & 0xFF);
+
+        size_t repeat = rng() % 600;
+        in.insert(in.end(), repeat, (uint8_t)(rng() & 0xFF));
+    }
+
+    roundTrip(in);
+}
+
+/**
+ * Decompressing to the wrong size throws.
+ */
+TEST(BlockCompressionTest, wrongSize)
+{
+    vector<uint8_t> in(1000, 'a');
+    vector<uint8_t> compressed;
+    vector<uint8_t> out(2000);
+
+    compressBlock(in.data(), in.size(), compressed);
+
+    EXPECT_THROW(
+        decompressBlock(compressed.data(), compressed.size(), out.data(), 999),
+        vix::exception::Decompression);
+    EXPECT_THROW(
+        decompressBlock(compressed.data(), compressed.size(), out.data(), 1001),
+        vix::exception::Decompression);
+}
+
+/**
+ * Decompressing a truncated or damaged block throws instead of reading or
+ * writing out of bounds.
+ */
+TEST(BlockCompressionTest, corrupt)
+{
+    string text;
+    for (int i = 0; i < 100; ++i)
+        text += "line " + to_string(i % 7) + "\n";
+
+    vector<uint8_t> compressed;
+    vector<uint8_t> out(text.size());
+
+    compressBlock(text.data(), text.size(), compressed);
+
+    for (size_t size = 0; size < compressed.size(); ++size)
+    {
+        EXPECT_THROW(
+            decompressBlock(compressed.data(), size, out.data(), out.size()),
+            vix::exception::Decompression);
+    }
+
+    for (size_t i = 0; i < compressed.size(); ++i)
+    {
+        vector<uint8_t> damaged(compressed);
+        damaged[i] ^= 0xFF;
+
+        try
+        {
+            decompressBlock(damaged.data(), damaged.size(), out.data(), out.size());
+        }
+        catch (vix::exception::Decompression&)
+        {
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <vix/BudgetedOutputStream.h>
+#include <vix/MappedFile.h>
+
+#include <cstring>
+#include <string>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+class BudgetedOutputStreamTest : public TemporaryFileTest
+{
+};
+
+/**
+ * Everything written, in small and large pieces, ends up in the file.
+ */
+TEST_F(BudgetedOutputStreamTest, write)
+{
+    IoBudget budget;
+    string expected;
+
+    {
+        BudgetedOutputStream out(path, budget);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            string piece(i * 7 % 300, (char)('a' + i % 26));
+            out.write(piece.data(), piece.size());
+            out.put('\n');
+
+            expected += piece + '\n';
+        }
+
+        string large(200000, 'x');
+        out << large;
+        expected += large;
+
+        out.commit();
+    }
+
+    MappedFile file(path);
+    ASSERT_EQ(expected.size(), file.size());
+    EXPECT_EQ(0, memcmp(expected.data(), file.data(), file.size()));
+}
+
+/**
+ * Creating the stream truncates an existing file.
+ */
+TEST_F(BudgetedOutputStreamTest, truncate)
+{
+    IoBudget budget;
+
+    {
+        BudgetedOutputStream out(path, budget);
+        out << "Some contents";
+    }
+
+    {
+        BudgetedOutputStream out(path, budget);
+        out << "New";
+        out.commit();
+    }
+
+    EXPECT_EQ(3U, MappedFile(path).size());
+}
+
+/**
+ * A file which can't be created throws.
+ */
+TEST_F(BudgetedOutputStreamTest, create)
+{
+    IoBudget budget;
+
+    EXPECT_THROW(
+        BudgetedOutputStream(path + ".missing/file", budget),
+        vix::exception::FileOpen);
+}
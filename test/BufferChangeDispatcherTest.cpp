@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+#include <vix/Buffer.h>
+#include <vix/BufferChangeDispatcher.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * An observer which records what it is told, and can be held up.
+     */
+    class RecordingObserver : public AsyncBufferChangeObserver
+    {
+    public:
+        vector<vector<BufferChange>> calls;
+        vector<wstring> snapshot;
+        thread::id caller;
+        bool throws = false;
+
+        virtual void onBufferChanged(
+            const list<Line>& lines, const vector<BufferChange>& changes)
+        {
+            {
+                unique_lock<mutex> lock(mutex_);
+                ++entered_;
+                entry_.notify_all();
+                released_.wait(lock, [this] { return !held_; });
+            }
+
+            calls.push_back(changes);
+            snapshot.clear();
+            for (auto& line : lines)
+                snapshot.push_back(line.str());
+            caller = this_thread::get_id();
+
+            if (throws)
+                throw runtime_error("observer failed");
+        }
+
+        void hold()
+        {
+            lock_guard<mutex> lock(mutex_);
+            held_ = true;
+        }
+
+        void waitForEntry(size_t calls)
+        {
+            unique_lock<mutex> lock(mutex_);
+            entry_.wait(lock, [&] { return entered_ >= calls; });
+        }
+
+        void release()
+        {
+            {
+                lock_guard<mutex> lock(mutex_);
+                held_ = false;
+            }
+
+            released_.notify_all();
+        }
+
+    private:
+        mutex mutex_;
+        condition_variable released_;
+        condition_variable entry_;
+        bool held_ = false;
+        size_t entered_ = 0;
+    };
+}
+
+/**
+ * Changes are delivered off the editing thread, with a snapshot which matches
+ * the buffer.
+ */
+TEST(BufferChangeDispatcherTest, deliver)
+{
+    Buffer buffer;
+    buffer.append(Line(L"one"));
+    buffer.append(Line(L"two"));
+
+    auto observer = make_shared<RecordingObserver>();
+    buffer.addObserver(observer);
+
+    buffer.replace(next(buffer.begin()), Line(L"2"));
+    buffer.waitForObservers();
+
+    ASSERT_EQ(1U, observer->calls.size());
+    ASSERT_EQ(1U, observer->calls[0].size());
+    EXPECT_EQ(1U, observer->calls[0][0].line);
+    EXPECT_EQ(1U, observer->calls[0][0].removed);
+    EXPECT_EQ(1U, observer->calls[0][0].inserted);
+    EXPECT_EQ(bufferLines(buffer), observer->snapshot);
+    EXPECT_NE(this_thread::get_id(), observer->caller);
+}
+
+/**
+ * Changes made while an observer is busy are delivered together, merged.
+ */
+TEST(BufferChangeDispatcherTest, coalesce)
+{
+    Buffer buffer;
+    auto observer = make_shared<RecordingObserver>();
+    buffer.addObserver(observer);
+
+    observer->hold();
+    buffer.append(Line(L"first"));
+    observer->waitForEntry(1);
+
+    //type while the first change is held up in the observer.
+    for (int i = 0; i < 20; ++i)
+        buffer.append(Line(L"typing"));
+
+    buffer.erase(next(buffer.begin(), 5));
+    buffer.insert(Line(L"top"));
+
+    observer->release();
+    buffer.waitForObservers();
+
+    ASSERT_EQ(2U, observer->calls.size());
+    EXPECT_EQ(bufferLines(buffer), observer->snapshot);
+
+    //the appends and the erase among them merge; the insert is apart.
+    auto& last = observer->calls[1];
+    ASSERT_EQ(2U, last.size());
+    EXPECT_EQ(1U, last[0].line);
+    EXPECT_EQ(0U, last[0].removed);
+    EXPECT_EQ(19U, last[0].inserted);
+    EXPECT_EQ(0U, last[1].line);
+    EXPECT_EQ(0U, last[1].removed);
+    EXPECT_EQ(1U, last[1].inserted);
+}
+
+/**
+ * Edits anywhere in the buffer keep the snapshot in step.
+ */
+TEST(BufferChangeDispatcherTest, snapshot)
+{
+    Buffer buffer;
+    for (int i = 0; i < 100; ++i)
+        buffer.append(Line(to_wstring(i)));
+
+    auto observer = make_shared<RecordingObserver>();
+    buffer.addObserver(observer);
+
+    for (int i = 0; i < 300; ++i)
+    {
+        auto line = next(buffer.begin(), (i * 37) % buffer.lines());
+
+        switch (i % 4)
+        {
+        case 0: buffer.insert(line, Line(L"inserted")); break;
+        case 1: buffer.erase(line); break;
+        case 2: buffer.replace(line, Line(L"replaced " + to_wstring(i))); break;
+        case 3: buffer.append(line, Line(L"appended")); break;
+        }
+    }
+
+    buffer.waitForObservers();
+    EXPECT_EQ(bufferLines(buffer), observer->snapshot);
+
+    Buffer::LineList lines{Line(L"assigned")};
+    buffer.assign(lines);
+    buffer.waitForObservers();
+    EXPECT_EQ(bufferLines(buffer), observer->snapshot);
+}
+
+/**
+ * A failing observer doesn't stop others hearing of changes.
+ */
+TEST(BufferChangeDispatcherTest, failingObserver)
+{
+    Buffer buffer;
+    auto failing = make_shared<RecordingObserver>();
+    auto observer = make_shared<RecordingObserver>();
+    failing->throws = true;
+
+    buffer.addObserver(failing);
+    buffer.addObserver(observer);
+
+    buffer.append(Line(L"one"));
+    buffer.waitForObservers();
+    buffer.append(Line(L"two"));
+    buffer.waitForObservers();
+
+    EXPECT_EQ(2U, failing->calls.size());
+    EXPECT_EQ(2U, observer->calls.size());
+}
+
+/**
+ * A reader sees the lines as they were when it was posted, off the editing
+ * thread, and the observers aren't told of anything by it.
+ */
+TEST(BufferChangeDispatcherTest, readLines)
+{
+    Buffer buffer;
+    auto observer = make_shared<RecordingObserver>();
+    buffer.addObserver(observer);
+
+    observer->hold();
+    buffer.append(Line(L"one"));
+    observer->waitForEntry(1);
+
+    vector<wstring> read;
+    thread::id reader;
+    buffer.append(Line(L"two"));
+    buffer.readLines([&](const Buffer::LineList& lines) {
+        for (auto& line : lines)
+            read.push_back(line.str());
+        reader = this_thread::get_id();
+    });
+    buffer.append(Line(L"three"));
+
+    observer->release();
+    buffer.waitForObservers();
+
+    EXPECT_EQ((vector<wstring>{L"one", L"two"}), read);
+    EXPECT_NE(this_thread::get_id(), reader);
+    EXPECT_EQ(2U, observer->calls.size());
+    EXPECT_EQ(bufferLines(buffer), observer->snapshot);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <vix/BufferChange.h>
+
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    void expectChange(const BufferChange& change, size_t line, size_t removed, size_t inserted)
+    {
+        EXPECT_EQ(line, change.line);
+        EXPECT_EQ(removed, change.removed);
+        EXPECT_EQ(inserted, change.inserted);
+    }
+}
+
+/**
+ * Lines inserted one after another merge into one insertion.
+ */
+TEST(BufferChangeTest, mergeInsertions)
+{
+    BufferChange change{5, 0, 1};
+
+    ASSERT_TRUE(change.touches(BufferChange{6, 0, 1}));
+    change.merge(BufferChange{6, 0, 1});
+    expectChange(change, 5, 0, 2);
+
+    //and so do lines inserted before.
+    ASSERT_TRUE(change.touches(BufferChange{5, 0, 1}));
+    change.merge(BufferChange{5, 0, 1});
+    expectChange(change, 5, 0, 3);
+}
+
+/**
+ * Erasing lines just inserted cancels them out, and erasing lines around them
+ * extends the change.
+ */
+TEST(BufferChangeTest, mergeErasures)
+{
+    BufferChange change{5, 0, 2};
+
+    change.merge(BufferChange{6, 1, 0});
+    expectChange(change, 5, 0, 1);
+
+    change.merge(BufferChange{4, 3, 0});
+    expectChange(change, 4, 2, 0);
+}
+
+/**
+ * Replacing the same line repeatedly is a single replacement.
+ */
+TEST(BufferChangeTest, mergeReplacements)
+{
+    BufferChange change{3, 1, 1};
+
+    change.merge(BufferChange{3, 1, 1});
+    expectChange(change, 3, 1, 1);
+}
+
+/**
+ * Changes which don't touch merge into one covering the lines between them.
+ */
+TEST(BufferChangeTest, mergeApart)
+{
+    BufferChange change{2, 1, 3};
+
+    EXPECT_FALSE(change.touches(BufferChange{10, 1, 0}));
+    change.merge(BufferChange{10, 1, 0});
+
+    //the second change's line 10 was the original's line 8.
+    expectChange(change, 2, 7, 8);
+
+    BufferChange before{10, 0, 1};
+    EXPECT_FALSE(before.touches(BufferChange{2, 1, 1}));
+    before.merge(BufferChange{2, 1, 1});
+    expectChange(before, 2, 8, 9);
+}
+
+/**
+ * Coalescing merges touching changes, keeps others apart, and folds a long
+ * sequence into one change.
+ */
+TEST(BufferChangeTest, coalesce)
+{
+    vector<BufferChange> changes;
+
+    coalesceBufferChange(changes, BufferChange{0, 0, 1}, 3);
+    coalesceBufferChange(changes, BufferChange{1, 0, 1}, 3);
+    ASSERT_EQ(1U, changes.size());
+    expectChange(changes[0], 0, 0, 2);
+
+    coalesceBufferChange(changes, BufferChange{10, 1, 1}, 3);
+    coalesceBufferChange(changes, BufferChange{20, 1, 1}, 3);
+    ASSERT_EQ(3U, changes.size());
+
+    coalesceBufferChange(changes, BufferChange{30, 1, 0}, 3);
+    ASSERT_EQ(1U, changes.size());
+    expectChange(changes[0], 0, 29, 30);
+}
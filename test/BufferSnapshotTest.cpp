@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include <vix/BufferSnapshot.h>
+#include <vix/SerialEndian.h>
+
+#include <cstdint>
+#include <sstream>
+
+using namespace std;
+using namespace vix;
+
+class BufferSnapshotTest : public ::testing::Test
+{
+protected:
+    Buffer b;
+
+    virtual void SetUp() {
+        b.append(Line(L"First Line"));
+        b.append(Line());
+        b.append(Line(L"é€\U0001F600"));
+        b.append(Line(L"Fourth Line"));
+    }
+
+    /**
+     * Expect the given buffer to hold the same lines as b.
+     */
+    void expectSameLines(const Buffer& other) {
+        ASSERT_EQ(b.lines(), other.lines());
+
+        auto i = b.begin();
+        auto j = other.begin();
+        for (; i != b.end(); ++i, ++j)
+            EXPECT_EQ(i->str(), j->str());
+    }
+};
+
+/**
+ * A snapshot read from a stream matches the buffer written to it.
+ */
+TEST_F(BufferSnapshotTest, streamRoundTrip)
+{
+    stringstream ss;
+    Buffer read;
+    read.append(Line(L"Replaced"));
+
+    writeBufferSnapshot(ss, b);
+    readBufferSnapshot(ss, read);
+
+    expectSameLines(read);
+}
+
+/**
+ * A snapshot read from memory matches the buffer written to it.
+ */
+TEST_F(BufferSnapshotTest, memoryRoundTrip)
+{
+    stringstream ss;
+    Buffer read;
+
+    writeBufferSnapshot(ss, b);
+    string data = ss.str();
+    readBufferSnapshot(data.data(), data.size(), read);
+
+    expectSameLines(read);
+}
+
+/**
+ * Snapshots can be written without checksums.
+ */
+TEST_F(BufferSnapshotTest, noChecksums)
+{
+    stringstream withChecksums;
+    stringstream withoutChecksums;
+    Buffer read;
+
+    writeBufferSnapshot(withChecksums, b);
+    writeBufferSnapshot(withoutChecksums, b, 0);
+
+    //three checksums are left out.
+    EXPECT_EQ(withChecksums.str().size() - 12, withoutChecksums.str().size());
+
+    readBufferSnapshot(withoutChecksums, read);
+
+    expectSameLines(read);
+}
+
+/**
+ * Buffer serializes itself as a snapshot.
+ */
+TEST_F(BufferSnapshotTest, serializable)
+{
+    stringstream ss;
+    Buffer read;
+
+    b.serialWrite(ss);
+    read.serialRead(ss);
+
+    expectSameLines(read);
+}
+
+/**
+ * An empty buffer round trips.
+ */
+TEST_F(BufferSnapshotTest, empty)
+{
+    stringstream ss;
+    Buffer empty;
+    Buffer read;
+    read.append(Line(L"Replaced"));
+
+    writeBufferSnapshot(ss, empty);
+    string data = ss.str();
+    readBufferSnapshot(data.data(), data.size(), read);
+
+    EXPECT_EQ(0U, read.lines());
+}
+
+/**
+ * Decoding across several threads gives the same result as decoding on one.
+ */
+TEST_F(BufferSnapshotTest, parallel)
+{
+    b.clear();
+    for (int n = 0; n < 100000; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    stringstream ss;
+    Buffer read;
+
+    writeBufferSnapshot(ss, b);
+    string data = ss.str();
+    readBufferSnapshot(data.data(), data.size(), read, 4);
+
+    expectSameLines(read);
+}
+
+/**
+ * A damaged snapshot fails its checksums.
+ */
+TEST_F(BufferSnapshotTest, corrupt)
+{
+    stringstream ss;
+    Buffer read;
+
+    writeBufferSnapshot(ss, b);
+    string data = ss.str();
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        string damaged(data);
+        damaged[i] ^= 0x01;
+
+        EXPECT_THROW(
+            readBufferSnapshot(damaged.data(), damaged.size(), read),
+            vix::exception::SerialRead);
+    }
+}
+
+/**
+ * A truncated snapshot can't be read.
+ */
+TEST_F(BufferSnapshotTest, truncated)
+{
+    stringstream ss;
+    Buffer read;
+
+    writeBufferSnapshot(ss, b, 0);
+    string data = ss.str();
+
+    for (size_t size = 0; size < data.size(); ++size)
+    {
+        stringstream truncated(data.substr(0, size));
+
+        EXPECT_THROW(
+            readBufferSnapshot(data.data(), size, read),
+            vix::exception::SerialRead);
+        EXPECT_THROW(
+            readBufferSnapshot(truncated, read),
+            vix::exception::SerialRead);
+    }
+}
+
+/**
+ * A snapshot without checksums whose header claims far more than the stream
+ * holds is rejected without allocating what the header claims.
+ */
+TEST_F(BufferSnapshotTest, hugeSizes)
+{
+    stringstream ss;
+    Buffer read;
+
+    writeBufferSnapshot(ss, b, 0);
+    string data = ss.str();
+
+    //the line count, then the text size.
+    string lines(data), text(data);
+    encodeBigEndian(&lines[8], static_cast<uint64_t>(1) << 40);
+    encodeBigEndian(&text[16], static_cast<uint64_t>(1) << 40);
+
+    stringstream hugeLines(lines), hugeText(text);
+
+    EXPECT_THROW(readBufferSnapshot(hugeLines, read), vix::exception::SerialRead);
+    EXPECT_THROW(readBufferSnapshot(hugeText, read), vix::exception::SerialRead);
+}
+
+/**
+ * Something that isn't a snapshot is rejected.
+ */
+TEST_F(BufferSnapshotTest, notASnapshot)
+{
+    const string data(64, 'x');
+    Buffer read;
+
+    EXPECT_THROW(
+        readBufferSnapshot(data.data(), data.size(), read),
+        vix::exception::SerialRead);
+}
+
+/**
+ * A line read back matches the line written.
+ */
+TEST_F(BufferSnapshotTest, serialReadWriteLine)
+{
+    stringstream ss;
+    Line read;
+
+    serialWrite(ss, *b.rbegin());
+    serialRead(ss, read);
+
+    EXPECT_EQ(b.rbegin()->str(), read.str());
+}
@@ -1,8 +1,14 @@
 #include <gtest/gtest.h>
 #include <vix/Buffer.h>
+#include <vix/Instrumentation.h>
 #include <vix/Line.h>
 
+#include <algorithm>
+#include <iterator>
+#include <list>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "BufferChangeObserverMock.h"
 
@@ -155,6 +161,44 @@ TEST_F(BufferTest, replace)
     ASSERT_EQ(i, b.end());
 }
 
+/**
+ * Replacing text in a line changes it in place, and is seen as the line being
+ * replaced.
+ */
+TEST_F(BufferTest, replaceText)
+{
+    b.append(firstLine);
+    b.append(secondLine);
+
+    i = b.begin();
+    ++i;
+    b.replace(i, 0, 6, L"Other");
+
+    EXPECT_EQ(L"Other Line", i->str());
+    EXPECT_EQ(b.version(), i->stamp());
+    EXPECT_EQ(1U, b.lastChange().line);
+    EXPECT_EQ(1U, b.lastChange().removed);
+    EXPECT_EQ(1U, b.lastChange().inserted);
+    EXPECT_EQ(firstLine.str(), b.begin()->str());
+}
+
+/**
+ * Lines can be found by index, from either end or the last change.
+ */
+TEST_F(BufferTest, lineAtIndex)
+{
+    for (int n = 0; n < 10; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.replace(b.line(6), Line(L"Changed"));
+
+    for (size_t n = 0; n < 10; ++n)
+        EXPECT_EQ(n, b.lineNumber(b.line(n)));
+
+    EXPECT_EQ(L"Changed", b.line(6)->str());
+    EXPECT_EQ(b.end(), b.line(10));
+}
+
 /**
  * Attempting to replace the end of the buffer does nothing.
  */
@@ -354,3 +398,672 @@ TEST_F(BufferTest, clearNotification)
     //the observer is called with an onBufferChanged event on clear.
     EXPECT_TRUE(VALIDATE(*observerMock, onBufferChanged).called(&b));
 }
+
+/**
+ * By default, a Buffer does not intern lines.
+ */
+TEST_F(BufferTest, interningDefault)
+{
+    ASSERT_FALSE(b.interning());
+
+    b.append(Line(L"Same"));
+    b.append(Line(L"Same"));
+
+    i = b.begin();
+    ASSERT_FALSE(i->shares(*b.rbegin()));
+}
+
+/**
+ * When interning is enabled, lines with the same contents share storage.
+ */
+TEST_F(BufferTest, interningEnabled)
+{
+    b.interning(true);
+    ASSERT_TRUE(b.interning());
+
+    b.append(Line(L"Same"));
+    b.insert(Line(L"Same"));
+    b.insert(b.begin(), Line(L"Same"));
+    b.append(b.begin(), Line(L"Same"));
+    b.append(firstLine);
+
+    for (i = b.begin(); i != b.end(); ++i)
+    {
+        if (i->str() == L"Same")
+            EXPECT_TRUE(i->shares(*b.begin()));
+        else
+            EXPECT_FALSE(i->shares(*b.begin()));
+    }
+
+    //replace also interns the new line.
+    b.replace(--b.end(), Line(L"Same"));
+    EXPECT_TRUE(b.rbegin()->shares(*b.begin()));
+}
+
+/**
+ * Enabling interning interns the lines already in the buffer.
+ */
+TEST_F(BufferTest, interningExistingLines)
+{
+    b.append(Line(L"Same"));
+    b.append(Line(L"Same"));
+
+    b.interning(true);
+
+    EXPECT_TRUE(b.begin()->shares(*b.rbegin()));
+}
+
+/**
+ * Editing an interned line in place does not change the lines it shares
+ * storage with.
+ */
+TEST_F(BufferTest, interningCopyOnWrite)
+{
+    b.interning(true);
+
+    b.append(Line(L"Same"));
+    b.append(Line(L"Same"));
+
+    b.begin()->str(L"Changed");
+
+    EXPECT_EQ(L"Changed", b.begin()->str());
+    EXPECT_EQ(L"Same", b.rbegin()->str());
+}
+
+/**
+ * compressCold compresses runs of lines without changing their contents.
+ */
+TEST_F(BufferTest, compressCold)
+{
+    for (int n = 0; n < 10; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.compressCold(4);
+    b.waitForCompression();
+
+    //two full runs of four lines are compressed; the rest are not.
+    int compressed = 0;
+    for (i = b.begin(); i != b.end(); ++i)
+        compressed += i->compressed() ? 1 : 0;
+    EXPECT_EQ(8, compressed);
+
+    //iteration decompresses lines on demand.
+    int n = 0;
+    for (i = b.begin(); i != b.end(); ++i, ++n)
+        EXPECT_EQ(L"Line " + to_wstring(n), i->str());
+}
+
+/**
+ * Lines read since the last sweep stay decompressed; lines not read since are
+ * dropped back to compressed form.
+ */
+TEST_F(BufferTest, compressColdSweep)
+{
+    for (int n = 0; n < 8; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.compressCold(4);
+    b.waitForCompression();
+
+    //read a line in the first block.
+    i = b.begin();
+    ASSERT_EQ(L"Line 0", i->str());
+    ASSERT_FALSE(i->compressed());
+
+    //the first block was read, so it stays warm.
+    b.compressCold(4);
+    EXPECT_FALSE(b.begin()->compressed());
+
+    //the first block was not read since, so it goes cold.
+    b.compressCold(4);
+    EXPECT_TRUE(b.begin()->compressed());
+    EXPECT_EQ(L"Line 0", b.begin()->str());
+}
+
+/**
+ * A line which keeps being read stays warm, even when each read is served from
+ * its cached contents.
+ */
+TEST_F(BufferTest, compressColdHot)
+{
+    for (int n = 0; n < 4; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.compressCold(4);
+    b.waitForCompression();
+    ASSERT_EQ(L"Line 0", b.begin()->str());
+
+    for (int sweep = 0; sweep < 3; ++sweep)
+    {
+        //this read doesn't need to decompress anything.
+        ASSERT_FALSE(b.begin()->compressed());
+        EXPECT_EQ(L"Line 0", b.begin()->str());
+
+        b.compressCold(4);
+        EXPECT_FALSE(b.begin()->compressed());
+    }
+}
+
+/**
+ * Editing a compressed line detaches it from its block.
+ */
+TEST_F(BufferTest, compressColdEdit)
+{
+    for (int n = 0; n < 4; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.compressCold(4);
+    b.waitForCompression();
+
+    i = b.begin();
+    ++i;
+    i->str(L"Changed");
+    b.replace(b.begin(), firstLine);
+
+    EXPECT_FALSE(i->compressed());
+
+    i = b.begin();
+    EXPECT_EQ(firstLine.str(), i->str());
+    EXPECT_EQ(L"Changed", (++i)->str());
+    EXPECT_EQ(L"Line 2", (++i)->str());
+    EXPECT_EQ(L"Line 3", (++i)->str());
+}
+
+/**
+ * A line changed while its block is being compressed keeps its new contents,
+ * and the rest of the run still gets the block.
+ */
+TEST_F(BufferTest, compressColdEditWhileCompressing)
+{
+    for (int n = 0; n < 4; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.compressCold(4);
+
+    i = b.begin();
+    ++i;
+    i->str(L"Changed");
+
+    b.waitForCompression();
+
+    EXPECT_FALSE(i->compressed());
+    EXPECT_TRUE(b.begin()->compressed());
+
+    i = b.begin();
+    EXPECT_EQ(L"Line 0", i->str());
+    EXPECT_EQ(L"Changed", (++i)->str());
+    EXPECT_EQ(L"Line 2", (++i)->str());
+    EXPECT_EQ(L"Line 3", (++i)->str());
+}
+
+/**
+ * Appending a list of lines moves them all to the end of the buffer, with a
+ * single notification.
+ */
+TEST_F(BufferTest, appendList)
+{
+    auto observerMock = make_shared<BufferChangeObserverMock>();
+    Buffer::LineList newLines{secondLine, thirdLine};
+
+    b.append(firstLine);
+    b.addObserver(observerMock);
+
+    b.append(newLines);
+
+    EXPECT_TRUE(VALIDATE(*observerMock, onBufferChanged).called(&b));
+    EXPECT_TRUE(newLines.empty());
+
+    i = b.begin();
+    ASSERT_EQ(i->str(), firstLine.str());
+    ++i;
+    ASSERT_EQ(i->str(), secondLine.str());
+    ++i;
+    ASSERT_EQ(i->str(), thirdLine.str());
+    ++i;
+    ASSERT_EQ(i, b.end());
+}
+
+/**
+ * Assigning a list of lines replaces the contents of the buffer, with a single
+ * notification.
+ */
+TEST_F(BufferTest, assign)
+{
+    auto observerMock = make_shared<BufferChangeObserverMock>();
+    Buffer::LineList newLines{secondLine, thirdLine};
+
+    b.append(firstLine);
+    b.addObserver(observerMock);
+
+    b.assign(newLines);
+
+    EXPECT_TRUE(VALIDATE(*observerMock, onBufferChanged).called(&b));
+    EXPECT_TRUE(newLines.empty());
+
+    i = b.begin();
+    ASSERT_EQ(i->str(), secondLine.str());
+    ++i;
+    ASSERT_EQ(i->str(), thirdLine.str());
+    ++i;
+    ASSERT_EQ(i, b.end());
+}
+
+/**
+ * A line's number is its index, whichever end it is nearer.
+ */
+TEST_F(BufferTest, lineNumber)
+{
+    for (int n = 0; n < 7; ++n)
+        b.append(Line(to_wstring(n)));
+
+    size_t index = 0;
+    for (ci = b.begin(); ci != b.end(); ++ci)
+        EXPECT_EQ(index++, b.lineNumber(ci));
+
+    EXPECT_EQ(7U, b.lineNumber(b.end()));
+}
+
+/**
+ * Each change records which lines it removed and inserted.
+ */
+TEST_F(BufferTest, lastChange)
+{
+    auto expectChange = [&](size_t line, size_t removed, size_t inserted) {
+        BufferChange change = b.lastChange();
+        EXPECT_EQ(line, change.line);
+        EXPECT_EQ(removed, change.removed);
+        EXPECT_EQ(inserted, change.inserted);
+    };
+
+    b.append(firstLine);
+    expectChange(0, 0, 1);
+
+    b.append(thirdLine);
+    expectChange(1, 0, 1);
+
+    b.insert(next(b.begin()), secondLine);
+    expectChange(1, 0, 1);
+
+    b.insert(fourthLine);
+    expectChange(0, 0, 1);
+
+    b.append(next(b.begin(), 2), fourthLine);
+    expectChange(3, 0, 1);
+
+    b.replace(next(b.begin(), 2), thirdLine);
+    expectChange(2, 1, 1);
+
+    b.erase(next(b.begin(), 4));
+    expectChange(4, 1, 0);
+
+    Buffer::LineList more{firstLine, secondLine};
+    b.append(more);
+    expectChange(4, 0, 2);
+
+    Buffer::LineList fewer{thirdLine};
+    b.assign(fewer);
+    expectChange(0, 6, 1);
+
+    b.clear();
+    expectChange(0, 1, 0);
+}
+
+/**
+ * Line numbers found by walking towards the last change agree with counting
+ * from the start, wherever the edits land.
+ */
+TEST_F(BufferTest, lineNumberNearChange)
+{
+    for (int n = 0; n < 200; ++n)
+        b.append(Line(to_wstring(n)));
+
+    unsigned seed = 7;
+    auto random = [&](size_t limit) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % limit;
+    };
+
+    for (int edit = 0; edit < 500; ++edit)
+    {
+        size_t line = random(b.lines());
+        i = next(b.begin(), line);
+
+        switch (edit % 4)
+        {
+        case 0:
+            b.insert(i, firstLine);
+            break;
+
+        case 1:
+            b.append(i, secondLine);
+            ++line;
+            break;
+
+        case 2:
+            b.replace(i, thirdLine);
+            break;
+
+        case 3:
+            b.erase(i);
+            break;
+        }
+
+        ASSERT_EQ(line, b.lastChange().line);
+
+        size_t probe = random(b.lines() + 1);
+        ASSERT_EQ(probe, b.lineNumber(next(b.begin(), probe)));
+    }
+}
+
+/**
+ * The last change is reported correctly however many changes went by without
+ * anything asking where they were.
+ */
+TEST_F(BufferTest, lastChangeAskedLate)
+{
+    for (int n = 0; n < 200; ++n)
+        b.append(Line(to_wstring(n)));
+
+    unsigned seed = 11;
+    auto random = [&](size_t limit) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 8) % limit;
+    };
+
+    for (int edit = 0; edit < 500; ++edit)
+    {
+        //stay close to the last edit most of the time, as typing does.
+        size_t line = edit % 3 == 0 ? random(b.lines()) : min(
+            b.lines() - 1, b.lastChange().line + random(3));
+        i = next(b.begin(), line);
+
+        switch (random(3))
+        {
+        case 0:
+            b.insert(i, firstLine);
+            break;
+
+        case 1:
+            b.replace(i, thirdLine);
+            break;
+
+        case 2:
+            b.erase(i);
+            break;
+        }
+
+        //only ask every few edits.
+        if (edit % 5 == 4)
+        {
+            ASSERT_EQ(line, b.lastChange().line);
+        }
+    }
+}
+
+/**
+ * Edits far from the ends of a large buffer, with nothing watching, don't walk
+ * the buffer to number the change.
+ */
+TEST_F(BufferTest, largeBufferUnobservedEdits)
+{
+    Buffer::LineList lines(500000, firstLine);
+    b.assign(lines);
+
+    //a quarter of the way in and three quarters, turn about.
+    Buffer::iterator positions[] = {
+        next(b.begin(), 125000), next(b.begin(), 375000)};
+
+    Instrumentation::reset();
+    Instrumentation::enable(true);
+
+    for (int edit = 0; edit < 1000; ++edit)
+    {
+        auto& position = positions[edit % 2];
+
+        b.insert(position, thirdLine);
+        b.replace(prev(position), secondLine);
+    }
+
+    Instrumentation::enable(false);
+    uint64_t walked = Instrumentation::snapshot().counters[COUNTER_LINES_WALKED];
+    Instrumentation::reset();
+
+    EXPECT_EQ(0U, walked);
+    EXPECT_EQ(375999U, b.lastChange().line);
+}
+
+/**
+ * Editing the middle of a large buffer doesn't walk the buffer to report the
+ * change, with or without asynchronous observers.
+ */
+TEST_F(BufferTest, largeBufferEdits)
+{
+    class NullObserver : public AsyncBufferChangeObserver
+    {
+    public:
+        virtual void onBufferChanged(const list<Line>&, const vector<BufferChange>&)
+        {
+        }
+    };
+
+    Buffer::LineList lines(500000, firstLine);
+    b.assign(lines);
+    b.addObserver(make_shared<NullObserver>());
+
+    i = next(b.begin(), 250000);
+    b.replace(i, secondLine);
+    i = next(b.begin(), 250000);
+    b.waitForObservers();
+
+    Instrumentation::reset();
+    Instrumentation::enable(true);
+
+    for (int edit = 0; edit < 1000; ++edit)
+    {
+        b.insert(i, thirdLine);
+        b.erase(prev(i));
+    }
+
+    b.waitForObservers();
+
+    Instrumentation::enable(false);
+    uint64_t walked = Instrumentation::snapshot().counters[COUNTER_LINES_WALKED];
+    Instrumentation::reset();
+
+    //each change is found from the one before, a line or so away, by the
+    //buffer and the observers' copy of it alike.
+    EXPECT_LE(walked, 2U * 2000U);
+    EXPECT_EQ(250000U, b.lastChange().line);
+}
+
+/**
+ * Every change bumps the version, and stamps the lines it inserts.
+ */
+TEST_F(BufferTest, version)
+{
+    uint64_t start = b.version();
+
+    b.append(firstLine);
+    b.append(secondLine);
+    EXPECT_EQ(start + 2, b.version());
+    EXPECT_EQ(start + 1, b.begin()->stamp());
+    EXPECT_EQ(start + 2, next(b.begin())->stamp());
+
+    //a cache built now only needs to revisit lines stamped later.
+    uint64_t cached = b.version();
+
+    b.replace(b.begin(), thirdLine);
+    b.insert(fourthLine);
+    EXPECT_EQ(cached + 2, b.version());
+
+    vector<wstring> changed;
+    for (auto& line : b)
+    {
+        if (line.stamp() > cached)
+            changed.push_back(line.str());
+    }
+
+    EXPECT_EQ(vector<wstring>({fourthLine.str(), thirdLine.str()}), changed);
+
+    //changes which don't touch the contents leave the version alone.
+    b.replace(b.end(), firstLine);
+    b.interning(true);
+    EXPECT_EQ(cached + 2, b.version());
+
+    Buffer::LineList lines{firstLine};
+    b.assign(lines);
+    EXPECT_EQ(cached + 3, b.version());
+    EXPECT_EQ(cached + 3, b.begin()->stamp());
+}
+
+/**
+ * A change token goes stale with the next change, even after the buffer is
+ * gone.
+ */
+TEST_F(BufferTest, changeToken)
+{
+    CancellationToken token;
+
+    {
+        Buffer buffer;
+        token = buffer.changeToken();
+        EXPECT_FALSE(token.cancelled());
+
+        buffer.append(firstLine);
+        EXPECT_TRUE(token.cancelled());
+
+        token = buffer.changeToken();
+    }
+
+    EXPECT_FALSE(token.cancelled());
+}
+
+/**
+ * References to the contents of compressed lines stay good until the next
+ * compressCold.
+ */
+TEST_F(BufferTest, compressColdReferences)
+{
+    for (int n = 0; n < 4; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.compressCold(4);
+    b.waitForCompression();
+
+    const wstring& line = b.begin()->str();
+
+    b.compressCold(4);
+    b.compressCold(4);
+    EXPECT_EQ(L"Line 0", line);
+    EXPECT_TRUE(b.begin()->compressed());
+}
+
+/**
+ * Lines inserted after the first compressCold are compressed by the next,
+ * along with the uncompressed lines next to them.
+ */
+TEST_F(BufferTest, compressColdInserted)
+{
+    for (int n = 0; n < 6; ++n)
+        b.append(Line(L"Line " + to_wstring(n)));
+
+    b.compressCold(4);
+    b.waitForCompression();
+
+    //the two lines left over make a run with the two appended.
+    b.append(Line(L"Line 6"));
+    b.append(Line(L"Line 7"));
+    b.insert(Line(L"Line -1"));
+
+    b.compressCold(4);
+    b.waitForCompression();
+
+    int compressed = 0;
+    for (i = b.begin(); i != b.end(); ++i)
+        compressed += i->compressed() ? 1 : 0;
+    EXPECT_EQ(8, compressed);
+    EXPECT_FALSE(b.begin()->compressed());
+
+    int n = -1;
+    for (i = b.begin(); i != b.end(); ++i, ++n)
+        EXPECT_EQ(L"Line " + to_wstring(n), i->str());
+}
+
+/**
+ * The asynchronous observers' copy of the lines shares their contents with the
+ * buffer's, both for the lines already there and for those inserted since.
+ */
+TEST_F(BufferTest, observersShareLines)
+{
+    class NullObserver : public AsyncBufferChangeObserver
+    {
+    public:
+        virtual void onBufferChanged(const list<Line>&, const vector<BufferChange>&)
+        {
+        }
+    };
+
+    for (int n = 0; n < 100; ++n)
+        b.append(Line(L"A line long enough to be shared " + to_wstring(n)));
+
+    auto observer = make_shared<NullObserver>();
+    b.addObserver(observer);
+
+    b.append(Line(L"A line appended once there are observers"));
+    b.replace(b.begin(), 0, 1, L"The");
+
+    //the editing thread leaves the lines alone until the reader is done.
+    size_t shared = 0;
+    b.readLines([&](const Buffer::LineList& lines) {
+        auto line = b.begin();
+        for (auto& copy : lines)
+            shared += copy.shares(*line++) ? 1 : 0;
+    });
+    b.waitForObservers();
+
+    EXPECT_EQ(101U, shared);
+}
+
+/**
+ * Compressing a buffer with asynchronous observers compresses their copy of
+ * the lines too, into the same blocks, rather than leaving them a copy of
+ * their own.
+ */
+TEST_F(BufferTest, compressColdObserved)
+{
+    class NullObserver : public AsyncBufferChangeObserver
+    {
+    public:
+        virtual void onBufferChanged(const list<Line>&, const vector<BufferChange>&)
+        {
+        }
+    };
+
+    auto observer = make_shared<NullObserver>();
+    b.addObserver(observer);
+
+    for (int n = 0; n < 8; ++n)
+        b.append(Line(L"A line long enough to be shared " + to_wstring(n)));
+
+    b.compressCold(4);
+    b.waitForCompression();
+
+    size_t shared = 0;
+    size_t compressed = 0;
+    b.readLines([&](const Buffer::LineList& lines) {
+        auto line = b.begin();
+        for (auto& copy : lines)
+        {
+            shared += copy.shares(*line++) ? 1 : 0;
+            compressed += copy.compressed() ? 1 : 0;
+        }
+    });
+    b.waitForObservers();
+
+    EXPECT_EQ(8U, shared);
+    EXPECT_EQ(8U, compressed);
+
+    int n = 0;
+    for (i = b.begin(); i != b.end(); ++i, ++n)
+        EXPECT_EQ(L"A line long enough to be shared " + to_wstring(n), i->str());
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include <vix/CancellationToken.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Cancelling a token cancels its copies.
+ */
+TEST(CancellationTokenTest, cancel)
+{
+    CancellationToken token;
+    CancellationToken copy = token;
+
+    EXPECT_FALSE(copy.cancelled());
+
+    token.cancel();
+    EXPECT_TRUE(copy.cancelled());
+}
+
+/**
+ * A token goes stale when its function says so, and stays stale.
+ */
+TEST(CancellationTokenTest, stale)
+{
+    bool stale = false;
+    int asked = 0;
+    CancellationToken token([&] { ++asked; return stale; });
+
+    EXPECT_FALSE(token.cancelled());
+
+    stale = true;
+    EXPECT_TRUE(token.cancelled());
+
+    stale = false;
+    EXPECT_TRUE(token.cancelled());
+    EXPECT_EQ(2, asked);
+}
@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <vix/CommandCoalescer.h>
+#include <vix/EraseTextCommand.h>
+#include <vix/InsertTextCommand.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * An insertion which counts how many times it is applied and reverted.
+     */
+    class CountingInsert : public InsertTextCommand
+    {
+    public:
+        CountingInsert(size_t line, size_t column, const wstring& text, int& applied)
+            : InsertTextCommand(line, column, text), applied_(applied)
+        {
+        }
+
+        virtual void apply(weak_ptr<Buffer> buffer)
+        {
+            ++applied_;
+            InsertTextCommand::apply(buffer);
+        }
+
+        virtual void revert(weak_ptr<Buffer> buffer)
+        {
+            --applied_;
+            InsertTextCommand::revert(buffer);
+        }
+
+    private:
+        int& applied_;
+    };
+}
+
+class CommandCoalescerTest : public ::testing::Test
+{
+protected:
+    shared_ptr<Buffer> buffer;
+    vector<const Command*> sunk;
+    UndoTree::clock::time_point now;
+
+    virtual void SetUp() {
+        buffer = make_shared<Buffer>();
+        buffer->append(Line(L""));
+        buffer->append(Line(L""));
+        now = UndoTree::clock::now();
+    }
+
+    const wstring& line(size_t index) {
+        return next(buffer->begin(), index)->str();
+    }
+
+    /**
+     * Type a string a character at a time, a tenth of a second apart.
+     */
+    void type(CommandCoalescer& coalescer, size_t row, size_t column, const wstring& text) {
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            now += chrono::milliseconds(100);
+            coalescer.apply(
+                make_shared<InsertTextCommand>(row, column + i, text.substr(i, 1)),
+                now);
+        }
+    }
+
+    CommandCoalescer::Sink sink() {
+        return [this](const Command& command) { sunk.push_back(&command); };
+    }
+};
+
+/**
+ * Typing becomes a single undo step and a single journal record.
+ */
+TEST_F(CommandCoalescerTest, typing)
+{
+    UndoTree tree(buffer);
+
+    {
+        CommandCoalescer coalescer(tree, sink());
+        type(coalescer, 0, 0, L"Hello, world");
+
+        EXPECT_EQ(L"Hello, world", line(0));
+        EXPECT_EQ(2U, tree.size());
+        EXPECT_TRUE(sunk.empty());
+    }
+
+    ASSERT_EQ(1U, sunk.size());
+    EXPECT_EQ(L"Hello, world", dynamic_cast<const InsertTextCommand*>(sunk[0])->text());
+
+    tree.undo();
+    EXPECT_EQ(L"", line(0));
+    tree.redo();
+    EXPECT_EQ(L"Hello, world", line(0));
+}
+
+/**
+ * Correcting a typo with backspace stays in the same undo step.
+ */
+TEST_F(CommandCoalescerTest, corrections)
+{
+    UndoTree tree(buffer);
+    CommandCoalescer coalescer(tree, sink());
+
+    type(coalescer, 0, 0, L"helo");
+    coalescer.apply(make_shared<EraseTextCommand>(0, 3, 1), now);
+    coalescer.apply(make_shared<EraseTextCommand>(0, 2, 1), now);
+    type(coalescer, 0, 2, L"llo");
+
+    EXPECT_EQ(L"hello", line(0));
+    EXPECT_EQ(2U, tree.size());
+
+    coalescer.boundary();
+    tree.undo();
+    EXPECT_EQ(L"", line(0));
+}
+
+/**
+ * Boundaries, pauses and edits elsewhere each start a new undo step.
+ */
+TEST_F(CommandCoalescerTest, boundaries)
+{
+    UndoTree tree(buffer);
+    CommandCoalescer coalescer(tree, sink());
+
+    type(coalescer, 0, 0, L"one");
+    coalescer.boundary();
+    EXPECT_EQ(1U, sunk.size());
+    EXPECT_FALSE(coalescer.open());
+
+    type(coalescer, 0, 3, L" two");
+    now += CommandCoalescer::DEFAULT_TIMEOUT;
+    type(coalescer, 0, 7, L" three");
+    type(coalescer, 1, 0, L"four");
+
+    EXPECT_EQ(L"one two three", line(0));
+    EXPECT_EQ(L"four", line(1));
+    EXPECT_EQ(5U, tree.size());
+    EXPECT_EQ(3U, sunk.size());
+
+    coalescer.boundary();
+    while (tree.undo())
+        ;
+
+    EXPECT_EQ(L"", line(0));
+    EXPECT_EQ(L"", line(1));
+}
+
+/**
+ * A command which doesn't merge into the open command is applied once, and
+ * never taken back.
+ */
+TEST_F(CommandCoalescerTest, appliedOnce)
+{
+    UndoTree tree(buffer);
+    CommandCoalescer coalescer(tree, sink());
+    int applied = 0;
+
+    type(coalescer, 0, 0, L"one");
+    coalescer.apply(make_shared<CountingInsert>(1, 0, L"two", applied), now);
+    coalescer.apply(make_shared<CountingInsert>(1, 3, L"!", applied), now);
+
+    EXPECT_EQ(2, applied);
+    EXPECT_EQ(L"one", line(0));
+    EXPECT_EQ(L"two!", line(1));
+    EXPECT_EQ(3U, tree.size());
+}
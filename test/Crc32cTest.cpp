@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <vix/Crc32c.h>
+
+#include <string>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * crc32c matches the standard check value.
+ */
+TEST(Crc32cTest, checkValue)
+{
+    const string CHECK{"123456789"};
+
+    EXPECT_EQ(0xE3069283U, crc32c(CHECK.data(), CHECK.size()));
+}
+
+/**
+ * The checksum of nothing is zero.
+ */
+TEST(Crc32cTest, empty)
+{
+    EXPECT_EQ(0U, crc32c(nullptr, 0));
+}
+
+/**
+ * A checksum computed in pieces matches the checksum computed at once,
+ * whatever the alignment of the pieces.
+ */
+TEST(Crc32cTest, incremental)
+{
+    string data;
+    for (int i = 0; i < 1000; ++i)
+        data.push_back((char)(i * 31));
+
+    uint32_t expected = crc32c(data.data(), data.size());
+
+    for (size_t split = 0; split < 20; ++split)
+    {
+        uint32_t crc = crc32c(data.data(), split);
+        crc = crc32c(data.data() + split, data.size() - split, crc);
+
+        EXPECT_EQ(expected, crc);
+    }
+}
+
+/**
+ * crc32c matches a bit at a time reference implementation for every length
+ * and alignment around the word sizes, whichever implementation is in use.
+ */
+TEST(Crc32cTest, reference)
+{
+    auto reference = [](const uint8_t* p, size_t size) {
+        uint32_t crc = ~0U;
+        while (size--)
+        {
+            crc ^= *p++;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc >> 1) ^ (0x82F63B78 & (~(crc & 1) + 1));
+        }
+
+        return ~crc;
+    };
+
+    uint8_t data[80];
+    for (size_t i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(i * 131 + 7);
+
+    for (size_t offset = 0; offset < 8; ++offset)
+    {
+        for (size_t size = 0; size + offset <= sizeof(data); ++size)
+        {
+            EXPECT_EQ(
+                reference(data + offset, size),
+                crc32c(data + offset, size));
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <vix/EditTrace.h>
+
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    EditEvent event(
+        EditEventType type, uint64_t delay, size_t line, size_t column,
+        size_t count = 0, const wstring& text = wstring())
+    {
+        EditEvent e;
+        e.type = type;
+        e.delay = delay;
+        e.line = line;
+        e.column = column;
+        e.count = count;
+        e.text = text;
+
+        return e;
+    }
+}
+
+/**
+ * A trace reads back exactly as it was written.
+ */
+TEST(EditTraceTest, serialize)
+{
+    EditTrace trace(1000);
+
+    trace.append(event(EDIT_MOVE, 0, 500, 3));
+    trace.append(event(EDIT_TYPE, 120000, 500, 3, 0, L"héllo 世界"));
+    trace.append(event(EDIT_ERASE, 90000, 500, 9, 2));
+    trace.append(event(EDIT_SEARCH, 2000000, 500, 9, 0, L"needle"));
+    trace.append(event(EDIT_PASTE, 300000, 12, 0, 0, wstring(100000, L'x')));
+    trace.append(event(EDIT_UNDO, 1, 0, 0));
+    trace.append(event(EDIT_REDO, 1, 0, 0));
+
+    stringstream stream;
+    trace.serialWrite(stream);
+
+    EditTrace copy;
+    copy.serialRead(stream);
+
+    EXPECT_EQ(1000U, copy.lines());
+    EXPECT_EQ(trace.events(), copy.events());
+}
+
+/**
+ * Typing costs a few bytes a keystroke.
+ */
+TEST(EditTraceTest, compact)
+{
+    EditTrace trace(100000);
+
+    for (size_t i = 0; i < 1000; ++i)
+        trace.append(event(EDIT_TYPE, 100000, 50000, i, 0, L"a"));
+
+    stringstream stream;
+    trace.serialWrite(stream);
+
+    EXPECT_GT(12000U, stream.str().size());
+}
+
+/**
+ * Anything which isn't a trace is rejected.
+ */
+TEST(EditTraceTest, malformed)
+{
+    EditTrace trace(10);
+    trace.append(event(EDIT_TYPE, 0, 1, 2, 0, L"text"));
+
+    stringstream stream;
+    trace.serialWrite(stream);
+    string bytes = stream.str();
+
+    EditTrace copy;
+
+    //wrong magic number.
+    stringstream notTrace("VIXS\x00\x01");
+    EXPECT_THROW(copy.serialRead(notTrace), exception::SerialRead);
+
+    //unknown version.
+    string newer = bytes;
+    newer[5] = 2;
+    stringstream newerStream(newer);
+    EXPECT_THROW(copy.serialRead(newerStream), exception::SerialRead);
+
+    //unknown kind of event, just after the header and two counts.
+    string unknown = bytes;
+    unknown[8] = EDIT_EVENT_TYPES;
+    stringstream unknownStream(unknown);
+    EXPECT_THROW(copy.serialRead(unknownStream), exception::SerialRead);
+
+    //cut short.
+    stringstream truncated(bytes.substr(0, bytes.size() - 2));
+    EXPECT_THROW(copy.serialRead(truncated), exception::SerialRead);
+
+    EXPECT_EQ(0U, copy.lines());
+    EXPECT_TRUE(copy.events().empty());
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include <vix/EraseTextCommand.h>
+
+#include <sstream>
+
+using namespace std;
+using namespace vix;
+
+class EraseTextCommandTest : public ::testing::Test
+{
+protected:
+    shared_ptr<Buffer> buffer;
+
+    virtual void SetUp() {
+        buffer = make_shared<Buffer>();
+        buffer->append(Line(L"abcdefgh"));
+    }
+
+    const wstring& line() {
+        return buffer->begin()->str();
+    }
+};
+
+/**
+ * Applying erases the text, and reverting puts it back.
+ */
+TEST_F(EraseTextCommandTest, applyRevert)
+{
+    EraseTextCommand command(0, 2, 3);
+
+    command.apply(buffer);
+    EXPECT_EQ(L"abfgh", line());
+    EXPECT_EQ(L"cde", command.text());
+
+    command.revert(buffer);
+    EXPECT_EQ(L"abcdefgh", line());
+}
+
+/**
+ * Erasing past the end of the line throws.
+ */
+TEST_F(EraseTextCommandTest, range)
+{
+    EraseTextCommand command(0, 6, 3);
+    EXPECT_THROW(command.apply(buffer), vix::exception::CommandRange);
+    EXPECT_EQ(L"abcdefgh", line());
+
+    EraseTextCommand row(1, 0, 1);
+    EXPECT_THROW(row.apply(buffer), vix::exception::CommandRange);
+}
+
+/**
+ * Backspacing merges erasures before the text.
+ */
+TEST_F(EraseTextCommandTest, mergeBackspace)
+{
+    EraseTextCommand command(0, 5, 1);
+    command.apply(buffer);
+
+    for (size_t column = 4; column >= 2; --column)
+    {
+        EraseTextCommand backspace(0, column, 1);
+        backspace.apply(buffer);
+        EXPECT_TRUE(command.merge(backspace));
+    }
+
+    EXPECT_EQ(L"abgh", line());
+    EXPECT_EQ(L"cdef", command.text());
+    EXPECT_EQ(2U, command.column());
+    EXPECT_EQ(4U, command.length());
+
+    command.revert(buffer);
+    EXPECT_EQ(L"abcdefgh", line());
+}
+
+/**
+ * Deleting merges erasures after the text.
+ */
+TEST_F(EraseTextCommandTest, mergeDelete)
+{
+    EraseTextCommand command(0, 1, 1);
+    command.apply(buffer);
+
+    EraseTextCommand del(0, 1, 2);
+    del.apply(buffer);
+    EXPECT_TRUE(command.merge(del));
+
+    EXPECT_EQ(L"aefgh", line());
+    EXPECT_EQ(L"bcd", command.text());
+
+    EraseTextCommand elsewhere(0, 3, 1);
+    EXPECT_FALSE(command.merge(elsewhere));
+
+    command.revert(buffer);
+    EXPECT_EQ(L"abcdefgh", line());
+}
+
+/**
+ * A command round trips through serialization, keeping the erased text so it
+ * can still be reverted.
+ */
+TEST_F(EraseTextCommandTest, serialization)
+{
+    EraseTextCommand command(0, 2, 3);
+    command.apply(buffer);
+
+    stringstream ss;
+    command.serialWrite(ss);
+
+    EraseTextCommand read;
+    read.serialRead(ss);
+
+    EXPECT_EQ(0U, read.line());
+    EXPECT_EQ(2U, read.column());
+    EXPECT_EQ(3U, read.length());
+    EXPECT_EQ(L"cde", read.text());
+
+    read.revert(buffer);
+    EXPECT_EQ(L"abcdefgh", line());
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <vix/FileFollower.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+class FileFollowerTest : public TemporaryFileTest
+{
+protected:
+    virtual void TearDown() {
+        unlink((path + ".1").c_str());
+    }
+
+    /**
+     * Append to the file, as a logger would.
+     */
+    void write(const string& text) {
+        ofstream(path, ios::binary | ios::app) << text;
+    }
+};
+
+/**
+ * Lines are appended as they end, each poll's lines in a single change.
+ */
+TEST_F(FileFollowerTest, append)
+{
+    write("one\ntw");
+
+    Buffer buffer;
+    FileFollower follower(path, buffer);
+
+    EXPECT_EQ(1U, follower.poll());
+    EXPECT_EQ((vector<wstring>{L"one"}), bufferLines(buffer));
+    EXPECT_EQ(1U, buffer.version());
+
+    write("o\nthree\nfour\n");
+    EXPECT_TRUE(follower.wait(1000));
+
+    EXPECT_EQ(3U, follower.poll());
+    EXPECT_EQ(
+        (vector<wstring>{L"one", L"two", L"three", L"four"}),
+        bufferLines(buffer));
+    EXPECT_EQ(2U, buffer.version());
+    EXPECT_EQ(19U, follower.offset());
+
+    //nothing new, so no change and nothing to wake for.
+    EXPECT_EQ(0U, follower.poll());
+    EXPECT_EQ(2U, buffer.version());
+    EXPECT_FALSE(follower.wait(0));
+}
+
+/**
+ * A poll reads no more than it is allowed, and says when it is behind.
+ */
+TEST_F(FileFollowerTest, behind)
+{
+    string text;
+    for (int i = 0; i < 1000; ++i)
+        text += "line " + to_string(i) + "\n";
+
+    write(text);
+
+    Buffer buffer;
+    FileFollower follower(path, buffer);
+    size_t polls = 0;
+
+    do
+    {
+        follower.poll(1000);
+        ++polls;
+    }
+    while (follower.behind());
+
+    EXPECT_EQ((text.size() + 999) / 1000, polls);
+    ASSERT_EQ(1000U, buffer.lines());
+    EXPECT_EQ(L"line 999", buffer.rbegin()->str());
+}
+
+/**
+ * Carriage returns are dropped if the first line ends in one, and sequences
+ * split between writes are decoded whole.
+ */
+TEST_F(FileFollowerTest, encoding)
+{
+    write("caf\xC3");
+
+    Buffer buffer;
+    FileFollower follower(path, buffer);
+
+    EXPECT_EQ(0U, follower.poll());
+
+    write("\xA9\r\nb\r\n");
+    follower.poll();
+
+    EXPECT_EQ((vector<wstring>{L"café", L"b"}), bufferLines(buffer));
+    EXPECT_EQ(LINE_ENDING_CRLF, follower.ending());
+    EXPECT_TRUE(follower.utf8());
+
+    write("\xFF\n");
+    follower.poll();
+
+    EXPECT_FALSE(follower.utf8());
+}
+
+/**
+ * A file truncated in place replaces the contents of the buffer.
+ */
+TEST_F(FileFollowerTest, truncate)
+{
+    write("one\ntwo\n");
+
+    Buffer buffer;
+    FileFollower follower(path, buffer);
+    follower.poll();
+
+    ofstream(path, ios::binary | ios::trunc) << "new\n";
+
+    EXPECT_EQ(1U, follower.poll());
+    EXPECT_EQ((vector<wstring>{L"new"}), bufferLines(buffer));
+    EXPECT_EQ(4U, follower.offset());
+}
+
+/**
+ * A rotated file is read to its end, then the new file is followed.
+ */
+TEST_F(FileFollowerTest, rotate)
+{
+    write("one\n");
+
+    Buffer buffer;
+    FileFollower follower(path, buffer);
+    follower.poll();
+
+    //the logger finishes with the old file after it has been moved.
+    ofstream old(path, ios::binary | ios::app);
+    ASSERT_EQ(0, rename(path.c_str(), (path + ".1").c_str()));
+    old << "two\nunfinished";
+    old.close();
+
+    follower.poll();
+    EXPECT_EQ((vector<wstring>{L"one", L"two"}), bufferLines(buffer));
+
+    write("three\n");
+    EXPECT_TRUE(follower.wait(1000));
+
+    EXPECT_EQ(2U, follower.poll());
+    EXPECT_EQ(
+        (vector<wstring>{L"one", L"two", L"unfinished", L"three"}),
+        bufferLines(buffer));
+    EXPECT_EQ(6U, follower.offset());
+}
+
+/**
+ * A file which doesn't exist can't be followed.
+ */
+TEST_F(FileFollowerTest, missing)
+{
+    Buffer buffer;
+
+    EXPECT_THROW(FileFollower(path + ".missing", buffer), exception::FileOpen);
+}
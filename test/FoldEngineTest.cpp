@@ -0,0 +1,501 @@
+#include <gtest/gtest.h>
+#include <vix/Buffer.h>
+#include <vix/FoldEngine.h>
+#include <vix/Instrumentation.h>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Fill a buffer with the given number of lines.
+     */
+    void fill(Buffer& buffer, size_t lines)
+    {
+        Buffer::LineList list;
+        for (size_t i = 0; i < lines; ++i)
+            list.push_back(Line(to_wstring(i)));
+
+        buffer.append(list);
+    }
+
+    /**
+     * Create an engine observing a buffer.
+     */
+    shared_ptr<FoldEngine> observe(Buffer& buffer)
+    {
+        auto engine = make_shared<FoldEngine>(buffer);
+        buffer.addObserver(engine);
+
+        return engine;
+    }
+
+    /**
+     * Returns true if a fold comes before another, outermost first.
+     */
+    bool before(const Fold& a, const Fold& b)
+    {
+        return a.first < b.first || (a.first == b.first && a.last > b.last);
+    }
+
+    /**
+     * Check an engine's mapping against the given folds.
+     */
+    void expectRows(const FoldEngine& engine, const vector<Fold>& folds)
+    {
+        size_t rows = 0;
+
+        for (size_t i = 0; i < engine.lines(); ++i)
+        {
+            bool hidden = any_of(folds.begin(), folds.end(), [&](const Fold& f) {
+                return f.closed && f.first < i && i <= f.last;
+            });
+
+            EXPECT_EQ(hidden, engine.hidden(i)) << "line " << i;
+
+            if (!hidden)
+            {
+                EXPECT_EQ(rows, engine.row(i)) << "line " << i;
+                EXPECT_EQ(i, engine.line(rows)) << "row " << rows;
+                ++rows;
+            }
+            else
+            {
+                EXPECT_EQ(rows - 1, engine.row(i)) << "line " << i;
+            }
+        }
+
+        EXPECT_EQ(rows, engine.rows());
+    }
+
+    /**
+     * Move folds for lines inserted, the plain way.
+     */
+    void insertLines(vector<Fold>& folds, size_t line, size_t count)
+    {
+        for (auto& fold : folds)
+        {
+            if (fold.first >= line)
+                fold.first += count;
+
+            if (fold.last >= line)
+                fold.last += count;
+        }
+    }
+
+    /**
+     * Move folds for lines erased, the plain way.
+     */
+    void eraseLines(vector<Fold>& folds, size_t line, size_t count)
+    {
+        vector<Fold> kept;
+        vector<Fold> cut;
+
+        for (auto fold : folds)
+        {
+            if (fold.first >= line && fold.first < line + count)
+                continue;
+
+            if (fold.first >= line + count)
+            {
+                fold.first -= count;
+                fold.last -= count;
+            }
+            else if (fold.last >= line + count)
+            {
+                fold.last -= count;
+            }
+            else if (fold.last >= line)
+            {
+                cut.push_back(fold);
+                continue;
+            }
+
+            kept.push_back(fold);
+        }
+
+        sort(cut.begin(), cut.end(), before);
+
+        for (auto fold : cut)
+        {
+            fold.last = line - 1;
+
+            bool exists = any_of(kept.begin(), kept.end(), [&](const Fold& f) {
+                return f.first == fold.first && f.last == fold.last;
+            });
+
+            if (fold.first < fold.last && !exists)
+                kept.push_back(fold);
+        }
+
+        sort(kept.begin(), kept.end(), before);
+        folds.swap(kept);
+    }
+}
+
+/**
+ * A closed fold is displayed as its first line.
+ */
+TEST(FoldEngineTest, add)
+{
+    Buffer buffer;
+    fill(buffer, 10);
+    auto engine = observe(buffer);
+
+    engine->add(2, 5);
+    engine->add(3, 4, false);
+
+    EXPECT_EQ(2U, engine->size());
+    EXPECT_EQ(7U, engine->rows());
+    EXPECT_FALSE(engine->hidden(2));
+    EXPECT_TRUE(engine->hidden(3));
+    EXPECT_EQ(2U, engine->row(5));
+    EXPECT_EQ(3U, engine->row(6));
+    EXPECT_EQ(6U, engine->line(3));
+
+    vector<Fold> expected{{2, 5, true}, {3, 4, false}};
+    EXPECT_EQ(expected, engine->folds());
+
+    Fold fold;
+    ASSERT_TRUE(engine->find(4, fold));
+    EXPECT_EQ((Fold{3, 4, false}), fold);
+    ASSERT_TRUE(engine->find(5, fold));
+    EXPECT_EQ((Fold{2, 5, true}), fold);
+    EXPECT_FALSE(engine->find(6, fold));
+}
+
+/**
+ * Folds must cover two lines of the buffer, and nest.
+ */
+TEST(FoldEngineTest, invalid)
+{
+    Buffer buffer;
+    fill(buffer, 10);
+    auto engine = observe(buffer);
+
+    engine->add(2, 6);
+
+    EXPECT_THROW(engine->add(3, 3), exception::FoldRange);
+    EXPECT_THROW(engine->add(5, 10), exception::FoldRange);
+    EXPECT_THROW(engine->add(2, 6), exception::FoldOverlap);
+    EXPECT_THROW(engine->add(4, 8), exception::FoldOverlap);
+    EXPECT_THROW(engine->add(0, 3), exception::FoldOverlap);
+
+    //sharing an end is nesting.
+    engine->add(2, 4);
+    engine->add(5, 6);
+    engine->add(0, 6);
+    EXPECT_EQ(4U, engine->size());
+}
+
+/**
+ * zo opens the outermost closed fold, zc closes the innermost open one.
+ */
+TEST(FoldEngineTest, openClose)
+{
+    Buffer buffer;
+    fill(buffer, 10);
+    auto engine = observe(buffer);
+
+    engine->add(1, 8);
+    engine->add(2, 6);
+    engine->add(3, 4);
+
+    ASSERT_TRUE(engine->open(4));
+    EXPECT_FALSE(engine->hidden(2));
+    EXPECT_TRUE(engine->hidden(3));
+
+    ASSERT_TRUE(engine->open(4));
+    ASSERT_TRUE(engine->open(4));
+    EXPECT_FALSE(engine->open(4));
+    EXPECT_EQ(10U, engine->rows());
+
+    ASSERT_TRUE(engine->close(5));
+    EXPECT_TRUE(engine->hidden(5));
+    EXPECT_FALSE(engine->hidden(2));
+
+    ASSERT_TRUE(engine->remove(5));
+    EXPECT_EQ(10U, engine->rows());
+    EXPECT_EQ(2U, engine->size());
+
+    engine->close(4);
+    engine->clear();
+    EXPECT_EQ(0U, engine->size());
+    EXPECT_EQ(10U, engine->rows());
+}
+
+/**
+ * Folds follow lines inserted and erased in the buffer.
+ */
+TEST(FoldEngineTest, edits)
+{
+    Buffer buffer;
+    fill(buffer, 10);
+    auto engine = observe(buffer);
+
+    engine->add(2, 5);
+    engine->add(7, 8);
+
+    //inside a fold, it grows.
+    buffer.insert(next(buffer.begin(), 4), Line(L"new"));
+    vector<Fold> expected{{2, 6, true}, {8, 9, true}};
+    EXPECT_EQ(expected, engine->folds());
+
+    //before its first line, it moves.
+    buffer.insert(next(buffer.begin(), 2), Line(L"new"));
+    expected = {{3, 7, true}, {9, 10, true}};
+    EXPECT_EQ(expected, engine->folds());
+    expectRows(*engine, expected);
+
+    //replacing a line leaves it be.
+    buffer.replace(next(buffer.begin(), 3), Line(L"replaced"));
+    EXPECT_EQ(expected, engine->folds());
+
+    //erasing its last line shrinks it, its first takes it away.
+    buffer.erase(next(buffer.begin(), 7));
+    buffer.erase(next(buffer.begin(), 8));
+    expected = {{3, 6, true}};
+    EXPECT_EQ(expected, engine->folds());
+    expectRows(*engine, expected);
+
+    buffer.clear();
+    EXPECT_EQ(0U, engine->size());
+    EXPECT_EQ(0U, engine->rows());
+}
+
+/**
+ * Editing the middle of a large, heavily folded buffer keeps every fold in
+ * place, and the engine never has the buffer walked to find an edit.  How
+ * long the edits take is measured by BM_FoldEngineEdit in vixbench.
+ */
+TEST(FoldEngineTest, largeBufferEdits)
+{
+    Buffer buffer;
+    fill(buffer, 500000);
+    auto engine = observe(buffer);
+
+    //a fold every ten lines, as in a deeply nested YAML file.
+    for (size_t first = 0; first + 5 < 500000; first += 10)
+        engine->add(first, first + 5);
+
+    auto middle = next(buffer.begin(), 250003);
+
+    //the first edit is found by walking from the nearer end of the buffer.
+    buffer.insert(middle, Line(L"new"));
+    buffer.erase(prev(middle));
+
+    Instrumentation::reset();
+    Instrumentation::enable(true);
+
+    for (int edit = 0; edit < 2000; ++edit)
+    {
+        buffer.insert(middle, Line(L"new"));
+        buffer.erase(prev(middle));
+    }
+
+    Instrumentation::enable(false);
+    uint64_t walked = Instrumentation::snapshot().counters[COUNTER_LINES_WALKED];
+    Instrumentation::reset();
+
+    //each edit is found from the one before, a line away.
+    EXPECT_LE(walked, 2U * 4000U);
+    EXPECT_EQ(50000U, engine->size());
+    EXPECT_EQ(500000U - 50000U * 5, engine->rows());
+    EXPECT_EQ(250000U - 25000U * 5, engine->row(250000));
+    EXPECT_EQ(250000U - 25000U * 5 + 1, engine->row(250006));
+}
+
+/**
+ * Random edits agree with folds moved the plain way.
+ */
+TEST(FoldEngineTest, random)
+{
+    mt19937 rng(40);
+    Buffer buffer;
+    fill(buffer, 60);
+    auto engine = observe(buffer);
+    vector<Fold> folds;
+
+    for (int step = 0; step < 1500; ++step)
+    {
+        size_t size = buffer.lines();
+        size_t line = size ? rng() % size : 0;
+
+        switch (rng() % 6)
+        {
+        case 0:
+        case 1:
+        {
+            size_t last = line + 1 + rng() % 10;
+            Fold fold{line, last, rng() % 3 != 0};
+
+            try
+            {
+                engine->add(fold.first, fold.last, fold.closed);
+                folds.push_back(fold);
+                sort(folds.begin(), folds.end(), before);
+            }
+            catch (exception::Fold&)
+            {
+            }
+
+            break;
+        }
+
+        case 2:
+            if (size < 200)
+            {
+                buffer.insert(next(buffer.begin(), line), Line(L"new"));
+                insertLines(folds, line, 1);
+            }
+
+            break;
+
+        case 3:
+            if (size > 0)
+            {
+                buffer.erase(next(buffer.begin(), line));
+                eraseLines(folds, line, 1);
+            }
+
+            break;
+
+        case 4:
+        {
+            Fold fold;
+            if (engine->find(line, fold))
+            {
+                auto found = find_if(folds.begin(), folds.end(), [&](const Fold& f) {
+                    return f.first == fold.first && f.last == fold.last;
+                });
+
+                ASSERT_NE(folds.end(), found);
+
+                if (fold.closed)
+                {
+                    engine->remove(line);
+                    folds.erase(found);
+                }
+                else
+                {
+                    engine->close(line);
+                    found->closed = true;
+                }
+            }
+
+            break;
+        }
+
+        default:
+        {
+            //assigning fewer lines is taken as erasing lines from the end.
+            Buffer::LineList lines(buffer.begin(), buffer.end());
+            size_t count = min<size_t>(1 + rng() % 8, size - line);
+
+            lines.erase(next(lines.begin(), line), next(lines.begin(), line + count));
+            buffer.assign(lines);
+            eraseLines(folds, size - count, count);
+            break;
+        }
+        }
+
+        ASSERT_EQ(folds, engine->folds()) << "step " << step;
+        ASSERT_EQ(buffer.lines(), engine->lines());
+
+        if (step % 50 == 0)
+            expectRows(*engine, folds);
+    }
+
+    expectRows(*engine, folds);
+}
+
+/**
+ * Indent folds follow the indent of each line, with blank lines taking the
+ * lower level either side.
+ */
+TEST(FoldEngineTest, indentFolds)
+{
+    list<Line> lines{
+        Line(L"a:"),
+        Line(L"  b:"),
+        Line(L"      c: 1"),
+        Line(L"      d: 2"),
+        Line(L""),
+        Line(L"  e: 3"),
+        Line(L"f:"),
+        Line(L"  g: 4"),
+    };
+
+    vector<Fold> expected{{1, 5, true}, {2, 3, true}};
+    EXPECT_EQ(expected, indentFolds(lines, 2));
+
+    //a tab is as wide as the tab stop.
+    list<Line> tabbed{
+        Line(L"a"),
+        Line(L"    b"),
+        Line(L"\tc"),
+        Line(L"\td"),
+        Line(L"e"),
+    };
+
+    expected = {{1, 3, true}};
+    EXPECT_EQ(expected, indentFolds(tabbed, 4, 4));
+
+    expected = {{1, 3, true}, {2, 3, true}};
+    EXPECT_EQ(expected, indentFolds(tabbed, 4, 8));
+
+    //a cancelled token gives up.
+    CancellationToken token;
+    token.cancel();
+    EXPECT_TRUE(indentFolds(lines, 2, 8, token).empty());
+}
+
+/**
+ * Indent folds are computed in the background, and only installed if the
+ * buffer hasn't changed since.
+ */
+TEST(FoldEngineTest, computeIndentFolds)
+{
+    Buffer buffer;
+    Buffer::LineList lines;
+    for (size_t i = 0; i < 50000; ++i)
+    {
+        lines.push_back(Line(L"key:"));
+        lines.push_back(Line(L"  value: 1"));
+        lines.push_back(Line(L"  other: 2"));
+    }
+
+    buffer.append(lines);
+    auto engine = observe(buffer);
+
+    EXPECT_FALSE(engine->poll());
+
+    engine->computeIndentFolds(2);
+    engine->wait();
+    ASSERT_TRUE(engine->poll());
+
+    EXPECT_EQ(50000U, engine->size());
+    EXPECT_EQ(100000U, engine->rows());
+    EXPECT_EQ(3U, engine->line(2));
+    EXPECT_FALSE(engine->poll());
+
+    //an open fold stays open when recomputed.
+    engine->open(1);
+    engine->computeIndentFolds(2);
+    engine->wait();
+    ASSERT_TRUE(engine->poll());
+    EXPECT_EQ(100001U, engine->rows());
+
+    //folds computed for an older version are thrown away.
+    engine->computeIndentFolds(2);
+    buffer.erase(buffer.begin());
+    engine->wait();
+    EXPECT_FALSE(engine->poll());
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <vix/EraseTextCommand.h>
+#include <vix/InsertTextCommand.h>
+
+#include <sstream>
+
+using namespace std;
+using namespace vix;
+
+class InsertTextCommandTest : public ::testing::Test
+{
+protected:
+    shared_ptr<Buffer> buffer;
+
+    virtual void SetUp() {
+        buffer = make_shared<Buffer>();
+        buffer->append(Line(L"first"));
+        buffer->append(Line(L"second"));
+    }
+
+    const wstring& line(size_t index) {
+        return next(buffer->begin(), index)->str();
+    }
+};
+
+/**
+ * Applying inserts the text, and reverting removes it.
+ */
+TEST_F(InsertTextCommandTest, applyRevert)
+{
+    InsertTextCommand command(1, 3, L"XYZ");
+
+    command.apply(buffer);
+    EXPECT_EQ(L"secXYZond", line(1));
+    EXPECT_EQ(L"first", line(0));
+
+    command.revert(buffer);
+    EXPECT_EQ(L"second", line(1));
+}
+
+/**
+ * Text can be inserted at the end of a line, but not beyond it.
+ */
+TEST_F(InsertTextCommandTest, range)
+{
+    InsertTextCommand end(0, 5, L"!");
+    end.apply(buffer);
+    EXPECT_EQ(L"first!", line(0));
+
+    InsertTextCommand column(0, 7, L"!");
+    EXPECT_THROW(column.apply(buffer), vix::exception::CommandRange);
+
+    InsertTextCommand row(2, 0, L"!");
+    EXPECT_THROW(row.apply(buffer), vix::exception::CommandRange);
+}
+
+/**
+ * Insertions straight after the text merge, others don't.
+ */
+TEST_F(InsertTextCommandTest, mergeInsert)
+{
+    InsertTextCommand command(0, 1, L"a");
+
+    EXPECT_TRUE(command.merge(InsertTextCommand(0, 2, L"bc")));
+    EXPECT_TRUE(command.merge(InsertTextCommand(0, 4, L"d")));
+    EXPECT_EQ(L"abcd", command.text());
+
+    EXPECT_FALSE(command.merge(InsertTextCommand(0, 4, L"e")));
+    EXPECT_FALSE(command.merge(InsertTextCommand(1, 5, L"e")));
+    EXPECT_EQ(L"abcd", command.text());
+}
+
+/**
+ * Whether a command merges is known before it is applied.
+ */
+TEST_F(InsertTextCommandTest, canMerge)
+{
+    InsertTextCommand command(0, 1, L"ab");
+
+    EXPECT_TRUE(command.canMerge(InsertTextCommand(0, 3, L"c")));
+    EXPECT_TRUE(command.canMerge(EraseTextCommand(0, 2, 1)));
+
+    EXPECT_FALSE(command.canMerge(InsertTextCommand(0, 2, L"c")));
+    EXPECT_FALSE(command.canMerge(InsertTextCommand(1, 3, L"c")));
+    EXPECT_FALSE(command.canMerge(EraseTextCommand(0, 0, 3)));
+    EXPECT_EQ(L"ab", command.text());
+}
+
+/**
+ * Erasing the end of the inserted text shortens it.
+ */
+TEST_F(InsertTextCommandTest, mergeErase)
+{
+    InsertTextCommand command(0, 0, L"typo");
+    command.apply(buffer);
+
+    EraseTextCommand backspace(0, 3, 1);
+    backspace.apply(buffer);
+    EXPECT_TRUE(command.merge(backspace));
+    EXPECT_EQ(L"typ", command.text());
+
+    //erasing more than was inserted doesn't merge.
+    EraseTextCommand tooFar(0, 0, 4);
+    EXPECT_FALSE(command.merge(tooFar));
+
+    command.revert(buffer);
+    EXPECT_EQ(L"first", line(0));
+}
+
+/**
+ * A command round trips through serialization, including text outside the
+ * Basic Multilingual Plane.
+ */
+TEST_F(InsertTextCommandTest, serialization)
+{
+    InsertTextCommand command(300, 70000, L"café \U0001F600");
+
+    stringstream ss;
+    command.serialWrite(ss);
+
+    InsertTextCommand read;
+    read.serialRead(ss);
+
+    EXPECT_EQ(300U, read.line());
+    EXPECT_EQ(70000U, read.column());
+    EXPECT_EQ(command.text(), read.text());
+
+    //two varints of two and three bytes, a length and ten bytes of UTF-8.
+    EXPECT_EQ(2U + 3U + 1U + 10U, ss.str().size());
+}
@@ -0,0 +1,385 @@
+#include <gtest/gtest.h>
+#include <vix/Buffer.h>
+#include <vix/BufferSnapshot.h>
+#include <vix/Instrumentation.h>
+#include <vix/Journal.h>
+#include <vix/JournalScanner.h>
+
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    class FastObserver : public BufferChangeObserver
+    {
+    public:
+        virtual void onBufferChanged(const Buffer*)
+        {
+        }
+    };
+
+    class NamedObserver : public BufferChangeObserver
+    {
+    public:
+        explicit NamedObserver(const string& name) : name_(name)
+        {
+        }
+
+        virtual void onBufferChanged(const Buffer*)
+        {
+        }
+
+        virtual string instrumentationName() const
+        {
+            return name_;
+        }
+
+    private:
+        string name_;
+    };
+
+    class SlowObserver : public BufferChangeObserver
+    {
+    public:
+        virtual void onBufferChanged(const Buffer*)
+        {
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+    };
+
+    class Record : public Serializable
+    {
+    public:
+        virtual void serialRead(istream&)
+        {
+        }
+
+        virtual void serialWrite(ostream& out) const
+        {
+            out << "payload";
+        }
+    };
+}
+
+class InstrumentationTest : public ::testing::Test
+{
+protected:
+    virtual void SetUp() {
+        Instrumentation::reset();
+        Instrumentation::enable(true);
+    }
+
+    virtual void TearDown() {
+        Instrumentation::enable(false);
+        Instrumentation::reset();
+    }
+};
+
+/**
+ * Nothing is recorded while instrumentation is off.
+ */
+TEST_F(InstrumentationTest, disabled)
+{
+    Instrumentation::enable(false);
+
+    Buffer buffer;
+    buffer.append(Line(L"line"));
+    Instrumentation::count(COUNTER_JOURNAL_RECORDS_WRITTEN);
+
+    auto snapshot = Instrumentation::snapshot();
+
+    EXPECT_EQ(0U, snapshot.counters[COUNTER_JOURNAL_RECORDS_WRITTEN]);
+    EXPECT_EQ(0U, snapshot.timers[TIMER_BUFFER_APPEND].count);
+    EXPECT_TRUE(snapshot.observers.empty());
+}
+
+/**
+ * Each buffer mutator is timed, as is the dispatch to observers.
+ */
+TEST_F(InstrumentationTest, bufferTimers)
+{
+    Buffer buffer;
+    buffer.append(Line(L"one"));
+    buffer.append(Line(L"two"));
+    buffer.insert(Line(L"zero"));
+    buffer.replace(buffer.begin(), Line(L"nought"));
+    buffer.erase(buffer.begin());
+
+    Buffer::LineList lines{Line(L"a"), Line(L"b")};
+    buffer.assign(lines);
+    buffer.clear();
+
+    auto snapshot = Instrumentation::snapshot();
+
+    EXPECT_EQ(1U, snapshot.timers[TIMER_BUFFER_INSERT].count);
+    EXPECT_EQ(2U, snapshot.timers[TIMER_BUFFER_APPEND].count);
+    EXPECT_EQ(1U, snapshot.timers[TIMER_BUFFER_REPLACE].count);
+    EXPECT_EQ(1U, snapshot.timers[TIMER_BUFFER_ERASE].count);
+    EXPECT_EQ(1U, snapshot.timers[TIMER_BUFFER_ASSIGN].count);
+    EXPECT_EQ(1U, snapshot.timers[TIMER_BUFFER_CLEAR].count);
+    EXPECT_EQ(7U, snapshot.timers[TIMER_BUFFER_NOTIFY].count);
+
+    Instrumentation::reset();
+
+    EXPECT_EQ(0U, Instrumentation::snapshot().timers[TIMER_BUFFER_APPEND].count);
+}
+
+/**
+ * Each observer is timed separately, so a slow one stands out.
+ */
+TEST_F(InstrumentationTest, observers)
+{
+    auto fast = make_shared<FastObserver>();
+    auto slow = make_shared<SlowObserver>();
+
+    Buffer buffer;
+    buffer.addObserver(fast);
+    buffer.addObserver(slow);
+
+    for (int i = 0; i < 3; ++i)
+        buffer.append(Line(L"line"));
+
+    auto snapshot = Instrumentation::snapshot();
+    ASSERT_EQ(2U, snapshot.observers.size());
+
+    const LatencyStatistics* fastLatency = nullptr;
+    const LatencyStatistics* slowLatency = nullptr;
+
+    for (const auto& observer : snapshot.observers)
+    {
+        if (observer.first.find("FastObserver") != string::npos)
+            fastLatency = &observer.second;
+        else if (observer.first.find("SlowObserver") != string::npos)
+            slowLatency = &observer.second;
+    }
+
+    ASSERT_TRUE(fastLatency);
+    ASSERT_TRUE(slowLatency);
+
+    EXPECT_EQ(3U, fastLatency->count);
+    EXPECT_EQ(3U, slowLatency->count);
+    EXPECT_LE(2000000U, slowLatency->percentile(0.5));
+    EXPECT_GT(slowLatency->total, fastLatency->total);
+    EXPECT_LE(slowLatency->total, snapshot.timers[TIMER_BUFFER_NOTIFY].total);
+}
+
+/**
+ * Observers of one class are told apart, and an observer can name itself.
+ */
+TEST_F(InstrumentationTest, observerInstances)
+{
+    auto first = make_shared<FastObserver>();
+    auto second = make_shared<FastObserver>();
+    auto named = make_shared<NamedObserver>("highlight");
+
+    Buffer buffer;
+    buffer.addObserver(first);
+    buffer.addObserver(second);
+    buffer.addObserver(named);
+    buffer.append(Line(L"line"));
+
+    auto snapshot = Instrumentation::snapshot();
+    ASSERT_EQ(3U, snapshot.observers.size());
+
+    size_t fast = 0;
+    size_t highlight = 0;
+
+    for (const auto& observer : snapshot.observers)
+    {
+        EXPECT_EQ(1U, observer.second.count);
+        fast += observer.first.find("FastObserver [") != string::npos;
+        highlight += observer.first.compare(0, 11, "highlight [") == 0;
+    }
+
+    EXPECT_EQ(2U, fast);
+    EXPECT_EQ(1U, highlight);
+}
+
+/**
+ * A reset forgets the observers seen so far, so new ones are told apart
+ * rather than counted as "(other)".
+ */
+TEST_F(InstrumentationTest, observerReset)
+{
+    //every observer is kept, so none is made at a gone one's address.
+    vector<shared_ptr<NamedObserver>> observers;
+
+    for (int round = 0; round < 3; ++round)
+    {
+        Buffer buffer;
+
+        for (int i = 0; i < 40; ++i)
+        {
+            observers.push_back(make_shared<NamedObserver>("observer"));
+            buffer.addObserver(observers.back());
+        }
+
+        buffer.append(Line(L"line"));
+
+        auto snapshot = Instrumentation::snapshot();
+
+        EXPECT_EQ(40U, snapshot.observers.size()) << round;
+        EXPECT_EQ(0U, snapshot.observers.count("(other)")) << round;
+
+        Instrumentation::reset();
+    }
+}
+
+/**
+ * Journal records and snapshots are counted as they are written and read.
+ */
+TEST_F(InstrumentationTest, serialization)
+{
+    stringstream journal;
+    writeJournalHeader(journal);
+
+    size_t frames = writeJournalRecord(journal, 1, Record());
+    frames += writeJournalRecord(journal, 2, "xyz", 3);
+
+    string data = journal.str();
+    JournalScanner scanner(data.data(), data.size());
+    JournalRecord record;
+
+    while (scanner.next(record))
+    {
+    }
+
+    Buffer buffer;
+    buffer.append(Line(L"snapshot"));
+
+    stringstream snapshotStream;
+    writeBufferSnapshot(snapshotStream, buffer);
+    size_t snapshotSize = snapshotStream.str().size();
+
+    Buffer copy;
+    readBufferSnapshot(snapshotStream, copy);
+
+    string snapshotData = snapshotStream.str();
+    readBufferSnapshot(snapshotData.data(), snapshotData.size(), copy);
+
+    auto snapshot = Instrumentation::snapshot();
+
+    EXPECT_EQ(2U, snapshot.counters[COUNTER_JOURNAL_RECORDS_WRITTEN]);
+    EXPECT_EQ(frames, snapshot.counters[COUNTER_JOURNAL_BYTES_WRITTEN]);
+    EXPECT_EQ(2U, snapshot.counters[COUNTER_JOURNAL_RECORDS_READ]);
+    EXPECT_EQ(frames, snapshot.counters[COUNTER_JOURNAL_BYTES_READ]);
+    EXPECT_EQ(1U, snapshot.counters[COUNTER_SNAPSHOTS_WRITTEN]);
+    EXPECT_EQ(snapshotSize, snapshot.counters[COUNTER_SNAPSHOT_BYTES_WRITTEN]);
+    EXPECT_EQ(2U, snapshot.counters[COUNTER_SNAPSHOTS_READ]);
+    EXPECT_EQ(2 * snapshotSize, snapshot.counters[COUNTER_SNAPSHOT_BYTES_READ]);
+}
+
+/**
+ * What other threads record is gathered up, even once they have finished.
+ */
+TEST_F(InstrumentationTest, threads)
+{
+    thread worker([] {
+        Buffer buffer;
+        buffer.append(Line(L"line"));
+        Instrumentation::count(COUNTER_JOURNAL_RECORDS_READ, 5);
+    });
+
+    worker.join();
+
+    Instrumentation::count(COUNTER_JOURNAL_RECORDS_READ, 2);
+
+    auto snapshot = Instrumentation::snapshot();
+
+    EXPECT_EQ(7U, snapshot.counters[COUNTER_JOURNAL_RECORDS_READ]);
+    EXPECT_EQ(1U, snapshot.timers[TIMER_BUFFER_APPEND].count);
+
+    Instrumentation::reset();
+
+    EXPECT_EQ(0U, Instrumentation::snapshot().counters[COUNTER_JOURNAL_RECORDS_READ]);
+}
+
+/**
+ * Percentiles are within a bucket of the true latency.
+ */
+TEST_F(InstrumentationTest, percentile)
+{
+    LatencyStatistics empty;
+    EXPECT_EQ(0U, empty.percentile(0.5));
+
+    for (uint64_t i = 1; i <= 1000; ++i)
+        Instrumentation::record(TIMER_BUFFER_INSERT, i * 1000);
+
+    auto latency = Instrumentation::snapshot().timers[TIMER_BUFFER_INSERT];
+
+    EXPECT_EQ(1000U, latency.count);
+    EXPECT_EQ(1000000U, latency.max);
+    EXPECT_EQ(500500000U, latency.total);
+
+    uint64_t p50 = latency.percentile(0.5);
+    EXPECT_LE(500000U, p50);
+    EXPECT_GE(500000U * 5 / 4, p50);
+
+    uint64_t p99 = latency.percentile(0.99);
+    EXPECT_LE(990000U, p99);
+    EXPECT_GE(1000000U, p99);
+}
+
+/**
+ * Statistics recorded directly count latencies in the same buckets as the
+ * timers.
+ */
+TEST_F(InstrumentationTest, record)
+{
+    LatencyStatistics latency;
+
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        latency.record(i * 1000);
+        Instrumentation::record(TIMER_BUFFER_INSERT, i * 1000);
+    }
+
+    auto timer = Instrumentation::snapshot().timers[TIMER_BUFFER_INSERT];
+
+    EXPECT_EQ(timer.count, latency.count);
+    EXPECT_EQ(timer.total, latency.total);
+    EXPECT_EQ(timer.max, latency.max);
+    EXPECT_EQ(timer.buckets, latency.buckets);
+    EXPECT_DOUBLE_EQ(500500.0, latency.mean());
+    EXPECT_EQ(0.0, LatencyStatistics().mean());
+
+    //every latency is at most the top of its bucket.
+    for (uint64_t value : {0ULL, 3ULL, 4ULL, 1000ULL, 123456789ULL})
+        EXPECT_LE(value, LatencyStatistics::bucketTop(LatencyStatistics::bucketOf(value)));
+}
+
+/**
+ * A snapshot can be written as JSON and as text.
+ */
+TEST_F(InstrumentationTest, exportSnapshot)
+{
+    auto observer = make_shared<FastObserver>();
+
+    Buffer buffer;
+    buffer.addObserver(observer);
+    buffer.append(Line(L"line"));
+    Instrumentation::count(COUNTER_JOURNAL_RECORDS_WRITTEN, 3);
+
+    auto snapshot = Instrumentation::snapshot();
+
+    ostringstream json;
+    snapshot.writeJson(json);
+
+    EXPECT_NE(string::npos, json.str().find("\"journal_records_written\": 3"));
+    EXPECT_NE(string::npos, json.str().find("\"buffer_append\": {\"count\": 1,"));
+    EXPECT_NE(string::npos, json.str().find("FastObserver ["));
+    EXPECT_NE(string::npos, json.str().find("]\": {\"count\": 1,"));
+
+    ostringstream text;
+    snapshot.writeText(text);
+
+    EXPECT_NE(string::npos, text.str().find("journal_records_written"));
+    EXPECT_NE(string::npos, text.str().find("buffer_append"));
+    EXPECT_NE(string::npos, text.str().find("FastObserver"));
+}
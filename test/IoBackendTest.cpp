@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <vix/IoBackend.h>
+
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+class IoBackendTest : public TemporaryFileTest
+{
+protected:
+    int fd;
+
+    virtual void SetUp() {
+        fd = open(path.c_str(), O_RDWR);
+        ASSERT_GE(fd, 0);
+    }
+
+    virtual void TearDown() {
+        close(fd);
+    }
+
+    /**
+     * Returns the fastest backend, or the blocking one.
+     */
+    static unique_ptr<IoBackend> backend(bool blocking, size_t buffers, size_t bufferSize) {
+        return blocking
+            ? IoBackend::blocking(buffers, bufferSize)
+            : IoBackend::create(buffers, bufferSize);
+    }
+};
+
+/**
+ * Writes queued together land where they were asked to, and read back the
+ * same.
+ */
+TEST_F(IoBackendTest, writeRead)
+{
+    const size_t BUFFER_SIZE = 4096;
+
+    for (bool blocking : {false, true})
+    {
+        auto io = backend(blocking, 4, BUFFER_SIZE);
+
+        ASSERT_EQ(4U, io->buffers());
+        ASSERT_EQ(BUFFER_SIZE, io->bufferSize());
+
+        //the blocks go out of order, all in one batch.
+        for (size_t i = 0; i < io->buffers(); ++i)
+        {
+            memset(io->buffer(i), 'a' + i, BUFFER_SIZE);
+            io->write(fd, i, BUFFER_SIZE, (3 - i) * BUFFER_SIZE);
+        }
+
+        io->submit();
+
+        for (size_t i = 0; i < io->buffers(); ++i)
+            EXPECT_EQ(BUFFER_SIZE, io->wait(i));
+
+        for (size_t i = 0; i < io->buffers(); ++i)
+            io->read(fd, i, BUFFER_SIZE, i * BUFFER_SIZE);
+
+        for (size_t i = 0; i < io->buffers(); ++i)
+        {
+            ASSERT_EQ(BUFFER_SIZE, io->wait(i));
+
+            vector<char> expected(BUFFER_SIZE, 'd' - i);
+            EXPECT_EQ(0, memcmp(expected.data(), io->buffer(i), BUFFER_SIZE))
+                << i << (blocking ? " blocking" : "");
+        }
+    }
+}
+
+/**
+ * A read falls short at the end of the file.
+ */
+TEST_F(IoBackendTest, endOfFile)
+{
+    ASSERT_EQ(5, ::write(fd, "hello", 5));
+
+    for (bool blocking : {false, true})
+    {
+        auto io = backend(blocking, 1, 64);
+
+        io->read(fd, 0, 64, 2);
+        ASSERT_EQ(3U, io->wait(0));
+        EXPECT_EQ("llo", string(io->buffer(0), 3));
+
+        io->read(fd, 0, 64, 5);
+        EXPECT_EQ(0U, io->wait(0));
+    }
+}
+
+/**
+ * A failed read or write is reported when it is waited for.
+ */
+TEST_F(IoBackendTest, failure)
+{
+    int readOnly = open(path.c_str(), O_RDONLY);
+    int writeOnly = open(path.c_str(), O_WRONLY);
+    ASSERT_GE(readOnly, 0);
+    ASSERT_GE(writeOnly, 0);
+
+    for (bool blocking : {false, true})
+    {
+        auto io = backend(blocking, 2, 64);
+
+        io->write(readOnly, 0, 64, 0);
+        EXPECT_THROW(io->wait(0), exception::FileWrite);
+
+        io->read(writeOnly, 1, 64, 0);
+        EXPECT_THROW(io->wait(1), exception::FileRead);
+    }
+
+    close(readOnly);
+    close(writeOnly);
+}
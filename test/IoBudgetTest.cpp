@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include <vix/IoBudget.h>
+
+#include <chrono>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Time how long it takes to consume the given amount in pieces.
+     */
+    double secondsToConsume(IoBudget& budget, uint64_t bytes, uint64_t piece)
+    {
+        auto start = chrono::steady_clock::now();
+
+        for (uint64_t consumed = 0; consumed < bytes; consumed += piece)
+            budget.consume(piece);
+
+        return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+/**
+ * An unlimited budget never blocks.
+ */
+TEST(IoBudgetTest, unlimited)
+{
+    IoBudget budget;
+
+    EXPECT_EQ(0U, budget.rate());
+    EXPECT_LT(secondsToConsume(budget, 1ULL << 40, 1ULL << 30), 0.1);
+}
+
+/**
+ * A burst is allowed straight away.
+ */
+TEST(IoBudgetTest, burst)
+{
+    IoBudget budget(1000, 100000);
+
+    EXPECT_LT(secondsToConsume(budget, 100000, 10000), 0.1);
+}
+
+/**
+ * Beyond the burst, writes are held to the rate.
+ */
+TEST(IoBudgetTest, rate)
+{
+    IoBudget budget(1000000, 10000);
+
+    EXPECT_EQ(1000000U, budget.rate());
+
+    //200 KB at 1 MB/s, less the burst, takes at least 0.19s.
+    EXPECT_GE(secondsToConsume(budget, 200000, 10000), 0.18);
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <vix/IoOutputStream.h>
+
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * A backend whose writes only ever manage half of what they are given.
+     */
+    class ShortBackend : public IoBackend
+    {
+    public:
+        ShortBackend() : IoBackend(2, 64), size_(0)
+        {
+        }
+
+        virtual void read(int, size_t, size_t, uint64_t)
+        {
+        }
+
+        virtual void write(int, size_t, size_t size, uint64_t)
+        {
+            size_ = size;
+        }
+
+        virtual void submit()
+        {
+        }
+
+        virtual size_t wait(size_t)
+        {
+            return size_ / 2;
+        }
+
+        virtual bool asynchronous() const
+        {
+            return false;
+        }
+
+    private:
+        size_t size_;
+    };
+}
+
+class IoOutputStreamTest : public TemporaryFileTest
+{
+protected:
+    int fd;
+
+    virtual void SetUp() {
+        fd = open(path.c_str(), O_RDWR);
+        ASSERT_GE(fd, 0);
+    }
+
+    virtual void TearDown() {
+        close(fd);
+    }
+
+    /**
+     * Returns the contents of the file.
+     */
+    string contents() {
+        ifstream in(path, ios::binary);
+        ostringstream out;
+        out << in.rdbuf();
+
+        return out.str();
+    }
+};
+
+/**
+ * Everything written goes to the file in order, across many buffers.
+ */
+TEST_F(IoOutputStreamTest, write)
+{
+    string expected;
+
+    for (size_t buffers : {1, 2, 3})
+    {
+        expected.clear();
+        ASSERT_EQ(0, ftruncate(fd, 0));
+
+        {
+            IoOutputStream out(fd, 0, IoBackend::create(buffers, 100));
+
+            for (int i = 0; i < 1000; ++i)
+            {
+                string piece = to_string(i) + (i % 7 == 0 ? string(250, 'x') : " ");
+
+                out << piece;
+                expected += piece;
+            }
+
+            EXPECT_EQ(expected.size(), out.offset());
+            ASSERT_TRUE(out.flush());
+        }
+
+        EXPECT_EQ(expected, contents()) << buffers << " buffers";
+    }
+}
+
+/**
+ * Writing starts at the given offset, and the destructor writes out whatever
+ * is left.
+ */
+TEST_F(IoOutputStreamTest, offset)
+{
+    ASSERT_EQ(6, ::write(fd, "start ", 6));
+
+    {
+        IoOutputStream out(fd, 6, IoBackend::blocking());
+        out << "end";
+    }
+
+    EXPECT_EQ("start end", contents());
+}
+
+/**
+ * A failed write makes the stream bad.
+ */
+TEST_F(IoOutputStreamTest, failure)
+{
+    int readOnly = open(path.c_str(), O_RDONLY);
+    ASSERT_GE(readOnly, 0);
+
+    IoOutputStream out(readOnly, 0);
+    out << "text";
+
+    EXPECT_FALSE(out.flush());
+
+    close(readOnly);
+}
+
+/**
+ * A write which falls short without an error makes the stream bad.
+ */
+TEST_F(IoOutputStreamTest, shortWrite)
+{
+    IoOutputStream out(fd, 0, unique_ptr<IoBackend>(new ShortBackend));
+    out << "text";
+
+    EXPECT_FALSE(out.flush());
+}
@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+#include <vix/Journal.h>
+#include <vix/JournalCheckpoint.h>
+#include <vix/JournalCheckpointer.h>
+#include <vix/MappedFile.h>
+#include <vix/SerialVarint.h>
+
+#include <future>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * A record appending a line to a buffer, standing in for a Command.
+     */
+    class AppendRecord : virtual public Serializable
+    {
+    public:
+        string text;
+
+        AppendRecord(const string& text = string()) : text(text) { }
+
+        void apply(Buffer& buffer) const
+        {
+            buffer.append(Line(wstring(text.begin(), text.end())));
+        }
+
+        virtual void serialRead(istream& in) { serialReadCompact(in, text); }
+
+        virtual void serialWrite(ostream& out) const { serialWriteCompact(out, text); }
+    };
+
+    /**
+     * Returns true if a file exists.
+     */
+    bool exists(const string& path)
+    {
+        return access(path.c_str(), F_OK) == 0;
+    }
+}
+
+class JournalCheckpointerTest : public TemporaryFileTest
+{
+protected:
+    Buffer buffer;
+
+    virtual void TearDown() {
+        unlink((path + ".compact").c_str());
+        for (uint64_t sequence = 1; sequence < 10; ++sequence)
+        {
+            unlink(checkpointSnapshotPath(path, sequence).c_str());
+            unlink((path + ".archive." + to_string(sequence)).c_str());
+        }
+    }
+
+    /**
+     * Edit the buffer, journaling each edit.
+     */
+    void edit(JournalCheckpointer& journal, int first, int last) {
+        for (int i = first; i < last; ++i)
+        {
+            AppendRecord record("line " + to_string(i));
+            record.apply(buffer);
+            journal.append(record);
+        }
+    }
+
+    /**
+     * Load the journal into a fresh buffer.
+     */
+    JournalRecovery load(Buffer& loaded) {
+        return loadJournal(path, loaded, [&](const JournalRecord& record) {
+            AppendRecord value;
+            readJournalRecord(record, value);
+            value.apply(loaded);
+        });
+    }
+};
+
+/**
+ * Without a checkpoint, loading replays the whole journal.
+ */
+TEST_F(JournalCheckpointerTest, noCheckpoint)
+{
+    {
+        JournalCheckpointer journal(path);
+        edit(journal, 0, 10);
+    }
+
+    Buffer loaded;
+    EXPECT_EQ(10U, load(loaded).records);
+    EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+}
+
+/**
+ * After a checkpoint, loading restores the snapshot and replays only the
+ * records after it, and the journal is compacted down to those records.
+ */
+TEST_F(JournalCheckpointerTest, checkpoint)
+{
+    {
+        JournalCheckpointer journal(path);
+        edit(journal, 0, 100);
+        journal.checkpoint(buffer);
+        edit(journal, 100, 105);
+        journal.wait();
+        edit(journal, 105, 110);
+    }
+
+    EXPECT_TRUE(exists(checkpointSnapshotPath(path, 1)));
+
+    Buffer loaded;
+    EXPECT_EQ(10U, load(loaded).records);
+    EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+
+    //the compacted journal holds the checkpoint and the last ten records.
+    size_t frame = JOURNAL_FRAME_HEADER_SIZE + 1 + string("line 100").size();
+    EXPECT_EQ(
+        JOURNAL_HEADER_SIZE + JOURNAL_FRAME_HEADER_SIZE
+      + JournalCheckpoint::SERIAL_SIZE + 10 * frame,
+        MappedFile(path).size());
+}
+
+/**
+ * Each checkpoint replaces the previous snapshot, and the snapshot numbering
+ * carries on across sessions.
+ */
+TEST_F(JournalCheckpointerTest, repeatedCheckpoints)
+{
+    {
+        JournalCheckpointer journal(path);
+        edit(journal, 0, 10);
+        journal.checkpoint(buffer);
+        journal.wait();
+        edit(journal, 10, 20);
+        journal.checkpoint(buffer);
+        journal.wait();
+    }
+
+    EXPECT_FALSE(exists(checkpointSnapshotPath(path, 1)));
+    EXPECT_TRUE(exists(checkpointSnapshotPath(path, 2)));
+
+    {
+        Buffer loaded;
+        EXPECT_EQ(0U, load(loaded).records);
+        EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+    }
+
+    {
+        JournalCheckpointer journal(path);
+        edit(journal, 20, 30);
+        journal.checkpoint(buffer);
+        journal.wait();
+    }
+
+    EXPECT_FALSE(exists(checkpointSnapshotPath(path, 2)));
+    EXPECT_TRUE(exists(checkpointSnapshotPath(path, 3)));
+
+    Buffer loaded;
+    load(loaded);
+    EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+}
+
+/**
+ * Checkpoints requested while another is running stay consistent with the
+ * journal, whichever order the background work happens in.
+ */
+TEST_F(JournalCheckpointerTest, overlappingCheckpoints)
+{
+    {
+        JournalCheckpointer journal(path);
+
+        for (int round = 0; round < 20; ++round)
+        {
+            edit(journal, round * 50, round * 50 + 50);
+            journal.checkpoint(buffer);
+        }
+
+        edit(journal, 1000, 1010);
+    }
+
+    Buffer loaded;
+    load(loaded);
+    EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+}
+
+/**
+ * Archiving keeps the replaced journal and the snapshot it refers to.
+ */
+TEST_F(JournalCheckpointerTest, archive)
+{
+    {
+        JournalCheckpointer journal(path, 0, true);
+        edit(journal, 0, 10);
+        journal.checkpoint(buffer);
+        journal.wait();
+        edit(journal, 10, 20);
+        journal.checkpoint(buffer);
+        journal.wait();
+
+        EXPECT_EQ(path + ".archive.2", journal.archivePath(2));
+    }
+
+    EXPECT_TRUE(exists(path + ".archive.1"));
+    EXPECT_TRUE(exists(path + ".archive.2"));
+    EXPECT_TRUE(exists(checkpointSnapshotPath(path, 1)));
+
+    Buffer loaded;
+    load(loaded);
+    EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+}
+
+/**
+ * A budgeted checkpoint is handed off to the checkpointer's scheduler rather
+ * than written by the editing thread.  How long the background work takes
+ * within its budget is measured by BM_JournalCheckpoint in vixbench.
+ */
+TEST_F(JournalCheckpointerTest, budget)
+{
+    TaskScheduler scheduler(1);
+    promise<void> started;
+    promise<void> released;
+    shared_future<void> release = released.get_future().share();
+
+    //hold the scheduler's only thread, so no background work can start.
+    scheduler.submit([&started, release] {
+        started.set_value();
+        release.wait();
+    });
+    started.get_future().wait();
+
+    JournalCheckpointer journal(path, 50000, false, scheduler);
+    edit(journal, 0, 5000);
+
+    journal.checkpoint(buffer);
+
+    EXPECT_FALSE(exists(checkpointSnapshotPath(path, 1)));
+
+    released.set_value();
+    journal.wait();
+
+    EXPECT_TRUE(exists(checkpointSnapshotPath(path, 1)));
+
+    Buffer loaded;
+    load(loaded);
+    EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+}
+
+/**
+ * Appending while a checkpoint is in flight never waits for the background
+ * writes, and the records appended meanwhile survive compaction.
+ * How long appends take while a checkpoint runs is measured by
+ * BM_JournalAppendDuringCheckpoint in vixbench.
+ */
+TEST_F(JournalCheckpointerTest, appendDuringCompaction)
+{
+    TaskScheduler scheduler(1);
+    promise<void> started;
+    promise<void> released;
+    shared_future<void> release = released.get_future().share();
+
+    //hold the scheduler's only thread, so the snapshot and compaction can't
+    //start until the appends are made.
+    scheduler.submit([&started, release] {
+        started.set_value();
+        release.wait();
+    });
+    started.get_future().wait();
+
+    JournalCheckpointer journal(path, 0, false, scheduler);
+    edit(journal, 0, 1000);
+
+    journal.checkpoint(buffer);
+    edit(journal, 1000, 2000);
+
+    EXPECT_FALSE(exists(checkpointSnapshotPath(path, 1)));
+
+    released.set_value();
+    journal.wait();
+    journal.flush();
+
+    EXPECT_TRUE(exists(checkpointSnapshotPath(path, 1)));
+
+    Buffer loaded;
+    EXPECT_EQ(1000U, load(loaded).records);
+    EXPECT_EQ(bufferLines(buffer), bufferLines(loaded));
+}
+
+/**
+ * A checkpoint's snapshot going missing is reported on load.
+ */
+TEST_F(JournalCheckpointerTest, missingSnapshot)
+{
+    {
+        JournalCheckpointer journal(path);
+        edit(journal, 0, 10);
+        journal.checkpoint(buffer);
+        journal.wait();
+    }
+
+    unlink(checkpointSnapshotPath(path, 1).c_str());
+
+    Buffer loaded;
+    EXPECT_THROW(load(loaded), vix::exception::FileOpen);
+}
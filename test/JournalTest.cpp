@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+#include <vix/Journal.h>
+#include <vix/JournalScanner.h>
+#include <vix/JournalWriter.h>
+#include <vix/MappedFile.h>
+#include <vix/SerialVarint.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * A serializable string, standing in for a Command.
+     */
+    class TestRecord : virtual public Serializable
+    {
+    public:
+        string text;
+
+        TestRecord(const string& text = string()) : text(text) { }
+
+        virtual void serialRead(istream& in) { serialReadCompact(in, text); }
+
+        virtual void serialWrite(ostream& out) const { serialWriteCompact(out, text); }
+    };
+}
+
+class JournalTest : public TemporaryFileTest
+{
+protected:
+    /**
+     * Write a journal holding the given strings, and return the size of the
+     * journal after each record.
+     */
+    vector<uint64_t> writeJournal(const vector<string>& texts) {
+        JournalWriter writer(path);
+        vector<uint64_t> sizes;
+
+        for (auto& text : texts)
+        {
+            writer.append(JOURNAL_COMMAND, TestRecord(text));
+            sizes.push_back(writer.size());
+        }
+
+        writer.flush();
+
+        return sizes;
+    }
+
+    /**
+     * Recover the journal, returning the replayed strings.
+     */
+    vector<string> recover(JournalRecovery& recovery) {
+        vector<string> texts;
+
+        recovery = recoverJournal(path, [&](const JournalRecord& record) {
+            EXPECT_EQ(JOURNAL_COMMAND, record.type);
+
+            TestRecord value;
+            readJournalRecord(record, value);
+            texts.push_back(value.text);
+        });
+
+        return texts;
+    }
+
+    /**
+     * Overwrite a byte of the journal.
+     */
+    void corrupt(uint64_t offset) {
+        fstream file(path, ios::binary | ios::in | ios::out);
+        file.seekg(offset);
+        char c = (char)file.get();
+        file.seekp(offset);
+        file.put(c ^ 0x40);
+    }
+};
+
+/**
+ * Records written to a journal are replayed in order.
+ */
+TEST_F(JournalTest, roundTrip)
+{
+    const vector<string> TEXTS{"first", "", "third record", string(100000, 'x')};
+
+    vector<uint64_t> sizes = writeJournal(TEXTS);
+
+    JournalRecovery recovery;
+    EXPECT_EQ(TEXTS, recover(recovery));
+    EXPECT_EQ(TEXTS.size(), recovery.records);
+    EXPECT_EQ(sizes.back(), recovery.size);
+    EXPECT_EQ(0U, recovery.discarded);
+}
+
+/**
+ * Reopening a journal appends to it.
+ */
+TEST_F(JournalTest, append)
+{
+    writeJournal({"a", "b"});
+    writeJournal({"c"});
+
+    JournalRecovery recovery;
+    EXPECT_EQ(vector<string>({"a", "b", "c"}), recover(recovery));
+}
+
+/**
+ * An empty file is an empty journal, and a journal with only a header holds
+ * no records.
+ */
+TEST_F(JournalTest, empty)
+{
+    JournalRecovery recovery;
+    EXPECT_TRUE(recover(recovery).empty());
+    EXPECT_EQ(0U, recovery.size);
+
+    writeJournal({});
+    EXPECT_TRUE(recover(recovery).empty());
+    EXPECT_EQ(JOURNAL_HEADER_SIZE, recovery.size);
+}
+
+/**
+ * A torn final record is cut off, keeping every record before it, and the
+ * journal can be appended to afterwards.
+ */
+TEST_F(JournalTest, tornTail)
+{
+    vector<uint64_t> sizes = writeJournal({"one", "two", "three"});
+
+    //tear the last record at every possible point.
+    for (uint64_t size = sizes[2] - 1; size > sizes[1]; --size)
+    {
+        ASSERT_EQ(0, truncate(path.c_str(), size));
+
+        JournalRecovery recovery;
+        EXPECT_EQ(vector<string>({"one", "two"}), recover(recovery));
+        EXPECT_EQ(sizes[1], recovery.size);
+        EXPECT_EQ(size - sizes[1], recovery.discarded);
+        EXPECT_EQ((off_t)sizes[1], MappedFile(path).size());
+    }
+
+    writeJournal({"four"});
+
+    JournalRecovery recovery;
+    EXPECT_EQ(vector<string>({"one", "two", "four"}), recover(recovery));
+}
+
+/**
+ * A corrupt record stops recovery, keeping every record before it.
+ */
+TEST_F(JournalTest, corruptRecord)
+{
+    vector<uint64_t> sizes = writeJournal({"one", "two", "three"});
+
+    //corrupt the payload, the type, the length and the checksum in turn.
+    for (uint64_t offset : {sizes[1] - 1, sizes[0] + 8, sizes[0] + 6, sizes[0]})
+    {
+        ASSERT_EQ(0, truncate(path.c_str(), 0));
+        sizes = writeJournal({"one", "two", "three"});
+        corrupt(offset);
+
+        JournalRecovery recovery;
+        EXPECT_EQ(vector<string>({"one"}), recover(recovery));
+        EXPECT_EQ(sizes[0], recovery.size);
+        EXPECT_EQ(sizes[2] - sizes[0], recovery.discarded);
+    }
+}
+
+/**
+ * A zero filled tail, as left by some file systems after a crash, is not
+ * mistaken for records.
+ */
+TEST_F(JournalTest, zeroTail)
+{
+    vector<uint64_t> sizes = writeJournal({"one"});
+
+    ofstream(path, ios::binary | ios::app) << string(64, '\0');
+
+    JournalRecovery recovery;
+    EXPECT_EQ(vector<string>({"one"}), recover(recovery));
+    EXPECT_EQ(sizes[0], recovery.size);
+    EXPECT_EQ(64U, recovery.discarded);
+}
+
+/**
+ * A torn header leaves an empty journal.
+ */
+TEST_F(JournalTest, tornHeader)
+{
+    writeJournal({});
+    ASSERT_EQ(0, truncate(path.c_str(), 3));
+
+    JournalRecovery recovery;
+    EXPECT_TRUE(recover(recovery).empty());
+    EXPECT_EQ(0U, recovery.size);
+    EXPECT_EQ(3U, recovery.discarded);
+
+    writeJournal({"one"});
+    EXPECT_EQ(vector<string>({"one"}), recover(recovery));
+}
+
+/**
+ * A file which isn't a journal is left alone.
+ */
+TEST_F(JournalTest, notAJournal)
+{
+    const string CONTENTS{"This is not a journal."};
+    ofstream(path, ios::binary) << CONTENTS;
+
+    JournalRecovery recovery;
+    EXPECT_THROW(recover(recovery), vix::exception::SerialRead);
+    EXPECT_EQ(CONTENTS.size(), MappedFile(path).size());
+}
+
+/**
+ * The scanner reports each record's type, offset and payload.
+ */
+TEST_F(JournalTest, scanner)
+{
+    const string PAYLOAD{"payload"};
+
+    {
+        JournalWriter writer(path);
+        writer.append(7, PAYLOAD.data(), PAYLOAD.size());
+        writer.append(8, nullptr, 0);
+    }
+
+    MappedFile file(path);
+    JournalScanner scanner(file.data(), file.size());
+    JournalRecord record;
+
+    ASSERT_TRUE(scanner.next(record));
+    EXPECT_EQ(7, record.type);
+    EXPECT_EQ(JOURNAL_HEADER_SIZE, record.offset);
+    EXPECT_EQ(PAYLOAD, string(record.payload.data(), record.payload.size()));
+
+    ASSERT_TRUE(scanner.next(record));
+    EXPECT_EQ(8, record.type);
+    EXPECT_EQ(JOURNAL_HEADER_SIZE + JOURNAL_FRAME_HEADER_SIZE + PAYLOAD.size(), record.offset);
+    EXPECT_TRUE(record.payload.empty());
+
+    EXPECT_FALSE(scanner.next(record));
+    EXPECT_FALSE(scanner.corrupt());
+    EXPECT_EQ(file.size(), scanner.position());
+}
+
+/**
+ * The scanner can continue from a record's offset, but not from outside the
+ * journal.
+ */
+TEST_F(JournalTest, scannerPosition)
+{
+    writeJournal({"one", "two", "three"});
+
+    MappedFile file(path);
+    JournalScanner scanner(file.data(), file.size());
+    JournalRecord first;
+    JournalRecord second;
+
+    ASSERT_TRUE(scanner.next(first));
+    ASSERT_TRUE(scanner.next(second));
+
+    scanner.position(second.offset);
+
+    JournalRecord record;
+    ASSERT_TRUE(scanner.next(record));
+    EXPECT_EQ(second.offset, record.offset);
+
+    scanner.position(file.size());
+    EXPECT_FALSE(scanner.next(record));
+    EXPECT_FALSE(scanner.corrupt());
+
+    EXPECT_THROW(scanner.position(file.size() + 1), vix::exception::SerialRead);
+    EXPECT_THROW(scanner.position(0), vix::exception::SerialRead);
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include <vix/LineBlock.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+class LineBlockTest : public ::testing::Test
+{
+protected:
+    shared_ptr<LineBlock> block;
+
+    virtual void SetUp() {
+        vector<wstring> contents{L"First Line", L"", L"Third Line"};
+
+        block = make_shared<LineBlock>(contents);
+        block->compress();
+    }
+};
+
+/**
+ * A block holds each of the lines it was created with, and can be read while
+ * it is being compressed.
+ */
+TEST_F(LineBlockTest, lines)
+{
+    ASSERT_EQ(3U, block->lines());
+    EXPECT_TRUE(block->compressed());
+    EXPECT_TRUE(block->decompressed());
+
+    EXPECT_EQ(L"First Line", block->line(0));
+    EXPECT_EQ(L"", block->line(1));
+    EXPECT_EQ(L"Third Line", block->line(2));
+}
+
+/**
+ * A cold copy of a block shares its compressed data, and is only decompressed
+ * when it is read.
+ */
+TEST_F(LineBlockTest, cold)
+{
+    const LineBlock* decompressed = nullptr;
+    auto cold = block->cold([&](const LineBlock* b) { decompressed = b; });
+
+    ASSERT_EQ(3U, cold->lines());
+    EXPECT_EQ(block->compressedSize(), cold->compressedSize());
+    EXPECT_FALSE(cold->decompressed());
+
+    EXPECT_EQ(L"Third Line", cold->line(2));
+    EXPECT_EQ(L"First Line", cold->line(0));
+
+    EXPECT_TRUE(cold->decompressed());
+    EXPECT_EQ(cold.get(), decompressed);
+}
+
+/**
+ * A block read since the last sweep is warm; one not read since is cold.
+ */
+TEST_F(LineBlockTest, sweep)
+{
+    block->sweep();
+    EXPECT_TRUE(block->sweep());
+
+    block->line(0);
+
+    EXPECT_FALSE(block->sweep());
+    EXPECT_TRUE(block->sweep());
+}
+
+/**
+ * References to a block's contents stay good however the block is swept, for
+ * as long as the block exists.
+ */
+TEST_F(LineBlockTest, referencesOutliveSweeps)
+{
+    auto cold = block->cold();
+    const wstring& line = cold->line(0);
+
+    cold->sweep();
+    cold->sweep();
+    auto colder = cold->cold();
+
+    EXPECT_EQ(L"First Line", line);
+    EXPECT_EQ(&line, &cold->line(0));
+}
+
+/**
+ * Reading a cold block from several threads at once decompresses it once, and
+ * gives each the same contents.
+ */
+TEST_F(LineBlockTest, concurrentReads)
+{
+    atomic<int> decompressions(0);
+    auto cold = block->cold([&](const LineBlock*) { ++decompressions; });
+    vector<const wstring*> lines(8);
+    vector<thread> readers;
+
+    for (size_t i = 0; i < lines.size(); ++i)
+        readers.emplace_back([&, i] { lines[i] = &cold->line(i % 3); });
+
+    for (auto& reader : readers)
+        reader.join();
+
+    EXPECT_EQ(1, decompressions.load());
+
+    for (size_t i = 0; i < lines.size(); ++i)
+        EXPECT_EQ(&cold->line(i % 3), lines[i]);
+}
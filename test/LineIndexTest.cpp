@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+#include <vix/LineIndex.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Returns the lines of an index.
+     */
+    vector<string> indexLines(const LineIndex& index)
+    {
+        vector<string> lines;
+
+        for (size_t i = 0; i < index.lines(); ++i)
+        {
+            StringRef line = index.line(i);
+            lines.push_back(string(line.data(), line.size()));
+        }
+
+        return lines;
+    }
+
+    /**
+     * Split a text into lines a byte at a time.
+     */
+    vector<string> splitLines(const string& text, bool stripCarriageReturns)
+    {
+        char separator = text.find('\n') == string::npos ? '\r' : '\n';
+        vector<string> lines;
+        string line;
+
+        for (char c : text)
+        {
+            if (c != separator)
+            {
+                line += c;
+                continue;
+            }
+
+            if (stripCarriageReturns && !line.empty() && line.back() == '\r')
+                line.pop_back();
+
+            lines.push_back(line);
+            line.clear();
+        }
+
+        if (!line.empty())
+            lines.push_back(line);
+
+        return lines;
+    }
+}
+
+/**
+ * Lines end at line feeds, and text after the last is a line too.
+ */
+TEST(LineIndexTest, lineFeeds)
+{
+    const string TEXT("a\nbb\n\nc");
+    LineIndex index(TEXT.data(), TEXT.size());
+
+    EXPECT_EQ((vector<string>{"a", "bb", "", "c"}), indexLines(index));
+    EXPECT_EQ(LINE_ENDING_LF, index.ending());
+    EXPECT_EQ(3U, index.endings(LINE_ENDING_LF));
+    EXPECT_FALSE(index.mixed());
+    EXPECT_FALSE(index.finalNewline());
+}
+
+/**
+ * Carriage return line feeds are dropped from lines when they're the most
+ * common ending.
+ */
+TEST(LineIndexTest, carriageReturnLineFeeds)
+{
+    const string TEXT("a\r\nb\r\n\r\n");
+    LineIndex index(TEXT.data(), TEXT.size());
+
+    EXPECT_EQ((vector<string>{"a", "b", ""}), indexLines(index));
+    EXPECT_EQ(LINE_ENDING_CRLF, index.ending());
+    EXPECT_EQ(3U, index.endings(LINE_ENDING_CRLF));
+    EXPECT_EQ(0U, index.endings(LINE_ENDING_LF));
+    EXPECT_TRUE(index.finalNewline());
+}
+
+/**
+ * A text without line feeds ends its lines at carriage returns.
+ */
+TEST(LineIndexTest, carriageReturns)
+{
+    const string TEXT("a\rb\r");
+    LineIndex index(TEXT.data(), TEXT.size());
+
+    EXPECT_EQ((vector<string>{"a", "b"}), indexLines(index));
+    EXPECT_EQ(LINE_ENDING_CR, index.ending());
+    EXPECT_TRUE(index.finalNewline());
+}
+
+/**
+ * Mixed endings are reported, and lines ending in the less common ending keep
+ * any carriage return.
+ */
+TEST(LineIndexTest, mixed)
+{
+    const string CRLF_TEXT("a\r\nb\nc\r\n");
+    LineIndex crlf(CRLF_TEXT.data(), CRLF_TEXT.size());
+
+    EXPECT_EQ((vector<string>{"a", "b", "c"}), indexLines(crlf));
+    EXPECT_EQ(LINE_ENDING_CRLF, crlf.ending());
+    EXPECT_TRUE(crlf.mixed());
+
+    const string LF_TEXT("a\nb\r\nc\n");
+    LineIndex lineFeeds(LF_TEXT.data(), LF_TEXT.size());
+
+    EXPECT_EQ((vector<string>{"a", "b\r", "c"}), indexLines(lineFeeds));
+    EXPECT_EQ(LINE_ENDING_LF, lineFeeds.ending());
+    EXPECT_TRUE(lineFeeds.mixed());
+}
+
+/**
+ * Each byte belongs to the line it ends or is part of.
+ */
+TEST(LineIndexTest, lineAt)
+{
+    const string TEXT("a\nbb\n\nc");
+    LineIndex index(TEXT.data(), TEXT.size());
+
+    const size_t LINES[] = {0, 0, 1, 1, 1, 2, 3};
+    for (size_t offset = 0; offset < TEXT.size(); ++offset)
+        EXPECT_EQ(LINES[offset], index.lineAt(offset)) << offset;
+
+    EXPECT_EQ(4U, index.lineAt(TEXT.size()));
+}
+
+/**
+ * An empty text has no lines.
+ */
+TEST(LineIndexTest, empty)
+{
+    LineIndex index("", 0);
+
+    EXPECT_EQ(0U, index.lines());
+    EXPECT_FALSE(index.finalNewline());
+    EXPECT_FALSE(index.mixed());
+}
+
+/**
+ * Large random texts, scanned by one thread or several, agree with splitting
+ * a byte at a time, wherever the vector blocks and parts fall.
+ */
+TEST(LineIndexTest, random)
+{
+    mt19937 rng(42);
+    const char ALPHABET[] = {'a', 'b', '\n', '\r', ' ', '\xC3', '\xA9'};
+
+    for (size_t size : {1U, 63U, 64U, 65U, 1000U, 3U << 20})
+    {
+        for (int crlf = 0; crlf < 2; ++crlf)
+        {
+            string text;
+            text.reserve(size);
+
+            while (text.size() < size)
+            {
+                char c = ALPHABET[rng() % sizeof(ALPHABET)];
+
+                if (crlf && c == '\n')
+                    text += '\r';
+
+                text += c;
+            }
+
+            for (unsigned threads : {1U, 4U})
+            {
+                LineIndex index(text.data(), text.size(), threads);
+                bool strip = index.ending() == LINE_ENDING_CRLF;
+
+                ASSERT_EQ(splitLines(text, strip), indexLines(index))
+                    << size << " bytes, " << threads << " threads";
+
+                uint64_t lineFeeds = 0;
+                uint64_t carriageReturns = 0;
+                uint64_t pairs = 0;
+
+                for (size_t i = 0; i < text.size(); ++i)
+                {
+                    lineFeeds += text[i] == '\n';
+                    carriageReturns += text[i] == '\r';
+                    pairs += i > 0 && text[i] == '\n' && text[i - 1] == '\r';
+                }
+
+                EXPECT_EQ(lineFeeds - pairs, index.endings(LINE_ENDING_LF));
+                EXPECT_EQ(pairs, index.endings(LINE_ENDING_CRLF));
+                EXPECT_EQ(carriageReturns - pairs, index.endings(LINE_ENDING_CR));
+            }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <vix/LineInternTable.h>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * Interning two lines with the same contents makes them share storage.
+ */
+TEST(LineInternTable, internSharesStorage)
+{
+    LineInternTable t;
+    Line l1(L"Test");
+    Line l2(L"Test");
+
+    ASSERT_FALSE(l1.shares(l2));
+
+    t.intern(l1);
+    t.intern(l2);
+
+    EXPECT_TRUE(l1.shares(l2));
+    EXPECT_EQ(1U, t.size());
+}
+
+/**
+ * Lines with different contents do not share storage.
+ */
+TEST(LineInternTable, internDistinct)
+{
+    LineInternTable t;
+    Line l1(L"Test");
+    Line l2(L"Other");
+
+    t.intern(l1);
+    t.intern(l2);
+
+    EXPECT_FALSE(l1.shares(l2));
+    EXPECT_EQ(2U, t.size());
+}
+
+/**
+ * Interning the same line twice does not add an entry.
+ */
+TEST(LineInternTable, internTwice)
+{
+    LineInternTable t;
+    Line l(L"Test");
+
+    t.intern(l);
+    t.intern(l);
+
+    EXPECT_EQ(1U, t.size());
+}
+
+/**
+ * Empty lines are never added to the table.
+ */
+TEST(LineInternTable, internEmpty)
+{
+    LineInternTable t;
+    Line l;
+
+    t.intern(l);
+
+    EXPECT_EQ(0U, t.size());
+}
+
+/**
+ * Modifying an interned line does not modify the lines it shared storage with.
+ */
+TEST(LineInternTable, copyOnWrite)
+{
+    LineInternTable t;
+    Line l1(L"Test");
+    Line l2(L"Test");
+
+    t.intern(l1);
+    t.intern(l2);
+
+    l2.str(L"Changed");
+
+    EXPECT_EQ(L"Test", l1.str());
+    EXPECT_EQ(L"Changed", l2.str());
+}
+
+/**
+ * purge removes the entries of lines which no longer exist.
+ */
+TEST(LineInternTable, purge)
+{
+    LineInternTable t;
+    Line l1(L"Test");
+
+    t.intern(l1);
+
+    {
+        Line l2(L"Other");
+        t.intern(l2);
+    }
+
+    EXPECT_EQ(2U, t.size());
+
+    t.purge();
+
+    EXPECT_EQ(1U, t.size());
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include <vix/LineRowMap.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Check a map against the cover counts it should hold.
+     */
+    void expectMap(const LineRowMap& map, const vector<int>& counts)
+    {
+        ASSERT_EQ(counts.size(), map.lines());
+
+        size_t rows = 0;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            EXPECT_EQ(counts[i] > 0, map.hidden(i)) << "line " << i;
+
+            if (counts[i] == 0)
+            {
+                EXPECT_EQ(rows, map.row(i)) << "line " << i;
+                EXPECT_EQ(i, map.line(rows)) << "row " << rows;
+                ++rows;
+            }
+            else
+            {
+                EXPECT_EQ(rows > 0 ? rows - 1 : 0, map.row(i)) << "line " << i;
+            }
+        }
+
+        EXPECT_EQ(rows, map.rows());
+        EXPECT_EQ(counts.size(), map.line(rows));
+    }
+}
+
+/**
+ * Every line of a new map is visible on its own row.
+ */
+TEST(LineRowMapTest, visible)
+{
+    LineRowMap map(10);
+
+    expectMap(map, vector<int>(10, 0));
+}
+
+/**
+ * Covered lines share the row of the line above them until uncovered.
+ */
+TEST(LineRowMapTest, cover)
+{
+    LineRowMap map(10);
+
+    map.cover(3, 5, 1);
+    map.cover(4, 8, 1);
+    expectMap(map, {0, 0, 0, 1, 2, 2, 1, 1, 1, 0});
+    EXPECT_EQ(2U, map.row(7));
+    EXPECT_EQ(9U, map.line(3));
+
+    map.cover(4, 8, -1);
+    expectMap(map, {0, 0, 0, 1, 1, 1, 0, 0, 0, 0});
+}
+
+/**
+ * Inserted lines take the cover of the line they are inserted before, and
+ * appended lines are visible.
+ */
+TEST(LineRowMapTest, insert)
+{
+    LineRowMap map(6);
+
+    map.cover(2, 4, 1);
+    map.insert(3, 2);
+    expectMap(map, {0, 0, 1, 1, 1, 1, 1, 0});
+
+    map.insert(2, 1);
+    expectMap(map, {0, 0, 1, 1, 1, 1, 1, 1, 0});
+
+    map.insert(0, 1);
+    map.insert(9, 2);
+    expectMap(map, {0, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0});
+
+    LineRowMap empty;
+    empty.insert(0, 3);
+    expectMap(empty, {0, 0, 0});
+}
+
+/**
+ * Lines are erased along with their cover.
+ */
+TEST(LineRowMapTest, erase)
+{
+    LineRowMap map(10);
+
+    map.cover(2, 6, 1);
+    map.erase(4, 4);
+    expectMap(map, {0, 0, 1, 1, 0, 0});
+
+    map.erase(0, 6);
+    expectMap(map, {});
+}
+
+/**
+ * Random edits agree with a plain array of counts.
+ */
+TEST(LineRowMapTest, random)
+{
+    mt19937 rng(2024);
+    LineRowMap map(50);
+    vector<int> counts(50, 0);
+
+    for (int step = 0; step < 2000; ++step)
+    {
+        size_t size = counts.size();
+        size_t line = rng() % (size + 1);
+
+        switch (rng() % 4)
+        {
+        case 0:
+        {
+            size_t count = 1 + rng() % 5;
+            int cover = line < size ? counts[line] : 0;
+
+            map.insert(line, count);
+            counts.insert(counts.begin() + line, count, cover);
+            break;
+        }
+
+        case 1:
+        {
+            size_t count = min<size_t>(rng() % 5, size - line);
+
+            map.erase(line, count);
+            counts.erase(counts.begin() + line, counts.begin() + line + count);
+            break;
+        }
+
+        default:
+        {
+            if (line >= size)
+                break;
+
+            size_t last = min(size - 1, line + rng() % 20);
+            int delta = 1;
+
+            //only uncover lines which are covered.
+            if (rng() % 2 && *min_element(&counts[line], &counts[last] + 1) > 0)
+                delta = -1;
+
+            map.cover(line, last, delta);
+            for (size_t i = line; i <= last; ++i)
+                counts[i] += delta;
+
+            break;
+        }
+        }
+
+        if (step % 100 == 0)
+            expectMap(map, counts);
+    }
+
+    expectMap(map, counts);
+}
@@ -1,5 +1,9 @@
 #include <gtest/gtest.h>
+#include <vix/Buffer.h>
 #include <vix/Line.h>
+#include <vix/LineInternTable.h>
+
+#include <type_traits>
 
 using namespace std;
 using namespace vix;
@@ -55,3 +59,104 @@ TEST(Line, strSet)
 
     ASSERT_EQ(l.str(), foo);
 }
+
+/**
+ * A line holds its own contents, so a copy doesn't share them.
+ */
+TEST(Line, copyOwnsStorage)
+{
+    Line ol(L"Test");
+    Line l(ol);
+
+    ASSERT_FALSE(l.shares(ol));
+    ASSERT_EQ(ol.str(), l.str());
+}
+
+/**
+ * A line takes no more room than its string and stamp.
+ */
+TEST(Line, size)
+{
+    EXPECT_EQ(sizeof(wstring) + sizeof(uint64_t), sizeof(Line));
+}
+
+TEST(Line, strSetCopyOnWrite)
+{
+    LineInternTable table;
+    Line ol(L"Test");
+    Line l(ol);
+
+    table.intern(ol);
+    table.intern(l);
+    ASSERT_TRUE(l.shares(ol));
+
+    l.str(L"Changed");
+
+    ASSERT_FALSE(l.shares(ol));
+    ASSERT_EQ(ol.str(), L"Test");
+    ASSERT_EQ(l.str(), L"Changed");
+}
+
+TEST(Line, moveConstructor)
+{
+    Line ol(L"Test");
+    Line l(std::move(ol));
+
+    ASSERT_EQ(l.str(), L"Test");
+    ASSERT_EQ(ol.str(), L"");
+}
+
+TEST(Line, moveAssignmentOperator)
+{
+    Line ol(L"Test");
+    Line l;
+
+    l = std::move(ol);
+
+    ASSERT_EQ(l.str(), L"Test");
+    ASSERT_EQ(ol.str(), L"");
+}
+
+/**
+ * Moving a line never throws, so a vector of lines moves them as it grows.
+ */
+TEST(Line, moveNoexcept)
+{
+    EXPECT_TRUE(is_nothrow_move_constructible<Line>::value);
+    EXPECT_TRUE(is_nothrow_move_assignable<Line>::value);
+}
+
+TEST(Line, equality)
+{
+    Line l1(L"Test");
+    Line l2(L"Test");
+    Line l3(L"Other");
+
+    ASSERT_TRUE(l1 == l2);
+    ASSERT_FALSE(l1 != l2);
+    ASSERT_TRUE(l1 != l3);
+    ASSERT_TRUE(Line() == Line(L""));
+}
+
+/**
+ * A line starts unstamped, copies keep the stamp it is given in a buffer, and
+ * a new value loses it.
+ */
+TEST(Line, stamp)
+{
+    Buffer buffer;
+    Line line(L"stamped");
+
+    EXPECT_EQ(0U, line.stamp());
+
+    buffer.append(line);
+    Line copy = *buffer.begin();
+    EXPECT_EQ(buffer.version(), copy.stamp());
+
+    Line moved(move(copy));
+    EXPECT_EQ(buffer.version(), moved.stamp());
+
+    //a new value isn't the one the stamp was given for.
+    moved.str(L"changed");
+    EXPECT_EQ(0U, moved.stamp());
+}
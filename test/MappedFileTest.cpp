@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <vix/MappedFile.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+class MappedFileTest : public TemporaryFileTest
+{
+};
+
+/**
+ * A mapped file exposes the contents of the file.
+ */
+TEST_F(MappedFileTest, map)
+{
+    const string CONTENTS{"These are the contents of the file."};
+    ofstream(path, ios::binary) << CONTENTS;
+
+    MappedFile file(path);
+
+    ASSERT_EQ(CONTENTS.size(), file.size());
+    EXPECT_EQ(0, memcmp(CONTENTS.data(), file.data(), file.size()));
+}
+
+/**
+ * An empty file maps to an empty range.
+ */
+TEST_F(MappedFileTest, empty)
+{
+    MappedFile file(path);
+
+    EXPECT_EQ(0U, file.size());
+    EXPECT_EQ(nullptr, file.data());
+}
+
+/**
+ * Moving a mapped file transfers the mapping.
+ */
+TEST_F(MappedFileTest, move)
+{
+    ofstream(path, ios::binary) << "Test";
+
+    MappedFile file(path);
+    const void* data = file.data();
+
+    MappedFile moved(std::move(file));
+
+    EXPECT_EQ(data, moved.data());
+    EXPECT_EQ(4U, moved.size());
+    EXPECT_EQ(nullptr, file.data());
+}
+
+/**
+ * Mapping a file which doesn't exist throws.
+ */
+TEST_F(MappedFileTest, missing)
+{
+    EXPECT_THROW(
+        MappedFile(path + ".missing"),
+        vix::exception::FileOpen);
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <vix/MemoryInputStream.h>
+#include <vix/SerialUtilities.h>
+
+#include <string>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * A memory input stream reads the contents of its range.
+ */
+TEST(MemoryInputStreamTest, read)
+{
+    const string DATA{"Test 1234"};
+
+    MemoryInputStream in(DATA.data(), DATA.size());
+
+    string word;
+    int number = 0;
+    in >> word >> number;
+
+    EXPECT_EQ("Test", word);
+    EXPECT_EQ(1234, number);
+}
+
+/**
+ * Reading past the end of the range fails the way a short stream does.
+ */
+TEST(MemoryInputStreamTest, truncated)
+{
+    const string DATA{"abc"};
+
+    MemoryInputStream in(DATA.data(), DATA.size());
+
+    char buffer[4];
+    EXPECT_THROW(
+        serialReadFixedBuffer(in, buffer, sizeof(buffer)),
+        vix::exception::SerialRead);
+}
+
+/**
+ * An empty range is an empty stream.
+ */
+TEST(MemoryInputStreamTest, empty)
+{
+    MemoryInputStream in(nullptr, 0);
+
+    EXPECT_EQ(char_traits<char>::eof(), in.get());
+}
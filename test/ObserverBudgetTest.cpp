@@ -0,0 +1,314 @@
+#include <gtest/gtest.h>
+#include <vix/Buffer.h>
+#include <vix/ObserverBudget.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * An observer which takes as long as it is told to, and remembers the
+     * changes it was told of.
+     */
+    class DelayObserver : public BufferChangeObserver
+    {
+    public:
+        DelayObserver(chrono::milliseconds delay = chrono::milliseconds(0))
+            : delay(delay)
+        {
+        }
+
+        virtual void onBufferChanged(const Buffer* changedBuffer)
+        {
+            changes.push_back(changedBuffer->lastChange());
+
+            if (delay.count())
+                this_thread::sleep_for(delay);
+        }
+
+        chrono::milliseconds delay;
+        vector<BufferChange> changes;
+    };
+}
+
+/**
+ * Each call is timed, and a rolling average kept, separately for each
+ * observer.
+ */
+TEST(ObserverBudgetTest, statistics)
+{
+    DelayObserver fast, slow;
+    ObserverBudget budget(chrono::milliseconds(5));
+
+    EXPECT_EQ(0U, budget.statistics(fast).calls);
+
+    budget.record(fast, chrono::milliseconds(1));
+    budget.record(fast, chrono::milliseconds(3));
+    budget.record(slow, chrono::milliseconds(8));
+
+    auto statistics = budget.statistics(fast);
+    EXPECT_EQ(2U, statistics.calls);
+    EXPECT_EQ(0U, statistics.overBudget);
+    EXPECT_EQ(chrono::milliseconds(4), statistics.total);
+    EXPECT_EQ(chrono::milliseconds(3), statistics.max);
+    EXPECT_LT(chrono::milliseconds(1), statistics.recent);
+    EXPECT_GT(chrono::milliseconds(3), statistics.recent);
+    EXPECT_FALSE(statistics.slow);
+
+    statistics = budget.statistics(slow);
+    EXPECT_EQ(1U, statistics.calls);
+    EXPECT_EQ(1U, statistics.overBudget);
+    EXPECT_TRUE(statistics.slow);
+    EXPECT_FALSE(statistics.deferred);
+}
+
+/**
+ * One slow call among many fast ones doesn't make an observer slow, but a
+ * run of them does, and the handler is told once.
+ */
+TEST(ObserverBudgetTest, slowHandler)
+{
+    DelayObserver observer;
+    vector<BufferChangeObserver*> told;
+
+    ObserverBudget budget(
+        chrono::milliseconds(5), false,
+        [&](BufferChangeObserver& o, const ObserverBudget::Statistics& s) {
+            EXPECT_TRUE(s.slow);
+            told.push_back(&o);
+        });
+
+    for (int i = 0; i < 8; ++i)
+        budget.record(observer, chrono::milliseconds(1));
+
+    budget.record(observer, chrono::milliseconds(20));
+    EXPECT_TRUE(told.empty());
+    EXPECT_EQ(1U, budget.statistics(observer).overBudget);
+
+    for (int i = 0; i < 8; ++i)
+        budget.record(observer, chrono::milliseconds(20));
+
+    ASSERT_EQ(1U, told.size());
+    EXPECT_EQ(&observer, told.front());
+    EXPECT_FALSE(budget.deferred(observer));
+}
+
+/**
+ * A demoting budget defers a slow observer, and promotes it again once its
+ * average falls well under budget.
+ */
+TEST(ObserverBudgetTest, demote)
+{
+    DelayObserver observer;
+    ObserverBudget budget(chrono::milliseconds(4), true);
+
+    budget.record(observer, chrono::milliseconds(10));
+    EXPECT_TRUE(budget.deferred(observer));
+
+    //under budget, but not by half.
+    for (int i = 0; i < 40; ++i)
+        budget.record(observer, chrono::milliseconds(3));
+
+    EXPECT_FALSE(budget.statistics(observer).slow);
+    EXPECT_TRUE(budget.deferred(observer));
+
+    for (int i = 0; i < 40; ++i)
+        budget.record(observer, chrono::milliseconds(0));
+
+    EXPECT_FALSE(budget.deferred(observer));
+}
+
+/**
+ * The buffer times each synchronous observer once given a budget.
+ */
+TEST(ObserverBudgetTest, buffer)
+{
+    auto observer = make_shared<DelayObserver>();
+
+    Buffer buffer;
+    buffer.addObserver(observer);
+    buffer.append(Line(L"untimed"));
+
+    EXPECT_EQ(0U, buffer.observerStatistics(*observer).calls);
+
+    buffer.observerBudget(chrono::milliseconds(50));
+    buffer.append(Line(L"one"));
+    buffer.append(Line(L"two"));
+
+    EXPECT_EQ(2U, buffer.observerStatistics(*observer).calls);
+    EXPECT_EQ(3U, observer->changes.size());
+
+    buffer.observerBudget(ObserverBudget::clock::duration::zero());
+    buffer.append(Line(L"three"));
+
+    EXPECT_EQ(0U, buffer.observerStatistics(*observer).calls);
+    EXPECT_EQ(4U, observer->changes.size());
+}
+
+/**
+ * A slow observer is demoted out of each change, and told of the changes it
+ * missed, merged, by dispatchDeferred.
+ */
+TEST(ObserverBudgetTest, deferredDispatch)
+{
+    auto fast = make_shared<DelayObserver>();
+    auto slow = make_shared<DelayObserver>(chrono::milliseconds(20));
+    size_t told = 0;
+
+    Buffer buffer;
+    buffer.addObserver(fast);
+    buffer.addObserver(slow);
+    buffer.observerBudget(
+        chrono::milliseconds(5), true,
+        [&](BufferChangeObserver&, const ObserverBudget::Statistics&) {
+            ++told;
+        });
+
+    buffer.append(Line(L"one"));
+    EXPECT_EQ(1U, told);
+    EXPECT_TRUE(buffer.observerStatistics(*slow).deferred);
+    EXPECT_FALSE(buffer.observerStatistics(*fast).deferred);
+
+    buffer.append(Line(L"two"));
+    buffer.append(Line(L"three"));
+
+    EXPECT_EQ(3U, fast->changes.size());
+    ASSERT_EQ(1U, slow->changes.size());
+
+    buffer.dispatchDeferred();
+
+    ASSERT_EQ(2U, slow->changes.size());
+    EXPECT_EQ(1U, slow->changes[1].line);
+    EXPECT_EQ(0U, slow->changes[1].removed);
+    EXPECT_EQ(2U, slow->changes[1].inserted);
+
+    //nothing has changed since.
+    buffer.dispatchDeferred();
+    EXPECT_EQ(2U, slow->changes.size());
+    EXPECT_EQ(2U, buffer.lastChange().line);
+
+    //once fast again, it is promoted back into each change.
+    slow->delay = chrono::milliseconds(0);
+
+    for (int i = 0; i < 100 && buffer.observerStatistics(*slow).deferred; ++i)
+    {
+        buffer.replace(buffer.begin(), Line(L"edit"));
+        buffer.dispatchDeferred();
+    }
+
+    ASSERT_FALSE(buffer.observerStatistics(*slow).deferred);
+
+    size_t before = slow->changes.size();
+    buffer.append(Line(L"four"));
+    EXPECT_EQ(before + 1, slow->changes.size());
+    EXPECT_EQ(1U, told);
+}
+
+/**
+ * A budget can forget an observer, or every observer but those still
+ * registered.
+ */
+TEST(ObserverBudgetTest, forget)
+{
+    DelayObserver one, two, three;
+    ObserverBudget budget(chrono::milliseconds(4), true);
+
+    budget.record(one, chrono::milliseconds(10));
+    budget.record(two, chrono::milliseconds(10));
+    budget.record(three, chrono::milliseconds(10));
+    EXPECT_EQ(3U, budget.size());
+
+    budget.forget(one);
+    EXPECT_EQ(0U, budget.statistics(one).calls);
+    EXPECT_FALSE(budget.deferred(one));
+    EXPECT_EQ(2U, budget.size());
+
+    budget.retain(vector<const BufferChangeObserver*>{&three});
+    EXPECT_EQ(0U, budget.statistics(two).calls);
+    EXPECT_TRUE(budget.deferred(three));
+    EXPECT_EQ(1U, budget.size());
+}
+
+/**
+ * An observer registered at the address of one which has gone doesn't
+ * inherit its deferral, whether or not the buffer has changed in between.
+ */
+TEST(ObserverBudgetTest, reusedAddress)
+{
+    DelayObserver storage(chrono::milliseconds(20));
+    auto keep = [](DelayObserver*) {};
+
+    Buffer buffer;
+    buffer.observerBudget(chrono::milliseconds(5), true);
+
+    shared_ptr<DelayObserver> observer(&storage, keep);
+    buffer.addObserver(observer);
+    buffer.append(Line(L"one"));
+    ASSERT_TRUE(buffer.observerStatistics(storage).deferred);
+
+    //gone, and forgotten at the next change.
+    observer.reset();
+    buffer.append(Line(L"two"));
+    EXPECT_EQ(0U, buffer.observerStatistics(storage).calls);
+
+    storage.delay = chrono::milliseconds(20);
+    observer.reset(&storage, keep);
+    buffer.addObserver(observer);
+    buffer.append(Line(L"three"));
+    ASSERT_TRUE(buffer.observerStatistics(storage).deferred);
+
+    //gone, and replaced before the buffer changes again.
+    observer.reset();
+    storage.delay = chrono::milliseconds(0);
+    storage.changes.clear();
+    observer.reset(&storage, keep);
+    buffer.addObserver(observer);
+    EXPECT_EQ(0U, buffer.observerStatistics(storage).calls);
+
+    buffer.append(Line(L"four"));
+    ASSERT_EQ(1U, storage.changes.size());
+    EXPECT_EQ(3U, storage.changes.front().line);
+}
+
+/**
+ * Observers demoted at different changes are each told of only the changes
+ * they missed.
+ */
+TEST(ObserverBudgetTest, deferredSeparately)
+{
+    auto first = make_shared<DelayObserver>(chrono::milliseconds(20));
+    auto second = make_shared<DelayObserver>(chrono::milliseconds(20));
+
+    Buffer buffer;
+    buffer.addObserver(first);
+    buffer.observerBudget(chrono::milliseconds(5), true);
+
+    buffer.append(Line(L"one"));
+    buffer.append(Line(L"two"));
+    ASSERT_TRUE(buffer.observerStatistics(*first).deferred);
+
+    buffer.addObserver(second);
+    buffer.append(Line(L"three"));
+    ASSERT_TRUE(buffer.observerStatistics(*second).deferred);
+
+    buffer.append(Line(L"four"));
+    buffer.dispatchDeferred();
+
+    ASSERT_EQ(2U, first->changes.size());
+    EXPECT_EQ(1U, first->changes[1].line);
+    EXPECT_EQ(3U, first->changes[1].inserted);
+
+    ASSERT_EQ(2U, second->changes.size());
+    EXPECT_EQ(3U, second->changes[1].line);
+    EXPECT_EQ(1U, second->changes[1].inserted);
+
+    //both are up to date, so neither is called again.
+    buffer.dispatchDeferred();
+    EXPECT_EQ(2U, first->changes.size());
+    EXPECT_EQ(2U, second->changes.size());
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <vix/SerialEndian.h>
+
+#include <limits>
+#include <sstream>
+
+using namespace std;
+using namespace vix;
+
+//byte swapping is resolved at compile time.
+static_assert(byteSwap<uint16_t>(0x0102) == 0x0201, "byteSwap(uint16_t)");
+static_assert(byteSwap<uint32_t>(0x01020304) == 0x04030201, "byteSwap(uint32_t)");
+static_assert(byteSwap<uint64_t>(0x0102030405060708ULL) == 0x0807060504030201ULL, "byteSwap(uint64_t)");
+static_assert(byteSwap<int8_t>(-2) == -2, "byteSwap(int8_t)");
+static_assert(hostToBigEndian(hostToBigEndian<uint32_t>(0x01020304)) == 0x01020304, "hostToBigEndian");
+
+/**
+ * encodeBigEndian writes the most significant byte first.
+ */
+TEST(SerialEndianTest, encodeBigEndian)
+{
+    uint8_t buffer[8];
+
+    encodeBigEndian<uint32_t>(buffer, 0x01020304);
+    EXPECT_EQ(0x01, buffer[0]);
+    EXPECT_EQ(0x02, buffer[1]);
+    EXPECT_EQ(0x03, buffer[2]);
+    EXPECT_EQ(0x04, buffer[3]);
+
+    encodeBigEndian<int16_t>(buffer, -2);
+    EXPECT_EQ(0xFF, buffer[0]);
+    EXPECT_EQ(0xFE, buffer[1]);
+
+    encodeBigEndian<uint64_t>(buffer, 0x0102030405060708ULL);
+    for (int i = 0; i < 8; ++i)
+        EXPECT_EQ(i + 1, buffer[i]);
+}
+
+/**
+ * decodeBigEndian reads back values written by encodeBigEndian, including the
+ * extremes of signed types.
+ */
+TEST(SerialEndianTest, decodeBigEndian)
+{
+    uint8_t buffer[8];
+
+    encodeBigEndian(buffer, numeric_limits<int64_t>::min());
+    EXPECT_EQ(numeric_limits<int64_t>::min(), decodeBigEndian<int64_t>(buffer));
+
+    encodeBigEndian(buffer, numeric_limits<int32_t>::min());
+    EXPECT_EQ(numeric_limits<int32_t>::min(), decodeBigEndian<int32_t>(buffer));
+
+    encodeBigEndian<int16_t>(buffer, -12345);
+    EXPECT_EQ(-12345, decodeBigEndian<int16_t>(buffer));
+
+    encodeBigEndian<uint8_t>(buffer, 0xAB);
+    EXPECT_EQ(0xAB, decodeBigEndian<uint8_t>(buffer));
+}
+
+/**
+ * serialReadBigEndian reads back a value written by serialWriteBigEndian.
+ */
+TEST(SerialEndianTest, serialReadWriteBigEndian)
+{
+    stringstream ss;
+    uint32_t value = 0;
+
+    serialWriteBigEndian<uint32_t>(ss, 0xDEADBEEF);
+
+    EXPECT_EQ(string("\xDE\xAD\xBE\xEF"), ss.str());
+
+    serialReadBigEndian(ss, value);
+
+    EXPECT_EQ(0xDEADBEEF, value);
+}
+
+/**
+ * serialWriteBigEndian throws if the stream is bad.
+ */
+TEST(SerialEndianTest, serialWriteBigEndianException)
+{
+    stringstream ss;
+    ss.setstate(ios::badbit);
+
+    EXPECT_THROW(
+        serialWriteBigEndian<uint16_t>(ss, 1),
+        vix::exception::SerialWrite);
+}
+
+/**
+ * serialReadBigEndian throws if the stream is too short.
+ */
+TEST(SerialEndianTest, serialReadBigEndianException)
+{
+    stringstream ss("\x01\x02");
+    uint32_t value;
+
+    EXPECT_THROW(
+        serialReadBigEndian(ss, value),
+        vix::exception::SerialRead);
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <vix/SerialMemoryReader.h>
+#include <vix/SerialUtilities.h>
+#include <vix/SerialVarint.h>
+
+#include <sstream>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * The reader reads back integers written by serialWrite.
+ */
+TEST(SerialMemoryReaderTest, readIntegers)
+{
+    stringstream ss;
+    serialWrite(ss, (uint8_t)0xAB);
+    serialWrite(ss, (int16_t)-2);
+    serialWrite(ss, (uint32_t)0xDEADBEEF);
+    serialWrite(ss, (int64_t)-1234567890123LL);
+    string data = ss.str();
+
+    SerialMemoryReader reader(data.data(), data.size());
+    uint8_t u8;
+    int16_t i16;
+    uint32_t u32;
+    int64_t i64;
+
+    reader.read(u8);
+    reader.read(i16);
+    reader.read(u32);
+    reader.read(i64);
+
+    EXPECT_EQ(0xAB, u8);
+    EXPECT_EQ(-2, i16);
+    EXPECT_EQ(0xDEADBEEF, u32);
+    EXPECT_EQ(-1234567890123LL, i64);
+    EXPECT_EQ(0U, reader.remaining());
+}
+
+/**
+ * Strings are read as references into the underlying memory, without being
+ * copied.
+ */
+TEST(SerialMemoryReaderTest, readStringRef)
+{
+    const string EXPECTED_STRING{"The string to be written."};
+    stringstream ss;
+    serialWrite(ss, EXPECTED_STRING);
+    serialWriteCompact(ss, EXPECTED_STRING);
+    string data = ss.str();
+
+    SerialMemoryReader reader(data.data(), data.size());
+    StringRef fixed;
+    StringRef compact;
+
+    reader.read(fixed);
+    reader.readCompact(compact);
+
+    EXPECT_EQ(EXPECTED_STRING, fixed.str());
+    EXPECT_EQ(EXPECTED_STRING, compact.str());
+
+    //both point straight into the data.
+    EXPECT_EQ(data.data() + 4, fixed.data());
+    EXPECT_EQ(data.data() + data.size() - EXPECTED_STRING.size(), compact.data());
+}
+
+/**
+ * The reader reads back varints written by serialWriteVarint and
+ * serialWriteZigzag.
+ */
+TEST(SerialMemoryReaderTest, readVarints)
+{
+    stringstream ss;
+    serialWriteVarint(ss, 300);
+    serialWriteZigzag(ss, -300);
+    string data = ss.str();
+
+    SerialMemoryReader reader(data.data(), data.size());
+    uint64_t u;
+    int64_t i;
+
+    reader.readVarint(u);
+    reader.readZigzag(i);
+
+    EXPECT_EQ(300U, u);
+    EXPECT_EQ(-300, i);
+    EXPECT_EQ(data.size(), reader.position());
+}
+
+/**
+ * readFixedBuffer copies out a fixed size buffer.
+ */
+TEST(SerialMemoryReaderTest, readFixedBuffer)
+{
+    const string data{"Test 1234"};
+    char buffer[4];
+
+    SerialMemoryReader reader(data.data(), data.size());
+    reader.readFixedBuffer(buffer, sizeof(buffer));
+
+    EXPECT_EQ(0, memcmp("Test", buffer, sizeof(buffer)));
+    EXPECT_EQ(5U, reader.remaining());
+}
+
+/**
+ * Every read past the end of the range throws, and does not move the reader.
+ */
+TEST(SerialMemoryReaderTest, truncated)
+{
+    stringstream ss;
+    serialWrite(ss, string("Truncated"));
+    string data = ss.str();
+
+    stringstream css;
+    serialWriteCompact(css, string("Truncated"));
+    string compactData = css.str();
+
+    SerialMemoryReader reader(data.data(), data.size() - 1);
+    SerialMemoryReader compactReader(compactData.data(), compactData.size() - 1);
+    StringRef s;
+    uint64_t u64;
+    char buffer[16];
+
+    EXPECT_THROW(reader.read(s), vix::exception::SerialRead);
+    EXPECT_EQ(0U, reader.position());
+
+    EXPECT_THROW(compactReader.readCompact(s), vix::exception::SerialRead);
+    EXPECT_EQ(0U, compactReader.position());
+
+    reader.position(reader.size() - 2);
+    EXPECT_THROW(reader.read(u64), vix::exception::SerialRead);
+    EXPECT_THROW(reader.readFixedBuffer(buffer, 3), vix::exception::SerialRead);
+    EXPECT_THROW(reader.readFixedRef(3), vix::exception::SerialRead);
+    EXPECT_EQ(reader.size() - 2, reader.position());
+
+    EXPECT_THROW(reader.position(reader.size() + 1), vix::exception::SerialRead);
+}
+
+/**
+ * An empty reader throws on any read.
+ */
+TEST(SerialMemoryReaderTest, empty)
+{
+    SerialMemoryReader reader(nullptr, 0);
+    uint8_t u8;
+    uint64_t u64;
+
+    EXPECT_THROW(reader.read(u8), vix::exception::SerialRead);
+    EXPECT_THROW(reader.readVarint(u64), vix::exception::SerialRead);
+}
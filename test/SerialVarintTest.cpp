@@ -0,0 +1,380 @@
+#include <gtest/gtest.h>
+#include <vix/SerialVarint.h>
+
+#include <limits>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    //values around every encoded size boundary.
+    vector<uint64_t> boundaryValues()
+    {
+        vector<uint64_t> values{0, 1};
+
+        for (unsigned bits = 7; bits < 64; bits += 7)
+        {
+            values.push_back((1ULL << bits) - 1);
+            values.push_back(1ULL << bits);
+        }
+
+        values.push_back(numeric_limits<uint64_t>::max());
+
+        return values;
+    }
+
+    /**
+     * A stream buffer which only ever has one byte buffered.
+     */
+    class ByteBuffer : public streambuf
+    {
+    public:
+        explicit ByteBuffer(const string& data)
+            : data_(data), next_(0)
+        {
+        }
+
+    protected:
+        virtual int_type underflow()
+        {
+            if (next_ >= data_.size())
+                return traits_type::eof();
+
+            char* p = &data_[next_++];
+            setg(p, p, p + 1);
+
+            return traits_type::to_int_type(*p);
+        }
+
+    private:
+        string data_;
+        size_t next_;
+    };
+}
+
+/**
+ * varintSize returns the number of bytes needed for seven bits per byte.
+ */
+TEST(SerialVarintTest, varintSize)
+{
+    EXPECT_EQ(1U, varintSize(0));
+    EXPECT_EQ(1U, varintSize(127));
+    EXPECT_EQ(2U, varintSize(128));
+    EXPECT_EQ(2U, varintSize(16383));
+    EXPECT_EQ(3U, varintSize(16384));
+    EXPECT_EQ(9U, varintSize(numeric_limits<int64_t>::max()));
+    EXPECT_EQ(10U, varintSize(numeric_limits<uint64_t>::max()));
+}
+
+/**
+ * encodeVarint writes LEB128, least significant group first.
+ */
+TEST(SerialVarintTest, encodeVarint)
+{
+    uint8_t buffer[VARINT_ENCODE_SPACE];
+
+    ASSERT_EQ(1U, encodeVarint(buffer, 1));
+    EXPECT_EQ(0x01, buffer[0]);
+
+    ASSERT_EQ(2U, encodeVarint(buffer, 300));
+    EXPECT_EQ(0xAC, buffer[0]);
+    EXPECT_EQ(0x02, buffer[1]);
+
+    ASSERT_EQ(10U, encodeVarint(buffer, numeric_limits<uint64_t>::max()));
+    for (int i = 0; i < 9; ++i)
+        EXPECT_EQ(0xFF, buffer[i]);
+    EXPECT_EQ(0x01, buffer[9]);
+}
+
+/**
+ * decodeVarint reads back every value written by encodeVarint, through both
+ * the word at a time path and the byte at a time path.
+ */
+TEST(SerialVarintTest, encodeDecodeVarint)
+{
+    for (auto value : boundaryValues())
+    {
+        uint8_t buffer[VARINT_ENCODE_SPACE];
+        size_t size = encodeVarint(buffer, value);
+        uint64_t decoded = 0;
+
+        ASSERT_EQ(varintSize(value), size);
+
+        //enough input for the fast path.
+        EXPECT_EQ(size, decodeVarint(buffer, sizeof(buffer), decoded));
+        EXPECT_EQ(value, decoded);
+
+        //exactly the encoded size.
+        decoded = 0;
+        EXPECT_EQ(size, decodeVarint(buffer, size, decoded));
+        EXPECT_EQ(value, decoded);
+    }
+}
+
+/**
+ * decodeVarint throws if the encoding is truncated.
+ */
+TEST(SerialVarintTest, decodeVarintTruncated)
+{
+    uint8_t buffer[VARINT_ENCODE_SPACE];
+    size_t size = encodeVarint(buffer, 1ULL << 40);
+    uint64_t value;
+
+    EXPECT_THROW(
+        decodeVarint(buffer, size - 1, value),
+        vix::exception::SerialRead);
+    EXPECT_THROW(
+        decodeVarint(buffer, 0, value),
+        vix::exception::SerialRead);
+}
+
+/**
+ * decodeVarint throws if the encoding is longer than any 64-bit value.
+ */
+TEST(SerialVarintTest, decodeVarintOverlong)
+{
+    vector<uint8_t> buffer(16, 0xFF);
+    uint64_t value;
+
+    EXPECT_THROW(
+        decodeVarint(&buffer[0], buffer.size(), value),
+        vix::exception::SerialRead);
+
+    //a tenth byte holding more than the top bit is also too long.
+    buffer[9] = 0x02;
+    EXPECT_THROW(
+        decodeVarint(&buffer[0], buffer.size(), value),
+        vix::exception::SerialRead);
+}
+
+/**
+ * zigzag encoding maps small magnitudes onto small values.
+ */
+TEST(SerialVarintTest, zigzag)
+{
+    EXPECT_EQ(0U, zigzagEncode(0));
+    EXPECT_EQ(1U, zigzagEncode(-1));
+    EXPECT_EQ(2U, zigzagEncode(1));
+    EXPECT_EQ(3U, zigzagEncode(-2));
+    EXPECT_EQ(numeric_limits<uint64_t>::max(),
+              zigzagEncode(numeric_limits<int64_t>::min()));
+
+    const vector<int64_t> VALUES{0, 1, -1, 63, -64, 1LL << 40,
+                                 numeric_limits<int64_t>::max(),
+                                 numeric_limits<int64_t>::min()};
+
+    for (auto value : VALUES)
+    {
+        EXPECT_EQ(value, zigzagDecode(zigzagEncode(value)));
+    }
+}
+
+/**
+ * serialReadVarint reads back a value written by serialWriteVarint.
+ */
+TEST(SerialVarintTest, serialReadWriteVarint)
+{
+    stringstream ss;
+
+    for (auto value : boundaryValues())
+        serialWriteVarint(ss, value);
+
+    for (auto value : boundaryValues())
+    {
+        uint64_t read = 0;
+        serialReadVarint(ss, read);
+        EXPECT_EQ(value, read);
+    }
+}
+
+/**
+ * serialReadVarint reads values from a stream which has less than a whole
+ * value buffered at a time.
+ */
+TEST(SerialVarintTest, serialReadVarintUnbuffered)
+{
+    stringstream ss;
+
+    for (auto value : boundaryValues())
+        serialWriteVarint(ss, value);
+
+    ByteBuffer buffer(ss.str());
+    istream in(&buffer);
+
+    for (auto value : boundaryValues())
+    {
+        uint64_t read = 0;
+        serialReadVarint(in, read);
+        EXPECT_EQ(value, read);
+    }
+}
+
+/**
+ * serialReadVarint leaves a stream at the byte after the value.
+ */
+TEST(SerialVarintTest, serialReadVarintPosition)
+{
+    stringstream ss;
+
+    serialWriteVarint(ss, 300);
+    ss << "rest";
+
+    uint64_t value = 0;
+    serialReadVarint(ss, value);
+
+    string rest;
+    ss >> rest;
+
+    EXPECT_EQ(300U, value);
+    EXPECT_EQ("rest", rest);
+}
+
+/**
+ * serialReadVarint throws if a value in a stream is too long.
+ */
+TEST(SerialVarintTest, serialReadVarintOverlong)
+{
+    stringstream ss(string(12, '\x80'));
+    uint64_t value;
+
+    EXPECT_THROW(
+        serialReadVarint(ss, value),
+        vix::exception::SerialRead);
+}
+
+/**
+ * Small values are written in a single byte.
+ */
+TEST(SerialVarintTest, serialWriteVarintSize)
+{
+    stringstream ss;
+
+    serialWriteVarint(ss, 42);
+
+    EXPECT_EQ(1U, ss.str().size());
+}
+
+/**
+ * serialWriteVarint throws if the stream is bad.
+ */
+TEST(SerialVarintTest, serialWriteVarintException)
+{
+    stringstream ss;
+    ss.setstate(ios::badbit);
+
+    EXPECT_THROW(
+        serialWriteVarint(ss, 42),
+        vix::exception::SerialWrite);
+}
+
+/**
+ * serialReadVarint throws if the stream ends partway through a value.
+ */
+TEST(SerialVarintTest, serialReadVarintException)
+{
+    stringstream ss(string(1, '\x80'));
+    uint64_t value;
+
+    EXPECT_THROW(
+        serialReadVarint(ss, value),
+        vix::exception::SerialRead);
+}
+
+/**
+ * serialReadZigzag reads back a value written by serialWriteZigzag.
+ */
+TEST(SerialVarintTest, serialReadWriteZigzag)
+{
+    const vector<int64_t> VALUES{0, -1, 1, -300, 300,
+                                 numeric_limits<int64_t>::min(),
+                                 numeric_limits<int64_t>::max()};
+    stringstream ss;
+
+    for (auto value : VALUES)
+        serialWriteZigzag(ss, value);
+
+    for (auto value : VALUES)
+    {
+        int64_t read = 0;
+        serialReadZigzag(ss, read);
+        EXPECT_EQ(value, read);
+    }
+}
+
+/**
+ * serialWriteCompact writes a string with a varint length prefix, and
+ * serialReadCompact reads it back.
+ */
+TEST(SerialVarintTest, serialReadWriteCompact)
+{
+    const string EXPECTED_STRING{"The string to be written."};
+    string readString;
+    stringstream ss;
+
+    serialWriteCompact(ss, EXPECTED_STRING);
+
+    //one byte of length, then the string.
+    EXPECT_EQ(EXPECTED_STRING.size() + 1, ss.str().size());
+
+    serialReadCompact(ss, readString);
+
+    EXPECT_EQ(EXPECTED_STRING, readString);
+}
+
+/**
+ * serialReadCompact handles the empty string.
+ */
+TEST(SerialVarintTest, serialReadWriteCompactEmpty)
+{
+    string readString{"not empty"};
+    stringstream ss;
+
+    serialWriteCompact(ss, string());
+    serialReadCompact(ss, readString);
+
+    EXPECT_EQ(string(), readString);
+}
+
+/**
+ * serialReadCompact throws if the string is truncated.
+ */
+TEST(SerialVarintTest, serialReadCompactException)
+{
+    stringstream ss;
+    string readString;
+
+    serialWriteCompact(ss, "Truncated");
+
+    stringstream truncated(ss.str().substr(0, 5));
+
+    EXPECT_THROW(
+        serialReadCompact(truncated, readString),
+        vix::exception::SerialRead);
+}
+
+/**
+ * serialReadCompact throws, rather than allocating, when a corrupt length asks
+ * for far more than the stream holds.
+ */
+TEST(SerialVarintTest, serialReadCompactHugeLength)
+{
+    stringstream ss;
+    string readString;
+
+    serialWriteVarint(ss, 1ULL << 40);
+    ss << "short";
+
+    EXPECT_THROW(
+        serialReadCompact(ss, readString),
+        vix::exception::SerialRead);
+
+    stringstream large;
+    string expected(3 * 64 * 1024 + 17, 'x');
+
+    serialWriteCompact(large, expected);
+    serialReadCompact(large, readString);
+
+    EXPECT_EQ(expected, readString);
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+#include <vix/StringRef.h>
+
+using namespace std;
+using namespace vix;
+
+TEST(StringRef, defaultConstructor)
+{
+    StringRef s;
+
+    ASSERT_TRUE(s.empty());
+    ASSERT_EQ(0U, s.size());
+    ASSERT_EQ(string(), s.str());
+}
+
+TEST(StringRef, stringConstructor)
+{
+    string str("This is a test");
+    StringRef s(str);
+
+    ASSERT_EQ(str.data(), s.data());
+    ASSERT_EQ(str.size(), s.size());
+    ASSERT_EQ(str, s.str());
+    ASSERT_EQ('T', s[0]);
+    ASSERT_EQ(str.size(), (size_t)(s.end() - s.begin()));
+}
+
+TEST(StringRef, equality)
+{
+    string a("Test");
+    string b("Test");
+    string c("Tess");
+
+    ASSERT_TRUE(StringRef(a) == StringRef(b));
+    ASSERT_TRUE(StringRef(a) != StringRef(c));
+    ASSERT_TRUE(StringRef(a) != StringRef(a.data(), 3));
+    ASSERT_TRUE(StringRef() == StringRef(a.data(), 0));
+}
@@ -0,0 +1,290 @@
+#include <gtest/gtest.h>
+#include <vix/TaskScheduler.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * A gate tasks can be held at until the test opens it.
+     */
+    class Gate
+    {
+    public:
+        void pass()
+        {
+            unique_lock<mutex> lock(mutex_);
+            ++waiting_;
+            arrived_.notify_all();
+            opened_.wait(lock, [this] { return open_; });
+        }
+
+        void waitFor(int waiting)
+        {
+            unique_lock<mutex> lock(mutex_);
+            arrived_.wait(lock, [&] { return waiting_ >= waiting; });
+        }
+
+        void open()
+        {
+            {
+                lock_guard<mutex> lock(mutex_);
+                open_ = true;
+            }
+
+            opened_.notify_all();
+        }
+
+    private:
+        mutex mutex_;
+        condition_variable arrived_;
+        condition_variable opened_;
+        int waiting_ = 0;
+        bool open_ = false;
+    };
+}
+
+/**
+ * Every task submitted runs, across the pool's threads.
+ */
+TEST(TaskSchedulerTest, run)
+{
+    TaskScheduler scheduler(4);
+    atomic<int> count(0);
+
+    EXPECT_EQ(4U, scheduler.threads());
+
+    for (int i = 0; i < 1000; ++i)
+        scheduler.submit([&] { ++count; });
+
+    scheduler.wait();
+    EXPECT_EQ(1000, count.load());
+
+    auto statistics = scheduler.statistics();
+    EXPECT_EQ(0U, statistics.queued);
+    EXPECT_EQ(1000U, statistics.executed);
+    EXPECT_LE(statistics.maxLatency * 1000, statistics.totalLatency * 1000);
+}
+
+/**
+ * Tasks submitted by tasks are waited for too.
+ */
+TEST(TaskSchedulerTest, nested)
+{
+    TaskScheduler scheduler(2);
+    atomic<int> count(0);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        scheduler.submit([&] {
+            for (int j = 0; j < 10; ++j)
+                scheduler.submit([&] { ++count; });
+        });
+    }
+
+    scheduler.wait();
+    EXPECT_EQ(100, count.load());
+}
+
+/**
+ * Interactive tasks are taken before background ones.
+ */
+TEST(TaskSchedulerTest, priority)
+{
+    TaskScheduler scheduler(1);
+    Gate gate;
+    mutex orderMutex;
+    vector<int> order;
+
+    scheduler.submit([&] { gate.pass(); });
+    gate.waitFor(1);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        scheduler.submit([&, i] {
+            lock_guard<mutex> lock(orderMutex);
+            order.push_back(i);
+        }, i == 2 ? TaskScheduler::INTERACTIVE : TaskScheduler::BACKGROUND);
+    }
+
+    gate.open();
+    scheduler.wait();
+
+    ASSERT_EQ(3U, order.size());
+    EXPECT_EQ(2, order[0]);
+}
+
+/**
+ * Idle threads steal tasks queued on a busy thread.
+ */
+TEST(TaskSchedulerTest, steal)
+{
+    TaskScheduler scheduler(2);
+    Gate gate;
+    mutex threadsMutex;
+    set<thread::id> threads;
+
+    //one task fills its thread's deque, then holds the thread up.  Either
+    //thread may have stolen that task itself.
+    uint64_t before = 0;
+    scheduler.submit([&] {
+        before = scheduler.statistics().stolen;
+
+        for (int i = 0; i < 20; ++i)
+        {
+            scheduler.submit([&] {
+                lock_guard<mutex> lock(threadsMutex);
+                threads.insert(this_thread::get_id());
+            });
+        }
+
+        gate.pass();
+    });
+
+    gate.waitFor(1);
+
+    //the other thread gets through the lot meanwhile.
+    while (scheduler.statistics().queued > 0)
+        this_thread::sleep_for(chrono::milliseconds(1));
+
+    gate.open();
+    scheduler.wait();
+
+    EXPECT_EQ(1U, threads.size());
+    EXPECT_EQ(20U, scheduler.statistics().stolen - before);
+}
+
+/**
+ * Cancelled tasks are dropped without running.
+ */
+TEST(TaskSchedulerTest, cancel)
+{
+    TaskScheduler scheduler(1);
+    Gate gate;
+    CancellationToken token;
+    atomic<int> count(0);
+    atomic<int> version(1);
+
+    scheduler.submit([&] { gate.pass(); });
+    gate.waitFor(1);
+
+    scheduler.submit([&] { ++count; }, TaskScheduler::BACKGROUND, token);
+    scheduler.submit(
+        [&] { ++count; }, TaskScheduler::BACKGROUND,
+        CancellationToken([&] { return version != 1; }));
+    scheduler.submit([&] { ++count; });
+
+    token.cancel();
+    version = 2;
+
+    gate.open();
+    scheduler.wait();
+
+    EXPECT_EQ(1, count.load());
+    EXPECT_EQ(2U, scheduler.statistics().cancelled);
+}
+
+/**
+ * A task which throws doesn't take the scheduler down.
+ */
+TEST(TaskSchedulerTest, failure)
+{
+    TaskScheduler scheduler(1);
+    atomic<int> count(0);
+
+    scheduler.submit([] { throw runtime_error("task failed"); });
+    scheduler.submit([&] { ++count; });
+    scheduler.wait();
+
+    EXPECT_EQ(1, count.load());
+    EXPECT_EQ(1U, scheduler.statistics().failed);
+}
+
+/**
+ * Destroying a scheduler runs the tasks already submitted.
+ */
+TEST(TaskSchedulerTest, destroy)
+{
+    atomic<int> count(0);
+
+    {
+        TaskScheduler scheduler(2);
+        for (int i = 0; i < 100; ++i)
+            scheduler.submit([&] { ++count; });
+    }
+
+    EXPECT_EQ(100, count.load());
+}
+
+/**
+ * parallelFor calls the function once with each index.
+ */
+TEST(TaskSchedulerTest, parallelFor)
+{
+    TaskScheduler scheduler(4);
+    vector<atomic<int>> calls(1000);
+
+    for (auto& count : calls)
+        count = 0;
+
+    scheduler.parallelFor(calls.size(), [&](size_t i) { ++calls[i]; });
+
+    for (auto& count : calls)
+        EXPECT_EQ(1, count.load());
+
+    scheduler.parallelFor(0, [&](size_t) { ADD_FAILURE(); });
+}
+
+/**
+ * parallelFor rethrows the exception from the lowest index, once every call
+ * has returned.
+ */
+TEST(TaskSchedulerTest, parallelForFailure)
+{
+    TaskScheduler scheduler(2);
+    atomic<int> count(0);
+
+    try
+    {
+        scheduler.parallelFor(8, [&](size_t i) {
+            ++count;
+            if (i == 3 || i == 6)
+                throw runtime_error(to_string(i));
+        });
+
+        ADD_FAILURE();
+    }
+    catch (runtime_error& e)
+    {
+        EXPECT_EQ(string("3"), e.what());
+    }
+
+    EXPECT_EQ(8, count.load());
+}
+
+/**
+ * parallelFor can be called from a task, even with every thread busy.
+ */
+TEST(TaskSchedulerTest, parallelForNested)
+{
+    TaskScheduler scheduler(1);
+    atomic<int> count(0);
+
+    scheduler.submit([&] {
+        scheduler.parallelFor(16, [&](size_t) { ++count; });
+    });
+
+    scheduler.wait();
+
+    EXPECT_EQ(16, count.load());
+}
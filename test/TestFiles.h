@@ -0,0 +1,80 @@
+#ifndef  TEST_FILES_HEADER_GUARD
+# define TEST_FILES_HEADER_GUARD
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <vix/Buffer.h>
+
+namespace vix {
+
+    /**
+     * Returns the text of each line of a buffer.
+     */
+    inline std::vector<std::wstring> bufferLines(const Buffer& buffer)
+    {
+        std::vector<std::wstring> lines;
+
+        for (auto& line : buffer)
+            lines.push_back(line.str());
+
+        return lines;
+    }
+
+    /**
+     * A TemporaryFile is an empty file under /tmp, named after the running
+     * test case, which is removed when it goes out of scope.
+     */
+    class TemporaryFile
+    {
+    public:
+        TemporaryFile()
+            : path_(std::string("/tmp/vix")
+                + ::testing::UnitTest::GetInstance()->current_test_info()->test_case_name()
+                + "XXXXXX")
+        {
+            int fd = mkstemp(&path_[0]);
+            if (fd < 0)
+                ADD_FAILURE() << "Could not create " << path_;
+            else
+                close(fd);
+        }
+
+        ~TemporaryFile()
+        {
+            unlink(path_.c_str());
+        }
+
+        const std::string& path() const
+        {
+            return path_;
+        }
+
+    private:
+        std::string path_;
+
+        TemporaryFile(const TemporaryFile&) = delete;
+        TemporaryFile& operator=(const TemporaryFile&) = delete;
+    };
+
+    /**
+     * A TemporaryFileTest gives each test an empty file, at path, which is
+     * removed once the test is done.  Files named after it are for the
+     * fixture to remove.
+     */
+    class TemporaryFileTest : public ::testing::Test
+    {
+    protected:
+        TemporaryFileTest() : path(file.path())
+        {
+        }
+
+        TemporaryFile file;
+        const std::string path;
+    };
+
+} /* namespace vix */
+
+#endif //TEST_FILES_HEADER_GUARD
@@ -0,0 +1,243 @@
+#include <gtest/gtest.h>
+#include <vix/TextFile.h>
+
+#include <csignal>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Read a text and write it back in the format it was read in.
+     */
+    string roundTrip(const string& text)
+    {
+        Buffer buffer;
+        TextFormat format;
+        ostringstream out;
+
+        readText(text.data(), text.size(), buffer, format);
+        writeText(out, buffer, format);
+
+        return out.str();
+    }
+}
+
+/**
+ * Reading a text fills the buffer with its lines, and reports its format.
+ */
+TEST(TextFileTest, read)
+{
+    const string TEXT("caf\xC3\xA9\r\n\r\nend\r\n");
+    Buffer buffer;
+    TextFormat format;
+
+    readText(TEXT.data(), TEXT.size(), buffer, format);
+
+    EXPECT_EQ((vector<wstring>{L"café", L"", L"end"}), bufferLines(buffer));
+    EXPECT_EQ(LINE_ENDING_CRLF, format.ending);
+    EXPECT_FALSE(format.mixed);
+    EXPECT_TRUE(format.finalNewline);
+    EXPECT_TRUE(format.utf8);
+}
+
+/**
+ * Text which isn't UTF-8 is read with replacement characters, and reported.
+ */
+TEST(TextFileTest, notUtf8)
+{
+    const string TEXT("caf\xE9\n");
+    Buffer buffer;
+    TextFormat format;
+
+    readText(TEXT.data(), TEXT.size(), buffer, format);
+
+    EXPECT_EQ((vector<wstring>{L"caf�"}), bufferLines(buffer));
+    EXPECT_FALSE(format.utf8);
+}
+
+/**
+ * A text read in parallel chunks gives exactly the lines of a serial read.
+ */
+TEST(TextFileTest, parallel)
+{
+    mt19937 rng(7);
+    const char* PIECES[] = {"a", "bc", " ", "\xC3\xA9", "\xE9", "\r\n", "\n"};
+    string text;
+
+    while (text.size() < (5 << 20))
+        text += PIECES[rng() % (sizeof(PIECES) / sizeof(PIECES[0]))];
+
+    Buffer serial;
+    TextFormat serialFormat;
+    readText(text.data(), text.size(), serial, serialFormat);
+
+    for (unsigned threads : {2U, 4U, 7U})
+    {
+        Buffer parallel;
+        TextFormat format;
+        readText(text.data(), text.size(), parallel, format, threads);
+
+        ASSERT_EQ(bufferLines(serial), bufferLines(parallel)) << threads;
+        EXPECT_EQ(serialFormat.ending, format.ending);
+        EXPECT_EQ(serialFormat.mixed, format.mixed);
+        EXPECT_EQ(serialFormat.finalNewline, format.finalNewline);
+        EXPECT_EQ(serialFormat.utf8, format.utf8);
+    }
+}
+
+/**
+ * Writing a text back in the format it was read in gives the same bytes.
+ */
+TEST(TextFileTest, roundTrip)
+{
+    const string TEXTS[] = {
+        "", "a", "a\n", "a\nb", "a\r\nb\r\n", "a\rb", "\n\n", "x\xE2\x82\xAC\n",
+    };
+
+    for (auto& text : TEXTS)
+        EXPECT_EQ(text, roundTrip(text));
+
+    //mixed endings are written the most common way.
+    EXPECT_EQ("a\r\nb\r\nc\r\n", roundTrip("a\r\nb\nc\r\n"));
+}
+
+/**
+ * Lone carriage returns within lines which end at line feeds are kept as part
+ * of their lines, and don't change how the lines are written.
+ */
+TEST(TextFileTest, loneCarriageReturns)
+{
+    const string TEXTS[] = {
+        "10%\r20%\r50%\r100%\ndone\n",
+        "10%\r20%\r50%\r100%\r\ndone\r\n",
+    };
+
+    for (auto& text : TEXTS)
+    {
+        Buffer buffer;
+        TextFormat format;
+
+        readText(text.data(), text.size(), buffer, format);
+
+        EXPECT_EQ((vector<wstring>{L"10%\r20%\r50%\r100%", L"done"}),
+            bufferLines(buffer));
+        EXPECT_FALSE(format.mixed);
+        EXPECT_EQ(text, roundTrip(text));
+    }
+}
+
+/**
+ * A new buffer is written with a line feed after every line.
+ */
+TEST(TextFileTest, write)
+{
+    Buffer buffer;
+    buffer.append(Line(L"one"));
+    buffer.append(Line(L"two"));
+
+    ostringstream out;
+    writeText(out, buffer);
+
+    EXPECT_EQ("one\ntwo\n", out.str());
+}
+
+/**
+ * A file is read through a mapping.
+ */
+TEST(TextFileTest, readFile)
+{
+    TemporaryFile file;
+
+    {
+        ofstream out(file.path(), ios::binary);
+        out << "first\nsecond\n";
+    }
+
+    Buffer buffer;
+    TextFormat format;
+    readTextFile(file.path(), buffer, format);
+    unlink(file.path().c_str());
+
+    EXPECT_EQ((vector<wstring>{L"first", L"second"}), bufferLines(buffer));
+    EXPECT_THROW(readTextFile(file.path(), buffer, format), exception::FileOpen);
+}
+
+/**
+ * A buffer written to a file reads back the same.
+ */
+TEST(TextFileTest, writeFile)
+{
+    TemporaryFile file;
+
+    Buffer buffer;
+    for (int i = 0; i < 100000; ++i)
+        buffer.append(Line(L"line " + to_wstring(i) + L" \u00e9"));
+
+    TextFormat format;
+    format.ending = LINE_ENDING_CRLF;
+    format.finalNewline = false;
+    writeTextFile(file.path(), buffer, format);
+
+    Buffer read;
+    TextFormat readFormat;
+    readTextFile(file.path(), read, readFormat);
+
+    EXPECT_EQ(bufferLines(buffer), bufferLines(read));
+    EXPECT_EQ(LINE_ENDING_CRLF, readFormat.ending);
+    EXPECT_FALSE(readFormat.finalNewline);
+
+    EXPECT_THROW(
+        writeTextFile("/nonexistent/file", buffer), exception::FileOpen);
+}
+
+/**
+ * A save which fails part way through leaves the file as it was, keeps its
+ * permissions when it succeeds, and leaves nothing behind either way.
+ */
+TEST(TextFileTest, writeFileFailure)
+{
+    TemporaryFile file;
+
+    ofstream(file.path(), ios::binary) << "original\n";
+    chmod(file.path().c_str(), 0600);
+
+    Buffer buffer;
+    for (int i = 0; i < 100000; ++i)
+        buffer.append(Line(L"line " + to_wstring(i)));
+
+    //writes past the size limit fail, as they would on a full disk.
+    rlimit limit;
+    ASSERT_EQ(0, getrlimit(RLIMIT_FSIZE, &limit));
+    rlimit small = limit;
+    small.rlim_cur = 4096;
+    auto oldHandler = signal(SIGXFSZ, SIG_IGN);
+    ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &small));
+
+    EXPECT_THROW(writeTextFile(file.path(), buffer), exception::FileWrite);
+
+    setrlimit(RLIMIT_FSIZE, &limit);
+    signal(SIGXFSZ, oldHandler);
+
+    ifstream in(file.path(), ios::binary);
+    EXPECT_EQ("original\n", string(istreambuf_iterator<char>(in), istreambuf_iterator<char>()));
+    EXPECT_NE(0, access((file.path() + ".tmp").c_str(), F_OK));
+
+    writeTextFile(file.path(), buffer);
+
+    struct stat written;
+    ASSERT_EQ(0, stat(file.path().c_str(), &written));
+    EXPECT_EQ(0600, written.st_mode & 07777);
+    EXPECT_NE(0, access((file.path() + ".tmp").c_str(), F_OK));
+}
@@ -0,0 +1,432 @@
+#include <gtest/gtest.h>
+#include <vix/EraseTextCommand.h>
+#include <vix/InsertTextCommand.h>
+#include <vix/UndoHistory.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * The number of commands created by the counting registry.
+     */
+    size_t created = 0;
+
+    /**
+     * Returns a registry of the standard commands which counts the commands
+     * it creates.
+     */
+    const CommandRegistry& countingRegistry()
+    {
+        static const CommandRegistry REGISTRY = [] {
+            CommandRegistry registry;
+            registry.add(1, typeid(InsertTextCommand), [] {
+                ++created;
+                return make_shared<InsertTextCommand>();
+            });
+            registry.add(2, typeid(EraseTextCommand), [] {
+                ++created;
+                return make_shared<EraseTextCommand>();
+            });
+
+            return registry;
+        }();
+
+        return REGISTRY;
+    }
+
+    /**
+     * The number of loaded commands applied or reverted.
+     */
+    size_t stepped = 0;
+
+    /**
+     * An insert which counts how often it is applied or reverted.
+     */
+    class SteppedInsertTextCommand : public InsertTextCommand
+    {
+    public:
+        virtual void apply(weak_ptr<Buffer> buffer)
+        {
+            ++stepped;
+            InsertTextCommand::apply(buffer);
+        }
+
+        virtual void revert(weak_ptr<Buffer> buffer)
+        {
+            ++stepped;
+            InsertTextCommand::revert(buffer);
+        }
+    };
+
+    /**
+     * Returns a registry whose inserts count how often they are stepped
+     * through.
+     */
+    const CommandRegistry& steppingRegistry()
+    {
+        static const CommandRegistry REGISTRY = [] {
+            CommandRegistry registry;
+            registry.add(1, typeid(InsertTextCommand), [] {
+                return make_shared<SteppedInsertTextCommand>();
+            });
+
+            return registry;
+        }();
+
+        return REGISTRY;
+    }
+
+    /**
+     * Returns the first line of a buffer.
+     */
+    wstring text(const Buffer& buffer)
+    {
+        return buffer.begin()->str();
+    }
+}
+
+class UndoHistoryTest : public TemporaryFileTest
+{
+protected:
+    string historyPath;
+
+    virtual void SetUp() {
+        historyPath = UndoHistory::historyPath(path);
+        created = 0;
+    }
+
+    virtual void TearDown() {
+        unlink(historyPath.c_str());
+        unlink((historyPath + ".tmp").c_str());
+    }
+
+    /**
+     * Write the file, as saving the buffer would.
+     */
+    void write(const Buffer& buffer) {
+        ofstream out(path, ios::binary | ios::trunc);
+        for (auto& line : buffer)
+            out << string(line.str().begin(), line.str().end()) << '\n';
+    }
+
+    /**
+     * Returns a buffer holding a single line.
+     */
+    shared_ptr<Buffer> buffer(const wstring& line) {
+        auto b = make_shared<Buffer>();
+        b->append(Line(line));
+
+        return b;
+    }
+
+    /**
+     * Returns the size of the history journal.
+     */
+    size_t historySize() {
+        ifstream in(historyPath, ios::binary | ios::ate);
+
+        return in.tellg();
+    }
+
+    /**
+     * Returns the number of undo nodes in the history journal.
+     */
+    size_t savedNodes() {
+        size_t nodes = 0;
+        recoverJournal(historyPath, [&](const JournalRecord& record) {
+            nodes += record.type == JOURNAL_UNDO_NODE;
+        });
+
+        return nodes;
+    }
+};
+
+/**
+ * The history lives beside the file.
+ */
+TEST_F(UndoHistoryTest, historyPath)
+{
+    EXPECT_EQ("dir/.file.txt.vixundo", UndoHistory::historyPath("dir/file.txt"));
+    EXPECT_EQ("/.file.vixundo", UndoHistory::historyPath("/file"));
+    EXPECT_EQ(".file.vixundo", UndoHistory::historyPath("file"));
+}
+
+/**
+ * Without a history, nothing is loaded.
+ */
+TEST_F(UndoHistoryTest, noHistory)
+{
+    auto b = buffer(L"");
+    UndoTree tree(b);
+    UndoHistory history(historyPath);
+
+    EXPECT_FALSE(history.load(tree, path));
+    EXPECT_EQ(1U, tree.size());
+}
+
+/**
+ * A saved tree, branches and all, is loaded into the next session.
+ */
+TEST_F(UndoHistoryTest, roundTrip)
+{
+    auto time = UndoTree::clock::time_point(chrono::seconds(1000000));
+    UndoTree::NodeId branch;
+
+    {
+        auto b = buffer(L"");
+        UndoTree tree(b);
+        UndoHistory history(historyPath);
+
+        tree.apply(make_shared<InsertTextCommand>(0, 0, L"Hello"), time);
+        tree.apply(make_shared<InsertTextCommand>(0, 5, L", world"), time + chrono::seconds(1));
+        branch = tree.current();
+        tree.undo();
+        tree.apply(make_shared<InsertTextCommand>(0, 5, L" there"), time + chrono::seconds(2));
+        tree.apply(make_shared<EraseTextCommand>(0, 0, 1), time + chrono::seconds(3));
+
+        EXPECT_EQ(L"ello there", text(*b));
+
+        write(*b);
+        history.save(tree, path);
+    }
+
+    auto b = buffer(L"ello there");
+    UndoTree tree(b);
+    UndoHistory history(historyPath);
+
+    ASSERT_TRUE(history.load(tree, path));
+    EXPECT_EQ(5U, tree.size());
+    EXPECT_EQ(4U, tree.current());
+    EXPECT_EQ(time + chrono::seconds(3), tree.timestamp(4));
+    EXPECT_EQ(tree.parent(branch), tree.parent(3));
+
+    EXPECT_TRUE(tree.undo());
+    EXPECT_EQ(L"Hello there", text(*b));
+    EXPECT_TRUE(tree.undo());
+    EXPECT_EQ(L"Hello", text(*b));
+
+    tree.jump(branch);
+    EXPECT_EQ(L"Hello, world", text(*b));
+
+    tree.jump(0);
+    EXPECT_EQ(L"", text(*b));
+
+    tree.jump(4);
+    EXPECT_EQ(L"ello there", text(*b));
+}
+
+/**
+ * Commands are only decoded when they're stepped through.
+ */
+TEST_F(UndoHistoryTest, lazy)
+{
+    {
+        auto b = buffer(L"");
+        UndoTree tree(b);
+        UndoHistory history(historyPath, countingRegistry());
+
+        for (size_t i = 0; i < 1000; ++i)
+            tree.apply(make_shared<InsertTextCommand>(0, i, L"x"));
+
+        write(*b);
+        history.save(tree, path);
+    }
+
+    auto b = buffer(wstring(1000, L'x'));
+    UndoTree tree(b);
+    UndoHistory history(historyPath, countingRegistry());
+
+    created = 0;
+    ASSERT_TRUE(history.load(tree, path));
+    EXPECT_EQ(1001U, tree.size());
+    EXPECT_EQ(0U, created);
+
+    tree.undo();
+    EXPECT_EQ(wstring(999, L'x'), text(*b));
+    EXPECT_EQ(1U, created);
+
+    //and only once.
+    tree.redo();
+    tree.undo();
+    EXPECT_EQ(1U, created);
+}
+
+/**
+ * The loaded state is kept as a checkpoint, so jumping far back and then
+ * forward again doesn't replay the whole history.
+ */
+TEST_F(UndoHistoryTest, jumpAfterLoad)
+{
+    {
+        auto b = buffer(L"");
+        UndoTree tree(b);
+        UndoHistory history(historyPath, steppingRegistry());
+
+        for (size_t i = 0; i < 1000; ++i)
+            tree.apply(make_shared<InsertTextCommand>(0, i, L"x"));
+
+        write(*b);
+        history.save(tree, path);
+    }
+
+    auto b = buffer(wstring(1000, L'x'));
+    UndoTree tree(b);
+    UndoHistory history(historyPath, steppingRegistry());
+
+    ASSERT_TRUE(history.load(tree, path));
+
+    tree.jump(5);
+    EXPECT_EQ(wstring(5, L'x'), text(*b));
+
+    stepped = 0;
+    tree.jump(995);
+
+    EXPECT_EQ(wstring(995, L'x'), text(*b));
+    EXPECT_GE(5U, stepped);
+}
+
+/**
+ * A history is ignored once the file has changed behind its back, and then
+ * replaced by the next save.
+ */
+TEST_F(UndoHistoryTest, changedFile)
+{
+    {
+        auto b = buffer(L"");
+        UndoTree tree(b);
+        UndoHistory history(historyPath);
+
+        tree.apply(make_shared<InsertTextCommand>(0, 0, L"one"));
+        write(*b);
+        history.save(tree, path);
+    }
+
+    auto b = buffer(L"two");
+    write(*b);
+
+    {
+        UndoTree tree(b);
+        UndoHistory history(historyPath);
+
+        EXPECT_FALSE(history.load(tree, path));
+        EXPECT_EQ(1U, tree.size());
+
+        tree.apply(make_shared<InsertTextCommand>(0, 3, L"!"));
+        write(*b);
+        history.save(tree, path);
+    }
+
+    EXPECT_EQ(1U, savedNodes());
+
+    UndoTree tree(b);
+    UndoHistory history(historyPath);
+
+    ASSERT_TRUE(history.load(tree, path));
+    tree.undo();
+    EXPECT_EQ(L"two", text(*b));
+}
+
+/**
+ * Each save appends only the nodes created since the last, across sessions.
+ */
+TEST_F(UndoHistoryTest, append)
+{
+    auto b = buffer(L"");
+
+    for (size_t session = 0; session < 3; ++session)
+    {
+        UndoTree tree(b);
+        UndoHistory history(historyPath);
+
+        EXPECT_EQ(session > 0, history.load(tree, path));
+        EXPECT_EQ(1 + 2 * session, tree.size());
+
+        tree.apply(make_shared<InsertTextCommand>(0, text(*b).size(), L"a"));
+        write(*b);
+        history.save(tree, path);
+
+        tree.apply(make_shared<InsertTextCommand>(0, text(*b).size(), L"b"));
+        write(*b);
+        history.save(tree, path);
+    }
+
+    EXPECT_EQ(6U, savedNodes());
+
+    UndoTree tree(b);
+    UndoHistory history(historyPath);
+
+    ASSERT_TRUE(history.load(tree, path));
+    EXPECT_EQ(L"ababab", text(*b));
+
+    tree.jump(0);
+    EXPECT_EQ(L"", text(*b));
+}
+
+/**
+ * Loading leaves a torn tail on the journal alone, whether or not the history
+ * is used, and the next save appends in its place.
+ */
+TEST_F(UndoHistoryTest, tornTail)
+{
+    auto b = buffer(L"");
+
+    {
+        UndoTree tree(b);
+        UndoHistory history(historyPath);
+
+        tree.apply(make_shared<InsertTextCommand>(0, 0, L"one"));
+        write(*b);
+        history.save(tree, path);
+    }
+
+    {
+        ofstream out(historyPath, ios::binary | ios::app);
+        out << "torn";
+    }
+
+    size_t size = historySize();
+
+    {
+        auto other = buffer(L"two");
+        write(*other);
+
+        UndoTree tree(other);
+        UndoHistory history(historyPath);
+
+        EXPECT_FALSE(history.load(tree, path));
+        EXPECT_EQ(size, historySize());
+    }
+
+    write(*b);
+
+    {
+        UndoTree tree(b);
+        UndoHistory history(historyPath);
+
+        ASSERT_TRUE(history.load(tree, path));
+        EXPECT_EQ(size, historySize());
+
+        tree.apply(make_shared<InsertTextCommand>(0, 3, L"!"));
+        write(*b);
+        history.save(tree, path);
+    }
+
+    EXPECT_EQ(2U, savedNodes());
+
+    UndoTree tree(b);
+    UndoHistory history(historyPath);
+
+    ASSERT_TRUE(history.load(tree, path));
+    EXPECT_EQ(L"one!", text(*b));
+
+    tree.jump(0);
+    EXPECT_EQ(L"", text(*b));
+}
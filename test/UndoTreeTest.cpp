@@ -0,0 +1,349 @@
+#include <gtest/gtest.h>
+#include <vix/UndoTree.h>
+
+#include <chrono>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "TestFiles.h"
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Counts of the commands applied and reverted.
+     */
+    size_t applied = 0;
+    size_t reverted = 0;
+
+    /**
+     * A command which inserts a line at a given index.
+     */
+    class InsertLineCommand : public Command
+    {
+    public:
+        InsertLineCommand(size_t index, const wstring& text)
+            : index_(index), text_(text)
+        {
+        }
+
+        virtual void apply(weak_ptr<Buffer> buffer)
+        {
+            auto b = buffer.lock();
+            b->insert(next(b->begin(), index_), Line(text_));
+            ++applied;
+        }
+
+        virtual void revert(weak_ptr<Buffer> buffer)
+        {
+            auto b = buffer.lock();
+            b->erase(next(b->begin(), index_));
+            ++reverted;
+        }
+
+        virtual void serialRead(istream&) { }
+        virtual void serialWrite(ostream&) const { }
+
+    private:
+        size_t index_;
+        wstring text_;
+    };
+}
+
+class UndoTreeTest : public ::testing::Test
+{
+protected:
+    shared_ptr<Buffer> buffer;
+
+    virtual void SetUp() {
+        buffer = make_shared<Buffer>();
+        buffer->append(Line(L"root"));
+        applied = 0;
+        reverted = 0;
+    }
+
+    shared_ptr<Command> insert(size_t index, const wstring& text) {
+        return make_shared<InsertLineCommand>(index, text);
+    }
+};
+
+/**
+ * Undo and redo walk a linear history.
+ */
+TEST_F(UndoTreeTest, undoRedo)
+{
+    UndoTree tree(buffer);
+
+    tree.apply(insert(1, L"a"));
+    tree.apply(insert(2, L"b"));
+    EXPECT_EQ(vector<wstring>({L"root", L"a", L"b"}), bufferLines(*buffer));
+
+    EXPECT_TRUE(tree.undo());
+    EXPECT_EQ(vector<wstring>({L"root", L"a"}), bufferLines(*buffer));
+    EXPECT_TRUE(tree.undo());
+    EXPECT_FALSE(tree.undo());
+    EXPECT_EQ(vector<wstring>({L"root"}), bufferLines(*buffer));
+
+    EXPECT_TRUE(tree.redo());
+    EXPECT_TRUE(tree.redo());
+    EXPECT_FALSE(tree.redo());
+    EXPECT_EQ(vector<wstring>({L"root", L"a", L"b"}), bufferLines(*buffer));
+}
+
+/**
+ * A new edit after an undo starts a branch, and the undone branch can still be
+ * reached.
+ */
+TEST_F(UndoTreeTest, branches)
+{
+    UndoTree tree(buffer);
+
+    tree.apply(insert(1, L"a"));
+    tree.apply(insert(2, L"b"));
+    UndoTree::NodeId b = tree.current();
+
+    tree.undo();
+    tree.apply(insert(2, L"c"));
+    UndoTree::NodeId c = tree.current();
+
+    EXPECT_EQ(4U, tree.size());
+    EXPECT_EQ(tree.parent(b), tree.parent(c));
+    EXPECT_EQ(tree.parent(b), tree.ancestor(b, c));
+    EXPECT_EQ(vector<wstring>({L"root", L"a", L"c"}), bufferLines(*buffer));
+
+    //the jump takes the shortest path, through the common ancestor.
+    applied = 0;
+    reverted = 0;
+    tree.jump(b);
+    EXPECT_EQ(vector<wstring>({L"root", L"a", L"b"}), bufferLines(*buffer));
+    EXPECT_EQ(1U, reverted);
+    EXPECT_EQ(1U, applied);
+
+    //redo follows the branch most recently visited.
+    tree.undo();
+    tree.redo();
+    EXPECT_EQ(b, tree.current());
+}
+
+/**
+ * The common ancestor of two nodes is found in deep, bushy trees.
+ */
+TEST_F(UndoTreeTest, ancestor)
+{
+    UndoTree tree(buffer, 1000000);
+    vector<UndoTree::NodeId> spine;
+
+    //a long spine, with a short branch off every node.
+    for (size_t i = 0; i < 500; ++i)
+    {
+        tree.apply(insert(1, L"x"));
+        spine.push_back(tree.current());
+
+        tree.apply(insert(1, L"y"));
+        tree.undo();
+    }
+
+    for (size_t i = 0; i < spine.size(); i += 7)
+    {
+        for (size_t j = 0; j < spine.size(); j += 13)
+        {
+            UndoTree::NodeId branch = spine[j] + 1;
+
+            EXPECT_EQ(spine[min(i, j)], tree.ancestor(spine[i], spine[j]));
+            EXPECT_EQ(spine[min(i, j)], tree.ancestor(spine[i], branch));
+        }
+    }
+}
+
+/**
+ * A long jump restores a checkpoint rather than replaying every command.
+ */
+TEST_F(UndoTreeTest, checkpoints)
+{
+    UndoTree tree(buffer, 16);
+    vector<vector<wstring>> states{bufferLines(*buffer)};
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        tree.apply(insert(1 + i % 3, to_wstring(i)));
+        states.push_back(bufferLines(*buffer));
+    }
+
+    tree.jump(0);
+    EXPECT_EQ(states[0], bufferLines(*buffer));
+
+    applied = 0;
+    reverted = 0;
+    tree.jump(990);
+
+    EXPECT_EQ(states[990], bufferLines(*buffer));
+    EXPECT_LT(applied + reverted, 16U);
+
+    //every state is rebuilt correctly, whichever route is taken.
+    for (size_t target : {500, 3, 999, 17, 16, 0, 640})
+    {
+        tree.jump(target);
+        EXPECT_EQ(states[target], bufferLines(*buffer));
+    }
+}
+
+/**
+ * Only as many of the most recent checkpoints are kept as fit the byte budget,
+ * and jumps still work without the others.
+ */
+TEST_F(UndoTreeTest, maxCheckpointBytes)
+{
+    UndoTree tree(buffer, 4, 1);
+    vector<vector<wstring>> states{bufferLines(*buffer)};
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        tree.apply(insert(1, to_wstring(i)));
+        states.push_back(bufferLines(*buffer));
+    }
+
+    for (size_t target : {0, 50, 97, 10, 100})
+    {
+        tree.jump(target);
+        EXPECT_EQ(states[target], bufferLines(*buffer));
+    }
+}
+
+/**
+ * Checkpoints share the runs of lines which haven't changed since the one
+ * before, rather than copying the whole buffer.
+ */
+TEST_F(UndoTreeTest, checkpointsShareLines)
+{
+    for (size_t i = 0; i < 10000; ++i)
+        buffer->append(Line(to_wstring(i)));
+
+    UndoTree tree(buffer, 1);
+    size_t rootBytes = tree.checkpointBytes();
+    vector<vector<wstring>> states{bufferLines(*buffer)};
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        tree.apply(insert(1 + i * 97 % 5000, L"new " + to_wstring(i)));
+        states.push_back(bufferLines(*buffer));
+    }
+
+    //a hundred copies would take a hundred times the root's checkpoint.
+    EXPECT_LT(tree.checkpointBytes(), 10 * rootBytes);
+
+    for (size_t target : {0, 50, 99, 1, 75})
+    {
+        tree.jump(target);
+        EXPECT_EQ(states[target], bufferLines(*buffer));
+    }
+}
+
+/**
+ * States can be found and reached by time.
+ */
+TEST_F(UndoTreeTest, time)
+{
+    UndoTree tree(buffer);
+    auto start = tree.timestamp(0);
+
+    for (int minute = 1; minute <= 30; ++minute)
+        tree.apply(insert(1, to_wstring(minute)), start + chrono::minutes(minute));
+
+    EXPECT_EQ(0U, tree.at(start - chrono::minutes(1)));
+    EXPECT_EQ(10U, tree.at(start + chrono::minutes(10)));
+    EXPECT_EQ(10U, tree.at(start + chrono::seconds(630)));
+    EXPECT_EQ(30U, tree.at(start + chrono::hours(1)));
+
+    tree.earlier(chrono::minutes(10));
+    EXPECT_EQ(20U, tree.current());
+    EXPECT_EQ(L"20", next(buffer->begin())->str());
+
+    tree.later(chrono::minutes(5));
+    EXPECT_EQ(25U, tree.current());
+
+    tree.jump(start);
+    EXPECT_EQ(1U, buffer->lines());
+}
+
+/**
+ * Timestamps never go backwards, even if the clock does.
+ */
+TEST_F(UndoTreeTest, monotonicTime)
+{
+    UndoTree tree(buffer);
+    auto start = tree.timestamp(0);
+
+    tree.apply(insert(1, L"a"), start + chrono::minutes(5));
+    tree.apply(insert(1, L"b"), start + chrono::minutes(1));
+
+    EXPECT_EQ(tree.timestamp(1), tree.timestamp(2));
+    EXPECT_EQ(2U, tree.at(start + chrono::minutes(5)));
+}
+
+/**
+ * A grafted tree, rebased onto the state the buffer already holds, can be
+ * walked like one built by applying commands.
+ */
+TEST_F(UndoTreeTest, graft)
+{
+    auto when = UndoTree::clock::now() - chrono::hours(1);
+
+    buffer->append(Line(L"a"));
+    buffer->append(Line(L"b"));
+
+    UndoTree tree(buffer);
+    UndoTree::NodeId a = tree.graft(0, insert(1, L"a"), when);
+    UndoTree::NodeId b = tree.graft(a, insert(2, L"b"), when);
+    UndoTree::NodeId c = tree.graft(a, insert(2, L"c"), when);
+    tree.rebase(b);
+
+    EXPECT_EQ(0U, applied);
+    EXPECT_EQ(b, tree.current());
+    EXPECT_EQ(when, tree.timestamp(0));
+
+    tree.jump(c);
+    EXPECT_EQ(vector<wstring>({L"root", L"a", L"c"}), bufferLines(*buffer));
+
+    tree.jump(0);
+    EXPECT_EQ(vector<wstring>({L"root"}), bufferLines(*buffer));
+
+    //redo leads back along the rebased path first.
+    tree.jump(b);
+    tree.jump(0);
+    tree.redo();
+    tree.redo();
+    EXPECT_EQ(b, tree.current());
+}
+
+/**
+ * A rebased tree keeps the buffer as a checkpoint, so after jumping far back
+ * it can come forward again without replaying the history.
+ */
+TEST_F(UndoTreeTest, rebaseCheckpoint)
+{
+    UndoTree tree(buffer, 16);
+    vector<vector<wstring>> states{bufferLines(*buffer)};
+    UndoTree::NodeId node = 0;
+    auto when = UndoTree::clock::now();
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        node = tree.graft(node, insert(1, to_wstring(i)), when);
+        buffer->insert(next(buffer->begin()), Line(to_wstring(i)));
+        states.push_back(bufferLines(*buffer));
+    }
+
+    tree.rebase(node);
+
+    tree.jump(5);
+    EXPECT_EQ(states[5], bufferLines(*buffer));
+
+    applied = 0;
+    reverted = 0;
+    tree.jump(995);
+
+    EXPECT_EQ(states[995], bufferLines(*buffer));
+    EXPECT_LT(applied + reverted, 16U);
+}
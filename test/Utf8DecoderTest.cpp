@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <vix/Utf8.h>
+#include <vix/Utf8Decoder.h>
+
+#include <string>
+
+using namespace std;
+using namespace vix;
+
+namespace {
+    /**
+     * Decode a buffer in two chunks, split at the given byte.
+     */
+    wstring decodeSplit(const string& in, size_t split, bool& valid)
+    {
+        Utf8Decoder decoder;
+        wstring out;
+
+        decoder.decode(in.data(), split, out);
+        decoder.decode(in.data() + split, in.size() - split, out);
+        valid = decoder.finish(out);
+
+        return out;
+    }
+}
+
+/**
+ * A sequence split between chunks is held back until it is complete.
+ */
+TEST(Utf8DecoderTest, split)
+{
+    Utf8Decoder decoder;
+    wstring out;
+
+    decoder.decode("a\xF0\x9F", 3, out);
+    EXPECT_EQ(L"a", out);
+    EXPECT_EQ(2U, decoder.pending());
+
+    decoder.decode("\x98", 1, out);
+    EXPECT_EQ(L"a", out);
+    EXPECT_EQ(3U, decoder.pending());
+
+    decoder.decode("\x80" "b", 2, out);
+    EXPECT_EQ(L"a\U0001F600b", out);
+    EXPECT_EQ(0U, decoder.pending());
+    EXPECT_TRUE(decoder.finish(out));
+}
+
+/**
+ * Splitting the input anywhere decodes the same as decoding it whole, for
+ * well formed and malformed input.
+ */
+TEST(Utf8DecoderTest, anySplit)
+{
+    const string CASES[] = {
+        "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z",
+        "a\x80" "b\xE2\x82" "a\xC0\xAF\xED\xA0\x80\xF4\x90\x80\x80",
+        "\xF0\x9F\x98",
+        "\xC3\xC3\xA9",
+    };
+
+    for (auto& in : CASES)
+    {
+        wstring expected;
+        bool wellFormed = utf8Decode(in.data(), in.size(), expected);
+
+        for (size_t split = 0; split <= in.size(); ++split)
+        {
+            bool valid;
+            EXPECT_EQ(expected, decodeSplit(in, split, valid)) << split;
+            EXPECT_EQ(wellFormed, valid) << split;
+        }
+    }
+}
+
+/**
+ * Input which ends part way through a sequence finishes with a replacement
+ * character, and the decoder starts again.
+ */
+TEST(Utf8DecoderTest, truncated)
+{
+    Utf8Decoder decoder;
+    wstring out;
+
+    decoder.decode("ab\xE2\x82", 4, out);
+    EXPECT_TRUE(decoder.valid());
+    EXPECT_FALSE(decoder.finish(out));
+    EXPECT_EQ(L"ab�", out);
+
+    decoder.decode("c", 1, out);
+    EXPECT_TRUE(decoder.finish(out));
+    EXPECT_EQ(L"ab�c", out);
+}
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <vix/Utf8.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace vix;
+
+/**
+ * utf8Encode encodes characters of every length.
+ */
+TEST(Utf8Test, encode)
+{
+    string out;
+
+    utf8Encode(L"aé€\U0001F600", out);
+
+    EXPECT_EQ(string("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80"), out);
+    EXPECT_EQ(out.size(), utf8EncodedSize(L"aé€\U0001F600", 4));
+}
+
+/**
+ * utf8Encode appends to the output.
+ */
+TEST(Utf8Test, encodeAppends)
+{
+    string out("prefix ");
+
+    utf8Encode(L"text", out);
+
+    EXPECT_EQ("prefix text", out);
+}
+
+/**
+ * Characters which aren't Unicode scalar values are encoded as the replacement
+ * character.
+ */
+TEST(Utf8Test, encodeInvalid)
+{
+    const wchar_t INVALID[] = {0xD800, (wchar_t)0x110000};
+    string out;
+
+    utf8Encode(INVALID, 2, out);
+
+    EXPECT_EQ(string("\xEF\xBF\xBD\xEF\xBF\xBD"), out);
+    EXPECT_EQ(out.size(), utf8EncodedSize(INVALID, 2));
+}
+
+/**
+ * utf8Decode decodes characters of every length.
+ */
+TEST(Utf8Test, decode)
+{
+    const string IN("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+    wstring out;
+
+    EXPECT_TRUE(utf8Decode(IN.data(), IN.size(), out));
+    EXPECT_EQ(L"aé€\U0001F600", out);
+}
+
+/**
+ * Malformed input is decoded as replacement characters, and reported.
+ */
+TEST(Utf8Test, decodeInvalid)
+{
+    struct { const char* in; const wchar_t* expected; } CASES[] = {
+        //stray continuation byte.
+        {"a\x80" "b", L"a�" L"b"},
+        //invalid lead byte.
+        {"\xFF", L"�"},
+        //truncated sequence, followed by ASCII.
+        {"\xE2\x82" "a", L"�" L"a"},
+        //truncated at end of input.
+        {"\xF0\x9F\x98", L"�"},
+        //overlong encoding of '/'.
+        {"\xC0\xAF", L"�"},
+        //encoded surrogate.
+        {"\xED\xA0\x80", L"�"},
+        //beyond U+10FFFF.
+        {"\xF4\x90\x80\x80", L"�"},
+    };
+
+    for (auto& c : CASES)
+    {
+        wstring out;
+
+        EXPECT_FALSE(utf8Decode(c.in, strlen(c.in), out));
+        EXPECT_EQ(wstring(c.expected), out);
+    }
+}
+
+/**
+ * Decoding what was encoded gives back the original string.
+ */
+TEST(Utf8Test, roundTrip)
+{
+    wstring in;
+    for (wchar_t c = 1; c < 0x11000; c += 7)
+        if (c < 0xD800 || c > 0xDFFF)
+            in.push_back(c);
+
+    string encoded;
+    wstring decoded;
+
+    utf8Encode(in, encoded);
+
+    EXPECT_TRUE(utf8Decode(encoded.data(), encoded.size(), decoded));
+    EXPECT_EQ(in, decoded);
+}
+
+/**
+ * Runs of ASCII long enough for the vector paths decode and encode the same
+ * whichever character interrupts them, wherever it falls.
+ */
+TEST(Utf8Test, asciiRuns)
+{
+    const wstring OTHERS[] = {L"é", L"€", L"\U0001F600"};
+
+    for (auto& other : OTHERS)
+    {
+        for (size_t offset = 0; offset < 80; ++offset)
+        {
+            wstring in(100, L'x');
+            in.insert(offset, other);
+
+            string encoded;
+            utf8Encode(in, encoded);
+
+            string expected(offset, 'x');
+            utf8Encode(other, expected);
+            expected.append(100 - offset, 'x');
+            EXPECT_EQ(expected, encoded);
+
+            wstring decoded(L"prefix");
+            EXPECT_TRUE(utf8Decode(encoded.data(), encoded.size(), decoded));
+            EXPECT_EQ(L"prefix" + in, decoded);
+            EXPECT_TRUE(utf8Validate(encoded.data(), encoded.size()));
+
+            //and a malformed byte in its place is found.
+            string broken(encoded);
+            broken[offset] = '\xFF';
+            EXPECT_FALSE(utf8Validate(broken.data(), broken.size()));
+        }
+    }
+}
+
+/**
+ * utf8Validate agrees with utf8Decode, including on malformed input split
+ * across the vector path's blocks.
+ */
+TEST(Utf8Test, validate)
+{
+    const char* CASES[] = {
+        "", "plain ascii", "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80",
+        "a\x80" "b", "\xFF", "\xE2\x82" "a", "\xF0\x9F\x98", "\xC0\xAF",
+        "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xEF\xBF\xBD", "\xF4\x8F\xBF\xBF",
+        "\xE0\xA0\x80", "\xE0\x9F\xBF", "\xF0\x90\x80\x80", "\xF0\x8F\xBF\xBF",
+    };
+
+    for (auto c : CASES)
+    {
+        for (size_t padding = 0; padding < 20; ++padding)
+        {
+            string in = string(padding, ' ') + c;
+            wstring decoded;
+
+            EXPECT_EQ(utf8Decode(in.data(), in.size(), decoded),
+                utf8Validate(in.data(), in.size())) << padding << ": " << c;
+        }
+    }
+
+    //random bytes, mostly valid sequences with the odd stray byte.
+    mt19937 rng(41);
+    const char* PIECES[] = {
+        "a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\x80", "\xC3",
+        "\xE2\x82", "\xF0\x9F",
+    };
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        string in;
+        size_t pieces = rng() % 40;
+
+        for (size_t j = 0; j < pieces; ++j)
+            in += PIECES[rng() % 8 < 6 ? rng() % 4 : 4 + rng() % 4];
+
+        wstring decoded;
+        EXPECT_EQ(utf8Decode(in.data(), in.size(), decoded),
+            utf8Validate(in.data(), in.size()));
+    }
+}